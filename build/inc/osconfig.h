@@ -50,8 +50,37 @@
 #define OS_MAX_TASKS                64
 #define OS_MAX_QUEUES               64
 #define OS_MAX_COUNT_SEMAPHORES     20
+#define OS_MAX_EVENT_FLAGS          20
 #define OS_MAX_BIN_SEMAPHORES       20
 #define OS_MAX_MUTEXES              20
+#define OS_MAX_RWLOCKS              20
+#define OS_MAX_SHMEM_SEGMENTS       8
+#define OS_MAX_TOPICS               16
+#define OS_MAX_MEMPOOLS             16
+#define OS_MAX_ARENAS               32
+
+/*
+** Maximum number of queues subscribed to one publish/subscribe topic
+*/
+#define OS_MAX_TOPIC_SUBSCRIBERS    16
+
+/*
+** Free blocks each task keeps for itself in a memory pool created with
+** OS_MEMPOOL_TASK_CACHE
+*/
+#define OS_MEMPOOL_CACHE_BLOCKS     16
+
+/*
+** Maximum number of objects a task can wait on in one call to OS_WaitAny
+*/
+#define OS_MAX_WAIT_OBJECTS         32
+
+/*
+** Number of message priorities a queue keeps apart, see OS_QUEUE_PRIORITY.
+** The socket and ring queues hold the messages of each priority separately,
+** higher priorities given to OS_QueuePut are treated as the highest one.
+*/
+#define OS_QUEUE_PRIORITIES         4
 
 /*
 ** Maximum length for an absolute path name
@@ -136,6 +165,44 @@
 */
 /* #define OSAL_SOCKET_QUEUE */
 
+/*
+** This define makes the Linux port keep the queues in ring buffers within the
+** process instead, sized from the depth and data size given to OS_QueueCreate.
+** A put or get only makes a system call when a task has to sleep or be woken
+** up. It takes precedence over OSAL_SOCKET_QUEUE.
+*/
+/* #define OSAL_RING_QUEUE */
+
+/*
+** This define makes the Linux port implement the binary and counting semaphores
+** with futexes instead of a pthread mutex and condition variable. Giving or
+** taking a semaphore that no task waits on then needs no system call.
+*/
+/* #define OS_USE_FUTEX_SEMAPHORES */
+
+/*
+** This define makes the posix port wrap malloc, free and the rest of the
+** malloc family, and count the allocations and frees of each task for
+** OS_HeapGetTaskInfo. It replaces them for the whole program, and costs a
+** lookup of the calling task on each call.
+*/
+/* #define OS_HEAP_ACCOUNTING */
+
+/*
+** Mount point of the hugetlbfs file system the Linux port keeps the shared
+** memory segments created with OS_SHMEM_HUGE_PAGES in. When it is missing, or
+** has no huge pages left, the segment is an ordinary one and the kernel is only
+** advised to use transparent huge pages for it.
+*/
+#define OS_SHMEM_HUGETLB_DIR "/dev/hugepages"
+
+/*
+** Size of the huge pages the Linux port maps the arenas created with
+** OS_ARENA_HUGE_PAGES from. When none are free, the arena is an ordinary
+** mapping and the kernel is only advised to use transparent huge pages for it.
+*/
+#define OS_ARENA_HUGE_PAGE_SIZE     (2 * 1024 * 1024)
+
 /*
 ** Module loader/symbol table is optional
 */
@@ -170,4 +237,10 @@
 */
 #define OS_MAX_TIMERS         5
 
+/*
+** This define sets the OSAL priority of the thread that calls the timer
+** callbacks on posix. It should be above the tasks that the callbacks wake up.
+*/
+#define OS_TIMER_THREAD_PRIORITY   10
+
 #endif
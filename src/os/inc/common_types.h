@@ -90,6 +90,7 @@ typedef int16_t        uint16;
 typedef uint32_t       uint32;
 typedef uint64_t       uint64;
 typedef int64_t        int64;
+typedef uintptr_t      cpuaddr;   /* an address held as an integer, as wide as a pointer */
 
 /*
 ** Includes
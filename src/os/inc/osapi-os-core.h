@@ -46,6 +46,58 @@
 /* #define for enabling floating point operations on a task*/
 #define OS_FP_ENABLED 1
 
+/* modes for OS_EventFlagsWait, they can be or'ed together */
+#define OS_EVENT_WAIT_ANY       0x0000  /* wake up when any of the flags is set */
+#define OS_EVENT_WAIT_ALL       0x0001  /* wake up when all of the flags are set */
+#define OS_EVENT_AUTO_CLEAR     0x0002  /* clear the flags waited for on wake up */
+
+/* types of the objects that OS_WaitAny can wait on */
+#define OS_WAIT_QUEUE           1
+#define OS_WAIT_BIN_SEM         2
+#define OS_WAIT_COUNT_SEM       3
+#define OS_WAIT_TIMER           4
+
+/* flags for OS_QueueCreate */
+#define OS_QUEUE_SPSC           0x0001  /* one task puts and one task gets, ring queues only */
+#define OS_QUEUE_LATENCY        0x0002  /* time each message in the queue, ring queues only */
+#define OS_QUEUE_SHARED         0x0010  /* other processes may open the queue by name, ring queues only */
+
+/* what OS_QueuePut does when the queue is full, given to OS_QueueCreate for the
+   queue or in the flags of OS_QueuePut for one put; by default it returns
+   OS_QUEUE_FULL */
+#define OS_QUEUE_BLOCK          0x0004  /* wait until there is room */
+#define OS_QUEUE_DROP_NEWEST    0x0008  /* drop the message put and return OS_SUCCESS */
+#define OS_QUEUE_OVERWRITE      0x000C  /* drop the oldest message of its priority */
+#define OS_QUEUE_POLICY_MASK    0x000C
+
+/* priority of a message given in the flags of OS_QueuePut, from 0 (the default)
+   up to OS_QUEUE_PRIORITIES - 1; messages of a higher priority are got first */
+#define OS_QUEUE_PRIORITY(priority)  (((uint32)(priority) & 0xFF) << 8)
+#define OS_QUEUE_PRIORITY_OF(flags)  (((flags) >> 8) & 0xFF)
+
+/* options for OS_MutSemCreate, they can be or'ed together */
+#define OS_MUTEX_ADAPTIVE       0x0001  /* spin briefly on a multi-core host before blocking */
+#define OS_MUTEX_FAST           0x0002  /* non-recursive, a nested take deadlocks */
+#define OS_MUTEX_PRIO_INHERIT   0x0004  /* owner inherits the priority of the tasks it blocks */
+#define OS_MUTEX_PRIO_PROTECT   0x0008  /* owner runs at the ceiling set with OS_MUTEX_CEILING */
+
+/* ceiling of an OS_MUTEX_PRIO_PROTECT mutex, as an OSAL task priority */
+#define OS_MUTEX_CEILING(priority)   (((uint32)(priority) & 0xFF) << 16)
+#define OS_MUTEX_CEILING_OF(options) (((options) >> 16) & 0xFF)
+
+/* flags for OS_ShMemCreateEx */
+#define OS_SHMEM_HUGE_PAGES     0x0001  /* back the segment with huge pages where the system has them */
+
+/* flags for OS_MemPoolCreate */
+#define OS_MEMPOOL_TASK_CACHE   0x0001  /* each task keeps a few free blocks of its own */
+
+/* flags for OS_ArenaCreate */
+#define OS_ARENA_HUGE_PAGES     0x0001  /* back the arena with huge pages where the system has them */
+
+/* options for OS_RwLockCreate, readers are preferred by default */
+#define OS_RWLOCK_PREFER_READER 0x0001  /* readers may take the lock while a writer waits */
+#define OS_RWLOCK_PREFER_WRITER 0x0002  /* new readers wait while a writer waits */
+
 /*  tables for the properties of objects */
 
 /*tasks */
@@ -65,6 +117,41 @@ typedef struct
     uint32 creator;
 }OS_queue_prop_t;
 
+/*
+** Queue statistics for OS_QueueGetStats. Bucket 0 of the latency histogram
+** counts the messages got less than 1 usec after they were put, bucket i the
+** ones got less than 2^i usecs after, and the last bucket all the later ones.
+*/
+#define OS_QUEUE_LATENCY_BUCKETS 24
+
+typedef struct
+{
+    uint32 depth;           /* messages in the queue now */
+    uint32 max_depth;       /* messages the queue can hold */
+    uint32 high_water;      /* most messages the queue has held */
+    uint64 puts;            /* messages put */
+    uint64 gets;            /* messages got */
+    uint64 full;            /* messages not put because the queue was full */
+    uint64 dropped;         /* messages dropped by OS_QUEUE_DROP_NEWEST */
+    uint64 overwritten;     /* messages dropped by OS_QUEUE_OVERWRITE */
+    uint64 empty;           /* OS_CHECK gets that found the queue empty */
+    uint64 timeouts;        /* gets that timed out */
+    uint64 latency[OS_QUEUE_LATENCY_BUCKETS];
+}OS_queue_stats_t;
+
+/* publish/subscribe topics */
+typedef struct
+{
+    char   name [OS_MAX_API_NAME];
+    uint32 creator;
+    uint32 buffer_size;     /* bytes a buffer of the topic holds */
+    uint32 buffers;         /* buffers of the topic */
+    uint32 buffers_free;    /* buffers not allocated or still held by a subscriber */
+    uint32 subscribers;     /* queues subscribed */
+    uint64 published;       /* buffers published */
+    uint64 missed;          /* deliveries that did not fit in a subscriber queue */
+}OS_topic_prop_t;
+
 /* Binary Semaphores */
 typedef struct
 {                     
@@ -81,6 +168,14 @@ typedef struct
     int32 value;
 }OS_count_sem_prop_t;
 
+/* Event Flags */
+typedef struct
+{
+    char name [OS_MAX_API_NAME];
+    uint32 creator;
+    uint32 flags;
+}OS_event_flags_prop_t;
+
 /* Mutexes */
 typedef struct
 {
@@ -88,6 +183,21 @@ typedef struct
     uint32 creator;
 }OS_mut_sem_prop_t;
 
+/* Reader/writer locks */
+typedef struct
+{
+    char name [OS_MAX_API_NAME];
+    uint32 creator;
+}OS_rwlock_prop_t;
+
+/* an object for OS_WaitAny, ready is set when the object can be taken */
+typedef struct
+{
+    uint32 type;
+    uint32 id;
+    uint32 ready;
+}OS_wait_object_t;
+
 
 /* struct for OS_GetLocalTime() */
 
@@ -105,6 +215,58 @@ typedef struct
     uint32 largest_free_block;
 }OS_heap_prop_t;
 
+/* allocations of a task since it was created, see OS_HeapGetTaskInfo */
+typedef struct
+{
+    uint64 allocs;          /* blocks allocated */
+    uint64 frees;           /* blocks freed */
+    uint64 bytes_allocated; /* usable bytes of the blocks allocated */
+    uint64 bytes_freed;     /* usable bytes of the blocks freed */
+}OS_heap_task_prop_t;
+
+/* memory pools */
+typedef struct
+{
+    char   name [OS_MAX_API_NAME];
+    uint32 creator;
+    uint32 block_size;      /* bytes a block holds, as the pool was created with */
+    uint32 blocks;          /* blocks of the pool */
+    uint32 blocks_free;     /* blocks not allocated */
+    uint32 blocks_in_use;   /* blocks allocated */
+    uint32 high_water;      /* most blocks allocated at once */
+    uint64 failures;        /* allocations that found no free block */
+}OS_mempool_prop_t;
+
+/* arenas */
+typedef struct
+{
+    char   name [OS_MAX_API_NAME];
+    uint32 creator;         /* the task the arena belongs to */
+    uint32 size;            /* bytes of the arena */
+    uint32 used;            /* bytes allocated since the last reset */
+    uint32 high_water;      /* most bytes allocated between two resets */
+    uint32 huge_pages;      /* TRUE when mapped from huge pages */
+    uint64 failures;        /* allocations that did not fit */
+}OS_arena_prop_t;
+
+/* object table capacities for OS_API_InitEx(), a zero selects the osconfig.h value */
+typedef struct
+{
+    uint32 max_tasks;
+    uint32 max_queues;
+    uint32 max_bin_semaphores;
+    uint32 max_count_semaphores;
+    uint32 max_event_flags;
+    uint32 max_mutexes;
+    uint32 max_rwlocks;
+    uint32 max_timers;
+    uint32 max_open_files;
+    uint32 max_shmem_segments;
+    uint32 max_topics;
+    uint32 max_mempools;
+    uint32 max_arenas;
+}OS_api_config_t;
+
 
 /* This typedef is for the OS_GetErrorName function, to ensure
  * everyone is making an array of the same length */
@@ -125,6 +287,7 @@ typedef osal_task ((*osal_task_entry)(void));
 ** Initialization of API
 */
 int32 OS_API_Init (void);
+int32 OS_API_InitEx (const OS_api_config_t *config);
 
 
 /*
@@ -161,8 +324,41 @@ int32 OS_QueueGet              (uint32 queue_id, void *data, uint32 size,
                                 uint32 *size_copied, int32 timeout);
 int32 OS_QueuePut              (uint32 queue_id, void *data, uint32 size, 
                                 uint32 flags);
+int32 OS_QueuePutTimeout       (uint32 queue_id, void *data, uint32 size,
+                                uint32 flags, int32 timeout);
 int32 OS_QueueGetIdByName      (uint32 *queue_id, const char *queue_name);
 int32 OS_QueueGetInfo          (uint32 queue_id, OS_queue_prop_t *queue_prop);
+int32 OS_QueueGetStats         (uint32 queue_id, OS_queue_stats_t *queue_stats);
+int32 OS_QueueGetEventFd       (uint32 queue_id, int32 *fd);
+int32 OS_QueuePutBatch         (uint32 queue_id, void *data, uint32 size, uint32 count,
+                                uint32 *count_put, uint32 flags);
+int32 OS_QueueGetBatch         (uint32 queue_id, void *data, uint32 size, uint32 max_count,
+                                uint32 *sizes_copied, uint32 *count_copied, int32 timeout);
+
+/*
+** Zero copy queue API, the messages are built and read in place. Only the
+** ring buffer queues implement it.
+*/
+int32 OS_QueueReserve          (uint32 queue_id, uint32 size, void **ptr);
+int32 OS_QueueCommit           (uint32 queue_id, void *ptr);
+int32 OS_QueueGetPtr           (uint32 queue_id, void **ptr, uint32 *size, int32 timeout);
+int32 OS_QueueRelease          (uint32 queue_id, void *ptr);
+
+/*
+** Publish/subscribe API, a buffer published on a topic is passed by reference
+** to the queue of each subscriber, and freed once all of them release it
+*/
+int32 OS_TopicInit             (void);
+int32 OS_TopicCreate           (uint32 *topic_id, const char *topic_name,
+                                uint32 buffer_size, uint32 num_buffers);
+int32 OS_TopicDelete           (uint32 topic_id);
+int32 OS_TopicGetIdByName      (uint32 *topic_id, const char *topic_name);
+int32 OS_TopicGetInfo          (uint32 topic_id, OS_topic_prop_t *topic_prop);
+int32 OS_TopicSubscribe        (uint32 topic_id, uint32 queue_id);
+int32 OS_TopicUnsubscribe      (uint32 topic_id, uint32 queue_id);
+int32 OS_TopicAlloc            (uint32 topic_id, void **buffer);
+int32 OS_TopicPublish          (uint32 topic_id, void *buffer, uint32 flags);
+int32 OS_TopicRelease          (void *buffer);
 
 /*
 ** Semaphore API
@@ -177,6 +373,7 @@ int32 OS_BinSemTimedWait       (uint32 sem_id, uint32 msecs);
 int32 OS_BinSemDelete          (uint32 sem_id);
 int32 OS_BinSemGetIdByName     (uint32 *sem_id, const char *sem_name);
 int32 OS_BinSemGetInfo         (uint32 sem_id, OS_bin_sem_prop_t *bin_prop);
+int32 OS_BinSemGetEventFd      (uint32 sem_id, int32 *fd);
 
 int32 OS_CountSemCreate          (uint32 *sem_id, const char *sem_name, 
                                 uint32 sem_initial_value, uint32 options);
@@ -186,6 +383,21 @@ int32 OS_CountSemTimedWait       (uint32 sem_id, uint32 msecs);
 int32 OS_CountSemDelete          (uint32 sem_id);
 int32 OS_CountSemGetIdByName     (uint32 *sem_id, const char *sem_name);
 int32 OS_CountSemGetInfo         (uint32 sem_id, OS_count_sem_prop_t *count_prop);
+int32 OS_CountSemGetEventFd      (uint32 sem_id, int32 *fd);
+
+/*
+** Event Flag API
+*/
+
+int32 OS_EventFlagsCreate       (uint32 *flags_id, const char *flags_name,
+                                 uint32 initial_flags, uint32 options);
+int32 OS_EventFlagsSet          (uint32 flags_id, uint32 flags);
+int32 OS_EventFlagsClear        (uint32 flags_id, uint32 flags);
+int32 OS_EventFlagsWait         (uint32 flags_id, uint32 wait_flags, uint32 mode,
+                                 int32 timeout, uint32 *flags_out);
+int32 OS_EventFlagsDelete       (uint32 flags_id);
+int32 OS_EventFlagsGetIdByName  (uint32 *flags_id, const char *flags_name);
+int32 OS_EventFlagsGetInfo      (uint32 flags_id, OS_event_flags_prop_t *flags_prop);
 
 /*
 ** Mutex API
@@ -198,6 +410,24 @@ int32 OS_MutSemDelete           (uint32 sem_id);
 int32 OS_MutSemGetIdByName      (uint32 *sem_id, const char *sem_name); 
 int32 OS_MutSemGetInfo          (uint32 sem_id, OS_mut_sem_prop_t *mut_prop);
 
+/*
+** Reader/Writer Lock API
+*/
+
+int32 OS_RwLockCreate           (uint32 *rwlock_id, const char *rwlock_name, uint32 options);
+int32 OS_RwLockReadTake         (uint32 rwlock_id);
+int32 OS_RwLockWriteTake        (uint32 rwlock_id);
+int32 OS_RwLockGive             (uint32 rwlock_id);
+int32 OS_RwLockDelete           (uint32 rwlock_id);
+int32 OS_RwLockGetIdByName      (uint32 *rwlock_id, const char *rwlock_name);
+int32 OS_RwLockGetInfo          (uint32 rwlock_id, OS_rwlock_prop_t *rwlock_prop);
+
+/*
+** Wait for Any API
+*/
+
+int32 OS_WaitAny                (OS_wait_object_t *objects, uint32 count, int32 timeout);
+
 /*
 ** OS Time/Tick related API
 */
@@ -243,19 +473,47 @@ int32 OS_IntGetMask        (uint32 *mask);
 int32 OS_IntAck             (int32 InterruptNumber);
 
 /*
-** Shared memory API 
+** Shared memory API, a segment is shared by name with the other processes
 */
 int32 OS_ShMemInit          (void);
 int32 OS_ShMemCreate        (uint32 *Id, uint32 NBytes, char* SegName);
+int32 OS_ShMemCreateEx      (uint32 *Id, uint32 NBytes, const char *SegName, uint32 flags);
+int32 OS_ShMemDelete        (uint32 Id);
 int32 OS_ShMemSemTake       (uint32 Id);
 int32 OS_ShMemSemGive       (uint32 Id);
-int32 OS_ShMemAttach        (uint32 * Address, uint32 Id);
+int32 OS_ShMemAttach        (cpuaddr * Address, uint32 Id);
 int32 OS_ShMemGetIdByName   (uint32 *ShMemId, const char *SegName );
 
 /*
 ** Heap API
 */
 int32 OS_HeapGetInfo       (OS_heap_prop_t *heap_prop);
+int32 OS_HeapGetTaskInfo   (uint32 task_id, OS_heap_task_prop_t *task_prop);
+
+/*
+** Memory pool API, blocks of a fixed size allocated without locks or malloc
+*/
+int32 OS_MemPoolInit        (void);
+int32 OS_MemPoolCreate      (uint32 *pool_id, const char *pool_name, uint32 block_size,
+                             uint32 block_count, uint32 flags);
+int32 OS_MemPoolDelete      (uint32 pool_id);
+int32 OS_MemPoolGetIdByName (uint32 *pool_id, const char *pool_name);
+int32 OS_MemPoolGetInfo     (uint32 pool_id, OS_mempool_prop_t *pool_prop);
+int32 OS_MemPoolAlloc       (uint32 pool_id, void **block);
+int32 OS_MemPoolFree        (uint32 pool_id, void *block);
+
+/*
+** Arena API, memory of a task allocated by moving a pointer and given back all
+** at once
+*/
+int32 OS_ArenaInit          (void);
+int32 OS_ArenaCreate        (uint32 *arena_id, const char *arena_name, uint32 size,
+                             uint32 flags);
+int32 OS_ArenaDelete        (uint32 arena_id);
+int32 OS_ArenaGetIdByName   (uint32 *arena_id, const char *arena_name);
+int32 OS_ArenaGetInfo       (uint32 arena_id, OS_arena_prop_t *arena_prop);
+int32 OS_ArenaAlloc         (uint32 arena_id, uint32 size, void **ptr);
+int32 OS_ArenaReset         (uint32 arena_id);
 
 /*
 ** API for useful debugging function
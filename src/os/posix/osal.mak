@@ -16,7 +16,10 @@ TARGET = osal.o
 #==============================================================================
 # Object files required to build subsystem.
 
-OBJS=osapi.o osfileapi.o  osfilesys.o  osnetwork.o osloader.o ostimer.o
+OBJS=osapi.o osfileapi.o  osfilesys.o  osnetwork.o osloader.o ostimer.o \
+     osqueues.o osqueues_posix.o osqueues_sockets.o osqueues_ring.o \
+     osobject.o osfutex.o osshmem.o osmempool.o osarena.o \
+     osheap.o ospubsub.o
 
 #==============================================================================
 # Source files required to build subsystem; used to generate dependencies.
@@ -98,6 +98,9 @@
 #include <errno.h>
 #include <limits.h>
 #include <time.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
 #include "osmac_stuff.h"
 #include "osposix.h"
 /*
@@ -112,7 +115,24 @@
 #include "common_types.h"
 #include "osapi.h"
 #include "osqueues.h"
+#include "osobject.h"
+#include "osfutex.h"
 
+/*
+** Number of times an adaptive mutex tries to take the lock before it blocks
+*/
+#ifndef OS_MUTEX_SPIN_LIMIT
+#define OS_MUTEX_SPIN_LIMIT  100
+#endif
+
+/*
+** Tells the CPU that the task is spinning
+*/
+#if defined(__i386__) || defined(__x86_64__)
+#define OS_CPU_RELAX()  __asm__ __volatile__ ("pause")
+#else
+#define OS_CPU_RELAX()
+#endif
 
 /*
 ** Global data for the API
@@ -132,32 +152,59 @@ typedef struct
     uint32    stack_size;
     uint32    priority;
     void     *delete_hook_pointer;
+    osal_task_entry entry_function;
 }OS_task_record_t;
 
 /* Binary Semaphores */
 typedef struct
 {
     int             free;
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    OS_futex_sem_t  sem;
+#else
     pthread_mutex_t id;
     pthread_cond_t  cv;
+#endif
     char            name [OS_MAX_API_NAME];
     int             creator;
     int             max_value;
     int             current_value;
+    int             wait_fd;
+    volatile uint32 any_waiters;
+    OS_event_fd_t   event;
 }OS_bin_sem_record_t;
 
 /*Counting Semaphores */
 typedef struct
 {
     int             free;
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    OS_futex_sem_t  sem;
+#else
     pthread_mutex_t id;
     pthread_cond_t  cv;
+#endif
     char            name [OS_MAX_API_NAME];
     int             creator;
     int             max_value;
     int             current_value;
+    int             wait_fd;
+    volatile uint32 any_waiters;
+    OS_event_fd_t   event;
 }OS_count_sem_record_t;
 
+/* Event Flags */
+typedef struct
+{
+    int             free;
+    pthread_mutex_t id;
+    pthread_cond_t  cv;
+    char            name [OS_MAX_API_NAME];
+    int             creator;
+    uint32          flags;
+    uint32          waiters;
+}OS_event_flags_record_t;
+
 /* Mutexes */
 typedef struct
 {
@@ -165,25 +212,70 @@ typedef struct
     pthread_mutex_t id;
     char            name [OS_MAX_API_NAME];
     int             creator;
+    uint32          options;
 }OS_mut_sem_record_t;
 
+/* Reader/Writer Locks */
+typedef struct
+{
+    int              free;
+    pthread_rwlock_t id;
+    char             name [OS_MAX_API_NAME];
+    int              creator;
+    uint32           options;
+}OS_rwlock_record_t;
+
 /* function pointer type */
 typedef void (*FuncPtr_t)(void);
 
 /* Tables where the OS object information is stored */
-OS_task_record_t    OS_task_table          [OS_MAX_TASKS];
-OS_bin_sem_record_t OS_bin_sem_table       [OS_MAX_BIN_SEMAPHORES];
-OS_count_sem_record_t OS_count_sem_table   [OS_MAX_COUNT_SEMAPHORES];
-OS_mut_sem_record_t OS_mut_sem_table       [OS_MAX_MUTEXES];
+OS_object_table_t   OS_task_table;
+OS_object_table_t   OS_bin_sem_table;
+OS_object_table_t   OS_count_sem_table;
+OS_object_table_t   OS_event_flags_table;
+OS_object_table_t   OS_mut_sem_table;
+OS_object_table_t   OS_rwlock_table;
+
+#define OS_TASK_RECORD(id)      ((OS_task_record_t *)OS_ObjectRecord(&OS_task_table, id))
+#define OS_BIN_SEM_RECORD(id)   ((OS_bin_sem_record_t *)OS_ObjectRecord(&OS_bin_sem_table, id))
+#define OS_COUNT_SEM_RECORD(id) ((OS_count_sem_record_t *)OS_ObjectRecord(&OS_count_sem_table, id))
+#define OS_EVENT_FLAGS_RECORD(id) ((OS_event_flags_record_t *)OS_ObjectRecord(&OS_event_flags_table, id))
+#define OS_MUT_SEM_RECORD(id)   ((OS_mut_sem_record_t *)OS_ObjectRecord(&OS_mut_sem_table, id))
+#define OS_RWLOCK_RECORD(id)    ((OS_rwlock_record_t *)OS_ObjectRecord(&OS_rwlock_table, id))
+
+/* The semaphore mutex that orders the gives and takes, and the semaphore value */
+#ifdef OS_USE_FUTEX_SEMAPHORES
+#define OS_BIN_SEM_MUTEX(sem_id)      NULL
+#define OS_COUNT_SEM_MUTEX(sem_id)    NULL
+#define OS_BIN_SEM_VALUE(sem_id)      OS_FutexSemValue(&(OS_BIN_SEM_RECORD(sem_id)->sem))
+#define OS_COUNT_SEM_VALUE(sem_id)    OS_FutexSemValue(&(OS_COUNT_SEM_RECORD(sem_id)->sem))
+#else
+#define OS_BIN_SEM_MUTEX(sem_id)      (&(OS_BIN_SEM_RECORD(sem_id)->id))
+#define OS_COUNT_SEM_MUTEX(sem_id)    (&(OS_COUNT_SEM_RECORD(sem_id)->id))
+#define OS_BIN_SEM_VALUE(sem_id)      (OS_BIN_SEM_RECORD(sem_id)->current_value)
+#define OS_COUNT_SEM_VALUE(sem_id)    (OS_COUNT_SEM_RECORD(sem_id)->current_value)
+#endif
+
+/* Object table capacities */
+OS_api_config_t     OS_api_config;
 
+/*
+** The thread_key holds the OSAL task ID of the calling thread plus one, so a
+** NULL value means the thread was not created or registered by the OSAL.
+*/
 pthread_key_t    thread_key;
 
 pthread_mutex_t OS_task_table_mut;
 pthread_mutex_t OS_bin_sem_table_mut;
 pthread_mutex_t OS_mut_sem_table_mut;
 pthread_mutex_t OS_count_sem_table_mut;
+pthread_mutex_t OS_event_flags_table_mut;
+pthread_mutex_t OS_rwlock_table_mut;
 uint32          OS_printf_enabled = TRUE;
 
+/* Number of CPUs online, adaptive mutexes do not spin when there is only one */
+long            OS_cpu_count = 1;
+
 /*
 ** Local Function Prototypes
 */
@@ -191,58 +283,142 @@ uint32  OS_CompAbsDelayTime( uint32 milli_second , struct timespec * tm);
 void    OS_ThreadKillHandler(int sig );
 uint32  OS_FindCreator(void);
 int32   OS_PriorityRemap(uint32 InputPri);
+void   *OS_PthreadTaskEntry(void *arg);
+void    OS_TaskInitRecord(void *record);
+void    OS_BinSemInitRecord(void *record);
+void    OS_CountSemInitRecord(void *record);
+void    OS_EventFlagsInitRecord(void *record);
+void    OS_MutSemInitRecord(void *record);
+void    OS_RwLockInitRecord(void *record);
+void    OS_WaitAnyNotify(int fd);
+int32   OS_TimerGetWaitFd(uint32 timer_id, int *fd);
 
 /*---------------------------------------------------------------------------------------
    Name: OS_API_Init
 
    Purpose: Initialize the tables that the OS API uses to keep track of information
-            about objects
+            about objects, with the capacities from osconfig.h
 
    returns: OS_SUCCESS or OS_ERROR
 ---------------------------------------------------------------------------------------*/
 int32 OS_API_Init(void)
 {
-   int                 i;
+   OS_api_config_t config;
+
+   memset(&config, 0, sizeof(config));
+
+   return(OS_API_InitEx(&config));
+
+}/* end OS_API_Init */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_API_InitEx
+
+   Purpose: Initialize the tables that the OS API uses to keep track of information
+            about objects. The tables start empty and grow in chunks up to the
+            capacities in config. A capacity of zero selects the osconfig.h value.
+
+   returns: OS_INVALID_POINTER if config is NULL
+            OS_SUCCESS or OS_ERROR
+---------------------------------------------------------------------------------------*/
+int32 OS_API_InitEx(const OS_api_config_t *config)
+{
    int                 ret;
    pthread_mutexattr_t mutex_attr ;    
    int32               return_code = OS_SUCCESS;
-    
-    /* Initialize Task Table */
-   
-   for(i = 0; i < OS_MAX_TASKS; i++)
-   {
-        OS_task_table[i].free                = TRUE;
-        OS_task_table[i].creator             = UNINITIALIZED;
-        OS_task_table[i].delete_hook_pointer = NULL;
-        strcpy(OS_task_table[i].name,"");    
-    }
-
-    /* Initialize Binary Semaphore Table */
 
-    for(i = 0; i < OS_MAX_BIN_SEMAPHORES; i++)
-    {
-        OS_bin_sem_table[i].free        = TRUE;
-        OS_bin_sem_table[i].creator     = UNINITIALIZED;
-        strcpy(OS_bin_sem_table[i].name,"");
-    }
+   if ( config == NULL )
+   {
+      return(OS_INVALID_POINTER);
+   }
 
-    /* Initialize Counting Semaphores */
+   OS_cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
 
-    for(i = 0; i < OS_MAX_COUNT_SEMAPHORES; i++)
-    {
-        OS_count_sem_table[i].free        = TRUE;
-        OS_count_sem_table[i].creator     = UNINITIALIZED;
-        strcpy(OS_count_sem_table[i].name,"");
-    }
+   /*
+   ** Fill in the capacities that were not given
+   */
+   OS_api_config = *config;
+   if ( OS_api_config.max_tasks == 0 )
+   {
+      OS_api_config.max_tasks = OS_MAX_TASKS;
+   }
+   if ( OS_api_config.max_queues == 0 )
+   {
+      OS_api_config.max_queues = OS_MAX_QUEUES;
+   }
+   if ( OS_api_config.max_bin_semaphores == 0 )
+   {
+      OS_api_config.max_bin_semaphores = OS_MAX_BIN_SEMAPHORES;
+   }
+   if ( OS_api_config.max_count_semaphores == 0 )
+   {
+      OS_api_config.max_count_semaphores = OS_MAX_COUNT_SEMAPHORES;
+   }
+   if ( OS_api_config.max_event_flags == 0 )
+   {
+      OS_api_config.max_event_flags = OS_MAX_EVENT_FLAGS;
+   }
+   if ( OS_api_config.max_mutexes == 0 )
+   {
+      OS_api_config.max_mutexes = OS_MAX_MUTEXES;
+   }
+   if ( OS_api_config.max_rwlocks == 0 )
+   {
+      OS_api_config.max_rwlocks = OS_MAX_RWLOCKS;
+   }
+   if ( OS_api_config.max_timers == 0 )
+   {
+      OS_api_config.max_timers = OS_MAX_TIMERS;
+   }
+   if ( OS_api_config.max_open_files == 0 )
+   {
+      OS_api_config.max_open_files = OS_MAX_NUM_OPEN_FILES;
+   }
+   if ( OS_api_config.max_shmem_segments == 0 )
+   {
+      OS_api_config.max_shmem_segments = OS_MAX_SHMEM_SEGMENTS;
+   }
+   if ( OS_api_config.max_topics == 0 )
+   {
+      OS_api_config.max_topics = OS_MAX_TOPICS;
+   }
+   if ( OS_api_config.max_mempools == 0 )
+   {
+      OS_api_config.max_mempools = OS_MAX_MEMPOOLS;
+   }
+   if ( OS_api_config.max_arenas == 0 )
+   {
+      OS_api_config.max_arenas = OS_MAX_ARENAS;
+   }
 
-    /* Initialize Mutex Semaphore Table */
+   /*
+   ** Initialize the Task, Semaphore, Event Flag, Mutex and Reader/Writer Lock tables
+   */
+   if ( (OS_ObjectTableInit(&OS_task_table, sizeof(OS_task_record_t),
+                            OS_api_config.max_tasks, OS_TaskInitRecord) != OS_SUCCESS) ||
+        (OS_ObjectTableInit(&OS_bin_sem_table, sizeof(OS_bin_sem_record_t),
+                            OS_api_config.max_bin_semaphores, OS_BinSemInitRecord) != OS_SUCCESS) ||
+        (OS_ObjectTableInit(&OS_count_sem_table, sizeof(OS_count_sem_record_t),
+                            OS_api_config.max_count_semaphores, OS_CountSemInitRecord) != OS_SUCCESS) ||
+        (OS_ObjectTableInit(&OS_event_flags_table, sizeof(OS_event_flags_record_t),
+                            OS_api_config.max_event_flags, OS_EventFlagsInitRecord) != OS_SUCCESS) ||
+        (OS_ObjectTableInit(&OS_mut_sem_table, sizeof(OS_mut_sem_record_t),
+                            OS_api_config.max_mutexes, OS_MutSemInitRecord) != OS_SUCCESS) ||
+        (OS_ObjectTableInit(&OS_rwlock_table, sizeof(OS_rwlock_record_t),
+                            OS_api_config.max_rwlocks, OS_RwLockInitRecord) != OS_SUCCESS) )
+   {
+      printf("Error: could not allocate the OSAL object tables\n");
+      return(OS_ERROR);
+   }
 
-    for(i = 0; i < OS_MAX_MUTEXES; i++)
-    {
-        OS_mut_sem_table[i].free        = TRUE;
-        OS_mut_sem_table[i].creator     = UNINITIALIZED;
-        strcpy(OS_mut_sem_table[i].name,"");
-    }
+   /*
+   ** Initialize the object name index
+   */
+   return_code = OS_NameIndexInit();
+   if ( return_code == OS_ERROR )
+   {
+      return(return_code);
+   }
 
    /*
    ** Initialize the module loader
@@ -335,6 +511,72 @@ int32 OS_API_Init(void)
       return_code = OS_ERROR;
       return(return_code);
    }
+   ret = pthread_mutex_init((pthread_mutex_t *) & OS_event_flags_table_mut,&mutex_attr); 
+   if ( ret != 0 )
+   {
+      return_code = OS_ERROR;
+      return(return_code);
+   }
+   ret = pthread_mutex_init((pthread_mutex_t *) & OS_rwlock_table_mut,&mutex_attr); 
+   if ( ret != 0 )
+   {
+      return_code = OS_ERROR;
+      return(return_code);
+   }
+
+   /*
+   ** Initialize the message queue table
+   */
+   return_code = OS_Queue_Init();
+   if ( return_code != OS_SUCCESS )
+   {
+      return(return_code);
+   }
+
+   /*
+   ** Initialize the shared memory segment table
+   */
+   return_code = OS_ShMemInit();
+   if ( return_code != OS_SUCCESS )
+   {
+      return(return_code);
+   }
+
+   /*
+   ** Initialize the memory pool table
+   */
+   return_code = OS_MemPoolInit();
+   if ( return_code != OS_SUCCESS )
+   {
+      return(return_code);
+   }
+
+   /*
+   ** Initialize the arena table
+   */
+   return_code = OS_ArenaInit();
+   if ( return_code != OS_SUCCESS )
+   {
+      return(return_code);
+   }
+
+   /*
+   ** Initialize the heap accounting of the tasks
+   */
+   return_code = OS_HeapInit();
+   if ( return_code != OS_SUCCESS )
+   {
+      return(return_code);
+   }
+
+   /*
+   ** Initialize the publish/subscribe topic table
+   */
+   return_code = OS_TopicInit();
+   if ( return_code != OS_SUCCESS )
+   {
+      return(return_code);
+   }
 
    /*
    ** File system init
@@ -345,6 +587,106 @@ int32 OS_API_Init(void)
    
 }
 
+/*---------------------------------------------------------------------------------------
+   Name: OS_TaskInitRecord, OS_BinSemInitRecord, OS_CountSemInitRecord,
+         OS_EventFlagsInitRecord, OS_MutSemInitRecord, OS_RwLockInitRecord
+
+   Purpose: Mark a newly allocated table record as free. They are called by the
+            object tables as they grow.
+
+   returns: nothing
+---------------------------------------------------------------------------------------*/
+void OS_TaskInitRecord(void *record)
+{
+    OS_task_record_t *task = record;
+
+    task->free                = TRUE;
+    task->creator             = UNINITIALIZED;
+    task->delete_hook_pointer = NULL;
+    strcpy(task->name,"");    
+}
+
+void OS_BinSemInitRecord(void *record)
+{
+    OS_bin_sem_record_t *sem = record;
+
+    sem->free        = TRUE;
+    sem->creator     = UNINITIALIZED;
+    sem->wait_fd     = -1;
+    sem->any_waiters = 0;
+    sem->event.fd    = -1;
+    strcpy(sem->name,"");
+}
+
+void OS_CountSemInitRecord(void *record)
+{
+    OS_count_sem_record_t *sem = record;
+
+    sem->free        = TRUE;
+    sem->creator     = UNINITIALIZED;
+    sem->wait_fd     = -1;
+    sem->any_waiters = 0;
+    sem->event.fd    = -1;
+    strcpy(sem->name,"");
+}
+
+void OS_EventFlagsInitRecord(void *record)
+{
+    OS_event_flags_record_t *group = record;
+
+    group->free      = TRUE;
+    group->creator   = UNINITIALIZED;
+    group->flags     = 0;
+    group->waiters   = 0;
+    strcpy(group->name,"");
+}
+
+void OS_MutSemInitRecord(void *record)
+{
+    OS_mut_sem_record_t *sem = record;
+
+    sem->free        = TRUE;
+    sem->creator     = UNINITIALIZED;
+    strcpy(sem->name,"");
+}
+
+void OS_RwLockInitRecord(void *record)
+{
+    OS_rwlock_record_t *rwlock = record;
+
+    rwlock->free     = TRUE;
+    rwlock->creator  = UNINITIALIZED;
+    strcpy(rwlock->name,"");
+}
+
+/*
+** Drains the event descriptor of a semaphore that cannot be taken after a
+** take, see OS_EventFdDrain
+*/
+static void OS_BinSemEventDrain(uint32 sem_id)
+{
+    if ( OS_BIN_SEM_RECORD(sem_id)->event.fd >= 0 && OS_BIN_SEM_VALUE(sem_id) <= 0 )
+    {
+        OS_EventFdDrain(&(OS_BIN_SEM_RECORD(sem_id)->event));
+        if ( OS_BIN_SEM_VALUE(sem_id) > 0 )
+        {
+            OS_EventFdSignal(&(OS_BIN_SEM_RECORD(sem_id)->event));
+        }
+    }
+}
+
+static void OS_CountSemEventDrain(uint32 sem_id)
+{
+    if ( OS_COUNT_SEM_RECORD(sem_id)->event.fd >= 0 && OS_COUNT_SEM_VALUE(sem_id) <= 0 )
+    {
+        OS_EventFdDrain(&(OS_COUNT_SEM_RECORD(sem_id)->event));
+        if ( OS_COUNT_SEM_VALUE(sem_id) > 0 )
+        {
+            OS_EventFdSignal(&(OS_COUNT_SEM_RECORD(sem_id)->event));
+        }
+    }
+}
+
 /*
 **********************************************************************************
 **          TASK API
@@ -375,8 +717,8 @@ int32 OS_TaskCreate (uint32 *task_id, const char *task_name, osal_task_entry fun
     int                return_code = 0;
     pthread_attr_t     custom_attr ;
     struct sched_param priority_holder ;
-    int                possible_taskid;
-    int                i;
+    pthread_t          thread;
+    uint32             possible_taskid;
     uint32             local_stack_size;
     int                ret;  
     int                os_priority;
@@ -404,42 +746,21 @@ int32 OS_TaskCreate (uint32 *task_id, const char *task_name, osal_task_entry fun
     /* Change OSAL priority into a priority that will work for this OS */
     os_priority = OS_PriorityRemap(priority);
     
-    /* Check Parameters */
-    pthread_mutex_lock(&OS_task_table_mut); 
-
-    for(possible_taskid = 0; possible_taskid < OS_MAX_TASKS; possible_taskid++)
-    {
-        if (OS_task_table[possible_taskid].free == TRUE)
-        {
-            break;
-        }
-    }
-
-    /* Check to see if the id is out of bounds */
-    if( possible_taskid >= OS_MAX_TASKS || OS_task_table[possible_taskid].free != TRUE)
+    /* Take a free task Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_task_table, &possible_taskid) != OS_SUCCESS )
     {
-        pthread_mutex_unlock(&OS_task_table_mut);
         return OS_ERR_NO_FREE_IDS;
     }
 
-    /* Check to see if the name is already taken */ 
-    for (i = 0; i < OS_MAX_TASKS; i++)
+    /* Check to see if the name is already taken, and reserve it */ 
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_TASK, task_name, possible_taskid);
+    if ( return_code != OS_SUCCESS )
     {
-        if ((OS_task_table[i].free == FALSE) &&
-           ( strcmp((char*) task_name, OS_task_table[i].name) == 0)) 
-        {       
-            pthread_mutex_unlock(&OS_task_table_mut);
-            return OS_ERR_NAME_TAKEN;
-        }
+        OS_ObjectRelease(&OS_task_table, possible_taskid);
+        return return_code;
     }
     
-    /* 
-    ** Set the possible task Id to not free so that
-    ** no other task can try to use it 
-    */
-    OS_task_table[possible_taskid].free = FALSE;
-    
-    pthread_mutex_unlock(&OS_task_table_mut);
+    OS_TASK_RECORD(possible_taskid)->free = FALSE;
 
     if ( stack_size < PTHREAD_STACK_MIN )
     {
@@ -458,8 +779,10 @@ int32 OS_TaskCreate (uint32 *task_id, const char *task_name, osal_task_entry fun
     if(pthread_attr_init(&custom_attr))
     {  
         pthread_mutex_lock(&OS_task_table_mut); 
-        OS_task_table[possible_taskid].free = TRUE;
+        OS_NameIndexRemove(OS_OBJECT_TYPE_TASK, task_name);
+        OS_TASK_RECORD(possible_taskid)->free = TRUE;
         pthread_mutex_unlock(&OS_task_table_mut); 
+        OS_ObjectRelease(&OS_task_table, possible_taskid);
         printf("pthread_attr_init error in OS_TaskCreate, Task ID = %d\n",possible_taskid);
 		  perror("pthread_attr_init");
         return(OS_ERROR); 
@@ -470,16 +793,44 @@ int32 OS_TaskCreate (uint32 *task_id, const char *task_name, osal_task_entry fun
     */
     if (pthread_attr_setstacksize(&custom_attr, (size_t)local_stack_size ))
     {
+        pthread_mutex_lock(&OS_task_table_mut);
+        OS_NameIndexRemove(OS_OBJECT_TYPE_TASK, task_name);
+        OS_TASK_RECORD(possible_taskid)->free = TRUE;
+        pthread_mutex_unlock(&OS_task_table_mut);
+        OS_ObjectRelease(&OS_task_table, possible_taskid);
         printf("pthread_attr_setstacksize error in OS_TaskCreate, Task ID = %d\n",possible_taskid);
         return(OS_ERROR); 
     }
 
+    /*
+    ** Create the thread detached. A task that runs at a higher priority than
+    ** its creator can exit before pthread_create returns, and could not be
+    ** detached afterwards.
+    */
+    if (pthread_attr_setdetachstate(&custom_attr, PTHREAD_CREATE_DETACHED))
+    {
+        pthread_mutex_lock(&OS_task_table_mut);
+        OS_NameIndexRemove(OS_OBJECT_TYPE_TASK, task_name);
+        OS_TASK_RECORD(possible_taskid)->free = TRUE;
+        pthread_mutex_unlock(&OS_task_table_mut);
+        OS_ObjectRelease(&OS_task_table, possible_taskid);
+        printf("pthread_attr_setdetachstate error in OS_TaskCreate, Task ID = %d\n",possible_taskid);
+        return(OS_ERROR);
+    }
+
     /*
     ** Set the scheduling policy 
-    ** On Linux, the schedpolity must be SCHED_FIFO or SCHED_RR to set the priorty
+    ** On Linux, the schedpolity must be SCHED_FIFO or SCHED_RR to set the priorty,
+    ** and the thread must not inherit the policy of its creator
     */
-    if (pthread_attr_setschedpolicy(&custom_attr, SCHED_FIFO))
+    if (pthread_attr_setinheritsched(&custom_attr, PTHREAD_EXPLICIT_SCHED) ||
+        pthread_attr_setschedpolicy(&custom_attr, SCHED_FIFO))
     {
+        pthread_mutex_lock(&OS_task_table_mut);
+        OS_NameIndexRemove(OS_OBJECT_TYPE_TASK, task_name);
+        OS_TASK_RECORD(possible_taskid)->free = TRUE;
+        pthread_mutex_unlock(&OS_task_table_mut);
+        OS_ObjectRelease(&OS_task_table, possible_taskid);
         printf("pthread_attr_setschedpolity error in OS_TaskCreate, Task ID = %d\n",possible_taskid);
         return(OS_ERROR);
     }
@@ -492,68 +843,83 @@ int32 OS_TaskCreate (uint32 *task_id, const char *task_name, osal_task_entry fun
     ret = pthread_attr_setschedparam(&custom_attr,&priority_holder);
     if(ret !=0)
     {
+       pthread_mutex_lock(&OS_task_table_mut);
+       OS_NameIndexRemove(OS_OBJECT_TYPE_TASK, task_name);
+       OS_TASK_RECORD(possible_taskid)->free = TRUE;
+       pthread_mutex_unlock(&OS_task_table_mut);
+       OS_ObjectRelease(&OS_task_table, possible_taskid);
        printf("pthread_attr_setschedparam error in OS_TaskCreate, Task ID = %d\n",possible_taskid);
        return(OS_ERROR);
     }
 
+    /* 
+    ** Initialize the table entries before the thread starts, so the new
+    ** task can look itself up right away
+    */
+    pthread_mutex_lock(&OS_task_table_mut); 
+
+    strcpy(OS_TASK_RECORD(possible_taskid)->name, (char*) task_name);
+    OS_TASK_RECORD(possible_taskid)->creator = OS_FindCreator();
+    OS_TASK_RECORD(possible_taskid)->stack_size = stack_size;
+    /* Use the abstracted priority, not the OS one */
+    OS_TASK_RECORD(possible_taskid)->priority = priority;
+
+    pthread_mutex_unlock(&OS_task_table_mut);
+
+    OS_HeapTaskStart(possible_taskid);
+
     /*
     ** Create thread
+    ** The thread starts in OS_PthreadTaskEntry, which records the task ID in
+    ** the thread specific data before calling the user's entry point.
+    ** The table mutex is held until the thread handle is in the record: the
+    ** new task waits for it before it runs, so it cannot exit and release
+    ** the record while its creator is still filling it in.
     */
-    return_code = pthread_create(&(OS_task_table[possible_taskid].id),
+    OS_TASK_RECORD(possible_taskid)->entry_function = function_pointer;
+
+    pthread_mutex_lock(&OS_task_table_mut);
+    return_code = pthread_create(&thread,
                                  &custom_attr,
-                                 function_pointer,
-                                 (void *)0);
-    if (return_code != 0)
+                                 OS_PthreadTaskEntry,
+                                 (void *)(unsigned long)possible_taskid);
+    if (return_code == EPERM)
     {
-        pthread_mutex_lock(&OS_task_table_mut); 
-        OS_task_table[possible_taskid].free = TRUE;
-        pthread_mutex_unlock(&OS_task_table_mut); 
-        printf("pthread_create error in OS_TaskCreate, Task ID = %d\n",possible_taskid);
-        return(OS_ERROR);
+       /*
+       ** Without the privilege to use SCHED_FIFO, run the task with the
+       ** policy and priority of its creator
+       */
+       pthread_attr_setinheritsched(&custom_attr, PTHREAD_INHERIT_SCHED);
+       return_code = pthread_create(&thread,
+                                    &custom_attr,
+                                    OS_PthreadTaskEntry,
+                                    (void *)(unsigned long)possible_taskid);
     }
 
     /*
     ** Free the resources that are no longer needed
     */
-    return_code = pthread_detach(OS_task_table[possible_taskid].id);
-    if (return_code !=0)
-    {
-       pthread_mutex_lock(&OS_task_table_mut);
-       OS_task_table[possible_taskid].free = TRUE;
-       pthread_mutex_unlock(&OS_task_table_mut);
-       printf("pthread_detach error in OS_TaskCreate, Task ID = %d\n",possible_taskid);
-       return(OS_ERROR);
-    }
+    pthread_attr_destroy(&custom_attr);
 
-    return_code = pthread_attr_destroy(&custom_attr);
-    if (return_code !=0)
+    if (return_code != 0)
     {
-       pthread_mutex_lock(&OS_task_table_mut);
-       OS_task_table[possible_taskid].free = TRUE;
-       pthread_mutex_unlock(&OS_task_table_mut);
-       printf("pthread_attr_destroy error in OS_TaskCreate, Task ID = %d\n",possible_taskid);
-       return(OS_ERROR);
+        OS_NameIndexRemove(OS_OBJECT_TYPE_TASK, task_name);
+        strcpy(OS_TASK_RECORD(possible_taskid)->name, "");
+        OS_TASK_RECORD(possible_taskid)->free = TRUE;
+        pthread_mutex_unlock(&OS_task_table_mut); 
+        OS_ObjectRelease(&OS_task_table, possible_taskid);
+        printf("pthread_create error in OS_TaskCreate, Task ID = %d\n",possible_taskid);
+        return(OS_ERROR);
     }
 
+    OS_TASK_RECORD(possible_taskid)->id = thread;
+    pthread_mutex_unlock(&OS_task_table_mut);
+
     /*
     ** Assign the task ID
     */
     *task_id = possible_taskid;
 
-    /* 
-    ** Initialize the table entries 
-    */
-    pthread_mutex_lock(&OS_task_table_mut); 
-
-    OS_task_table[possible_taskid].free = FALSE;
-    strcpy(OS_task_table[*task_id].name, (char*) task_name);
-    OS_task_table[possible_taskid].creator = OS_FindCreator();
-    OS_task_table[possible_taskid].stack_size = stack_size;
-    /* Use the abstracted priority, not the OS one */
-    OS_task_table[possible_taskid].priority = priority;
-
-    pthread_mutex_unlock(&OS_task_table_mut);
-
     return OS_SUCCESS;
 }/* end OS_TaskCreate */
 
@@ -575,7 +941,7 @@ int32 OS_TaskDelete (uint32 task_id)
     /* 
     ** Check to see if the task_id given is valid 
     */
-    if (task_id >= OS_MAX_TASKS || OS_task_table[task_id].free == TRUE)
+    if (task_id >= OS_task_table.num_records || OS_TASK_RECORD(task_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
@@ -583,16 +949,16 @@ int32 OS_TaskDelete (uint32 task_id)
     /*
     ** Call the thread Delete hook if there is one.
     */
-    if ( OS_task_table[task_id].delete_hook_pointer != NULL)
+    if ( OS_TASK_RECORD(task_id)->delete_hook_pointer != NULL)
     {
-       FunctionPointer = (FuncPtr_t)(OS_task_table[task_id].delete_hook_pointer);
+       FunctionPointer = (FuncPtr_t)(OS_TASK_RECORD(task_id)->delete_hook_pointer);
        (*FunctionPointer)();
     }
 
     /* 
     ** Try to delete the task 
     */
-    ret = pthread_cancel(OS_task_table[task_id].id);
+    ret = pthread_cancel(OS_TASK_RECORD(task_id)->id);
     if (ret != 0)
     {
         /*debugging statement only*/
@@ -606,16 +972,23 @@ int32 OS_TaskDelete (uint32 task_id)
     */
     pthread_mutex_lock(&OS_task_table_mut); 
 
-    OS_task_table[task_id].free = TRUE;
-    strcpy(OS_task_table[task_id].name, "");
-    OS_task_table[task_id].creator = UNINITIALIZED;
-    OS_task_table[task_id].stack_size = UNINITIALIZED;
-    OS_task_table[task_id].priority = UNINITIALIZED;    
-    OS_task_table[task_id].id = UNINITIALIZED;
-    OS_task_table[task_id].delete_hook_pointer = NULL;
+    OS_NameIndexRemove(OS_OBJECT_TYPE_TASK, OS_TASK_RECORD(task_id)->name);
+    OS_TASK_RECORD(task_id)->free = TRUE;
+    strcpy(OS_TASK_RECORD(task_id)->name, "");
+    OS_TASK_RECORD(task_id)->creator = UNINITIALIZED;
+    OS_TASK_RECORD(task_id)->stack_size = UNINITIALIZED;
+    OS_TASK_RECORD(task_id)->priority = UNINITIALIZED;    
+    OS_TASK_RECORD(task_id)->id = UNINITIALIZED;
+    OS_TASK_RECORD(task_id)->delete_hook_pointer = NULL;
+    OS_TASK_RECORD(task_id)->entry_function = NULL;
     
     pthread_mutex_unlock(&OS_task_table_mut);
 
+    /* before the task id can be taken by a new task */
+    OS_ArenaDeleteByTask(task_id);
+
+    OS_ObjectRelease(&OS_task_table, task_id);
+
     return OS_SUCCESS;
     
 }/* end OS_TaskDelete */
@@ -632,20 +1005,36 @@ void OS_TaskExit()
 {
     uint32 task_id;
 
-    task_id = OS_TaskGetId();
+    /*
+    ** A thread that is not an OSAL task has nothing to give back. Its
+    ** thread key is not set, OS_TaskGetId would take it for task 0.
+    */
+    task_id = OS_FindCreator();
+    if ( task_id >= OS_api_config.max_tasks )
+    {
+        pthread_exit(NULL);
+    }
 
     pthread_mutex_lock(&OS_task_table_mut); 
 
-    OS_task_table[task_id].free = TRUE;
-    strcpy(OS_task_table[task_id].name, "");
-    OS_task_table[task_id].creator = UNINITIALIZED;
-    OS_task_table[task_id].stack_size = UNINITIALIZED;
-    OS_task_table[task_id].priority = UNINITIALIZED;
-    OS_task_table[task_id].id = UNINITIALIZED;
-    OS_task_table[task_id].delete_hook_pointer = NULL;
+    OS_NameIndexRemove(OS_OBJECT_TYPE_TASK, OS_TASK_RECORD(task_id)->name);
+    OS_TASK_RECORD(task_id)->free = TRUE;
+    strcpy(OS_TASK_RECORD(task_id)->name, "");
+    OS_TASK_RECORD(task_id)->creator = UNINITIALIZED;
+    OS_TASK_RECORD(task_id)->stack_size = UNINITIALIZED;
+    OS_TASK_RECORD(task_id)->priority = UNINITIALIZED;
+    OS_TASK_RECORD(task_id)->id = UNINITIALIZED;
+    OS_TASK_RECORD(task_id)->delete_hook_pointer = NULL;
+    OS_TASK_RECORD(task_id)->entry_function = NULL;
     
     pthread_mutex_unlock(&OS_task_table_mut);
 
+    /* before the task id can be taken by a new task */
+    OS_ArenaDeleteByTask(task_id);
+
+    OS_ObjectRelease(&OS_task_table, task_id);
+
+    pthread_setspecific(thread_key, NULL);
     pthread_exit(NULL);
 
 }/*end OS_TaskExit */
@@ -683,11 +1072,11 @@ int32 OS_TaskDelay(uint32 millisecond )
 ---------------------------------------------------------------------------------------*/
 int32 OS_TaskSetPriority (uint32 task_id, uint32 new_priority)
 {
-    pthread_attr_t     custom_attr ;
     struct sched_param priority_holder ;
     int                os_priority;
+    int                ret;
 
-    if(task_id >= OS_MAX_TASKS || OS_task_table[task_id].free == TRUE)
+    if(task_id >= OS_task_table.num_records || OS_TASK_RECORD(task_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
@@ -701,18 +1090,21 @@ int32 OS_TaskSetPriority (uint32 task_id, uint32 new_priority)
     os_priority = OS_PriorityRemap(new_priority);
 
     /* 
-    ** Set priority
+    ** Set priority. Without the privilege to use SCHED_FIFO the task keeps
+    ** the policy of its creator, as in OS_TaskCreate.
     */
+    memset(&priority_holder, 0, sizeof(priority_holder));
     priority_holder.sched_priority = os_priority ;
-    if(pthread_attr_setschedparam(&custom_attr,&priority_holder))
+    ret = pthread_setschedparam(OS_TASK_RECORD(task_id)->id, SCHED_FIFO, &priority_holder);
+    if(ret != 0 && ret != EPERM)
     {
-       printf("pthread_attr_setschedparam error in OS_TaskSetPriority, Task ID = %lu\n",task_id);
+       printf("pthread_setschedparam error in OS_TaskSetPriority, Task ID = %lu\n",(unsigned long)task_id);
        return(OS_ERROR);
     }
 
     /* Use the abstracted priority, not the OS one */
     /* Change the priority in the table as well */
-    OS_task_table[task_id].priority = new_priority;
+    OS_TASK_RECORD(task_id)->priority = new_priority;
 
    return OS_SUCCESS;
 } /* end OS_TaskSetPriority */
@@ -722,7 +1114,8 @@ int32 OS_TaskSetPriority (uint32 task_id, uint32 new_priority)
    Name: OS_TaskRegister
   
    Purpose: Registers the calling task id with the task by adding the var to the tcb
-            It searches the OS_task_table to find the task_id corresponding to the tcb_id
+            Tasks created with OS_TaskCreate are registered when they start, so this
+            only searches the OS_task_table for threads that are not registered yet.
             
    Returns: OS_ERR_INVALID_ID if there the specified ID could not be found
             OS_ERROR if the OS call fails
@@ -735,6 +1128,14 @@ int32 OS_TaskRegister (void)
     uint32       task_id;
     pthread_t    pthread_id;
 
+    /*
+    ** Nothing to do if the thread already carries its task ID
+    */
+    if ( pthread_getspecific(thread_key) != NULL )
+    {
+       return OS_SUCCESS;
+    }
+
     /* 
     ** Get PTHREAD Id
     */
@@ -743,16 +1144,17 @@ int32 OS_TaskRegister (void)
     /*
     ** Look our task ID in table 
     */
-    for(i = 0; i < OS_MAX_TASKS; i++)
+    for(i = 0; i < OS_task_table.num_records; i++)
     {
-       if(OS_task_table[i].id == pthread_id)
+       if((OS_TASK_RECORD(i)->free == FALSE) && 
+          (pthread_equal(OS_TASK_RECORD(i)->id, pthread_id) != 0))
        {
           break;
        }
     }
     task_id = i;
 
-    if(task_id == OS_MAX_TASKS)
+    if(task_id == OS_task_table.num_records)
     {
         return OS_ERR_INVALID_ID;
     }
@@ -760,7 +1162,7 @@ int32 OS_TaskRegister (void)
     /*
     ** Add pthread variable
     */
-    ret = pthread_setspecific(thread_key, (void *)task_id);
+    ret = pthread_setspecific(thread_key, (void *)(unsigned long)(task_id + 1));
     if ( ret != 0 )
     {
        printf("OS_TaskRegister Failed during pthread_setspecific function\n");
@@ -775,23 +1177,21 @@ int32 OS_TaskRegister (void)
 
    Purpose: This function returns the #defined task id of the calling task
 
-   Notes: The OS_task_key is initialized by the task switch if AND ONLY IF the 
-          OS_task_key has been registered via OS_TaskRegister(..).  If this is not 
-          called prior to this call, the value will be old and wrong.
+   Notes: The task ID is read from the thread specific data set up when the task
+          started ( or by OS_TaskRegister ), so no table search is needed. A thread
+          that was not created by the OSAL gets 0, as before.
 ---------------------------------------------------------------------------------------*/
 uint32 OS_TaskGetId (void)
 { 
-   void*   task_id;
-   int     task_id_int;
-   uint32   task_key;
-   task_key = 0;
+   unsigned long task_key;
    
-   task_id = (void *)pthread_getspecific(thread_key);
-
-   memcpy(& task_id_int,&task_id, sizeof(uint32));
-   task_key = task_id_int & 0xFFFF;
+   task_key = (unsigned long)pthread_getspecific(thread_key);
+   if ( task_key == 0 )
+   {
+      return(0);
+   }
    
-   return(task_key);
+   return((uint32)(task_key - 1));
 }/* end OS_TaskGetId */
 
 /*--------------------------------------------------------------------------------------
@@ -822,14 +1222,12 @@ int32 OS_TaskGetIdByName (uint32 *task_id, const char *task_name)
        return OS_ERR_NAME_TOO_LONG;
     }
 
-    for (i = 0; i < OS_MAX_TASKS; i++)
+    if ((OS_NameIndexFind(OS_OBJECT_TYPE_TASK, task_name, &i) == OS_SUCCESS) &&
+        (OS_TASK_RECORD(i)->free != TRUE) &&
+        (strcmp(OS_TASK_RECORD(i)->name,(char*) task_name) == 0 ))
     {
-        if((OS_task_table[i].free != TRUE) &&
-                (strcmp(OS_task_table[i].name,(char*) task_name) == 0 ))
-        {
-            *task_id = i;
-            return OS_SUCCESS;
-        }
+        *task_id = i;
+        return OS_SUCCESS;
     }
     /* The name was not found in the table,
     **  or it was, and the task_id isn't valid anymore 
@@ -855,7 +1253,7 @@ int32 OS_TaskGetInfo (uint32 task_id, OS_task_prop_t *task_prop)
     /* 
     ** Check to see that the id given is valid 
     */
-    if (task_id >= OS_MAX_TASKS || OS_task_table[task_id].free == TRUE)
+    if (task_id >= OS_task_table.num_records || OS_TASK_RECORD(task_id)->free == TRUE)
     {
        return OS_ERR_INVALID_ID;
     }
@@ -868,12 +1266,12 @@ int32 OS_TaskGetInfo (uint32 task_id, OS_task_prop_t *task_prop)
     /* put the info into the stucture */
     pthread_mutex_lock(&OS_task_table_mut); 
 
-    task_prop -> creator =    OS_task_table[task_id].creator;
-    task_prop -> stack_size = OS_task_table[task_id].stack_size;
-    task_prop -> priority =   OS_task_table[task_id].priority;
-    task_prop -> OStask_id =  (uint32) OS_task_table[task_id].id;
+    task_prop -> creator =    OS_TASK_RECORD(task_id)->creator;
+    task_prop -> stack_size = OS_TASK_RECORD(task_id)->stack_size;
+    task_prop -> priority =   OS_TASK_RECORD(task_id)->priority;
+    task_prop -> OStask_id =  (uint32) OS_TASK_RECORD(task_id)->id;
     
-    strcpy(task_prop-> name, OS_task_table[task_id].name);
+    strcpy(task_prop-> name, OS_TASK_RECORD(task_id)->name);
 
     pthread_mutex_unlock(&OS_task_table_mut);
     
@@ -895,14 +1293,14 @@ int32 OS_TaskInstallDeleteHandler(void *function_pointer)
 
     task_id = OS_TaskGetId();
 
-    if ( task_id >= OS_MAX_TASKS )
+    if ( task_id >= OS_task_table.num_records )
     {
        return(OS_ERR_INVALID_ID);
     }
 
     pthread_mutex_lock(&OS_task_table_mut); 
 
-    if ( OS_task_table[task_id].free != FALSE )
+    if ( OS_TASK_RECORD(task_id)->free != FALSE )
     {
        /* 
        ** Somehow the calling task is not registered 
@@ -914,7 +1312,7 @@ int32 OS_TaskInstallDeleteHandler(void *function_pointer)
     /*
     ** Install the pointer
     */
-    OS_task_table[task_id].delete_hook_pointer = function_pointer;    
+    OS_TASK_RECORD(task_id)->delete_hook_pointer = function_pointer;    
     
     pthread_mutex_unlock(&OS_task_table_mut);
 
@@ -949,9 +1347,10 @@ int32 OS_BinSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initial_
                         uint32 options)
 {
     uint32              possible_semid;
-    uint32              i;
     int                 Status;
+#ifndef OS_USE_FUTEX_SEMAPHORES
     pthread_mutexattr_t mutex_attr;    
+#endif
 
     /* 
     ** Check Parameters 
@@ -969,32 +1368,19 @@ int32 OS_BinSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initial_
         return OS_ERR_NAME_TOO_LONG;
     }
 
-    /* Lock table */
-    pthread_mutex_lock(&OS_bin_sem_table_mut);  
-
-    for (possible_semid = 0; possible_semid < OS_MAX_BIN_SEMAPHORES; possible_semid++)
-    {
-        if (OS_bin_sem_table[possible_semid].free == TRUE)    
-            break;
-    }
-
-    if((possible_semid >= OS_MAX_BIN_SEMAPHORES) ||  
-       (OS_bin_sem_table[possible_semid].free != TRUE))
+    /* Take a free semaphore Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_bin_sem_table, &possible_semid) != OS_SUCCESS )
     {
-        pthread_mutex_unlock(&OS_bin_sem_table_mut);
         return OS_ERR_NO_FREE_IDS;
     }
     
-    /* Check to see if the name is already taken */
-    for (i = 0; i < OS_MAX_BIN_SEMAPHORES; i++)
+    /* Check to see if the name is already taken, and reserve it */
+    Status = OS_NameIndexAdd(OS_OBJECT_TYPE_BINSEM, sem_name, possible_semid);
+    if ( Status != OS_SUCCESS )
     {
-        if ((OS_bin_sem_table[i].free == FALSE) &&
-                strcmp ((char*) sem_name, OS_bin_sem_table[i].name) == 0)
-        {
-            pthread_mutex_unlock(&OS_bin_sem_table_mut);
-            return OS_ERR_NAME_TAKEN;
-        }
-    }  
+        OS_ObjectRelease(&OS_bin_sem_table, possible_semid);
+        return Status;
+    }
 
     /* 
     ** Check to make sure the value is 0 or 1 
@@ -1008,6 +1394,24 @@ int32 OS_BinSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initial_
         sem_initial_value = 1;
     }
 
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    OS_FutexSemInit(&(OS_BIN_SEM_RECORD(possible_semid)->sem), sem_initial_value, 1);
+
+    *sem_id = possible_semid;
+
+    /* Lock table */
+    pthread_mutex_lock(&OS_bin_sem_table_mut);
+
+    strcpy(OS_BIN_SEM_RECORD(*sem_id)->name , (char*) sem_name);
+    OS_BIN_SEM_RECORD(*sem_id)->creator = OS_FindCreator();
+    OS_BIN_SEM_RECORD(*sem_id)->max_value = 1;
+    OS_BIN_SEM_RECORD(*sem_id)->free = FALSE;
+
+    /* Unlock table */
+    pthread_mutex_unlock(&OS_bin_sem_table_mut);
+
+    return OS_SUCCESS;
+#else
     /* 
     ** Initialize the pthread mutex attribute structure with default values 
     */
@@ -1024,13 +1428,13 @@ int32 OS_BinSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initial_
           /*
           ** Initialize the mutex that is used with the condition variable
           */
-          Status = pthread_mutex_init(&(OS_bin_sem_table[possible_semid].id), &mutex_attr);
+          Status = pthread_mutex_init(&(OS_BIN_SEM_RECORD(possible_semid)->id), &mutex_attr);
           if( Status == 0 )
           {
              /*
              ** Initialize the condition variable
              */
-             Status = pthread_cond_init(&(OS_bin_sem_table[possible_semid].cv), NULL);
+             Status = pthread_cond_init(&(OS_BIN_SEM_RECORD(possible_semid)->cv), NULL);
              if ( Status == 0 )
              {
                 /*
@@ -1038,12 +1442,15 @@ int32 OS_BinSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initial_
                 */
                 *sem_id = possible_semid;
 
-                strcpy(OS_bin_sem_table[*sem_id].name , (char*) sem_name);
-                OS_bin_sem_table[*sem_id].creator = OS_FindCreator();
+                /* Lock table */
+                pthread_mutex_lock(&OS_bin_sem_table_mut);
+
+                strcpy(OS_BIN_SEM_RECORD(*sem_id)->name , (char*) sem_name);
+                OS_BIN_SEM_RECORD(*sem_id)->creator = OS_FindCreator();
     
-                OS_bin_sem_table[*sem_id].max_value = 1;
-                OS_bin_sem_table[*sem_id].current_value = sem_initial_value;
-                OS_bin_sem_table[*sem_id].free = FALSE;
+                OS_BIN_SEM_RECORD(*sem_id)->max_value = 1;
+                OS_BIN_SEM_RECORD(*sem_id)->current_value = sem_initial_value;
+                OS_BIN_SEM_RECORD(*sem_id)->free = FALSE;
    
                 /* Unlock table */ 
                 pthread_mutex_unlock(&OS_bin_sem_table_mut);
@@ -1052,32 +1459,37 @@ int32 OS_BinSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initial_
              } 
              else
              {
-                pthread_mutex_unlock(&OS_bin_sem_table_mut);
+                OS_NameIndexRemove(OS_OBJECT_TYPE_BINSEM, sem_name);
+                OS_ObjectRelease(&OS_bin_sem_table, possible_semid);
                 printf("Error: pthread_cond_init failed\n");
                 return (OS_SEM_FAILURE);
              }
           }
           else
           {
-             pthread_mutex_unlock(&OS_bin_sem_table_mut);
+             OS_NameIndexRemove(OS_OBJECT_TYPE_BINSEM, sem_name);
+             OS_ObjectRelease(&OS_bin_sem_table, possible_semid);
              printf("Error: pthread_mutex_init failed\n");
              return (OS_SEM_FAILURE);
           }
       }
       else
       {
-          pthread_mutex_unlock(&OS_bin_sem_table_mut);
+          OS_NameIndexRemove(OS_OBJECT_TYPE_BINSEM, sem_name);
+          OS_ObjectRelease(&OS_bin_sem_table, possible_semid);
           printf("Error: pthread_mutexattr_setprotocol failed\n");
           return (OS_SEM_FAILURE);
       }
    }
    else
    {
-      pthread_mutex_unlock(&OS_bin_sem_table_mut);
+      OS_NameIndexRemove(OS_OBJECT_TYPE_BINSEM, sem_name);
+      OS_ObjectRelease(&OS_bin_sem_table, possible_semid);
       printf("Error: pthread_mutexattr_init failed\n");
       return (OS_SEM_FAILURE);
    }
-            
+#endif
+
 }/* end OS_BinSemCreate */
 
 /*--------------------------------------------------------------------------------------
@@ -1096,7 +1508,7 @@ int32 OS_BinSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initial_
 int32 OS_BinSemDelete (uint32 sem_id)
 {
     /* Check to see if this sem_id is valid */
-    if (sem_id >= OS_MAX_BIN_SEMAPHORES || OS_bin_sem_table[sem_id].free == TRUE)
+    if (sem_id >= OS_bin_sem_table.num_records || OS_BIN_SEM_RECORD(sem_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
@@ -1105,16 +1517,27 @@ int32 OS_BinSemDelete (uint32 sem_id)
     pthread_mutex_lock(&OS_bin_sem_table_mut);  
    
     /* Remove the Id from the table, and its name, so that it cannot be found again */
-    pthread_mutex_destroy(&(OS_bin_sem_table[sem_id].id));
-    pthread_cond_destroy(&(OS_bin_sem_table[sem_id].cv));
-    OS_bin_sem_table[sem_id].free = TRUE;
-    strcpy(OS_bin_sem_table[sem_id].name , "");
-    OS_bin_sem_table[sem_id].creator = UNINITIALIZED;
-    OS_bin_sem_table[sem_id].max_value = 0;
-    OS_bin_sem_table[sem_id].current_value = 0;
+#ifndef OS_USE_FUTEX_SEMAPHORES
+    pthread_mutex_destroy(&(OS_BIN_SEM_RECORD(sem_id)->id));
+    pthread_cond_destroy(&(OS_BIN_SEM_RECORD(sem_id)->cv));
+#endif
+    OS_NameIndexRemove(OS_OBJECT_TYPE_BINSEM, OS_BIN_SEM_RECORD(sem_id)->name);
+    OS_BIN_SEM_RECORD(sem_id)->free = TRUE;
+    strcpy(OS_BIN_SEM_RECORD(sem_id)->name , "");
+    OS_BIN_SEM_RECORD(sem_id)->creator = UNINITIALIZED;
+    OS_BIN_SEM_RECORD(sem_id)->max_value = 0;
+    OS_BIN_SEM_RECORD(sem_id)->current_value = 0;
+    if ( OS_BIN_SEM_RECORD(sem_id)->wait_fd >= 0 )
+    {
+        close(OS_BIN_SEM_RECORD(sem_id)->wait_fd);
+        OS_BIN_SEM_RECORD(sem_id)->wait_fd = -1;
+    }
+    OS_EventFdClose(&(OS_BIN_SEM_RECORD(sem_id)->event));
 
     /* Unlock table */
     pthread_mutex_unlock(&OS_bin_sem_table_mut);
+
+    OS_ObjectRelease(&OS_bin_sem_table, sem_id);
    
     return OS_SUCCESS;
 
@@ -1140,15 +1563,29 @@ int32 OS_BinSemDelete (uint32 sem_id)
 int32 OS_BinSemGive ( uint32 sem_id )
 {
     int    ret;
-   
+
     /* Check Parameters */
-    if(sem_id >= OS_MAX_BIN_SEMAPHORES || OS_bin_sem_table[sem_id].free == TRUE)
+    if(sem_id >= OS_bin_sem_table.num_records || OS_BIN_SEM_RECORD(sem_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
 
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    ret = OS_FutexSemGive(&(OS_BIN_SEM_RECORD(sem_id)->sem));
+
+    /* The give is a full barrier, see OS_WaitAny */
+    if ( OS_BIN_SEM_RECORD(sem_id)->any_waiters != 0 )
+    {
+        OS_WaitAnyNotify(OS_BIN_SEM_RECORD(sem_id)->wait_fd);
+    }
+    if ( OS_BIN_SEM_RECORD(sem_id)->event.fd >= 0 )
+    {
+        OS_EventFdSignal(&(OS_BIN_SEM_RECORD(sem_id)->event));
+    }
+    return(ret);
+#else
     /* Lock the mutex ( not the table! ) */    
-    ret = pthread_mutex_lock(&(OS_bin_sem_table[sem_id].id));
+    ret = pthread_mutex_lock(&(OS_BIN_SEM_RECORD(sem_id)->id));
     if ( ret != 0 )
     {
        return(OS_SEM_FAILURE);
@@ -1157,14 +1594,23 @@ int32 OS_BinSemGive ( uint32 sem_id )
     /* 
     ** If the sem value is not full ( 1 ) then increment it.
     */
-    if ( OS_bin_sem_table[sem_id].current_value  < OS_bin_sem_table[sem_id].max_value )
-    {
-         OS_bin_sem_table[sem_id].current_value ++;
-         pthread_cond_signal(&(OS_bin_sem_table[sem_id].cv));
+    if ( OS_BIN_SEM_RECORD(sem_id)->current_value  < OS_BIN_SEM_RECORD(sem_id)->max_value )
+    {
+         OS_BIN_SEM_RECORD(sem_id)->current_value ++;
+         pthread_cond_signal(&(OS_BIN_SEM_RECORD(sem_id)->cv));
+         if ( OS_BIN_SEM_RECORD(sem_id)->any_waiters != 0 )
+         {
+             OS_WaitAnyNotify(OS_BIN_SEM_RECORD(sem_id)->wait_fd);
+         }
+         if ( OS_BIN_SEM_RECORD(sem_id)->event.fd >= 0 )
+         {
+             OS_EventFdSignal(&(OS_BIN_SEM_RECORD(sem_id)->event));
+         }
     }
 
-    pthread_mutex_unlock(&(OS_bin_sem_table[sem_id].id));
+    pthread_mutex_unlock(&(OS_BIN_SEM_RECORD(sem_id)->id));
     return (OS_SUCCESS);
+#endif
 
 }/* end OS_BinSemGive */
 
@@ -1183,17 +1629,22 @@ int32 OS_BinSemGive ( uint32 sem_id )
 ---------------------------------------------------------------------------------------*/
 int32 OS_BinSemFlush (uint32 sem_id)
 {
+#ifndef OS_USE_FUTEX_SEMAPHORES
     uint32 ret_val;
     int32  ret = 0;
+#endif
 
     /* Check Parameters */
-    if(sem_id >= OS_MAX_BIN_SEMAPHORES || OS_bin_sem_table[sem_id].free == TRUE)
+    if(sem_id >= OS_bin_sem_table.num_records || OS_BIN_SEM_RECORD(sem_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
 
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    return(OS_FutexSemFlush(&(OS_BIN_SEM_RECORD(sem_id)->sem)));
+#else
     /* Lock the mutex ( not the table! ) */    
-    ret = pthread_mutex_lock(&(OS_bin_sem_table[sem_id].id));
+    ret = pthread_mutex_lock(&(OS_BIN_SEM_RECORD(sem_id)->id));
     if ( ret != 0 )
     {
        return(OS_SEM_FAILURE);
@@ -1202,19 +1653,24 @@ int32 OS_BinSemFlush (uint32 sem_id)
     /* 
     ** Release all threads waiting on the binary semaphore 
     */
-    ret = pthread_cond_broadcast(&(OS_bin_sem_table[sem_id].cv));
+    ret = pthread_cond_broadcast(&(OS_BIN_SEM_RECORD(sem_id)->cv));
     if ( ret == 0 )
     {
        ret_val = OS_SUCCESS ;
-       OS_bin_sem_table[sem_id].current_value = OS_bin_sem_table[sem_id].max_value;
+       OS_BIN_SEM_RECORD(sem_id)->current_value = OS_BIN_SEM_RECORD(sem_id)->max_value;
+       if ( OS_BIN_SEM_RECORD(sem_id)->event.fd >= 0 )
+       {
+           OS_EventFdSignal(&(OS_BIN_SEM_RECORD(sem_id)->event));
+       }
     }
     else
     {
        ret_val = OS_SEM_FAILURE;
     }
-    ret = pthread_mutex_unlock(&(OS_bin_sem_table[sem_id].id));
+    ret = pthread_mutex_unlock(&(OS_BIN_SEM_RECORD(sem_id)->id));
 
     return(ret_val);
+#endif
 
 }/* end OS_BinSemFlush */
 
@@ -1235,16 +1691,23 @@ int32 OS_BinSemFlush (uint32 sem_id)
 int32 OS_BinSemTake ( uint32 sem_id )
 {
     uint32 ret_val;
+#ifndef OS_USE_FUTEX_SEMAPHORES
     int    ret;
+#endif
    
     /* Check parameters */ 
-    if(sem_id >= OS_MAX_BIN_SEMAPHORES  || OS_bin_sem_table[sem_id].free == TRUE)
+    if(sem_id >= OS_bin_sem_table.num_records  || OS_BIN_SEM_RECORD(sem_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
-        
+
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    ret_val = OS_FutexSemTake(&(OS_BIN_SEM_RECORD(sem_id)->sem), NULL);
+    OS_BinSemEventDrain(sem_id);
+    return(ret_val);
+#else
     /* Lock the mutex */    
-    ret = pthread_mutex_lock(&(OS_bin_sem_table[sem_id].id));
+    ret = pthread_mutex_lock(&(OS_BIN_SEM_RECORD(sem_id)->id));
     if ( ret != 0 )
     {
        return(OS_SEM_FAILURE);
@@ -1255,21 +1718,21 @@ int32 OS_BinSemTake ( uint32 sem_id )
     ** wait until it is available
     ** If the value is max (1), then grab the resource without waiting
     */
-    if ( OS_bin_sem_table[sem_id].current_value < OS_bin_sem_table[sem_id].max_value )
+    if ( OS_BIN_SEM_RECORD(sem_id)->current_value < OS_BIN_SEM_RECORD(sem_id)->max_value )
     {
        /*
        ** Wait on the condition variable. Calling this function unlocks the mutex and 
        ** re-aquires the mutex when the function returns. This allows the function that
        ** calls the pthread_cond_signal or pthread_cond_broadcast to aquire the mutex
        */
-       ret = pthread_cond_wait(&(OS_bin_sem_table[sem_id].cv),&(OS_bin_sem_table[sem_id].id));
+       ret = pthread_cond_wait(&(OS_BIN_SEM_RECORD(sem_id)->cv),&(OS_BIN_SEM_RECORD(sem_id)->id));
        if ( ret == 0 )
        {
           ret_val = OS_SUCCESS;
           /*
           ** Decrement the counter
           */
-          OS_bin_sem_table[sem_id].current_value --;
+          OS_BIN_SEM_RECORD(sem_id)->current_value --;
        }
        else
        {
@@ -1279,14 +1742,17 @@ int32 OS_BinSemTake ( uint32 sem_id )
     }
     else
     {
-       OS_bin_sem_table[sem_id].current_value --;
+       OS_BIN_SEM_RECORD(sem_id)->current_value --;
        ret_val = OS_SUCCESS;
     }
 
+    OS_BinSemEventDrain(sem_id);
+
     /* Unlock the mutex */
-    pthread_mutex_unlock(&(OS_bin_sem_table[sem_id].id));
+    pthread_mutex_unlock(&(OS_BIN_SEM_RECORD(sem_id)->id));
     
     return (ret_val);
+#endif
 
 }/* end OS_BinSemTake */
 
@@ -1307,11 +1773,13 @@ int32 OS_BinSemTake ( uint32 sem_id )
 ----------------------------------------------------------------------------------------*/
 int32 OS_BinSemTimedWait ( uint32 sem_id, uint32 msecs )
 {
+#ifndef OS_USE_FUTEX_SEMAPHORES
     int              ret;
+#endif
     uint32           ret_val;
     struct timespec  ts;
 
-    if( (sem_id >= OS_MAX_BIN_SEMAPHORES) || (OS_bin_sem_table[sem_id].free == TRUE) )
+    if( (sem_id >= OS_bin_sem_table.num_records) || (OS_BIN_SEM_RECORD(sem_id)->free == TRUE) )
     {
        return OS_ERR_INVALID_ID;
     }
@@ -1321,8 +1789,13 @@ int32 OS_BinSemTimedWait ( uint32 sem_id, uint32 msecs )
     */
     ret_val = OS_CompAbsDelayTime(msecs, &ts);
 
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    ret_val = OS_FutexSemTake(&(OS_BIN_SEM_RECORD(sem_id)->sem), &ts);
+    OS_BinSemEventDrain(sem_id);
+    return(ret_val);
+#else
     /* Lock the mutex */    
-    ret = pthread_mutex_lock(&(OS_bin_sem_table[sem_id].id));
+    ret = pthread_mutex_lock(&(OS_BIN_SEM_RECORD(sem_id)->id));
     if ( ret != 0 )
     {
        return(OS_SEM_FAILURE);
@@ -1333,19 +1806,19 @@ int32 OS_BinSemTimedWait ( uint32 sem_id, uint32 msecs )
     ** wait until it is available
     ** If the value is max (1), then grab the resource
     */
-    if ( OS_bin_sem_table[sem_id].current_value < OS_bin_sem_table[sem_id].max_value )
+    if ( OS_BIN_SEM_RECORD(sem_id)->current_value < OS_BIN_SEM_RECORD(sem_id)->max_value )
     {
        /*
        ** Wait on the condition variable. Calling this function unlocks the mutex and 
        ** re-aquires the mutex when the function returns. This allows the function that
        ** calls the pthread_cond_signal or pthread_cond_broadcast to aquire the mutex
        */
-       ret = pthread_cond_timedwait(&(OS_bin_sem_table[sem_id].cv), &(OS_bin_sem_table[sem_id].id), &ts);
+       ret = pthread_cond_timedwait(&(OS_BIN_SEM_RECORD(sem_id)->cv), &(OS_BIN_SEM_RECORD(sem_id)->id), &ts);
        if ( ret == 0 )
        {
           ret_val = OS_SUCCESS;
           /* Decrement the counter */
-          OS_bin_sem_table[sem_id].current_value --;
+          OS_BIN_SEM_RECORD(sem_id)->current_value --;
        }
        else if ( ret == ETIMEDOUT )
        {
@@ -1359,14 +1832,17 @@ int32 OS_BinSemTimedWait ( uint32 sem_id, uint32 msecs )
     }
     else
     {
-       OS_bin_sem_table[sem_id].current_value --;
+       OS_BIN_SEM_RECORD(sem_id)->current_value --;
        ret_val = OS_SUCCESS;
     }
 
+    OS_BinSemEventDrain(sem_id);
+
     /* Unlock the mutex */
-    pthread_mutex_unlock(&(OS_bin_sem_table[sem_id].id));
+    pthread_mutex_unlock(&(OS_BIN_SEM_RECORD(sem_id)->id));
 
     return ret_val;
+#endif
 }
 /*--------------------------------------------------------------------------------------
     Name: OS_BinSemGetIdByName
@@ -1399,14 +1875,12 @@ int32 OS_BinSemGetIdByName (uint32 *sem_id, const char *sem_name)
        return OS_ERR_NAME_TOO_LONG;
     }
 
-    for (i = 0; i < OS_MAX_BIN_SEMAPHORES; i++)
+    if ((OS_NameIndexFind(OS_OBJECT_TYPE_BINSEM, sem_name, &i) == OS_SUCCESS) &&
+        (OS_BIN_SEM_RECORD(i)->free != TRUE) &&
+        (strcmp (OS_BIN_SEM_RECORD(i)->name, (char*) sem_name) == 0))
     {
-        if (OS_bin_sem_table[i].free != TRUE &&
-                (strcmp (OS_bin_sem_table[i].name , (char*) sem_name) == 0))
-        {
-            *sem_id = i;
-            return OS_SUCCESS;
-        }
+        *sem_id = i;
+        return OS_SUCCESS;
     }
     /* 
     ** The name was not found in the table,
@@ -1430,7 +1904,7 @@ int32 OS_BinSemGetIdByName (uint32 *sem_id, const char *sem_name)
 int32 OS_BinSemGetInfo (uint32 sem_id, OS_bin_sem_prop_t *bin_prop)  
 {
     /* Check parameters */
-    if (sem_id >= OS_MAX_BIN_SEMAPHORES || OS_bin_sem_table[sem_id].free == TRUE)
+    if (sem_id >= OS_bin_sem_table.num_records || OS_BIN_SEM_RECORD(sem_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
@@ -1442,9 +1916,13 @@ int32 OS_BinSemGetInfo (uint32 sem_id, OS_bin_sem_prop_t *bin_prop)
     /* put the info into the stucture */
     pthread_mutex_lock(&OS_bin_sem_table_mut);  
 
-    bin_prop ->creator =    OS_bin_sem_table[sem_id].creator;
-    bin_prop -> value = OS_bin_sem_table[sem_id].current_value ;
-    strcpy(bin_prop-> name, OS_bin_sem_table[sem_id].name);
+    bin_prop ->creator =    OS_BIN_SEM_RECORD(sem_id)->creator;
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    bin_prop -> value = OS_FutexSemValue(&(OS_BIN_SEM_RECORD(sem_id)->sem));
+#else
+    bin_prop -> value = OS_BIN_SEM_RECORD(sem_id)->current_value ;
+#endif
+    strcpy(bin_prop-> name, OS_BIN_SEM_RECORD(sem_id)->name);
     
     pthread_mutex_unlock(&OS_bin_sem_table_mut);
 
@@ -1452,6 +1930,63 @@ int32 OS_BinSemGetInfo (uint32 sem_id, OS_bin_sem_prop_t *bin_prop)
     
 } /* end OS_BinSemGetInfo */
 
+/*---------------------------------------------------------------------------------------
+    Name: OS_BinSemGetEventFd
+
+    Purpose: Passes back a descriptor that is readable while the binary semaphore
+             can be taken, for a poll or epoll loop of the caller
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid semaphore
+             OS_INVALID_POINTER if fd is NULL
+             OS_SEM_FAILURE if the descriptor cannot be created
+             OS_SUCCESS if success
+
+    Notes: The descriptor belongs to the semaphore, it must not be read or closed,
+           and it is closed when the semaphore is deleted. It is only a hint: take
+           the semaphore with OS_BinSemTimedWait and a timeout of 0 once it polls
+           readable, which also clears it when another task took the semaphore
+           first.
+---------------------------------------------------------------------------------------*/
+int32 OS_BinSemGetEventFd (uint32 sem_id, int32 *fd)
+{
+    if (sem_id >= OS_bin_sem_table.num_records || OS_BIN_SEM_RECORD(sem_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if (fd == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( OS_EventFdOpen(&(OS_BIN_SEM_RECORD(sem_id)->event), &OS_bin_sem_table_mut) != OS_SUCCESS )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    /*
+    ** A give either sees the descriptor, or has raised the value checked here.
+    ** The pthread semaphores order the two with the mutex of the semaphore, the
+    ** futex gives are a full barrier.
+    */
+#ifndef OS_USE_FUTEX_SEMAPHORES
+    pthread_mutex_lock(OS_BIN_SEM_MUTEX(sem_id));
+#endif
+    __sync_synchronize();
+    if ( OS_BIN_SEM_VALUE(sem_id) > 0 )
+    {
+        OS_EventFdSignal(&(OS_BIN_SEM_RECORD(sem_id)->event));
+    }
+#ifndef OS_USE_FUTEX_SEMAPHORES
+    pthread_mutex_unlock(OS_BIN_SEM_MUTEX(sem_id));
+#endif
+
+    *fd = OS_BIN_SEM_RECORD(sem_id)->event.fd;
+
+    return OS_SUCCESS;
+
+} /* end OS_BinSemGetEventFd */
+
 /*---------------------------------------------------------------------------------------
    Name: OS_CountSemCreate
 
@@ -1474,9 +2009,10 @@ int32 OS_CountSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initia
                         uint32 options)
 {
     uint32              possible_semid;
-    uint32              i;
     int                 Status;
+#ifndef OS_USE_FUTEX_SEMAPHORES
     pthread_mutexattr_t mutex_attr;    
+#endif
 
     /* 
     ** Check Parameters 
@@ -1506,33 +2042,38 @@ int32 OS_CountSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initia
         return OS_INVALID_SEM_VALUE;
     }
 
-    /* Lock table */
-    pthread_mutex_lock(&OS_count_sem_table_mut);  
-
-    for (possible_semid = 0; possible_semid < OS_MAX_COUNT_SEMAPHORES; possible_semid++)
-    {
-        if (OS_count_sem_table[possible_semid].free == TRUE)    
-            break;
-    }
-
-    if((possible_semid >= OS_MAX_COUNT_SEMAPHORES) ||  
-       (OS_count_sem_table[possible_semid].free != TRUE))
+    /* Take a free semaphore Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_count_sem_table, &possible_semid) != OS_SUCCESS )
     {
-        pthread_mutex_unlock(&OS_count_sem_table_mut);
         return OS_ERR_NO_FREE_IDS;
     }
     
-    /* Check to see if the name is already taken */
-    for (i = 0; i < OS_MAX_COUNT_SEMAPHORES; i++)
+    /* Check to see if the name is already taken, and reserve it */
+    Status = OS_NameIndexAdd(OS_OBJECT_TYPE_COUNTSEM, sem_name, possible_semid);
+    if ( Status != OS_SUCCESS )
     {
-        if ((OS_count_sem_table[i].free == FALSE) &&
-                strcmp ((char*) sem_name, OS_count_sem_table[i].name) == 0)
-        {
-            pthread_mutex_unlock(&OS_count_sem_table_mut);
-            return OS_ERR_NAME_TAKEN;
-        }
-    }  
+        OS_ObjectRelease(&OS_count_sem_table, possible_semid);
+        return Status;
+    }
+
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    OS_FutexSemInit(&(OS_COUNT_SEM_RECORD(possible_semid)->sem), sem_initial_value, SEM_VALUE_MAX);
+
+    *sem_id = possible_semid;
+
+    /* Lock table */
+    pthread_mutex_lock(&OS_count_sem_table_mut);
+
+    strcpy(OS_COUNT_SEM_RECORD(*sem_id)->name , (char*) sem_name);
+    OS_COUNT_SEM_RECORD(*sem_id)->creator = OS_FindCreator();
+    OS_COUNT_SEM_RECORD(*sem_id)->max_value = SEM_VALUE_MAX;
+    OS_COUNT_SEM_RECORD(*sem_id)->free = FALSE;
+
+    /* Unlock table */
+    pthread_mutex_unlock(&OS_count_sem_table_mut);
 
+    return OS_SUCCESS;
+#else
     /* 
     ** Initialize the pthread mutex attribute structure with default values 
     */
@@ -1549,13 +2090,13 @@ int32 OS_CountSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initia
           /*
           ** Initialize the mutex that is used with the condition variable
           */
-          Status = pthread_mutex_init(&(OS_bin_sem_table[possible_semid].id), &mutex_attr);
+          Status = pthread_mutex_init(&(OS_COUNT_SEM_RECORD(possible_semid)->id), &mutex_attr);
           if( Status == 0 )
           {
              /*
              ** Initialize the condition variable
              */
-             Status = pthread_cond_init(&(OS_count_sem_table[possible_semid].cv), NULL);
+             Status = pthread_cond_init(&(OS_COUNT_SEM_RECORD(possible_semid)->cv), NULL);
              if ( Status == 0 )
              {
                 /*
@@ -1563,12 +2104,15 @@ int32 OS_CountSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initia
                 */
                 *sem_id = possible_semid;
 
-                strcpy(OS_count_sem_table[*sem_id].name , (char*) sem_name);
-                OS_count_sem_table[*sem_id].creator = OS_FindCreator();
+                /* Lock table */
+                pthread_mutex_lock(&OS_count_sem_table_mut);
+
+                strcpy(OS_COUNT_SEM_RECORD(*sem_id)->name , (char*) sem_name);
+                OS_COUNT_SEM_RECORD(*sem_id)->creator = OS_FindCreator();
     
-                OS_count_sem_table[*sem_id].max_value = SEM_VALUE_MAX;
-                OS_count_sem_table[*sem_id].current_value = sem_initial_value;
-                OS_count_sem_table[*sem_id].free = FALSE;
+                OS_COUNT_SEM_RECORD(*sem_id)->max_value = SEM_VALUE_MAX;
+                OS_COUNT_SEM_RECORD(*sem_id)->current_value = sem_initial_value;
+                OS_COUNT_SEM_RECORD(*sem_id)->free = FALSE;
    
                 /* Unlock table */ 
                 pthread_mutex_unlock(&OS_count_sem_table_mut);
@@ -1577,31 +2121,36 @@ int32 OS_CountSemCreate (uint32 *sem_id, const char *sem_name, uint32 sem_initia
              } 
              else
              {
-                pthread_mutex_unlock(&OS_count_sem_table_mut);
+                OS_NameIndexRemove(OS_OBJECT_TYPE_COUNTSEM, sem_name);
+                OS_ObjectRelease(&OS_count_sem_table, possible_semid);
                 printf("Error: pthread_cond_init failed\n");
                 return (OS_SEM_FAILURE);
              }
           }
           else
           {
-             pthread_mutex_unlock(&OS_count_sem_table_mut);
+             OS_NameIndexRemove(OS_OBJECT_TYPE_COUNTSEM, sem_name);
+             OS_ObjectRelease(&OS_count_sem_table, possible_semid);
              printf("Error: pthread_mutex_init failed\n");
              return (OS_SEM_FAILURE);
           }
       }
       else
       {
-          pthread_mutex_unlock(&OS_count_sem_table_mut);
+          OS_NameIndexRemove(OS_OBJECT_TYPE_COUNTSEM, sem_name);
+          OS_ObjectRelease(&OS_count_sem_table, possible_semid);
           printf("Error: pthread_mutexattr_setprotocol failed\n");
           return (OS_SEM_FAILURE);
       }
    }
    else
    {
-      pthread_mutex_unlock(&OS_count_sem_table_mut);
+      OS_NameIndexRemove(OS_OBJECT_TYPE_COUNTSEM, sem_name);
+      OS_ObjectRelease(&OS_count_sem_table, possible_semid);
       printf("Error: pthread_mutexattr_init failed\n");
       return (OS_SEM_FAILURE);
    }
+#endif
 
 }/* end OS_CountSemCreate */
 
@@ -1622,7 +2171,7 @@ int32 OS_CountSemDelete (uint32 sem_id)
 {
 
     /* Check to see if this sem_id is valid */
-    if (sem_id >= OS_MAX_COUNT_SEMAPHORES || OS_count_sem_table[sem_id].free == TRUE)
+    if (sem_id >= OS_count_sem_table.num_records || OS_COUNT_SEM_RECORD(sem_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
@@ -1631,16 +2180,27 @@ int32 OS_CountSemDelete (uint32 sem_id)
     pthread_mutex_lock(&OS_count_sem_table_mut);  
    
     /* Remove the Id from the table, and its name, so that it cannot be found again */
-    pthread_mutex_destroy(&(OS_count_sem_table[sem_id].id));
-    pthread_cond_destroy(&(OS_count_sem_table[sem_id].cv));
-    OS_count_sem_table[sem_id].free = TRUE;
-    strcpy(OS_count_sem_table[sem_id].name , "");
-    OS_count_sem_table[sem_id].creator = UNINITIALIZED;
-    OS_count_sem_table[sem_id].max_value = 0;
-    OS_count_sem_table[sem_id].current_value = 0;
+#ifndef OS_USE_FUTEX_SEMAPHORES
+    pthread_mutex_destroy(&(OS_COUNT_SEM_RECORD(sem_id)->id));
+    pthread_cond_destroy(&(OS_COUNT_SEM_RECORD(sem_id)->cv));
+#endif
+    OS_NameIndexRemove(OS_OBJECT_TYPE_COUNTSEM, OS_COUNT_SEM_RECORD(sem_id)->name);
+    OS_COUNT_SEM_RECORD(sem_id)->free = TRUE;
+    strcpy(OS_COUNT_SEM_RECORD(sem_id)->name , "");
+    OS_COUNT_SEM_RECORD(sem_id)->creator = UNINITIALIZED;
+    OS_COUNT_SEM_RECORD(sem_id)->max_value = 0;
+    OS_COUNT_SEM_RECORD(sem_id)->current_value = 0;
+    if ( OS_COUNT_SEM_RECORD(sem_id)->wait_fd >= 0 )
+    {
+        close(OS_COUNT_SEM_RECORD(sem_id)->wait_fd);
+        OS_COUNT_SEM_RECORD(sem_id)->wait_fd = -1;
+    }
+    OS_EventFdClose(&(OS_COUNT_SEM_RECORD(sem_id)->event));
 
     /* Unlock table */
     pthread_mutex_unlock(&OS_count_sem_table_mut);
+
+    OS_ObjectRelease(&OS_count_sem_table, sem_id);
    
     return OS_SUCCESS;
 
@@ -1667,35 +2227,55 @@ int32 OS_CountSemGive ( uint32 sem_id )
     int   ret;
    
     /* Check Parameters */
-    if(sem_id >= OS_MAX_COUNT_SEMAPHORES || OS_count_sem_table[sem_id].free == TRUE)
+    if(sem_id >= OS_count_sem_table.num_records || OS_COUNT_SEM_RECORD(sem_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
 
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    ret = OS_FutexSemGive(&(OS_COUNT_SEM_RECORD(sem_id)->sem));
+
+    /* The give is a full barrier, see OS_WaitAny */
+    if ( OS_COUNT_SEM_RECORD(sem_id)->any_waiters != 0 )
+    {
+        OS_WaitAnyNotify(OS_COUNT_SEM_RECORD(sem_id)->wait_fd);
+    }
+    if ( OS_COUNT_SEM_RECORD(sem_id)->event.fd >= 0 )
+    {
+        OS_EventFdSignal(&(OS_COUNT_SEM_RECORD(sem_id)->event));
+    }
+    return(ret);
+#else
     /* Lock the mutex ( not the table! ) */    
-    ret = pthread_mutex_lock(&(OS_count_sem_table[sem_id].id));
+    ret = pthread_mutex_lock(&(OS_COUNT_SEM_RECORD(sem_id)->id));
     if ( ret != 0 )
     {
        return(OS_SEM_FAILURE);
     }
     
     /* 
-    ** If the sem value is less than or equal to 0, there are waiters.
-    ** If the count is from 1 to max, there are no waiters
+    ** If the sem value is not at its max then increment it, and wake up
+    ** one of the waiters. Tasks may be waiting even when the value was
+    ** above 0, since a waiter only takes the sem once it runs again.
     */
-    if ( OS_count_sem_table[sem_id].current_value  <= 0 )
-    {
-         OS_count_sem_table[sem_id].current_value ++;
-         pthread_cond_signal(&(OS_count_sem_table[sem_id].cv));
-    }
-    else if ( OS_count_sem_table[sem_id].current_value  < OS_count_sem_table[sem_id].max_value )
-    {
-         OS_count_sem_table[sem_id].current_value ++;
+    if ( OS_COUNT_SEM_RECORD(sem_id)->current_value  < OS_COUNT_SEM_RECORD(sem_id)->max_value )
+    {
+         OS_COUNT_SEM_RECORD(sem_id)->current_value ++;
+         pthread_cond_signal(&(OS_COUNT_SEM_RECORD(sem_id)->cv));
+         if ( OS_COUNT_SEM_RECORD(sem_id)->any_waiters != 0 )
+         {
+             OS_WaitAnyNotify(OS_COUNT_SEM_RECORD(sem_id)->wait_fd);
+         }
+         if ( OS_COUNT_SEM_RECORD(sem_id)->event.fd >= 0 )
+         {
+             OS_EventFdSignal(&(OS_COUNT_SEM_RECORD(sem_id)->event));
+         }
     }
 
-    pthread_mutex_unlock(&(OS_count_sem_table[sem_id].id));
+    pthread_mutex_unlock(&(OS_COUNT_SEM_RECORD(sem_id)->id));
 
     return (OS_SUCCESS);
+#endif
 
 }/* end OS_CountSemGive */
 
@@ -1716,16 +2296,23 @@ int32 OS_CountSemGive ( uint32 sem_id )
 int32 OS_CountSemTake ( uint32 sem_id )
 {
     uint32 ret_val;
+#ifndef OS_USE_FUTEX_SEMAPHORES
     int    ret;
+#endif
    
     /* Check parameters */ 
-    if(sem_id >= OS_MAX_COUNT_SEMAPHORES  || OS_count_sem_table[sem_id].free == TRUE)
+    if(sem_id >= OS_count_sem_table.num_records  || OS_COUNT_SEM_RECORD(sem_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
-        
+
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    ret_val = OS_FutexSemTake(&(OS_COUNT_SEM_RECORD(sem_id)->sem), NULL);
+    OS_CountSemEventDrain(sem_id);
+    return(ret_val);
+#else
     /* Lock the mutex */    
-    ret = pthread_mutex_lock(&(OS_count_sem_table[sem_id].id));
+    ret = pthread_mutex_lock(&(OS_COUNT_SEM_RECORD(sem_id)->id));
     if ( ret != 0 )
     {
        return(OS_SEM_FAILURE);
@@ -1735,38 +2322,35 @@ int32 OS_CountSemTake ( uint32 sem_id )
     ** If the value is <= 0, then wait until the semaphore is available 
     ** If the value is > 1, then grab the resource without waiting
     */
-    if ( OS_count_sem_table[sem_id].current_value <= 0 )
+    ret = 0;
+    while ( OS_COUNT_SEM_RECORD(sem_id)->current_value <= 0 && ret == 0 )
     {
        /*
        ** Wait on the condition variable. Calling this function unlocks the mutex and 
        ** re-aquires the mutex when the function returns. This allows the function that
-       ** calls the pthread_cond_signal or pthread_cond_broadcast to aquire the mutex
+       ** calls the pthread_cond_signal or pthread_cond_broadcast to aquire the mutex.
+       ** Another task may have taken the sem first, so check the value again.
        */
-       ret = pthread_cond_wait(&(OS_count_sem_table[sem_id].cv),&(OS_count_sem_table[sem_id].id));
-       if ( ret == 0 )
-       {
-          ret_val = OS_SUCCESS;
-          /*
-          ** Decrement the counter
-          */
-          OS_count_sem_table[sem_id].current_value --;
-       }
-       else
-       {
-           ret_val = OS_SEM_FAILURE;
-       }
-
+       ret = pthread_cond_wait(&(OS_COUNT_SEM_RECORD(sem_id)->cv),&(OS_COUNT_SEM_RECORD(sem_id)->id));
     }
-    else /* Grab the sem */
+
+    if ( ret == 0 ) /* Grab the sem */
     {
-       OS_count_sem_table[sem_id].current_value --;
+       OS_COUNT_SEM_RECORD(sem_id)->current_value --;
        ret_val = OS_SUCCESS;
     }
+    else
+    {
+       ret_val = OS_SEM_FAILURE;
+    }
+
+    OS_CountSemEventDrain(sem_id);
 
     /* Unlock the mutex */
-    pthread_mutex_unlock(&(OS_count_sem_table[sem_id].id));
+    pthread_mutex_unlock(&(OS_COUNT_SEM_RECORD(sem_id)->id));
     
     return (ret_val);
+#endif
 
 }/* end OS_CountSemTake */
 
@@ -1787,11 +2371,13 @@ int32 OS_CountSemTake ( uint32 sem_id )
 ----------------------------------------------------------------------------------------*/
 int32 OS_CountSemTimedWait ( uint32 sem_id, uint32 msecs )
 {
+#ifndef OS_USE_FUTEX_SEMAPHORES
     int              ret;
+#endif
     uint32           ret_val;
     struct timespec  ts;
 
-    if( (sem_id >= OS_MAX_COUNT_SEMAPHORES) || (OS_count_sem_table[sem_id].free == TRUE) )
+    if( (sem_id >= OS_count_sem_table.num_records) || (OS_COUNT_SEM_RECORD(sem_id)->free == TRUE) )
     {
        return OS_ERR_INVALID_ID;
     }
@@ -1801,8 +2387,13 @@ int32 OS_CountSemTimedWait ( uint32 sem_id, uint32 msecs )
     */
     ret_val = OS_CompAbsDelayTime(msecs, &ts);
 
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    ret_val = OS_FutexSemTake(&(OS_COUNT_SEM_RECORD(sem_id)->sem), &ts);
+    OS_CountSemEventDrain(sem_id);
+    return(ret_val);
+#else
     /* Lock the mutex */    
-    ret = pthread_mutex_lock(&(OS_count_sem_table[sem_id].id));
+    ret = pthread_mutex_lock(&(OS_COUNT_SEM_RECORD(sem_id)->id));
     if ( ret != 0 )
     {
        return(OS_SEM_FAILURE);
@@ -1812,40 +2403,39 @@ int32 OS_CountSemTimedWait ( uint32 sem_id, uint32 msecs )
     ** If the value is <= 0, then wait until the semaphore is available 
     ** If the value is > 1, then grab the resource without waiting
     */
-    if ( OS_count_sem_table[sem_id].current_value <= 0 )
+    ret = 0;
+    while ( OS_COUNT_SEM_RECORD(sem_id)->current_value <= 0 && ret == 0 )
     {
        /*
        ** Wait on the condition variable. Calling this function unlocks the mutex and 
        ** re-aquires the mutex when the function returns. This allows the function that
-       ** calls the pthread_cond_signal or pthread_cond_broadcast to aquire the mutex
+       ** calls the pthread_cond_signal or pthread_cond_broadcast to aquire the mutex.
+       ** Another task may have taken the sem first, so check the value again.
        */
-       ret = pthread_cond_timedwait(&(OS_count_sem_table[sem_id].cv), &(OS_count_sem_table[sem_id].id), &ts);
-       if ( ret == 0 )
-       {
-          ret_val = OS_SUCCESS;
-          /* Decrement the counter */
-          OS_count_sem_table[sem_id].current_value --;
-       }
-       else if ( ret == ETIMEDOUT )
-       {
-          ret_val = OS_SEM_TIMEOUT;
-       }
-       else
-       {
-           ret_val = OS_SEM_FAILURE;
-       }
-
+       ret = pthread_cond_timedwait(&(OS_COUNT_SEM_RECORD(sem_id)->cv), &(OS_COUNT_SEM_RECORD(sem_id)->id), &ts);
     }
-    else /* Grab the sem */ 
+
+    if ( OS_COUNT_SEM_RECORD(sem_id)->current_value > 0 ) /* Grab the sem */
     {
-       OS_count_sem_table[sem_id].current_value --;
+       OS_COUNT_SEM_RECORD(sem_id)->current_value --;
        ret_val = OS_SUCCESS;
     }
+    else if ( ret == ETIMEDOUT )
+    {
+       ret_val = OS_SEM_TIMEOUT;
+    }
+    else
+    {
+       ret_val = OS_SEM_FAILURE;
+    }
+
+    OS_CountSemEventDrain(sem_id);
 
     /* Unlock the mutex */
-    pthread_mutex_unlock(&(OS_count_sem_table[sem_id].id));
+    pthread_mutex_unlock(&(OS_COUNT_SEM_RECORD(sem_id)->id));
 
     return ret_val;
+#endif
 }
 
 /*--------------------------------------------------------------------------------------
@@ -1878,14 +2468,12 @@ int32 OS_CountSemGetIdByName (uint32 *sem_id, const char *sem_name)
         return OS_ERR_NAME_TOO_LONG;
     }
 
-    for (i = 0; i < OS_MAX_COUNT_SEMAPHORES; i++)
+    if ((OS_NameIndexFind(OS_OBJECT_TYPE_COUNTSEM, sem_name, &i) == OS_SUCCESS) &&
+        (OS_COUNT_SEM_RECORD(i)->free != TRUE) &&
+        (strcmp (OS_COUNT_SEM_RECORD(i)->name, (char*) sem_name) == 0))
     {
-        if (OS_count_sem_table[i].free != TRUE &&
-                (strcmp (OS_count_sem_table[i].name , (char*) sem_name) == 0))
-        {
-            *sem_id = i;
-            return OS_SUCCESS;
-        }
+        *sem_id = i;
+        return OS_SUCCESS;
     }
     /* 
     ** The name was not found in the table,
@@ -1911,7 +2499,7 @@ int32 OS_CountSemGetInfo (uint32 sem_id, OS_count_sem_prop_t *count_prop)
     /* 
     ** Check to see that the id given is valid 
     */
-    if (sem_id >= OS_MAX_COUNT_SEMAPHORES || OS_count_sem_table[sem_id].free == TRUE)
+    if (sem_id >= OS_count_sem_table.num_records || OS_COUNT_SEM_RECORD(sem_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
@@ -1927,10 +2515,14 @@ int32 OS_CountSemGetInfo (uint32 sem_id, OS_count_sem_prop_t *count_prop)
     pthread_mutex_lock(&OS_count_sem_table_mut);  
     
     /* put the info into the stucture */
-    count_prop -> value = OS_count_sem_table[sem_id].current_value;
+#ifdef OS_USE_FUTEX_SEMAPHORES
+    count_prop -> value = OS_FutexSemValue(&(OS_COUNT_SEM_RECORD(sem_id)->sem));
+#else
+    count_prop -> value = OS_COUNT_SEM_RECORD(sem_id)->current_value;
+#endif
     
-    count_prop -> creator =    OS_count_sem_table[sem_id].creator;
-    strcpy(count_prop-> name, OS_count_sem_table[sem_id].name);
+    count_prop -> creator =    OS_COUNT_SEM_RECORD(sem_id)->creator;
+    strcpy(count_prop-> name, OS_COUNT_SEM_RECORD(sem_id)->name);
    
     /*
     ** Unlock
@@ -1940,76 +2532,548 @@ int32 OS_CountSemGetInfo (uint32 sem_id, OS_count_sem_prop_t *count_prop)
     return OS_SUCCESS;
     
 } /* end OS_CountSemGetInfo */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_CountSemGetEventFd
+
+    Purpose: Passes back a descriptor that is readable while the counting semaphore
+             can be taken, for a poll or epoll loop of the caller
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid semaphore
+             OS_INVALID_POINTER if fd is NULL
+             OS_SEM_FAILURE if the descriptor cannot be created
+             OS_SUCCESS if success
+
+    Notes: The descriptor belongs to the semaphore, it must not be read or closed,
+           and it is closed when the semaphore is deleted. It is only a hint: take
+           the semaphore with OS_CountSemTimedWait and a timeout of 0 once it polls
+           readable, which also clears it when another task took the semaphore
+           first.
+---------------------------------------------------------------------------------------*/
+int32 OS_CountSemGetEventFd (uint32 sem_id, int32 *fd)
+{
+    if (sem_id >= OS_count_sem_table.num_records || OS_COUNT_SEM_RECORD(sem_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if (fd == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( OS_EventFdOpen(&(OS_COUNT_SEM_RECORD(sem_id)->event), &OS_count_sem_table_mut) != OS_SUCCESS )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    /*
+    ** A give either sees the descriptor, or has raised the value checked here.
+    ** The pthread semaphores order the two with the mutex of the semaphore, the
+    ** futex gives are a full barrier.
+    */
+#ifndef OS_USE_FUTEX_SEMAPHORES
+    pthread_mutex_lock(OS_COUNT_SEM_MUTEX(sem_id));
+#endif
+    __sync_synchronize();
+    if ( OS_COUNT_SEM_VALUE(sem_id) > 0 )
+    {
+        OS_EventFdSignal(&(OS_COUNT_SEM_RECORD(sem_id)->event));
+    }
+#ifndef OS_USE_FUTEX_SEMAPHORES
+    pthread_mutex_unlock(OS_COUNT_SEM_MUTEX(sem_id));
+#endif
+
+    *fd = OS_COUNT_SEM_RECORD(sem_id)->event.fd;
+
+    return OS_SUCCESS;
+
+} /* end OS_CountSemGetEventFd */
 /****************************************************************************************
-                                  MUTEX API
+                                  EVENT FLAG API
 ****************************************************************************************/
 
+/* TRUE when the flags satisfy a wait for wait_flags in the given mode */
+#define OS_EVENT_FLAGS_MET(flags, wait_flags, mode) \
+    (((mode) & OS_EVENT_WAIT_ALL) ? (((flags) & (wait_flags)) == (wait_flags)) : \
+                                    (((flags) & (wait_flags)) != 0))
+
 /*---------------------------------------------------------------------------------------
-    Name: OS_MutSemCreate
+    Name: OS_EventFlagsCreate
 
-    Purpose: Creates a mutex semaphore initially full.
+    Purpose: Creates a group of 32 event flags, set to initial_flags. A task can
+             wait for any or all of a set of flags in one call.
 
-    Returns: OS_INVALID_POINTER if sem_id or sem_name are NULL
-             OS_ERR_NAME_TOO_LONG if the sem_name is too long to be stored
-             OS_ERR_NO_FREE_IDS if there are no more free mutex Ids
-             OS_ERR_NAME_TAKEN if there is already a mutex with the same name
+    Returns: OS_INVALID_POINTER if flags_id or flags_name are NULL
+             OS_ERR_NAME_TOO_LONG if the flags_name is too long to be stored
+             OS_ERR_NO_FREE_IDS if there are no more free event flag Ids
+             OS_ERR_NAME_TAKEN if there is already a group with the same name
              OS_SEM_FAILURE if the OS call failed
              OS_SUCCESS if success
-    
-    Notes: the options parameter is not used in this implementation
 
+    Notes: options is not used yet, it should be 0.
 ---------------------------------------------------------------------------------------*/
-int32 OS_MutSemCreate (uint32 *sem_id, const char *sem_name, uint32 options)
+int32 OS_EventFlagsCreate (uint32 *flags_id, const char *flags_name, uint32 initial_flags,
+                           uint32 options)
 {
-    int                 return_code;
-    pthread_mutexattr_t mutex_attr ;    
-    uint32              possible_semid;
-    uint32              i;      
+    uint32              possible_id;
+    int                 Status;
+    pthread_mutexattr_t mutex_attr;
 
-    /* Check Parameters */
-    if (sem_id == NULL || sem_name == NULL)
+    /*
+    ** Check Parameters
+    */
+    if (flags_id == NULL || flags_name == NULL)
     {
         return OS_INVALID_POINTER;
     }
-    
-    /* we don't want to allow names too long*/
-    /* if truncated, two names might be the same */
-    if (strlen(sem_name) >= OS_MAX_API_NAME)
+
+    if (strlen(flags_name) >= OS_MAX_API_NAME)
     {
         return OS_ERR_NAME_TOO_LONG;
     }
 
-    pthread_mutex_lock(&OS_mut_sem_table_mut);  
-
-    for (possible_semid = 0; possible_semid < OS_MAX_MUTEXES; possible_semid++)
-    {
-        if (OS_mut_sem_table[possible_semid].free == TRUE)    
-            break;
-    }
-    
-    if( (possible_semid == OS_MAX_MUTEXES) ||
-        (OS_mut_sem_table[possible_semid].free != TRUE) )
+    /* Take a free event flag Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_event_flags_table, &possible_id) != OS_SUCCESS )
     {
-        pthread_mutex_unlock(&OS_mut_sem_table_mut);
         return OS_ERR_NO_FREE_IDS;
     }
 
-    /* Check to see if the name is already taken */
+    /* Check to see if the name is already taken, and reserve it */
+    Status = OS_NameIndexAdd(OS_OBJECT_TYPE_EVENTFLAGS, flags_name, possible_id);
+    if ( Status != OS_SUCCESS )
+    {
+        OS_ObjectRelease(&OS_event_flags_table, possible_id);
+        return Status;
+    }
 
-    for (i = 0; i < OS_MAX_MUTEXES; i++)
+    /*
+    ** The flags are guarded by a priority inheritance mutex, like the binary
+    ** semaphores, and the waiting tasks sleep on a condition variable
+    */
+    Status = pthread_mutexattr_init(&mutex_attr);
+    if ( Status == 0 )
+    {
+        Status = pthread_mutexattr_setprotocol(&mutex_attr, PTHREAD_PRIO_INHERIT);
+    }
+    if ( Status == 0 )
+    {
+        Status = pthread_mutex_init(&(OS_EVENT_FLAGS_RECORD(possible_id)->id), &mutex_attr);
+    }
+    if ( Status == 0 )
     {
-        if ((OS_mut_sem_table[i].free == FALSE) &&
-                strcmp ((char*) sem_name, OS_mut_sem_table[i].name) == 0)
+        Status = pthread_cond_init(&(OS_EVENT_FLAGS_RECORD(possible_id)->cv), NULL);
+        if ( Status != 0 )
         {
-            pthread_mutex_unlock(&OS_mut_sem_table_mut);
-            return OS_ERR_NAME_TAKEN;
+            pthread_mutex_destroy(&(OS_EVENT_FLAGS_RECORD(possible_id)->id));
         }
     }
 
-    /* Set the free flag to false to make sure no other task grabs it */
+    if ( Status != 0 )
+    {
+        OS_NameIndexRemove(OS_OBJECT_TYPE_EVENTFLAGS, flags_name);
+        OS_ObjectRelease(&OS_event_flags_table, possible_id);
+        printf("Error: Event flags could not be created. ID = %u\n", possible_id);
+        return OS_SEM_FAILURE;
+    }
 
-    OS_mut_sem_table[possible_semid].free = FALSE;
-    pthread_mutex_unlock(&OS_mut_sem_table_mut);
+    /*
+    ** fill out the proper OSAL table fields
+    */
+    *flags_id = possible_id;
+
+    pthread_mutex_lock(&OS_event_flags_table_mut);
+
+    strcpy(OS_EVENT_FLAGS_RECORD(*flags_id)->name, (char*) flags_name);
+    OS_EVENT_FLAGS_RECORD(*flags_id)->creator = OS_FindCreator();
+    OS_EVENT_FLAGS_RECORD(*flags_id)->flags   = initial_flags;
+    OS_EVENT_FLAGS_RECORD(*flags_id)->waiters = 0;
+    OS_EVENT_FLAGS_RECORD(*flags_id)->free    = FALSE;
+
+    pthread_mutex_unlock(&OS_event_flags_table_mut);
+
+    return OS_SUCCESS;
+
+}/* end OS_EventFlagsCreate */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_EventFlagsDelete
+
+    Purpose: Deletes the specified group of event flags.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid group
+             OS_SUCCESS if success
+
+    Notes: No task should be waiting on the flags when they are deleted.
+---------------------------------------------------------------------------------------*/
+int32 OS_EventFlagsDelete (uint32 flags_id)
+{
+    if (flags_id >= OS_event_flags_table.num_records || OS_EVENT_FLAGS_RECORD(flags_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    pthread_mutex_lock(&OS_event_flags_table_mut);
+
+    /* Remove the Id from the table, and its name, so that it cannot be found again */
+    pthread_mutex_destroy(&(OS_EVENT_FLAGS_RECORD(flags_id)->id));
+    pthread_cond_destroy(&(OS_EVENT_FLAGS_RECORD(flags_id)->cv));
+    OS_NameIndexRemove(OS_OBJECT_TYPE_EVENTFLAGS, OS_EVENT_FLAGS_RECORD(flags_id)->name);
+    OS_EVENT_FLAGS_RECORD(flags_id)->free = TRUE;
+    strcpy(OS_EVENT_FLAGS_RECORD(flags_id)->name, "");
+    OS_EVENT_FLAGS_RECORD(flags_id)->creator = UNINITIALIZED;
+    OS_EVENT_FLAGS_RECORD(flags_id)->flags = 0;
+
+    pthread_mutex_unlock(&OS_event_flags_table_mut);
+
+    OS_ObjectRelease(&OS_event_flags_table, flags_id);
+
+    return OS_SUCCESS;
+
+}/* end OS_EventFlagsDelete */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_EventFlagsSet
+
+    Purpose: Sets the given flags in the group, and wakes up the tasks waiting on
+             the group so they can check whether their wait is satisfied.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid group
+             OS_SEM_FAILURE if the OS call failed
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_EventFlagsSet (uint32 flags_id, uint32 flags)
+{
+    OS_event_flags_record_t *group;
+    int                      ret;
+
+    if (flags_id >= OS_event_flags_table.num_records || OS_EVENT_FLAGS_RECORD(flags_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    group = OS_EVENT_FLAGS_RECORD(flags_id);
+
+    if ( pthread_mutex_lock(&(group->id)) != 0 )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    group->flags |= flags;
+
+    /*
+    ** Only wake the waiters when there are some, setting flags that nobody
+    ** waits on costs no system call
+    */
+    ret = 0;
+    if ( group->waiters != 0 )
+    {
+        ret = pthread_cond_broadcast(&(group->cv));
+    }
+
+    pthread_mutex_unlock(&(group->id));
+
+    return (ret == 0) ? OS_SUCCESS : OS_SEM_FAILURE;
+
+}/* end OS_EventFlagsSet */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_EventFlagsClear
+
+    Purpose: Clears the given flags in the group.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid group
+             OS_SEM_FAILURE if the OS call failed
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_EventFlagsClear (uint32 flags_id, uint32 flags)
+{
+    OS_event_flags_record_t *group;
+
+    if (flags_id >= OS_event_flags_table.num_records || OS_EVENT_FLAGS_RECORD(flags_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    group = OS_EVENT_FLAGS_RECORD(flags_id);
+
+    if ( pthread_mutex_lock(&(group->id)) != 0 )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    group->flags &= ~flags;
+
+    pthread_mutex_unlock(&(group->id));
+
+    return OS_SUCCESS;
+
+}/* end OS_EventFlagsClear */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_EventFlagsWait
+
+    Purpose: Waits until any (OS_EVENT_WAIT_ANY) or all (OS_EVENT_WAIT_ALL) of
+             wait_flags are set in the group. With OS_EVENT_AUTO_CLEAR, the flags
+             in wait_flags that are set are cleared before returning, so only one
+             waiting task sees each event.
+
+             timeout is OS_PEND to wait forever, OS_CHECK to not wait at all, or
+             a number of milliseconds, as for OS_QueueGet. The flags of the group
+             when the wait was satisfied are returned through flags_out, if it is
+             not NULL.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid group
+             OS_ERROR if wait_flags is 0, or timeout is negative and not OS_CHECK
+             OS_SEM_TIMEOUT if the flags were not set in time
+             OS_SEM_FAILURE if the OS call failed
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_EventFlagsWait (uint32 flags_id, uint32 wait_flags, uint32 mode, int32 timeout,
+                         uint32 *flags_out)
+{
+    OS_event_flags_record_t *group;
+    struct timespec          ts;
+    int32                    ret_val;
+    int                      ret;
+
+    if (flags_id >= OS_event_flags_table.num_records || OS_EVENT_FLAGS_RECORD(flags_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if (wait_flags == 0 || (timeout < 0 && timeout != OS_CHECK))
+    {
+        return OS_ERROR;
+    }
+    group = OS_EVENT_FLAGS_RECORD(flags_id);
+
+    if ( timeout > 0 )
+    {
+        OS_CompAbsDelayTime(timeout, &ts);
+    }
+
+    if ( pthread_mutex_lock(&(group->id)) != 0 )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    ret_val = OS_SUCCESS;
+    for ( ;; )
+    {
+        if ( OS_EVENT_FLAGS_MET(group->flags, wait_flags, mode) )
+        {
+            break;
+        }
+
+        if ( timeout == OS_CHECK )
+        {
+            ret_val = OS_SEM_TIMEOUT;
+            break;
+        }
+
+        /*
+        ** Wait on the condition variable, every set wakes this task up to
+        ** check the flags again
+        */
+        group->waiters++;
+        if ( timeout == OS_PEND )
+        {
+            ret = pthread_cond_wait(&(group->cv), &(group->id));
+        }
+        else
+        {
+            ret = pthread_cond_timedwait(&(group->cv), &(group->id), &ts);
+        }
+        group->waiters--;
+
+        if ( ret == ETIMEDOUT )
+        {
+            /* The flags may have been set just as the wait timed out */
+            if ( OS_EVENT_FLAGS_MET(group->flags, wait_flags, mode) )
+            {
+                break;
+            }
+            ret_val = OS_SEM_TIMEOUT;
+            break;
+        }
+        else if ( ret != 0 )
+        {
+            ret_val = OS_SEM_FAILURE;
+            break;
+        }
+    }
+
+    if ( ret_val == OS_SUCCESS )
+    {
+        if ( flags_out != NULL )
+        {
+            *flags_out = group->flags;
+        }
+        if ( mode & OS_EVENT_AUTO_CLEAR )
+        {
+            group->flags &= ~wait_flags;
+        }
+    }
+
+    pthread_mutex_unlock(&(group->id));
+
+    return ret_val;
+
+}/* end OS_EventFlagsWait */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_EventFlagsGetIdByName
+
+    Purpose: This function tries to find an event flag group Id given its name.
+             The id is returned through flags_id
+
+    Returns: OS_INVALID_POINTER is flags_id or flags_name are NULL pointers
+             OS_ERR_NAME_TOO_LONG if the name given is to long to have been stored
+             OS_ERR_NAME_NOT_FOUND if the name was not found in the table
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_EventFlagsGetIdByName (uint32 *flags_id, const char *flags_name)
+{
+    uint32 i;
+
+    if (flags_id == NULL || flags_name == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if (strlen(flags_name) >= OS_MAX_API_NAME)
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ((OS_NameIndexFind(OS_OBJECT_TYPE_EVENTFLAGS, flags_name, &i) == OS_SUCCESS) &&
+        (OS_EVENT_FLAGS_RECORD(i)->free != TRUE) &&
+        (strcmp (OS_EVENT_FLAGS_RECORD(i)->name, (char*) flags_name) == 0))
+    {
+        *flags_id = i;
+        return OS_SUCCESS;
+    }
+
+    return OS_ERR_NAME_NOT_FOUND;
+
+}/* end OS_EventFlagsGetIdByName */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_EventFlagsGetInfo
+
+    Purpose: This function will pass back the name, creator and current flags of
+             the specified event flag group.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid group
+             OS_INVALID_POINTER if the flags_prop pointer is null
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_EventFlagsGetInfo (uint32 flags_id, OS_event_flags_prop_t *flags_prop)
+{
+    if (flags_id >= OS_event_flags_table.num_records || OS_EVENT_FLAGS_RECORD(flags_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if (flags_prop == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    pthread_mutex_lock(&OS_event_flags_table_mut);
+
+    flags_prop->creator = OS_EVENT_FLAGS_RECORD(flags_id)->creator;
+    strcpy(flags_prop->name, OS_EVENT_FLAGS_RECORD(flags_id)->name);
+    flags_prop->flags = OS_EVENT_FLAGS_RECORD(flags_id)->flags;
+
+    pthread_mutex_unlock(&OS_event_flags_table_mut);
+
+    return OS_SUCCESS;
+
+} /* end OS_EventFlagsGetInfo */
+
+/****************************************************************************************
+                                  MUTEX API
+****************************************************************************************/
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_MutSemCreate
+
+    Purpose: Creates a mutex semaphore initially full.
+
+    Returns: OS_INVALID_POINTER if sem_id or sem_name are NULL
+             OS_ERR_NAME_TOO_LONG if the sem_name is too long to be stored
+             OS_ERR_NO_FREE_IDS if there are no more free mutex Ids
+             OS_ERR_NAME_TAKEN if there is already a mutex with the same name
+             OS_ERROR if both priority protocols are asked for
+             OS_SEM_FAILURE if the OS call failed
+             OS_SUCCESS if success
+    
+    Notes: options is 0 or OS_MUTEX_ADAPTIVE and OS_MUTEX_FAST or'ed together,
+           with at most one of OS_MUTEX_PRIO_INHERIT and OS_MUTEX_PRIO_PROTECT.
+           An adaptive mutex spins for a while before blocking when more than
+           one CPU is online. A fast mutex is not recursive and does not use
+           priority inheritance. The ceiling of a priority protect mutex is an
+           OSAL priority given with OS_MUTEX_CEILING; a task with a higher
+           priority than the ceiling cannot take the mutex.
+
+---------------------------------------------------------------------------------------*/
+int32 OS_MutSemCreate (uint32 *sem_id, const char *sem_name, uint32 options)
+{
+    int                 return_code;
+    pthread_mutexattr_t mutex_attr ;    
+    uint32              possible_semid;
+    int                 protocol;
+
+    /* Check Parameters */
+    if (sem_id == NULL || sem_name == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+    
+    /* we don't want to allow names too long*/
+    /* if truncated, two names might be the same */
+    if (strlen(sem_name) >= OS_MAX_API_NAME)
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    /*
+    ** Pick the locking protocol. A mutex uses priority inheritance unless
+    ** it is a fast mutex, or another protocol is asked for.
+    */
+    if ( (options & OS_MUTEX_PRIO_INHERIT) && (options & OS_MUTEX_PRIO_PROTECT) )
+    {
+        return OS_ERROR;
+    }
+    else if ( options & OS_MUTEX_PRIO_PROTECT )
+    {
+        protocol = PTHREAD_PRIO_PROTECT;
+    }
+    else if ( (options & OS_MUTEX_PRIO_INHERIT) || !(options & OS_MUTEX_FAST) )
+    {
+        protocol = PTHREAD_PRIO_INHERIT;
+    }
+    else
+    {
+        protocol = PTHREAD_PRIO_NONE;
+    }
+
+    /* Take a free mutex Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_mut_sem_table, &possible_semid) != OS_SUCCESS )
+    {
+        return OS_ERR_NO_FREE_IDS;
+    }
+
+    /* Check to see if the name is already taken, and reserve it */
+
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_MUTEX, sem_name, possible_semid);
+    if ( return_code != OS_SUCCESS )
+    {
+        OS_ObjectRelease(&OS_mut_sem_table, possible_semid);
+        return return_code;
+    }
+
+    OS_MUT_SEM_RECORD(possible_semid)->free = FALSE;
 
     /* 
     ** initialize the attribute with default values 
@@ -2019,37 +3083,50 @@ int32 OS_MutSemCreate (uint32 *sem_id, const char *sem_name, uint32 options)
     {
         /* Since the call failed, set free back to true */
         pthread_mutex_lock(&OS_mut_sem_table_mut);
-        OS_mut_sem_table[possible_semid].free = TRUE;
+        OS_NameIndexRemove(OS_OBJECT_TYPE_MUTEX, sem_name);
+        OS_MUT_SEM_RECORD(possible_semid)->free = TRUE;
         pthread_mutex_unlock(&OS_mut_sem_table_mut);
+        OS_ObjectRelease(&OS_mut_sem_table, possible_semid);
 
        printf("Error: Mutex could not be created. pthread_mutexattr_init failed ID = %lu\n",possible_semid);
        return OS_SEM_FAILURE;
     }
 
     /*
-    ** Allow the mutex to use priority inheritance  
+    ** Set the locking protocol, and the ceiling of a priority protect mutex
     */  
-    return_code = pthread_mutexattr_setprotocol(&mutex_attr,PTHREAD_PRIO_INHERIT) ;
+    return_code = pthread_mutexattr_setprotocol(&mutex_attr, protocol) ;
+    if ( return_code == 0 && protocol == PTHREAD_PRIO_PROTECT )
+    {
+        return_code = pthread_mutexattr_setprioceiling(&mutex_attr,
+                         OS_PriorityRemap(OS_MUTEX_CEILING_OF(options)));
+    }
     if ( return_code != 0 )
     {
         /* Since the call failed, set free back to true */
         pthread_mutex_lock(&OS_mut_sem_table_mut);
-        OS_mut_sem_table[possible_semid].free = TRUE;
+        OS_NameIndexRemove(OS_OBJECT_TYPE_MUTEX, sem_name);
+        OS_MUT_SEM_RECORD(possible_semid)->free = TRUE;
         pthread_mutex_unlock(&OS_mut_sem_table_mut);
+        OS_ObjectRelease(&OS_mut_sem_table, possible_semid);
 
        printf("Error: Mutex could not be created. pthread_mutexattr_setprotocol failed ID = %lu\n",possible_semid);
        return OS_SEM_FAILURE;    
     }	
     /*
-    **  Set the mutex type to RECURSIVE so a thread can do nested locks
+    **  Set the mutex type to RECURSIVE so a thread can do nested locks,
+    **  a fast mutex is a plain one
     */
-    return_code = pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
+    return_code = pthread_mutexattr_settype(&mutex_attr,
+                     (options & OS_MUTEX_FAST) ? PTHREAD_MUTEX_NORMAL : PTHREAD_MUTEX_RECURSIVE);
     if ( return_code != 0 )
     {
         /* Since the call failed, set free back to true */
         pthread_mutex_lock(&OS_mut_sem_table_mut);
-        OS_mut_sem_table[possible_semid].free = TRUE;
+        OS_NameIndexRemove(OS_OBJECT_TYPE_MUTEX, sem_name);
+        OS_MUT_SEM_RECORD(possible_semid)->free = TRUE;
         pthread_mutex_unlock(&OS_mut_sem_table_mut);
+        OS_ObjectRelease(&OS_mut_sem_table, possible_semid);
 
        printf("Error: Mutex could not be created. pthread_mutexattr_settype failed ID = %lu\n",possible_semid);
        return OS_SEM_FAILURE;   
@@ -2059,13 +3136,15 @@ int32 OS_MutSemCreate (uint32 *sem_id, const char *sem_name, uint32 options)
     ** create the mutex 
     ** upon successful initialization, the state of the mutex becomes initialized and unlocked 
     */
-    return_code =  pthread_mutex_init((pthread_mutex_t *) &OS_mut_sem_table[possible_semid].id,&mutex_attr); 
+    return_code =  pthread_mutex_init((pthread_mutex_t *) &OS_MUT_SEM_RECORD(possible_semid)->id,&mutex_attr); 
     if ( return_code != 0 )
     {
         /* Since the call failed, set free back to true */
         pthread_mutex_lock(&OS_mut_sem_table_mut);
-        OS_mut_sem_table[possible_semid].free = TRUE;
+        OS_NameIndexRemove(OS_OBJECT_TYPE_MUTEX, sem_name);
+        OS_MUT_SEM_RECORD(possible_semid)->free = TRUE;
         pthread_mutex_unlock(&OS_mut_sem_table_mut);
+        OS_ObjectRelease(&OS_mut_sem_table, possible_semid);
 
        printf("Error: Mutex could not be created. ID = %lu\n",possible_semid);
        return OS_SEM_FAILURE;
@@ -2079,9 +3158,10 @@ int32 OS_MutSemCreate (uint32 *sem_id, const char *sem_name, uint32 options)
     
        pthread_mutex_lock(&OS_mut_sem_table_mut);  
 
-       strcpy(OS_mut_sem_table[*sem_id].name, (char*) sem_name);
-       OS_mut_sem_table[*sem_id].free = FALSE;
-       OS_mut_sem_table[*sem_id].creator = OS_FindCreator();
+       strcpy(OS_MUT_SEM_RECORD(*sem_id)->name, (char*) sem_name);
+       OS_MUT_SEM_RECORD(*sem_id)->free = FALSE;
+       OS_MUT_SEM_RECORD(*sem_id)->creator = OS_FindCreator();
+       OS_MUT_SEM_RECORD(*sem_id)->options = options;
     
        pthread_mutex_unlock(&OS_mut_sem_table_mut);
 
@@ -2101,211 +3181,937 @@ int32 OS_MutSemCreate (uint32 *sem_id, const char *sem_name, uint32 options)
 
     Notes: The mutex must be full to take it, so we have to check for fullness
 
----------------------------------------------------------------------------------------*/
+---------------------------------------------------------------------------------------*/
+
+int32 OS_MutSemDelete (uint32 sem_id)
+{
+    int status=-1;
+
+    /* Check to see if this sem_id is valid   */
+    if (sem_id >= OS_mut_sem_table.num_records || OS_MUT_SEM_RECORD(sem_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    status = pthread_mutex_destroy( &(OS_MUT_SEM_RECORD(sem_id)->id)); /* 0 = success */   
+    
+    if( status != 0)
+    {
+        return OS_SEM_FAILURE;
+    }
+    /* Delete its presence in the table */
+   
+    pthread_mutex_lock(&OS_mut_sem_table_mut);  
+
+    OS_NameIndexRemove(OS_OBJECT_TYPE_MUTEX, OS_MUT_SEM_RECORD(sem_id)->name);
+    OS_MUT_SEM_RECORD(sem_id)->free = TRUE;
+    strcpy(OS_MUT_SEM_RECORD(sem_id)->name , "");
+    OS_MUT_SEM_RECORD(sem_id)->creator = UNINITIALIZED;
+    
+    pthread_mutex_unlock(&OS_mut_sem_table_mut);
+
+    OS_ObjectRelease(&OS_mut_sem_table, sem_id);
+    
+    return OS_SUCCESS;
+
+}/* end OS_MutSemDelete */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_MutSemGive
+
+    Purpose: The function releases the mutex object referenced by sem_id.The 
+             manner in which a mutex is released is dependent upon the mutex's type 
+             attribute.  If there are threads blocked on the mutex object referenced by 
+             mutex when this function is called, resulting in the mutex becoming 
+             available, the scheduling policy shall determine which thread shall 
+             acquire the mutex.
+
+    Returns: OS_SUCCESS if success
+             OS_SEM_FAILURE if the semaphore was not previously  initialized 
+             OS_ERR_INVALID_ID if the id passed in is not a valid mutex
+
+---------------------------------------------------------------------------------------*/
+
+int32 OS_MutSemGive ( uint32 sem_id )
+{
+    uint32 ret_val ;
+
+    /* Check Parameters */
+
+    if(sem_id >= OS_mut_sem_table.num_records || OS_MUT_SEM_RECORD(sem_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    /*
+    ** Unlock the mutex
+    */
+    if(pthread_mutex_unlock(&(OS_MUT_SEM_RECORD(sem_id)->id)))
+    {
+        ret_val = OS_SEM_FAILURE ;
+    }
+    else
+    {
+        ret_val = OS_SUCCESS ;
+    }
+    
+    return ret_val;
+} /* end OS_MutSemGive */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_MutSemTake
+
+    Purpose: The mutex object referenced by sem_id shall be locked by calling this
+             function. If the mutex is already locked, the calling thread shall
+             block until the mutex becomes available. This operation shall return
+             with the mutex object referenced by mutex in the locked state with the              
+             calling thread as its owner.
+
+    Returns: OS_SUCCESS if success
+             OS_SEM_FAILURE if the semaphore was not previously initialized or is 
+             not in the array of semaphores defined by the system
+             OS_ERR_INVALID_ID the id passed in is not a valid mutex
+---------------------------------------------------------------------------------------*/
+int32 OS_MutSemTake ( uint32 sem_id )
+{
+    int status;
+    int spins;
+
+    /* 
+    ** Check Parameters
+    */  
+    if(sem_id >= OS_mut_sem_table.num_records || OS_MUT_SEM_RECORD(sem_id)->free == TRUE)
+    {
+       return OS_ERR_INVALID_ID;
+    }
+ 
+    /*
+    ** An adaptive mutex is usually held for a short time, so on a multi-core
+    ** host it is cheaper to retry for a while than to sleep in the kernel
+    */
+    status = EBUSY;
+    if ( (OS_MUT_SEM_RECORD(sem_id)->options & OS_MUTEX_ADAPTIVE) && OS_cpu_count > 1 )
+    {
+       for ( spins = 0; spins < OS_MUTEX_SPIN_LIMIT; spins++ )
+       {
+          status = pthread_mutex_trylock(&(OS_MUT_SEM_RECORD(sem_id)->id));
+          if ( status != EBUSY )
+          {
+             break;
+          }
+          OS_CPU_RELAX();
+       }
+    }
+
+    /*
+    ** Lock the mutex - unlike the sem calls, the pthread mutex call
+    ** should not be interrupted by a signal
+    */
+    if ( status == EBUSY )
+    {
+       status = pthread_mutex_lock(&(OS_MUT_SEM_RECORD(sem_id)->id));
+    }
+    if( status == EINVAL )
+    {
+      return OS_SEM_FAILURE ;
+    }
+    else if ( status == EDEADLK )
+    {
+       printf("Task would deadlock--nested mutex call!\n");
+       return OS_SUCCESS ;
+    }
+    else
+    {
+      return OS_SUCCESS;
+    }
+
+}
+/*--------------------------------------------------------------------------------------
+    Name: OS_MutSemGetIdByName
+
+    Purpose: This function tries to find a mutex sem Id given the name of a mut_sem
+             The id is returned through sem_id
+
+    Returns: OS_INVALID_POINTER is semid or sem_name are NULL pointers
+             OS_ERR_NAME_TOO_LONG if the name given is to long to have been stored
+             OS_ERR_NAME_NOT_FOUND if the name was not found in the table
+             OS_SUCCESS if success
+             
+---------------------------------------------------------------------------------------*/
+int32 OS_MutSemGetIdByName (uint32 *sem_id, const char *sem_name)
+{
+    uint32 i;
+
+    if(sem_id == NULL || sem_name == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    /* 
+    ** Check parameters 
+    */ 
+    if (strlen(sem_name) >= OS_MAX_API_NAME)
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ((OS_NameIndexFind(OS_OBJECT_TYPE_MUTEX, sem_name, &i) == OS_SUCCESS) &&
+        (OS_MUT_SEM_RECORD(i)->free != TRUE) &&
+        (strcmp (OS_MUT_SEM_RECORD(i)->name, (char*) sem_name) == 0))
+    {
+        *sem_id = i;
+        return OS_SUCCESS;
+    }
+    
+    /* 
+    ** The name was not found in the table,
+    **  or it was, and the sem_id isn't valid anymore 
+    */
+    return OS_ERR_NAME_NOT_FOUND;
+
+}/* end OS_MutSemGetIdByName */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_MutSemGetInfo
+
+    Purpose: This function will pass back a pointer to structure that contains 
+             all of the relevant info( name and creator) about the specified mutex
+             semaphore.
+             
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid semaphore 
+             OS_INVALID_POINTER if the mut_prop pointer is null
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+
+int32 OS_MutSemGetInfo (uint32 sem_id, OS_mut_sem_prop_t *mut_prop)  
+{
+    /* Check to see that the id given is valid */
+    
+    if (sem_id >= OS_mut_sem_table.num_records || OS_MUT_SEM_RECORD(sem_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if (mut_prop == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+    
+    /* put the info into the stucture */    
+    
+    pthread_mutex_lock(&OS_mut_sem_table_mut);  
+
+    mut_prop -> creator =   OS_MUT_SEM_RECORD(sem_id)->creator;
+    strcpy(mut_prop-> name, OS_MUT_SEM_RECORD(sem_id)->name);
+
+    pthread_mutex_unlock(&OS_mut_sem_table_mut);
+    
+    return OS_SUCCESS;
+    
+} /* end OS_BinSemGetInfo */
+
+/****************************************************************************************
+                              READER/WRITER LOCK API
+****************************************************************************************/
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_RwLockCreate
+
+    Purpose: Creates a reader/writer lock, initially not held. Any number of tasks
+             can hold it for reading at the same time, or one task for writing.
+
+    Returns: OS_INVALID_POINTER if rwlock_id or rwlock_name are NULL
+             OS_ERR_NAME_TOO_LONG if the rwlock_name is too long to be stored
+             OS_ERR_NO_FREE_IDS if there are no more free lock Ids
+             OS_ERR_NAME_TAKEN if there is already a lock with the same name
+             OS_ERROR if both preferences are asked for
+             OS_SEM_FAILURE if the OS call failed
+             OS_SUCCESS if success
+
+    Notes: options is 0, OS_RWLOCK_PREFER_READER or OS_RWLOCK_PREFER_WRITER.
+           A reader preference lock lets new readers in while a writer waits,
+           which gives the most read throughput but can starve the writers.
+           A writer preference lock holds back new readers while a writer
+           waits, so a task must not take it for reading twice. Writer
+           preference needs glibc, elsewhere the lock uses the default of
+           the pthread library.
+---------------------------------------------------------------------------------------*/
+int32 OS_RwLockCreate (uint32 *rwlock_id, const char *rwlock_name, uint32 options)
+{
+    int                  return_code;
+    pthread_rwlockattr_t rwlock_attr;
+    uint32               possible_id;
+
+    /* Check Parameters */
+    if (rwlock_id == NULL || rwlock_name == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    /* we don't want to allow names too long*/
+    /* if truncated, two names might be the same */
+    if (strlen(rwlock_name) >= OS_MAX_API_NAME)
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ( (options & OS_RWLOCK_PREFER_READER) && (options & OS_RWLOCK_PREFER_WRITER) )
+    {
+        return OS_ERROR;
+    }
+
+    /* Take a free lock Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_rwlock_table, &possible_id) != OS_SUCCESS )
+    {
+        return OS_ERR_NO_FREE_IDS;
+    }
+
+    /* Check to see if the name is already taken, and reserve it */
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_RWLOCK, rwlock_name, possible_id);
+    if ( return_code != OS_SUCCESS )
+    {
+        OS_ObjectRelease(&OS_rwlock_table, possible_id);
+        return return_code;
+    }
+
+    OS_RWLOCK_RECORD(possible_id)->free = FALSE;
+
+    return_code = pthread_rwlockattr_init(&rwlock_attr);
+
+#ifdef __GLIBC__
+    if ( return_code == 0 )
+    {
+        return_code = pthread_rwlockattr_setkind_np(&rwlock_attr,
+                         (options & OS_RWLOCK_PREFER_WRITER) ?
+                            PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP :
+                            PTHREAD_RWLOCK_PREFER_READER_NP);
+    }
+#endif
+
+    /*
+    ** create the lock
+    */
+    if ( return_code == 0 )
+    {
+        return_code = pthread_rwlock_init(&OS_RWLOCK_RECORD(possible_id)->id, &rwlock_attr);
+        pthread_rwlockattr_destroy(&rwlock_attr);
+    }
+
+    if ( return_code != 0 )
+    {
+        /* Since the call failed, set free back to true */
+        pthread_mutex_lock(&OS_rwlock_table_mut);
+        OS_NameIndexRemove(OS_OBJECT_TYPE_RWLOCK, rwlock_name);
+        OS_RWLOCK_RECORD(possible_id)->free = TRUE;
+        pthread_mutex_unlock(&OS_rwlock_table_mut);
+        OS_ObjectRelease(&OS_rwlock_table, possible_id);
+
+        printf("Error: Reader/writer lock could not be created. ID = %u\n",possible_id);
+        return OS_SEM_FAILURE;
+    }
+
+    /*
+    ** Mark the lock as initialized
+    */
+    *rwlock_id = possible_id;
+
+    pthread_mutex_lock(&OS_rwlock_table_mut);
+
+    strcpy(OS_RWLOCK_RECORD(*rwlock_id)->name, (char*) rwlock_name);
+    OS_RWLOCK_RECORD(*rwlock_id)->free = FALSE;
+    OS_RWLOCK_RECORD(*rwlock_id)->creator = OS_FindCreator();
+    OS_RWLOCK_RECORD(*rwlock_id)->options = options;
+
+    pthread_mutex_unlock(&OS_rwlock_table_mut);
+
+    return OS_SUCCESS;
+
+}/* end OS_RwLockCreate */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_RwLockDelete
+
+    Purpose: Deletes the specified reader/writer lock.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid lock
+             OS_SEM_FAILURE if the OS call failed, for example if the lock is held
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_RwLockDelete (uint32 rwlock_id)
+{
+    if (rwlock_id >= OS_rwlock_table.num_records || OS_RWLOCK_RECORD(rwlock_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( pthread_rwlock_destroy(&(OS_RWLOCK_RECORD(rwlock_id)->id)) != 0 )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    /* Delete its presence in the table */
+    pthread_mutex_lock(&OS_rwlock_table_mut);
+
+    OS_NameIndexRemove(OS_OBJECT_TYPE_RWLOCK, OS_RWLOCK_RECORD(rwlock_id)->name);
+    OS_RWLOCK_RECORD(rwlock_id)->free = TRUE;
+    strcpy(OS_RWLOCK_RECORD(rwlock_id)->name , "");
+    OS_RWLOCK_RECORD(rwlock_id)->creator = UNINITIALIZED;
+
+    pthread_mutex_unlock(&OS_rwlock_table_mut);
+
+    OS_ObjectRelease(&OS_rwlock_table, rwlock_id);
+
+    return OS_SUCCESS;
+
+}/* end OS_RwLockDelete */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_RwLockReadTake
+
+    Purpose: Takes the lock for reading, waiting while a writer holds it. With
+             writer preference it also waits while a writer is waiting.
+
+    Returns: OS_SUCCESS if success
+             OS_SEM_FAILURE if the OS call failed
+             OS_ERR_INVALID_ID if the id passed in is not a valid lock
+---------------------------------------------------------------------------------------*/
+int32 OS_RwLockReadTake (uint32 rwlock_id)
+{
+    if (rwlock_id >= OS_rwlock_table.num_records || OS_RWLOCK_RECORD(rwlock_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( pthread_rwlock_rdlock(&(OS_RWLOCK_RECORD(rwlock_id)->id)) != 0 )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    return OS_SUCCESS;
+
+}/* end OS_RwLockReadTake */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_RwLockWriteTake
+
+    Purpose: Takes the lock for writing, waiting until no other task holds it.
+
+    Returns: OS_SUCCESS if success
+             OS_SEM_FAILURE if the OS call failed, for example if the calling
+             task already holds the lock
+             OS_ERR_INVALID_ID if the id passed in is not a valid lock
+---------------------------------------------------------------------------------------*/
+int32 OS_RwLockWriteTake (uint32 rwlock_id)
+{
+    if (rwlock_id >= OS_rwlock_table.num_records || OS_RWLOCK_RECORD(rwlock_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( pthread_rwlock_wrlock(&(OS_RWLOCK_RECORD(rwlock_id)->id)) != 0 )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    return OS_SUCCESS;
+
+}/* end OS_RwLockWriteTake */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_RwLockGive
+
+    Purpose: Releases the lock taken by the calling task, for reading or writing.
+
+    Returns: OS_SUCCESS if success
+             OS_SEM_FAILURE if the OS call failed
+             OS_ERR_INVALID_ID if the id passed in is not a valid lock
+---------------------------------------------------------------------------------------*/
+int32 OS_RwLockGive (uint32 rwlock_id)
+{
+    if (rwlock_id >= OS_rwlock_table.num_records || OS_RWLOCK_RECORD(rwlock_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( pthread_rwlock_unlock(&(OS_RWLOCK_RECORD(rwlock_id)->id)) != 0 )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    return OS_SUCCESS;
+
+}/* end OS_RwLockGive */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_RwLockGetIdByName
+
+    Purpose: This function tries to find a reader/writer lock Id given its name.
+             The id is returned through rwlock_id
+
+    Returns: OS_INVALID_POINTER is rwlock_id or rwlock_name are NULL pointers
+             OS_ERR_NAME_TOO_LONG if the name given is to long to have been stored
+             OS_ERR_NAME_NOT_FOUND if the name was not found in the table
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_RwLockGetIdByName (uint32 *rwlock_id, const char *rwlock_name)
+{
+    uint32 i;
+
+    if (rwlock_id == NULL || rwlock_name == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if (strlen(rwlock_name) >= OS_MAX_API_NAME)
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ((OS_NameIndexFind(OS_OBJECT_TYPE_RWLOCK, rwlock_name, &i) == OS_SUCCESS) &&
+        (OS_RWLOCK_RECORD(i)->free != TRUE) &&
+        (strcmp (OS_RWLOCK_RECORD(i)->name, (char*) rwlock_name) == 0))
+    {
+        *rwlock_id = i;
+        return OS_SUCCESS;
+    }
+
+    return OS_ERR_NAME_NOT_FOUND;
+
+}/* end OS_RwLockGetIdByName */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_RwLockGetInfo
+
+    Purpose: This function will pass back the name and creator of the specified
+             reader/writer lock.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid lock
+             OS_INVALID_POINTER if the rwlock_prop pointer is null
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_RwLockGetInfo (uint32 rwlock_id, OS_rwlock_prop_t *rwlock_prop)
+{
+    if (rwlock_id >= OS_rwlock_table.num_records || OS_RWLOCK_RECORD(rwlock_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if (rwlock_prop == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    pthread_mutex_lock(&OS_rwlock_table_mut);
+
+    rwlock_prop->creator = OS_RWLOCK_RECORD(rwlock_id)->creator;
+    strcpy(rwlock_prop->name, OS_RWLOCK_RECORD(rwlock_id)->name);
+
+    pthread_mutex_unlock(&OS_rwlock_table_mut);
+
+    return OS_SUCCESS;
+
+} /* end OS_RwLockGetInfo */
+
+/****************************************************************************************
+                                  WAIT FOR ANY API
+****************************************************************************************/
+
+/*
+** OS_WaitAny polls one descriptor for each object. A queue is ready when its
+** message queue or socket is readable, or for the ring buffer queues when the
+** ring holds a message; puts write to an eventfd while a task waits on it
+** here, as for the semaphores below. The timer dispatch thread writes to an
+** eventfd of the timer each time it expires. A semaphore is ready when its
+** value is above 0; its gives write to an eventfd only while a task waits on
+** it here, so the gives nobody waits for with OS_WaitAny cost no system call.
+*/
 
-int32 OS_MutSemDelete (uint32 sem_id)
+/*
+** Wakes up the tasks waiting on an object in OS_WaitAny
+*/
+void OS_WaitAnyNotify(int fd)
 {
-    int status=-1;
+    uint64_t one = 1;
 
-    /* Check to see if this sem_id is valid   */
-    if (sem_id >= OS_MAX_MUTEXES || OS_mut_sem_table[sem_id].free == TRUE)
+    if ( write(fd, &one, sizeof(one)) < 0 )
     {
-        return OS_ERR_INVALID_ID;
+        /* the count is saturated, the waiters will see it anyway */
     }
+}
 
-    status = pthread_mutex_destroy( &(OS_mut_sem_table[sem_id].id)); /* 0 = success */   
-    
-    if( status != 0)
+/*
+** Empties an eventfd once its wakeup has been seen
+*/
+static void OS_WaitAnyDrain(int fd)
+{
+    uint64_t count;
+
+    if ( read(fd, &count, sizeof(count)) < 0 )
     {
-        return OS_SEM_FAILURE;
+        /* nothing to drain, another task got there first */
     }
-    /* Delete its presence in the table */
-   
-    pthread_mutex_lock(&OS_mut_sem_table_mut);  
-
-    OS_mut_sem_table[sem_id].free = TRUE;
-    strcpy(OS_mut_sem_table[sem_id].name , "");
-    OS_mut_sem_table[sem_id].creator = UNINITIALIZED;
-    
-    pthread_mutex_unlock(&OS_mut_sem_table_mut);
-    
-    return OS_SUCCESS;
+}
 
-}/* end OS_MutSemDelete */
+/*
+** The descriptors of OS_QueueGetEventFd and the semaphore equivalents are
+** eventfds of their own, the ones OS_WaitAny drains would not stay readable.
+** A call that makes the object ready signals it once the change is visible,
+** and only writes to it when nothing was written since the last drain. A call
+** that finds or leaves the object not ready drains it, then checks the object
+** again and signals it if it became ready meanwhile. A signal that loses the
+** race with a drain may leave the descriptor readable while the object is
+** not; the next call that finds the object not ready drains it.
+*/
 
-/*---------------------------------------------------------------------------------------
-    Name: OS_MutSemGive
+/*
+** Creates the event descriptor of an object the first time it is asked for.
+** The caller signals it if the object is ready already.
+*/
+int32 OS_EventFdOpen(OS_event_fd_t *event, pthread_mutex_t *table_mut)
+{
+    pthread_mutex_lock(table_mut);
+    if ( event->fd < 0 )
+    {
+        event->signalled = 0;
+        event->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    pthread_mutex_unlock(table_mut);
 
-    Purpose: The function releases the mutex object referenced by sem_id.The 
-             manner in which a mutex is released is dependent upon the mutex's type 
-             attribute.  If there are threads blocked on the mutex object referenced by 
-             mutex when this function is called, resulting in the mutex becoming 
-             available, the scheduling policy shall determine which thread shall 
-             acquire the mutex.
+    return (event->fd < 0) ? OS_ERROR : OS_SUCCESS;
+}
 
-    Returns: OS_SUCCESS if success
-             OS_SEM_FAILURE if the semaphore was not previously  initialized 
-             OS_ERR_INVALID_ID if the id passed in is not a valid mutex
+/*
+** Closes the event descriptor of an object being deleted
+*/
+void OS_EventFdClose(OS_event_fd_t *event)
+{
+    if ( event->fd >= 0 )
+    {
+        close(event->fd);
+    }
+    event->fd = -1;
+}
 
----------------------------------------------------------------------------------------*/
+/*
+** Makes the event descriptor readable, after a full barrier that orders the
+** store that made the object ready with the load of signalled
+*/
+void OS_EventFdSignal(OS_event_fd_t *event)
+{
+    if ( __sync_bool_compare_and_swap(&event->signalled, 0, 1) )
+    {
+        OS_WaitAnyNotify(event->fd);
+    }
+}
 
-int32 OS_MutSemGive ( uint32 sem_id )
+/*
+** Empties the event descriptor of an object that is not ready. The caller
+** checks the object again afterwards.
+*/
+void OS_EventFdDrain(OS_event_fd_t *event)
 {
-    uint32 ret_val ;
+    OS_WaitAnyDrain(event->fd);
+    event->signalled = 0;
+    __sync_synchronize();
+}
 
-    /* Check Parameters */
+/*
+** Counts the calling task as waiting on a semaphore, and creates the eventfd
+** its gives write to the first time. A give either sees the waiter, or has
+** already raised the value the waiter checks next. The pthread semaphores
+** order the two with the mutex of the semaphore, the futex gives are a full
+** barrier.
+*/
+static int32 OS_WaitAnySemStart(int *wait_fd, volatile uint32 *any_waiters,
+                                pthread_mutex_t *table_mut, pthread_mutex_t *sem_mut)
+{
+    pthread_mutex_lock(table_mut);
+    if ( *wait_fd < 0 )
+    {
+        *wait_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    pthread_mutex_unlock(table_mut);
 
-    if(sem_id >= OS_MAX_MUTEXES || OS_mut_sem_table[sem_id].free == TRUE)
+    if ( *wait_fd < 0 )
     {
-        return OS_ERR_INVALID_ID;
+        return OS_SEM_FAILURE;
     }
 
-    /*
-    ** Unlock the mutex
-    */
-    if(pthread_mutex_unlock(&(OS_mut_sem_table[sem_id].id)))
+    if ( sem_mut != NULL )
     {
-        ret_val = OS_SEM_FAILURE ;
+        pthread_mutex_lock(sem_mut);
     }
-    else
+    __sync_fetch_and_add(any_waiters, 1);
+    if ( sem_mut != NULL )
     {
-        ret_val = OS_SUCCESS ;
+        pthread_mutex_unlock(sem_mut);
     }
-    
-    return ret_val;
-} /* end OS_MutSemGive */
-
-/*---------------------------------------------------------------------------------------
-    Name: OS_MutSemTake
 
-    Purpose: The mutex object referenced by sem_id shall be locked by calling this
-             function. If the mutex is already locked, the calling thread shall
-             block until the mutex becomes available. This operation shall return
-             with the mutex object referenced by mutex in the locked state with the              
-             calling thread as its owner.
+    return OS_SUCCESS;
+}
 
-    Returns: OS_SUCCESS if success
-             OS_SEM_FAILURE if the semaphore was not previously initialized or is 
-             not in the array of semaphores defined by the system
-             OS_ERR_INVALID_ID the id passed in is not a valid mutex
----------------------------------------------------------------------------------------*/
-int32 OS_MutSemTake ( uint32 sem_id )
+/*
+** Finds the descriptor to poll for an object, and counts the task as a
+** waiter of a semaphore or ring buffer queue
+*/
+static int32 OS_WaitAnyStart(OS_wait_object_t *object, int *fd)
 {
-    int status;
+    switch ( object->type )
+    {
+        case OS_WAIT_QUEUE:
+            return OS_QueueWaitStart(object->id, fd);
+
+        case OS_WAIT_TIMER:
+            return OS_TimerGetWaitFd(object->id, fd);
+
+        case OS_WAIT_BIN_SEM:
+            if ( object->id >= OS_bin_sem_table.num_records ||
+                 OS_BIN_SEM_RECORD(object->id)->free == TRUE )
+            {
+                return OS_ERR_INVALID_ID;
+            }
+            if ( OS_WaitAnySemStart(&(OS_BIN_SEM_RECORD(object->id)->wait_fd),
+                                    &(OS_BIN_SEM_RECORD(object->id)->any_waiters),
+                                    &OS_bin_sem_table_mut,
+                                    OS_BIN_SEM_MUTEX(object->id)) != OS_SUCCESS )
+            {
+                return OS_SEM_FAILURE;
+            }
+            *fd = OS_BIN_SEM_RECORD(object->id)->wait_fd;
+            return OS_SUCCESS;
 
-    /* 
-    ** Check Parameters
-    */  
-    if(sem_id >= OS_MAX_MUTEXES || OS_mut_sem_table[sem_id].free == TRUE)
+        case OS_WAIT_COUNT_SEM:
+            if ( object->id >= OS_count_sem_table.num_records ||
+                 OS_COUNT_SEM_RECORD(object->id)->free == TRUE )
+            {
+                return OS_ERR_INVALID_ID;
+            }
+            if ( OS_WaitAnySemStart(&(OS_COUNT_SEM_RECORD(object->id)->wait_fd),
+                                    &(OS_COUNT_SEM_RECORD(object->id)->any_waiters),
+                                    &OS_count_sem_table_mut,
+                                    OS_COUNT_SEM_MUTEX(object->id)) != OS_SUCCESS )
+            {
+                return OS_SEM_FAILURE;
+            }
+            *fd = OS_COUNT_SEM_RECORD(object->id)->wait_fd;
+            return OS_SUCCESS;
+
+        default:
+            return OS_ERROR;
+    }
+}
+
+/*
+** Stops counting the task as a waiter of a semaphore or queue
+*/
+static void OS_WaitAnyEnd(OS_wait_object_t *object)
+{
+    if ( object->type == OS_WAIT_QUEUE )
     {
-       return OS_ERR_INVALID_ID;
+        OS_QueueWaitEnd(object->id);
     }
- 
-    /*
-    ** Lock the mutex - unlike the sem calls, the pthread mutex call
-    ** should not be interrupted by a signal
-    */
-    status = pthread_mutex_lock(&(OS_mut_sem_table[sem_id].id));
-    if( status == EINVAL )
+    else if ( object->type == OS_WAIT_BIN_SEM )
     {
-      return OS_SEM_FAILURE ;
+        __sync_fetch_and_sub(&(OS_BIN_SEM_RECORD(object->id)->any_waiters), 1);
     }
-    else if ( status == EDEADLK )
+    else if ( object->type == OS_WAIT_COUNT_SEM )
     {
-       printf("Task would deadlock--nested mutex call!\n");
-       return OS_SUCCESS ;
+        __sync_fetch_and_sub(&(OS_COUNT_SEM_RECORD(object->id)->any_waiters), 1);
     }
-    else
+}
+
+/*
+** TRUE when a semaphore can be taken, or a ring buffer queue holds a message
+*/
+static int OS_WaitAnyReady(OS_wait_object_t *object)
+{
+    if ( object->type == OS_WAIT_QUEUE )
     {
-      return OS_SUCCESS;
+        return(OS_QueueWaitReady(object->id, FALSE));
+    }
+    else if ( object->type == OS_WAIT_BIN_SEM )
+    {
+        return(OS_BIN_SEM_VALUE(object->id) > 0);
+    }
+    else if ( object->type == OS_WAIT_COUNT_SEM )
+    {
+        return(OS_COUNT_SEM_VALUE(object->id) > 0);
     }
 
+    return(FALSE);
 }
-/*--------------------------------------------------------------------------------------
-    Name: OS_MutSemGetIdByName
 
-    Purpose: This function tries to find a mutex sem Id given the name of a mut_sem
-             The id is returned through sem_id
+/*---------------------------------------------------------------------------------------
+    Name: OS_WaitAny
 
-    Returns: OS_INVALID_POINTER is semid or sem_name are NULL pointers
-             OS_ERR_NAME_TOO_LONG if the name given is to long to have been stored
-             OS_ERR_NAME_NOT_FOUND if the name was not found in the table
-             OS_SUCCESS if success
-             
+    Purpose: Waits until at least one of the queues, semaphores and timers in
+             objects is ready, and sets the ready field of each object that is.
+             A queue is ready when it holds a message, a semaphore when it can
+             be taken, and a timer when it expired since it was last reported.
+
+             OS_WaitAny does not take anything. The caller gets the message or
+             takes the semaphore with OS_CHECK or a short timeout, since another
+             task may have taken it in between.
+
+             timeout is OS_PEND to wait forever, OS_CHECK to not wait at all, or
+             a number of milliseconds, as for OS_QueueGet.
+
+    Returns: OS_INVALID_POINTER if objects is NULL
+             OS_ERROR if count is 0 or above OS_MAX_WAIT_OBJECTS, or a type is unknown
+             OS_ERR_INVALID_ID if one of the ids is not valid
+             OS_ERROR_TIMEOUT if no object was ready in time
+             OS_SEM_FAILURE if the OS call failed
+             OS_SUCCESS if at least one object is ready
+
+    Notes: When several tasks wait on the same semaphore, a give may only be
+           reported to one of them, as only one of them can take it.
 ---------------------------------------------------------------------------------------*/
-int32 OS_MutSemGetIdByName (uint32 *sem_id, const char *sem_name)
+int32 OS_WaitAny (OS_wait_object_t *objects, uint32 count, int32 timeout)
 {
-    uint32 i;
+    struct pollfd   fds[OS_MAX_WAIT_OBJECTS];
+    struct timespec deadline;
+    struct timespec now;
+    int32           ret_val;
+    int             poll_msecs;
+    int             ret;
+    uint32          num_ready;
+    uint32          i;
 
-    if(sem_id == NULL || sem_name == NULL)
+    if ( objects == NULL )
     {
         return OS_INVALID_POINTER;
     }
 
-    /* 
-    ** Check parameters 
-    */ 
-    if (strlen(sem_name) >= OS_MAX_API_NAME)
+    if ( count == 0 || count > OS_MAX_WAIT_OBJECTS )
     {
-        return OS_ERR_NAME_TOO_LONG;
+        return OS_ERROR;
     }
 
-    for (i = 0; i < OS_MAX_MUTEXES; i++)
+    /*
+    ** Find the descriptor of each object
+    */
+    for ( i = 0; i < count; i++ )
     {
-        if ((OS_mut_sem_table[i].free != TRUE) &&
-           (strcmp (OS_mut_sem_table[i].name, (char*) sem_name) == 0) )
+        objects[i].ready = FALSE;
+        fds[i].events    = POLLIN;
+        ret_val = OS_WaitAnyStart(&objects[i], &fds[i].fd);
+        if ( ret_val != OS_SUCCESS )
         {
-            *sem_id = i;
-            return OS_SUCCESS;
+            while ( i > 0 )
+            {
+                OS_WaitAnyEnd(&objects[--i]);
+            }
+            return ret_val;
         }
     }
-    
-    /* 
-    ** The name was not found in the table,
-    **  or it was, and the sem_id isn't valid anymore 
-    */
-    return OS_ERR_NAME_NOT_FOUND;
 
-}/* end OS_MutSemGetIdByName */
+    if ( timeout > 0 )
+    {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec  += timeout / 1000;
+        deadline.tv_nsec += (timeout % 1000) * 1000000L;
+        if ( deadline.tv_nsec >= 1000000000L )
+        {
+            deadline.tv_nsec -= 1000000000L;
+            deadline.tv_sec++;
+        }
+    }
 
-/*---------------------------------------------------------------------------------------
-    Name: OS_MutSemGetInfo
+    ret_val = OS_SUCCESS;
+    for ( ;; )
+    {
+        /*
+        ** The semaphores and ring buffer queues are checked first. If one is
+        ** ready, the poll only picks up the other objects that are ready too.
+        */
+        num_ready = 0;
+        for ( i = 0; i < count; i++ )
+        {
+            if ( OS_WaitAnyReady(&objects[i]) )
+            {
+                objects[i].ready = TRUE;
+                num_ready++;
+            }
+        }
 
-    Purpose: This function will pass back a pointer to structure that contains 
-             all of the relevant info( name and creator) about the specified mutex
-             semaphore.
-             
-    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid semaphore 
-             OS_INVALID_POINTER if the mut_prop pointer is null
-             OS_SUCCESS if success
----------------------------------------------------------------------------------------*/
+        if ( num_ready > 0 || timeout == OS_CHECK )
+        {
+            poll_msecs = 0;
+        }
+        else if ( timeout == OS_PEND )
+        {
+            poll_msecs = -1;
+        }
+        else
+        {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            poll_msecs = (deadline.tv_sec - now.tv_sec) * 1000 +
+                         (deadline.tv_nsec - now.tv_nsec + 999999) / 1000000;
+            if ( poll_msecs < 0 )
+            {
+                poll_msecs = 0;
+            }
+        }
 
-int32 OS_MutSemGetInfo (uint32 sem_id, OS_mut_sem_prop_t *mut_prop)  
-{
-    /* Check to see that the id given is valid */
-    
-    if (sem_id >= OS_MAX_MUTEXES || OS_mut_sem_table[sem_id].free == TRUE)
-    {
-        return OS_ERR_INVALID_ID;
+        ret = poll(fds, count, poll_msecs);
+        if ( ret < 0 && errno != EINTR )
+        {
+            ret_val = OS_SEM_FAILURE;
+            break;
+        }
+
+        for ( i = 0; ret > 0 && i < count; i++ )
+        {
+            if ( fds[i].revents == 0 )
+            {
+                continue;
+            }
+
+            if ( objects[i].type == OS_WAIT_QUEUE )
+            {
+                if ( OS_QueueWaitReady(objects[i].id, TRUE) && objects[i].ready == FALSE )
+                {
+                    objects[i].ready = TRUE;
+                    num_ready++;
+                }
+            }
+            else if ( objects[i].type == OS_WAIT_TIMER )
+            {
+                OS_WaitAnyDrain(fds[i].fd);
+                objects[i].ready = TRUE;
+                num_ready++;
+            }
+            else
+            {
+                /* The value is checked again, another task may have taken it */
+                OS_WaitAnyDrain(fds[i].fd);
+                if ( objects[i].ready == FALSE && OS_WaitAnyReady(&objects[i]) )
+                {
+                    objects[i].ready = TRUE;
+                    num_ready++;
+                }
+            }
+        }
+
+        if ( num_ready > 0 )
+        {
+            break;
+        }
+        else if ( ret == 0 && poll_msecs == 0 )
+        {
+            ret_val = OS_ERROR_TIMEOUT;
+            break;
+        }
     }
 
-    if (mut_prop == NULL)
+    for ( i = 0; i < count; i++ )
     {
-        return OS_INVALID_POINTER;
+        OS_WaitAnyEnd(&objects[i]);
     }
-    
-    /* put the info into the stucture */    
-    
-    pthread_mutex_lock(&OS_mut_sem_table_mut);  
 
-    mut_prop -> creator =   OS_mut_sem_table[sem_id].creator;
-    strcpy(mut_prop-> name, OS_mut_sem_table[sem_id].name);
+    return ret_val;
 
-    pthread_mutex_unlock(&OS_mut_sem_table_mut);
-    
-    return OS_SUCCESS;
-    
-} /* end OS_BinSemGetInfo */
+}/* end OS_WaitAny */
 
 
 /****************************************************************************************
@@ -2436,25 +4242,6 @@ int32 OS_IntDisable(int32 Level)
     return(OS_ERR_NOT_IMPLEMENTED);
 }
 
-/*---------------------------------------------------------------------------------------
-   Name: OS_HeapGetInfo
-
-   Purpose: Return current info on the heap
-
-   Parameters:
-
----------------------------------------------------------------------------------------*/
-int32 OS_HeapGetInfo       (OS_heap_prop_t *heap_prop)
-{
-    if (heap_prop == NULL)
-    {
-        return OS_INVALID_POINTER;
-    }
-    /*
-    ** Not implemented yet
-    */
-    return (OS_ERR_NOT_IMPLEMENTED);
-}
 /*---------------------------------------------------------------------------------------
 ** Name: OS_Tick2Micros
 **
@@ -2662,25 +4449,44 @@ int32 OS_GetMask ( uint32 * MaskSettingPtr )
 /*--------------------------------------------------------------------------------------
  * uint32 FindCreator
  * purpose: Finds the creator of the calling thread
+ *          Returns the task table capacity if the calling thread is not an
+ *          OSAL task
 ---------------------------------------------------------------------------------------*/
 uint32 OS_FindCreator(void)
 {
-    pthread_t    pthread_id;
-    uint32 i;  
-   
-    pthread_id = pthread_self();
-    /* 
-    ** Get PTHREAD Id
-    */
-    for (i = 0; i < OS_MAX_TASKS; i++)
+    unsigned long task_key;
+
+    task_key = (unsigned long)pthread_getspecific(thread_key);
+    if ( task_key == 0 )
     {
-        if (pthread_equal(pthread_id, OS_task_table[i].id) != 0 )
-        {
-            break;
-        }
+        return OS_api_config.max_tasks;
     }
 
-    return i;
+    return (uint32)(task_key - 1);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Name: OS_PthreadTaskEntry
+ * 
+ * Purpose: Start routine for every thread created by OS_TaskCreate. It stores the
+ *          task ID in the thread specific data so OS_TaskGetId and OS_FindCreator
+ *          do not need to search the task table, then calls the user's entry point.
+---------------------------------------------------------------------------------------*/
+void *OS_PthreadTaskEntry(void *arg)
+{
+    unsigned long task_id;
+
+    task_id = (unsigned long)arg;
+
+    pthread_setspecific(thread_key, (void *)(task_id + 1));
+
+    /* wait for OS_TaskCreate to put the thread handle in the record */
+    pthread_mutex_lock(&OS_task_table_mut);
+    pthread_mutex_unlock(&OS_task_table_mut);
+
+    (OS_TASK_RECORD(task_id)->entry_function)();
+
+    return(NULL);
 }
 
 /*---------------------------------------------------------------------------------------
@@ -0,0 +1,489 @@
+/*
+** File   : osarena.c
+**
+**      Copyright (c) 2004-2006, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+** Purpose: This file contains the arena API of the posix OSAL. An arena is a
+**          mapping of a fixed size that belongs to the task that created it.
+**          Allocating from it moves a pointer forward, and a reset gives all
+**          of it back at once, so a task that frees everything it allocated at
+**          the end of a cycle never calls malloc or free. The arenas of a task
+**          are deleted with it.
+*/
+
+/****************************************************************************************
+                                    INCLUDE FILES
+****************************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "common_types.h"
+#include "osapi.h"
+#include "osposix.h"
+#include "osobject.h"
+
+/****************************************************************************************
+                                     DEFINES
+****************************************************************************************/
+
+/* every allocation starts on this boundary, as malloc does */
+#define OS_ARENA_ALIGN      16
+
+/****************************************************************************************
+                                   GLOBAL DATA
+****************************************************************************************/
+
+/* arenas */
+typedef struct
+{
+    int              free;
+    char             name[OS_MAX_API_NAME];
+    uint32           creator;      /* the task the arena belongs to */
+    uint32           flags;
+    char            *base;
+    size_t           size;         /* as asked for */
+    size_t           map_size;
+    int              huge;         /* mapped from huge pages */
+    size_t           used;
+    size_t           high_water;   /* as of the last reset */
+    uint64           failures;
+} OS_arena_record_t;
+
+OS_object_table_t   OS_arena_table;
+pthread_mutex_t     OS_arena_table_mut;
+
+static int          OS_arena_initialized = FALSE;
+
+#define OS_ARENA_RECORD(id)   ((OS_arena_record_t *)OS_ObjectRecord(&OS_arena_table, id))
+
+uint32  OS_FindCreator(void);
+
+/****************************************************************************************
+                                 LOCAL FUNCTIONS
+****************************************************************************************/
+
+/*
+** Marks a new arena table record as free
+*/
+static void OS_ArenaInitRecord(void *record)
+{
+    OS_arena_record_t *arena = record;
+
+    arena->free    = TRUE;
+    arena->creator = UNINITIALIZED;
+    arena->base    = NULL;
+    strcpy(arena->name, "");
+}
+
+/*
+** Tells whether id is an arena in use
+*/
+static int OS_ArenaValidId(uint32 id)
+{
+    return(id < OS_arena_table.num_records && OS_ARENA_RECORD(id)->free != TRUE);
+}
+
+/*
+** Maps the memory of an arena of size bytes. With OS_ARENA_HUGE_PAGES it is
+** taken from the huge pages of the system, or when there are none free the
+** kernel is advised to use transparent huge pages for it.
+*/
+static int32 OS_ArenaMap(OS_arena_record_t *arena, size_t size, uint32 flags)
+{
+    size_t  page_size;
+    void   *addr;
+
+    addr = MAP_FAILED;
+    page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+#ifdef MAP_HUGETLB
+    if ( (flags & OS_ARENA_HUGE_PAGES) != 0 )
+    {
+        page_size = OS_ARENA_HUGE_PAGE_SIZE;
+        arena->map_size = ((size + page_size - 1) / page_size) * page_size;
+        addr = mmap(NULL, arena->map_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+
+    arena->huge = (addr != MAP_FAILED);
+    if ( addr == MAP_FAILED )
+    {
+        arena->map_size = ((size + page_size - 1) / page_size) * page_size;
+        addr = mmap(NULL, arena->map_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if ( addr == MAP_FAILED )
+        {
+            return OS_ERROR;
+        }
+
+#ifdef MADV_HUGEPAGE
+        if ( (flags & OS_ARENA_HUGE_PAGES) != 0 )
+        {
+            madvise(addr, arena->map_size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+    arena->base = addr;
+    arena->size = size;
+
+    return OS_SUCCESS;
+}
+
+/****************************************************************************************
+                                     ARENA API
+****************************************************************************************/
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ArenaInit
+
+   Purpose: Initialize the table of arenas
+
+   Returns: OS_ERROR if the table cannot be set up
+            OS_SUCCESS if success
+
+   Notes: OS_API_Init calls it, calling it again does nothing
+---------------------------------------------------------------------------------------*/
+int32 OS_ArenaInit (void)
+{
+    uint32 max_arenas;
+
+    if ( OS_arena_initialized )
+    {
+        return OS_SUCCESS;
+    }
+
+    max_arenas = OS_api_config.max_arenas;
+    if ( max_arenas == 0 )
+    {
+        max_arenas = OS_MAX_ARENAS;
+    }
+
+    if ( OS_ObjectTableInit(&OS_arena_table, sizeof(OS_arena_record_t),
+                            max_arenas, OS_ArenaInitRecord) != OS_SUCCESS )
+    {
+        return OS_ERROR;
+    }
+
+    if ( pthread_mutex_init(&OS_arena_table_mut, NULL) != 0 )
+    {
+        return OS_ERROR;
+    }
+
+    OS_arena_initialized = TRUE;
+
+    return OS_SUCCESS;
+
+}/* end OS_ArenaInit */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ArenaCreate
+
+   Purpose: Create an arena of size bytes for the calling task to allocate from
+
+   Returns: OS_INVALID_POINTER if a pointer passed in is NULL
+            OS_ERR_NAME_TOO_LONG if the name passed in is too long
+            OS_ERR_NO_FREE_IDS if there are already the max arenas created
+            OS_ERR_NAME_TAKEN if the name is already used by an arena
+            OS_QUEUE_INVALID_SIZE if size is 0
+            OS_ERROR if the memory cannot be mapped
+            OS_SUCCESS if success
+
+   Notes: The arena belongs to the calling task, and is deleted when the task
+          is deleted or exits. flags may be OS_ARENA_HUGE_PAGES, which takes
+          the memory from the huge pages of the system when there are some
+          free. The pages are only backed by memory as they are first used.
+---------------------------------------------------------------------------------------*/
+int32 OS_ArenaCreate (uint32 *arena_id, const char *arena_name, uint32 size, uint32 flags)
+{
+    uint32             possible_id;
+    int32              return_code;
+    OS_arena_record_t *arena;
+
+    if ( arena_id == NULL || arena_name == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( strlen(arena_name) >= OS_MAX_API_NAME )
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ( size == 0 )
+    {
+        return OS_QUEUE_INVALID_SIZE;
+    }
+
+    /* Take a free arena Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_arena_table, &possible_id) != OS_SUCCESS )
+    {
+        return OS_ERR_NO_FREE_IDS;
+    }
+
+    /* Check to see if the name is already taken, and reserve it */
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_ARENA, arena_name, possible_id);
+    if ( return_code != OS_SUCCESS )
+    {
+        OS_ObjectRelease(&OS_arena_table, possible_id);
+        return return_code;
+    }
+
+    arena = OS_ARENA_RECORD(possible_id);
+
+    if ( OS_ArenaMap(arena, size, flags) != OS_SUCCESS )
+    {
+        pthread_mutex_lock(&OS_arena_table_mut);
+        OS_NameIndexRemove(OS_OBJECT_TYPE_ARENA, arena_name);
+        pthread_mutex_unlock(&OS_arena_table_mut);
+        OS_ObjectRelease(&OS_arena_table, possible_id);
+        return OS_ERROR;
+    }
+
+    arena->flags      = flags;
+    arena->used       = 0;
+    arena->high_water = 0;
+    arena->failures   = 0;
+
+    *arena_id = possible_id;
+
+    pthread_mutex_lock(&OS_arena_table_mut);
+
+    arena->free    = FALSE;
+    strcpy(arena->name, arena_name);
+    arena->creator = OS_FindCreator();
+
+    pthread_mutex_unlock(&OS_arena_table_mut);
+
+    return OS_SUCCESS;
+
+}/* end OS_ArenaCreate */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ArenaDelete
+
+   Purpose: Delete an arena and unmap its memory
+
+   Returns: OS_ERR_INVALID_ID if the id passed in is not an arena
+            OS_SUCCESS if success
+
+   Notes: Everything allocated from the arena is gone with it
+---------------------------------------------------------------------------------------*/
+int32 OS_ArenaDelete (uint32 arena_id)
+{
+    OS_arena_record_t *arena;
+    void              *base;
+    size_t             map_size;
+
+    pthread_mutex_lock(&OS_arena_table_mut);
+
+    if ( !OS_ArenaValidId(arena_id) )
+    {
+        pthread_mutex_unlock(&OS_arena_table_mut);
+        return OS_ERR_INVALID_ID;
+    }
+
+    arena = OS_ARENA_RECORD(arena_id);
+
+    OS_NameIndexRemove(OS_OBJECT_TYPE_ARENA, arena->name);
+    arena->free    = TRUE;
+    strcpy(arena->name, "");
+    arena->creator = UNINITIALIZED;
+    base           = arena->base;
+    map_size       = arena->map_size;
+    arena->base    = NULL;
+
+    pthread_mutex_unlock(&OS_arena_table_mut);
+
+    munmap(base, map_size);
+    OS_ObjectRelease(&OS_arena_table, arena_id);
+
+    return OS_SUCCESS;
+
+}/* end OS_ArenaDelete */
+
+/*
+** Deletes the arenas of a task, when it is deleted or exits
+*/
+void OS_ArenaDeleteByTask(uint32 task_id)
+{
+    uint32 i;
+
+    for ( i = 0; i < OS_arena_table.num_records; i++ )
+    {
+        if ( OS_ARENA_RECORD(i)->free != TRUE && OS_ARENA_RECORD(i)->creator == task_id )
+        {
+            OS_ArenaDelete(i);
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_ArenaGetIdByName
+
+    Purpose: This function tries to find an arena Id given its name.
+             The id is returned through arena_id
+
+    Returns: OS_INVALID_POINTER is arena_id or arena_name are NULL pointers
+             OS_ERR_NAME_TOO_LONG if the name given is to long to have been stored
+             OS_ERR_NAME_NOT_FOUND if the name was not found in the table
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_ArenaGetIdByName (uint32 *arena_id, const char *arena_name)
+{
+    uint32 i;
+
+    if ( arena_id == NULL || arena_name == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( strlen(arena_name) >= OS_MAX_API_NAME )
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ( (OS_NameIndexFind(OS_OBJECT_TYPE_ARENA, arena_name, &i) == OS_SUCCESS) &&
+         (OS_ARENA_RECORD(i)->free != TRUE) &&
+         (strcmp(OS_ARENA_RECORD(i)->name, arena_name) == 0) )
+    {
+        *arena_id = i;
+        return OS_SUCCESS;
+    }
+
+    return OS_ERR_NAME_NOT_FOUND;
+
+}/* end OS_ArenaGetIdByName */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_ArenaGetInfo
+
+    Purpose: This function will pass back the name and the task of the specified
+             arena, with the use of its memory.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid arena
+             OS_INVALID_POINTER if the arena_prop pointer is null
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_ArenaGetInfo (uint32 arena_id, OS_arena_prop_t *arena_prop)
+{
+    OS_arena_record_t *arena;
+
+    if ( !OS_ArenaValidId(arena_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( arena_prop == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    arena = OS_ARENA_RECORD(arena_id);
+
+    pthread_mutex_lock(&OS_arena_table_mut);
+
+    arena_prop->creator    = arena->creator;
+    strcpy(arena_prop->name, arena->name);
+    arena_prop->size       = (uint32)arena->size;
+    arena_prop->used       = (uint32)arena->used;
+    arena_prop->high_water = (uint32)((arena->used > arena->high_water) ?
+                                      arena->used : arena->high_water);
+    arena_prop->huge_pages = arena->huge;
+    arena_prop->failures   = arena->failures;
+
+    pthread_mutex_unlock(&OS_arena_table_mut);
+
+    return OS_SUCCESS;
+
+} /* end OS_ArenaGetInfo */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ArenaAlloc
+
+   Purpose: Allocate size bytes from an arena
+
+   Returns: OS_ERR_INVALID_ID if the arena id passed in is not an arena
+            OS_INVALID_POINTER if ptr is NULL
+            OS_ERROR if the arena does not have size bytes left
+            OS_SUCCESS if success
+
+   Notes: The memory starts on a 16 byte boundary, and stays allocated until
+          the arena is reset. Only the task the arena belongs to may allocate
+          from it, without any lock; other tasks may use the memory.
+---------------------------------------------------------------------------------------*/
+int32 OS_ArenaAlloc (uint32 arena_id, uint32 size, void **ptr)
+{
+    OS_arena_record_t *arena;
+    size_t             start;
+
+    if ( !OS_ArenaValidId(arena_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( ptr == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    arena = OS_ARENA_RECORD(arena_id);
+
+    start = (arena->used + OS_ARENA_ALIGN - 1) & ~((size_t)OS_ARENA_ALIGN - 1);
+    if ( start > arena->size || size > arena->size - start )
+    {
+        arena->failures++;
+        return OS_ERROR;
+    }
+
+    arena->used = start + size;
+    *ptr = arena->base + start;
+
+    return OS_SUCCESS;
+
+}/* end OS_ArenaAlloc */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ArenaReset
+
+   Purpose: Give back everything allocated from an arena at once
+
+   Returns: OS_ERR_INVALID_ID if the arena id passed in is not an arena
+            OS_SUCCESS if success
+
+   Notes: The memory stays mapped, so the next cycle of the task reuses the
+          same pages. Only the task the arena belongs to may reset it.
+---------------------------------------------------------------------------------------*/
+int32 OS_ArenaReset (uint32 arena_id)
+{
+    OS_arena_record_t *arena;
+
+    if ( !OS_ArenaValidId(arena_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    arena = OS_ARENA_RECORD(arena_id);
+
+    if ( arena->used > arena->high_water )
+    {
+        arena->high_water = arena->used;
+    }
+    arena->used = 0;
+
+    return OS_SUCCESS;
+
+}/* end OS_ArenaReset */
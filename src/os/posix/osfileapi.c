@@ -82,6 +82,7 @@
 
 #include "common_types.h"
 #include "osapi.h"
+#include "osobject.h"
 
 /****************************************************************************************
                                      DEFINES
@@ -96,29 +97,29 @@
 ***************************************************************************************/
 
 int32 OS_check_name_length(const char *path);
+void  OS_FDInitRecord(void *record);
 extern uint32 OS_FindCreator(void);
 
 /****************************************************************************************
                                    GLOBAL DATA
 ****************************************************************************************/
 
-OS_FDTableEntry OS_FDTable[OS_MAX_NUM_OPEN_FILES];
+OS_object_table_t OS_FDTable;
 pthread_mutex_t OS_FDTableMutex;
+
+#define OS_FD_RECORD(fd) ((OS_FDTableEntry *)OS_ObjectRecord(&OS_FDTable, fd))
 /****************************************************************************************
                                 INITIALIZATION FUNCTION
 ****************************************************************************************/
 int32 OS_FS_Init(void)
 {
-    int i;
     int ret;	
 
     /* Initialize the file system constructs */
-    for (i =0; i < OS_MAX_NUM_OPEN_FILES; i++)
+    if ( OS_ObjectTableInit(&OS_FDTable, sizeof(OS_FDTableEntry),
+                            OS_api_config.max_open_files, OS_FDInitRecord) != OS_SUCCESS )
     {
-        OS_FDTable[i].OSfd =       -1;
-        strcpy(OS_FDTable[i].Path, "\0");
-        OS_FDTable[i].User =       0;
-        OS_FDTable[i].IsValid =    FALSE;
+        return(OS_ERROR);
     }
     
     ret = pthread_mutex_init((pthread_mutex_t *) & OS_FDTableMutex,NULL); 
@@ -133,6 +134,19 @@ int32 OS_FS_Init(void)
     }
 
 }
+
+/*
+** Marks a new file descriptor table entry as unused
+*/
+void OS_FDInitRecord(void *record)
+{
+    OS_FDTableEntry *entry = record;
+
+    entry->OSfd =       -1;
+    strcpy(entry->Path, "\0");
+    entry->User =       0;
+    entry->IsValid =    FALSE;
+}
 /****************************************************************************************
                                     Filesys API
 ****************************************************************************************/
@@ -214,28 +228,14 @@ int32 OS_creat  (const char *path, int32  access)
         return OS_FS_ERR_PATH_INVALID;
     }
     
-    pthread_mutex_lock(&OS_FDTableMutex);
-
-    for ( PossibleFD = 0; PossibleFD < OS_MAX_NUM_OPEN_FILES; PossibleFD++)
-    {
-        if( OS_FDTable[PossibleFD].IsValid == FALSE)
-        {
-            break;
-        }
-    }
-
-    if (PossibleFD >= OS_MAX_NUM_OPEN_FILES)
+    /* Take a free file descriptor, no other
+     * task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_FDTable, &PossibleFD) != OS_SUCCESS )
     {
-        pthread_mutex_unlock(&OS_FDTableMutex);
         return OS_FS_ERR_NO_FREE_FDS;
     }
 
-
-    /* Mark the table entry as valid so no other 
-     * task can take that ID */
-    OS_FDTable[PossibleFD].IsValid =    TRUE;
-
-    pthread_mutex_unlock(&OS_FDTableMutex);
+    OS_FD_RECORD(PossibleFD)->IsValid =    TRUE;
 
     mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
    
@@ -246,17 +246,18 @@ int32 OS_creat  (const char *path, int32  access)
     if (status != ERROR)
     {
         /* fill in the table before returning */
-        OS_FDTable[PossibleFD].OSfd =       status;
-        strncpy(OS_FDTable[PossibleFD].Path, path, OS_MAX_PATH_LEN);
-        OS_FDTable[PossibleFD].User =       OS_FindCreator();
+        OS_FD_RECORD(PossibleFD)->OSfd =       status;
+        strncpy(OS_FD_RECORD(PossibleFD)->Path, path, OS_MAX_PATH_LEN);
+        OS_FD_RECORD(PossibleFD)->User =       OS_FindCreator();
         pthread_mutex_unlock(&OS_FDTableMutex);
         return PossibleFD;
     }
     else
     {
         /* Operation failed, so reset to false */
-        OS_FDTable[PossibleFD].IsValid = FALSE;
+        OS_FD_RECORD(PossibleFD)->IsValid = FALSE;
         pthread_mutex_unlock(&OS_FDTableMutex);
+        OS_ObjectRelease(&OS_FDTable, PossibleFD);
         return OS_FS_ERROR;
     }
  
@@ -334,28 +335,14 @@ int32 OS_open   (const char *path,  int32 access,  uint32  mode)
         return OS_FS_ERR_PATH_INVALID;
     }
     
-    pthread_mutex_lock(&OS_FDTableMutex);
-
-    for ( PossibleFD = 0; PossibleFD < OS_MAX_NUM_OPEN_FILES; PossibleFD++)
-    {
-        if( OS_FDTable[PossibleFD].IsValid == FALSE)
-        {
-            break;
-        }
-    }
-
-    if (PossibleFD >= OS_MAX_NUM_OPEN_FILES)
+    /* Take a free file descriptor, no other
+     * task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_FDTable, &PossibleFD) != OS_SUCCESS )
     {
-        pthread_mutex_unlock(&OS_FDTableMutex);
-
         return OS_FS_ERR_NO_FREE_FDS;
     }
 
-    /* Mark the table entry as valid so no other 
-     * task can take that ID */
-    OS_FDTable[PossibleFD].IsValid = TRUE;
-
-    pthread_mutex_unlock(&OS_FDTableMutex);
+    OS_FD_RECORD(PossibleFD)->IsValid =    TRUE;
 
     /* open the file  */
     status =  open(local_path, perm, mode);
@@ -365,9 +352,9 @@ int32 OS_open   (const char *path,  int32 access,  uint32  mode)
     if (status != ERROR)
     {
         /* fill in the table before returning */
-        OS_FDTable[PossibleFD].OSfd =       status;
-        strncpy(OS_FDTable[PossibleFD].Path, path, OS_MAX_PATH_LEN);
-        OS_FDTable[PossibleFD].User =       OS_FindCreator();
+        OS_FD_RECORD(PossibleFD)->OSfd =       status;
+        strncpy(OS_FD_RECORD(PossibleFD)->Path, path, OS_MAX_PATH_LEN);
+        OS_FD_RECORD(PossibleFD)->User =       OS_FindCreator();
         pthread_mutex_unlock(&OS_FDTableMutex);
         
         return PossibleFD;
@@ -375,8 +362,9 @@ int32 OS_open   (const char *path,  int32 access,  uint32  mode)
     else
     {
         /* Operation failed, so reset to false */
-        OS_FDTable[PossibleFD].IsValid = FALSE;
+        OS_FD_RECORD(PossibleFD)->IsValid = FALSE;
         pthread_mutex_unlock(&OS_FDTableMutex);
+        OS_ObjectRelease(&OS_FDTable, PossibleFD);
         return OS_FS_ERROR;
     }
  
@@ -398,7 +386,7 @@ int32 OS_close (int32  filedes)
     int status;
 
     /* Make sure the file descriptor is legit before using it */
-    if (filedes < 0 || filedes >= OS_MAX_NUM_OPEN_FILES || OS_FDTable[filedes].IsValid == FALSE)
+    if (filedes < 0 || filedes >= OS_FDTable.num_records || OS_FD_RECORD(filedes)->IsValid == FALSE)
     {
         return OS_FS_ERR_INVALID_FD;
     }
@@ -410,7 +398,7 @@ int32 OS_close (int32  filedes)
         */
         do
         {
-            status = close ((int) OS_FDTable[filedes].OSfd);
+            status = close ((int) OS_FD_RECORD(filedes)->OSfd);
         } while ( status == -1 && errno == EINTR );
 
         if (status == ERROR)
@@ -421,11 +409,12 @@ int32 OS_close (int32  filedes)
             */
             /* fill in the table before returning */
             pthread_mutex_lock(&OS_FDTableMutex);
-            OS_FDTable[filedes].OSfd =       -1;
-            strcpy(OS_FDTable[filedes].Path, "\0");
-            OS_FDTable[filedes].User =       0;
-            OS_FDTable[filedes].IsValid =    FALSE;
+            OS_FD_RECORD(filedes)->OSfd =       -1;
+            strcpy(OS_FD_RECORD(filedes)->Path, "\0");
+            OS_FD_RECORD(filedes)->User =       0;
+            OS_FD_RECORD(filedes)->IsValid =    FALSE;
             pthread_mutex_unlock(&OS_FDTableMutex);
+            OS_ObjectRelease(&OS_FDTable, filedes);
 
             return OS_FS_ERROR;
         }
@@ -433,11 +422,12 @@ int32 OS_close (int32  filedes)
         {
             /* fill in the table before returning */
             pthread_mutex_lock(&OS_FDTableMutex);
-            OS_FDTable[filedes].OSfd =       -1;
-            strcpy(OS_FDTable[filedes].Path, "\0");
-            OS_FDTable[filedes].User =       0;
-            OS_FDTable[filedes].IsValid =    FALSE;
+            OS_FD_RECORD(filedes)->OSfd =       -1;
+            strcpy(OS_FD_RECORD(filedes)->Path, "\0");
+            OS_FD_RECORD(filedes)->User =       0;
+            OS_FD_RECORD(filedes)->IsValid =    FALSE;
             pthread_mutex_unlock(&OS_FDTableMutex);
+            OS_ObjectRelease(&OS_FDTable, filedes);
             
             return OS_FS_SUCCESS;
         }
@@ -464,13 +454,13 @@ int32 OS_read  (int32  filedes, void *buffer, uint32 nbytes)
         return OS_FS_ERR_INVALID_POINTER;
 
     /* Make sure the file descriptor is legit before using it */
-    if (filedes < 0 || filedes >= OS_MAX_NUM_OPEN_FILES || OS_FDTable[filedes].IsValid == FALSE)
+    if (filedes < 0 || filedes >= OS_FDTable.num_records || OS_FD_RECORD(filedes)->IsValid == FALSE)
     {
         return OS_FS_ERR_INVALID_FD;
     }
     else
     { 
-        status = read (OS_FDTable[filedes].OSfd, buffer, nbytes);
+        status = read (OS_FD_RECORD(filedes)->OSfd, buffer, nbytes);
  
         if (status == ERROR)
             return OS_FS_ERROR;
@@ -500,13 +490,13 @@ int32 OS_write (int32  filedes, void *buffer, uint32 nbytes)
         return OS_FS_ERR_INVALID_POINTER;
 
     /* Make sure the file descriptor is legit before using it */
-    if (filedes < 0 || filedes >= OS_MAX_NUM_OPEN_FILES || OS_FDTable[filedes].IsValid == FALSE)
+    if (filedes < 0 || filedes >= OS_FDTable.num_records || OS_FD_RECORD(filedes)->IsValid == FALSE)
     {
         return OS_FS_ERR_INVALID_FD;
     }
     else
     {
-        status = write(OS_FDTable[filedes].OSfd, buffer, nbytes );
+        status = write(OS_FD_RECORD(filedes)->OSfd, buffer, nbytes );
     
         if (status != ERROR)
             return  status;
@@ -593,7 +583,7 @@ int32 OS_lseek  (int32  filedes, int32 offset, uint32 whence)
      int where;
 
     /* Make sure the file descriptor is legit before using it */
-    if (filedes < 0 || filedes >= OS_MAX_NUM_OPEN_FILES || OS_FDTable[filedes].IsValid == FALSE)
+    if (filedes < 0 || filedes >= OS_FDTable.num_records || OS_FD_RECORD(filedes)->IsValid == FALSE)
     {
         return OS_FS_ERR_INVALID_FD;
     }
@@ -615,7 +605,7 @@ int32 OS_lseek  (int32  filedes, int32 offset, uint32 whence)
         }
 
     
-        status = lseek( OS_FDTable[filedes].OSfd, (off_t) offset, (int) where );
+        status = lseek( OS_FD_RECORD(filedes)->OSfd, (off_t) offset, (int) where );
 
         if ( (int) status != ERROR)
             return (int32) status;
@@ -748,12 +738,12 @@ int32 OS_rename (const char *old, const char *new)
     status = rename (old_path, new_path);
     if (status != ERROR)
     {
-        for ( i =0; i < OS_MAX_NUM_OPEN_FILES; i++) 
+        for ( i =0; i < OS_FDTable.num_records; i++) 
         {
-            if (strcmp(OS_FDTable[i].Path, old) == 0 &&
-                OS_FDTable[i].IsValid == TRUE)
+            if (strcmp(OS_FD_RECORD(i)->Path, old) == 0 &&
+                OS_FD_RECORD(i)->IsValid == TRUE)
             {
-                strncpy (OS_FDTable[i].Path, new, OS_MAX_PATH_LEN);  
+                strncpy (OS_FD_RECORD(i)->Path, new, OS_MAX_PATH_LEN);  
             } 
         }
         return OS_FS_SUCCESS;
@@ -918,12 +908,12 @@ int32 OS_mv (const char *src, const char *dest)
     status = system(command);
     if (status != ERROR)
     {
-        for ( i =0; i < OS_MAX_NUM_OPEN_FILES; i++) 
+        for ( i =0; i < OS_FDTable.num_records; i++) 
         {
-            if (strcmp(OS_FDTable[i].Path, src) == 0 &&
-                OS_FDTable[i].IsValid == TRUE)
+            if (strcmp(OS_FD_RECORD(i)->Path, src) == 0 &&
+                OS_FD_RECORD(i)->IsValid == TRUE)
             {
-                strncpy (OS_FDTable[i].Path, dest, OS_MAX_PATH_LEN);  
+                strncpy (OS_FD_RECORD(i)->Path, dest, OS_MAX_PATH_LEN);  
             } 
         }
         return OS_FS_SUCCESS;
@@ -1239,7 +1229,7 @@ int32 OS_ShellOutputToFile(char* Cmd, int32 OS_fd)
     int32 Result;
 
     /* Make sure the file descriptor is legit before using it */
-    if (OS_fd < 0 || OS_fd >= OS_MAX_NUM_OPEN_FILES || OS_FDTable[OS_fd].IsValid == FALSE)
+    if (OS_fd < 0 || OS_fd >= OS_FDTable.num_records || OS_FD_RECORD(OS_fd)->IsValid == FALSE)
     {
         return OS_FS_ERR_INVALID_FD;
     }
@@ -1249,14 +1239,14 @@ int32 OS_ShellOutputToFile(char* Cmd, int32 OS_fd)
         strncpy(LocalCmd,Cmd,OS_MAX_CMD_LEN +OS_REDIRECTSTRSIZE);
     
         /* Make sure that we are able to access this file */
-        fchmod(OS_FDTable[OS_fd].OSfd,0777);
+        fchmod(OS_FD_RECORD(OS_fd)->OSfd,0777);
   
 
         /* add in the extra chars necessary to perform the redirection
         1 for stdout and 2 for stderr. they are redirected to the 
         file descriptor passed in
         */
-        sprintf(String, " 1>&%d 2>&%d",(int)OS_FDTable[OS_fd].OSfd, (int)OS_FDTable[OS_fd].OSfd);
+        sprintf(String, " 1>&%d 2>&%d",(int)OS_FD_RECORD(OS_fd)->OSfd, (int)OS_FD_RECORD(OS_fd)->OSfd);
         strcat(LocalCmd, String);
 
     
@@ -1295,14 +1285,14 @@ int32 OS_FDGetInfo (int32 filedes, OS_FDTableEntry *fd_prop)
     }
 
     /* Make sure the file descriptor is legit before using it */
-    if (filedes < 0 || filedes >= OS_MAX_NUM_OPEN_FILES || OS_FDTable[filedes].IsValid == FALSE)
+    if (filedes < 0 || filedes >= OS_FDTable.num_records || OS_FD_RECORD(filedes)->IsValid == FALSE)
     {
        (*(fd_prop)).IsValid = FALSE; 
         return OS_FS_ERR_INVALID_FD;
     }
     else
     { 
-        *fd_prop = OS_FDTable[filedes];
+        *fd_prop = *OS_FD_RECORD(filedes);
         return OS_FS_SUCCESS;
     }
 
@@ -1327,9 +1317,9 @@ int32 OS_FileOpenCheck(char *Filename)
 
     pthread_mutex_lock(&OS_FDTableMutex);
 
-    for ( i = 0; i < OS_MAX_NUM_OPEN_FILES; i++)
+    for ( i = 0; i < OS_FDTable.num_records; i++)
     {
-        if ((OS_FDTable[i].IsValid == TRUE) &&  (strcmp(OS_FDTable[i].Path, Filename) == 0))
+        if ((OS_FD_RECORD(i)->IsValid == TRUE) &&  (strcmp(OS_FD_RECORD(i)->Path, Filename) == 0))
         {
            pthread_mutex_unlock(&OS_FDTableMutex);
            return(OS_FS_SUCCESS);
@@ -1365,24 +1355,25 @@ int32 OS_CloseFileByName(char *Filename)
 
     pthread_mutex_lock(&OS_FDTableMutex);
 
-    for ( i = 0; i < OS_MAX_NUM_OPEN_FILES; i++)
+    for ( i = 0; i < OS_FDTable.num_records; i++)
     {
-        if ((OS_FDTable[i].IsValid == TRUE) &&  (strcmp(OS_FDTable[i].Path, Filename) == 0))
+        if ((OS_FD_RECORD(i)->IsValid == TRUE) &&  (strcmp(OS_FD_RECORD(i)->Path, Filename) == 0))
         {
            /*
            ** Close the file
            */
-           status = close ((int) OS_FDTable[i].OSfd);
+           status = close ((int) OS_FD_RECORD(i)->OSfd);
 
            /*
            ** Next, remove the file from the OSAL list
            ** to free up that slot
            */
-           OS_FDTable[i].OSfd =       -1;
-           strcpy(OS_FDTable[i].Path, "\0");
-           OS_FDTable[i].User =       0;
-           OS_FDTable[i].IsValid =    FALSE;
+           OS_FD_RECORD(i)->OSfd =       -1;
+           strcpy(OS_FD_RECORD(i)->Path, "\0");
+           OS_FD_RECORD(i)->User =       0;
+           OS_FD_RECORD(i)->IsValid =    FALSE;
            pthread_mutex_unlock(&OS_FDTableMutex);
+           OS_ObjectRelease(&OS_FDTable, i);
 
            if (status == ERROR)
            {
@@ -1417,23 +1408,24 @@ int32 OS_CloseAllFiles(void)
     
     pthread_mutex_lock(&OS_FDTableMutex);
 
-    for ( i = 0; i < OS_MAX_NUM_OPEN_FILES; i++)
+    for ( i = 0; i < OS_FDTable.num_records; i++)
     {
-        if ( OS_FDTable[i].IsValid == TRUE )
+        if ( OS_FD_RECORD(i)->IsValid == TRUE )
         {
            /*
            ** Close the file
            */
-           status = close ((int) OS_FDTable[i].OSfd);
+           status = close ((int) OS_FD_RECORD(i)->OSfd);
 
            /*
            ** Next, remove the file from the OSAL list
            ** to free up that slot
            */
-           OS_FDTable[i].OSfd =       -1;
-           strcpy(OS_FDTable[i].Path, "\0");
-           OS_FDTable[i].User =       0;
-           OS_FDTable[i].IsValid =    FALSE;
+           OS_FD_RECORD(i)->OSfd =       -1;
+           strcpy(OS_FD_RECORD(i)->Path, "\0");
+           OS_FD_RECORD(i)->User =       0;
+           OS_FD_RECORD(i)->IsValid =    FALSE;
+           OS_ObjectRelease(&OS_FDTable, i);
            if (status == ERROR)
            {
               return_status = OS_FS_ERROR;
@@ -0,0 +1,257 @@
+/*
+** File   : osfutex.c
+**
+**      Copyright (c) 2004-2006, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+** Purpose: This file contains the futex based semaphores used by the binary
+**          and counting semaphore API when OS_USE_FUTEX_SEMAPHORES is defined.
+**          Giving and taking a semaphore that nobody waits on costs a compare
+**          and swap, and no system call. The ring buffer queues sleep on the
+**          same futex calls when OSAL_RING_QUEUE is defined.
+*/
+
+/****************************************************************************************
+                                    INCLUDE FILES
+****************************************************************************************/
+
+#include "common_types.h"
+#include "osapi.h"
+
+#if defined(OS_USE_FUTEX_SEMAPHORES) || defined(OSAL_RING_QUEUE)
+
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "osfutex.h"
+
+/****************************************************************************************
+                                     FUTEX CALLS
+****************************************************************************************/
+
+/*
+** Sleeps while the futex word still holds val, until the absolute
+** CLOCK_REALTIME time abs_timeout, or forever if it is NULL
+*/
+int OS_FutexWait(volatile uint32 *addr, uint32 val, const struct timespec *abs_timeout)
+{
+   return(syscall(SYS_futex, addr, FUTEX_WAIT_BITSET_PRIVATE | FUTEX_CLOCK_REALTIME,
+                  val, abs_timeout, NULL, FUTEX_BITSET_MATCH_ANY));
+}
+
+/*
+** Wakes up to count tasks sleeping on the futex word
+*/
+int OS_FutexWake(volatile uint32 *addr, int count)
+{
+   return(syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0));
+}
+
+/*
+** Same as OS_FutexWait and OS_FutexWake, for a futex word in memory shared with
+** other processes
+*/
+int OS_FutexWaitShared(volatile uint32 *addr, uint32 val, const struct timespec *abs_timeout)
+{
+   return(syscall(SYS_futex, addr, FUTEX_WAIT_BITSET | FUTEX_CLOCK_REALTIME,
+                  val, abs_timeout, NULL, FUTEX_BITSET_MATCH_ANY));
+}
+
+int OS_FutexWakeShared(volatile uint32 *addr, int count)
+{
+   return(syscall(SYS_futex, addr, FUTEX_WAKE, count, NULL, NULL, 0));
+}
+
+/*
+** Takes the semaphore if its value is above zero, without waiting
+*/
+static int OS_FutexSemTryTake(OS_futex_sem_t *sem)
+{
+   int32 value;
+
+   value = sem->value;
+   while ( value > 0 )
+   {
+      if ( __sync_bool_compare_and_swap(&sem->value, value, value - 1) )
+      {
+         return(TRUE);
+      }
+      value = sem->value;
+   }
+
+   return(FALSE);
+}
+
+/****************************************************************************************
+                                 FUTEX SEMAPHORE API
+****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_FutexSemInit
+
+    Purpose: Initializes a semaphore with a value of initial_value, that can be
+             given up to max_value.
+
+    Returns: Nothing
+---------------------------------------------------------------------------------------*/
+void OS_FutexSemInit(OS_futex_sem_t *sem, int32 initial_value, int32 max_value)
+{
+   sem->value     = initial_value;
+   sem->seq       = 0;
+   sem->waiters   = 0;
+   sem->flush_gen = 0;
+   sem->max_value = max_value;
+
+}/* end OS_FutexSemInit */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_FutexSemGive
+
+    Purpose: Increments the value of the semaphore, unless it is already at its
+             maximum, and wakes up one of the tasks waiting on it.
+
+    Returns: OS_SEM_FAILURE if the waiting task could not be woken up
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_FutexSemGive(OS_futex_sem_t *sem)
+{
+   int32 value;
+
+   do
+   {
+      value = sem->value;
+      if ( value >= sem->max_value )
+      {
+         return(OS_SUCCESS);
+      }
+   } while ( !__sync_bool_compare_and_swap(&sem->value, value, value + 1) );
+
+   /*
+   ** The compare and swap is a full barrier, so a task that is about to sleep
+   ** has either counted itself in waiters, or it will see the new value
+   */
+   if ( sem->waiters != 0 )
+   {
+      __sync_fetch_and_add(&sem->seq, 1);
+      if ( OS_FutexWake(&sem->seq, 1) < 0 )
+      {
+         return(OS_SEM_FAILURE);
+      }
+   }
+
+   return(OS_SUCCESS);
+
+}/* end OS_FutexSemGive */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_FutexSemTake
+
+    Purpose: Decrements the value of the semaphore, waiting for it to be above zero
+             until abs_timeout, or forever if abs_timeout is NULL. A task waiting
+             when the semaphore is flushed returns without decrementing it.
+
+    Returns: OS_SEM_TIMEOUT if the semaphore was not given before abs_timeout
+             OS_SEM_FAILURE if the OS call failed
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_FutexSemTake(OS_futex_sem_t *sem, const struct timespec *abs_timeout)
+{
+   uint32 seq;
+   uint32 flush_gen;
+   int    ret;
+
+   for ( ;; )
+   {
+      if ( OS_FutexSemTryTake(sem) )
+      {
+         return(OS_SUCCESS);
+      }
+
+      seq       = sem->seq;
+      flush_gen = sem->flush_gen;
+
+      __sync_fetch_and_add(&sem->waiters, 1);
+
+      /*
+      ** Check again now that the givers can see this task. If a give or a
+      ** flush gets in after this, seq no longer matches and the wait returns
+      */
+      ret = 0;
+      if ( sem->value <= 0 && sem->flush_gen == flush_gen )
+      {
+         ret = OS_FutexWait(&sem->seq, seq, abs_timeout);
+      }
+
+      __sync_fetch_and_sub(&sem->waiters, 1);
+
+      if ( sem->flush_gen != flush_gen )
+      {
+         return(OS_SUCCESS);
+      }
+
+      if ( ret < 0 )
+      {
+         if ( errno == ETIMEDOUT )
+         {
+            /*
+            ** A give may have woken this task just as it timed out. Take the
+            ** semaphore if it is there, so that wakeup is not lost.
+            */
+            if ( OS_FutexSemTryTake(sem) )
+            {
+               return(OS_SUCCESS);
+            }
+            return(OS_SEM_TIMEOUT);
+         }
+         else if ( errno != EAGAIN && errno != EINTR )
+         {
+            return(OS_SEM_FAILURE);
+         }
+      }
+   }
+
+}/* end OS_FutexSemTake */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_FutexSemFlush
+
+    Purpose: Releases all of the tasks waiting on the semaphore, without changing
+             its value.
+
+    Returns: OS_SEM_FAILURE if the waiting tasks could not be woken up
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_FutexSemFlush(OS_futex_sem_t *sem)
+{
+   __sync_fetch_and_add(&sem->flush_gen, 1);
+   __sync_fetch_and_add(&sem->seq, 1);
+
+   if ( OS_FutexWake(&sem->seq, INT_MAX) < 0 )
+   {
+      return(OS_SEM_FAILURE);
+   }
+
+   return(OS_SUCCESS);
+
+}/* end OS_FutexSemFlush */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_FutexSemValue
+
+    Purpose: Returns the current value of the semaphore.
+---------------------------------------------------------------------------------------*/
+int32 OS_FutexSemValue(OS_futex_sem_t *sem)
+{
+   return(sem->value);
+
+}/* end OS_FutexSemValue */
+
+#endif
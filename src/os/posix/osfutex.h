@@ -0,0 +1,60 @@
+/*
+** File   : osfutex.h
+**
+**      Copyright (c) 2004-2006, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+** Purpose: Futex based semaphores for the Linux port. They are used by the
+**          binary and counting semaphore API when OS_USE_FUTEX_SEMAPHORES is
+**          defined in osconfig.h, and by the ring buffer queues when
+**          OSAL_RING_QUEUE is.
+*/
+#ifndef OSFUTEX_H
+#define OSFUTEX_H
+
+#include <time.h>
+
+#include "common_types.h"
+#include "osapi.h"
+
+/*
+** A semaphore is a counter changed with atomic instructions. A task only
+** makes a system call when it has to sleep, or when it gives a semaphore
+** that has tasks sleeping on it.
+**
+** Sleeping tasks wait on seq, which is bumped by every give that finds
+** waiters and by every flush. A flush also bumps flush_gen, so the tasks
+** that were waiting when it happened return without taking the semaphore.
+*/
+typedef struct
+{
+   volatile int32   value;
+   volatile uint32  seq;
+   volatile uint32  waiters;
+   volatile uint32  flush_gen;
+   int32            max_value;
+} OS_futex_sem_t;
+
+/*
+** Futex calls, also used by the ring buffer queues
+*/
+int   OS_FutexWait       (volatile uint32 *addr, uint32 val, const struct timespec *abs_timeout);
+int   OS_FutexWake       (volatile uint32 *addr, int count);
+int   OS_FutexWaitShared (volatile uint32 *addr, uint32 val, const struct timespec *abs_timeout);
+int   OS_FutexWakeShared (volatile uint32 *addr, int count);
+
+/*
+** Futex semaphore API
+*/
+void  OS_FutexSemInit    (OS_futex_sem_t *sem, int32 initial_value, int32 max_value);
+int32 OS_FutexSemGive    (OS_futex_sem_t *sem);
+int32 OS_FutexSemTake    (OS_futex_sem_t *sem, const struct timespec *abs_timeout);
+int32 OS_FutexSemFlush   (OS_futex_sem_t *sem);
+int32 OS_FutexSemValue   (OS_futex_sem_t *sem);
+
+#endif
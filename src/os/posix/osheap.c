@@ -0,0 +1,359 @@
+/*
+** File   : osheap.c
+**
+**      Copyright (c) 2004-2006, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+** Purpose: This file contains the heap API of the posix OSAL. The state of the
+**          heap comes from the statistics of the glibc allocator. With
+**          OS_HEAP_ACCOUNTING defined in osconfig.h, the malloc family is
+**          wrapped here as well, and each allocation and free is counted
+**          against the OSAL task that made it.
+*/
+
+/****************************************************************************************
+                                    INCLUDE FILES
+****************************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "common_types.h"
+#include "osapi.h"
+#include "osposix.h"
+#include "osobject.h"
+
+/****************************************************************************************
+                                   GLOBAL DATA
+****************************************************************************************/
+
+/* mallinfo2 does not wrap its counts at 2 GB */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+typedef struct mallinfo2 OS_mallinfo_t;
+#define OS_MALLINFO()   mallinfo2()
+#elif defined(__GLIBC__)
+typedef struct mallinfo  OS_mallinfo_t;
+#define OS_MALLINFO()   mallinfo()
+#endif
+
+#ifdef OS_HEAP_ACCOUNTING
+
+/*
+** Allocations of a task, on a cache line of their own. Only the task itself
+** adds to them, the threads that are not OSAL tasks share the last ones and
+** add with atomics.
+*/
+typedef struct
+{
+    uint64  allocs OS_ALIGN(OS_CACHE_LINE);
+    uint64  frees;
+    uint64  bytes_allocated;
+    uint64  bytes_freed;
+} OS_heap_counters_t;
+
+static OS_heap_counters_t *OS_heap_counters;    /* max_tasks + 1, NULL until OS_HeapInit */
+static uint32              OS_heap_other;       /* the counters of the other threads */
+
+uint32  OS_FindCreator(void);
+
+/* the glibc allocator behind the wrappers */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void  __libc_free(void *ptr);
+
+#endif
+
+/****************************************************************************************
+                                 LOCAL FUNCTIONS
+****************************************************************************************/
+
+#ifdef OS_HEAP_ACCOUNTING
+/*
+** Counts an allocation (sign 1) or a free (sign -1) of the block at ptr
+** against the calling task
+*/
+static void OS_HeapCount(void *ptr, int sign)
+{
+    OS_heap_counters_t *counters;
+    uint32              task_id;
+    size_t              size;
+
+    if ( OS_heap_counters == NULL || ptr == NULL )
+    {
+        return;
+    }
+
+    size    = malloc_usable_size(ptr);
+    task_id = OS_FindCreator();
+
+    if ( task_id < OS_heap_other )
+    {
+        counters = &OS_heap_counters[task_id];
+        if ( sign > 0 )
+        {
+            counters->allocs++;
+            counters->bytes_allocated += size;
+        }
+        else
+        {
+            counters->frees++;
+            counters->bytes_freed += size;
+        }
+    }
+    else
+    {
+        counters = &OS_heap_counters[OS_heap_other];
+        if ( sign > 0 )
+        {
+            __sync_fetch_and_add(&counters->allocs, 1);
+            __sync_fetch_and_add(&counters->bytes_allocated, size);
+        }
+        else
+        {
+            __sync_fetch_and_add(&counters->frees, 1);
+            __sync_fetch_and_add(&counters->bytes_freed, size);
+        }
+    }
+}
+
+/****************************************************************************************
+                                  MALLOC WRAPPERS
+****************************************************************************************/
+
+/*
+** These take the place of the glibc functions for the whole program, the
+** libraries included, and count the usable size of each block.
+*/
+void *malloc(size_t size)
+{
+    void *ptr;
+
+    ptr = __libc_malloc(size);
+    OS_HeapCount(ptr, 1);
+
+    return(ptr);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    void *ptr;
+
+    ptr = __libc_calloc(count, size);
+    OS_HeapCount(ptr, 1);
+
+    return(ptr);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    void *new_ptr;
+
+    OS_HeapCount(ptr, -1);
+    new_ptr = __libc_realloc(ptr, size);
+    if ( new_ptr != NULL )
+    {
+        OS_HeapCount(new_ptr, 1);
+    }
+    else if ( size != 0 )
+    {
+        /* the old block is still there */
+        OS_HeapCount(ptr, 1);
+    }
+
+    return(new_ptr);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    void *ptr;
+
+    ptr = __libc_memalign(alignment, size);
+    OS_HeapCount(ptr, 1);
+
+    return(ptr);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    return(memalign(alignment, size));
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    void *ptr;
+
+    if ( alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0 )
+    {
+        return(EINVAL);
+    }
+
+    ptr = memalign(alignment, size);
+    if ( ptr == NULL && size != 0 )
+    {
+        return(ENOMEM);
+    }
+
+    *memptr = ptr;
+    return(0);
+}
+
+void free(void *ptr)
+{
+    OS_HeapCount(ptr, -1);
+    __libc_free(ptr);
+}
+#endif
+
+/****************************************************************************************
+                                     HEAP API
+****************************************************************************************/
+
+/*
+** Sets up the allocation counters of the tasks, see OS_HeapGetTaskInfo
+*/
+int32 OS_HeapInit(void)
+{
+#ifdef OS_HEAP_ACCOUNTING
+    OS_heap_counters_t *counters;
+
+    if ( OS_heap_counters != NULL )
+    {
+        return OS_SUCCESS;
+    }
+
+    counters = __libc_memalign(OS_CACHE_LINE,
+                               sizeof(OS_heap_counters_t) * (OS_api_config.max_tasks + 1));
+    if ( counters == NULL )
+    {
+        return OS_ERROR;
+    }
+    memset(counters, 0, sizeof(OS_heap_counters_t) * (OS_api_config.max_tasks + 1));
+
+    OS_heap_other    = OS_api_config.max_tasks;
+    OS_heap_counters = counters;
+#endif
+
+    return OS_SUCCESS;
+}
+
+/*
+** Clears the allocation counters of a task that is about to start
+*/
+void OS_HeapTaskStart(uint32 task_id)
+{
+#ifdef OS_HEAP_ACCOUNTING
+    if ( OS_heap_counters != NULL && task_id < OS_heap_other )
+    {
+        memset(&OS_heap_counters[task_id], 0, sizeof(OS_heap_counters_t));
+    }
+#endif
+}
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_HeapGetInfo
+
+   Purpose: Return current info on the heap
+
+   Returns: OS_INVALID_POINTER if heap_prop is NULL
+            OS_ERR_NOT_IMPLEMENTED if the C library keeps no statistics
+            OS_SUCCESS if success
+
+   Notes: The free bytes and blocks are the ones of all the malloc arenas. The
+          largest free block is the free space at the top of the main arena,
+          which a large allocation is carved from; a free block inside the
+          heap may be larger. The values stop at 0xFFFFFFFF.
+---------------------------------------------------------------------------------------*/
+int32 OS_HeapGetInfo (OS_heap_prop_t *heap_prop)
+{
+#ifdef __GLIBC__
+    OS_mallinfo_t info;
+    uint64        free_bytes;
+    uint64        free_blocks;
+    uint64        largest;
+#endif
+
+    if ( heap_prop == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+#ifdef __GLIBC__
+    info        = OS_MALLINFO();
+    free_bytes  = (uint64)info.fordblks;
+    free_blocks = (uint64)info.ordblks + (uint64)info.smblks;
+    largest     = (uint64)info.keepcost;
+
+    heap_prop->free_bytes         = (uint32)((free_bytes > 0xFFFFFFFF) ? 0xFFFFFFFF : free_bytes);
+    heap_prop->free_blocks        = (uint32)((free_blocks > 0xFFFFFFFF) ? 0xFFFFFFFF : free_blocks);
+    heap_prop->largest_free_block = (uint32)((largest > 0xFFFFFFFF) ? 0xFFFFFFFF : largest);
+
+    return OS_SUCCESS;
+#else
+    return OS_ERR_NOT_IMPLEMENTED;
+#endif
+
+} /* end OS_HeapGetInfo */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_HeapGetTaskInfo
+
+   Purpose: Return the allocations and frees a task has made since it was
+            created
+
+   Returns: OS_INVALID_POINTER if task_prop is NULL
+            OS_ERR_INVALID_ID if the id passed in is not a task
+            OS_ERR_NOT_IMPLEMENTED unless OS_HEAP_ACCOUNTING is defined
+            OS_SUCCESS if success
+
+   Notes: A block is counted against the task that allocates it, and its free
+          against the task that frees it, so the bytes allocated less the
+          bytes freed is what a task holds only when it frees its own blocks.
+          The sizes are the usable sizes of the blocks, which may be larger
+          than the ones asked for.
+---------------------------------------------------------------------------------------*/
+int32 OS_HeapGetTaskInfo (uint32 task_id, OS_heap_task_prop_t *task_prop)
+{
+    OS_task_prop_t task;
+
+    if ( task_prop == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( OS_TaskGetInfo(task_id, &task) != OS_SUCCESS )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+#ifdef OS_HEAP_ACCOUNTING
+    if ( OS_heap_counters == NULL || task_id >= OS_heap_other )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    task_prop->allocs          = OS_heap_counters[task_id].allocs;
+    task_prop->frees           = OS_heap_counters[task_id].frees;
+    task_prop->bytes_allocated = OS_heap_counters[task_id].bytes_allocated;
+    task_prop->bytes_freed     = OS_heap_counters[task_id].bytes_freed;
+
+    return OS_SUCCESS;
+#else
+    return OS_ERR_NOT_IMPLEMENTED;
+#endif
+
+} /* end OS_HeapGetTaskInfo */
@@ -32,6 +32,8 @@
 
 #include <dlfcn.h>
 
+#include "osobject.h"
+
 /*
 ** If OS_INCLUDE_MODULE_LOADER is not defined, skip the whole module
 */
@@ -57,6 +59,12 @@ OS_module_record_t OS_module_table[OS_MAX_MODULES];
 */
 pthread_mutex_t    OS_module_table_mut;
 
+/*
+** The free module Ids
+*/
+OS_id_pool_t       OS_module_id_pool;
+uint32             OS_module_id_map[OS_ID_POOL_WORDS(OS_MAX_MODULES)];
+
 /****************************************************************************************
                                 INITIALIZATION FUNCTION
 ****************************************************************************************/
@@ -77,6 +85,7 @@ int32  OS_ModuleTableInit ( void )
       strcpy(OS_module_table[i].name,"");
       strcpy(OS_module_table[i].filename,"");
    }
+   OS_IdPoolInit(&OS_module_id_pool, OS_module_id_map, OS_MAX_MODULES, OS_MAX_MODULES);
 
    /*
    ** Create the Module Table mutex
@@ -164,12 +173,12 @@ int32 OS_SymbolTableDump ( char *filename, uint32 SizeLimit )
     Returns: OS_ERROR if the module cannot be loaded
              OS_INVALID_POINTER if one of the parameters is NULL
              OS_ERR_NO_FREE_IDS if the module table is full
+             OS_ERR_NAME_TOO_LONG if the name is too long
              OS_ERR_NAME_TAKEN if the name is in use
              OS_SUCCESS if the module is loaded successfuly
 ---------------------------------------------------------------------------------------*/
 int32 OS_ModuleLoad ( uint32 *module_id, char *module_name, char *filename )
 {
-   int         i;
    uint32      possible_moduleid;
    char        translated_path[OS_MAX_LOCAL_PATH_LEN];
    int32       return_code;
@@ -184,48 +193,35 @@ int32 OS_ModuleLoad ( uint32 *module_id, char *module_name, char *filename )
       OS_printf("OSAL: Error, invalid parameters to OS_ModuleLoad\n");
       return(OS_INVALID_POINTER);
    }
-  
-   pthread_mutex_lock(&OS_module_table_mut); 
 
-   /*
-   ** Find a free module id
+   /* 
+   ** we don't want to allow names too long
+   ** if truncated, two names might be the same 
    */
-   for( possible_moduleid = 0; possible_moduleid < OS_MAX_MODULES; possible_moduleid++)
+   if (strlen(module_name) >= OS_MAX_API_NAME)
    {
-       if (OS_module_table[possible_moduleid].free == TRUE)
-       {
-           break;
-       }
+      return(OS_ERR_NAME_TOO_LONG);
    }
-
-   /* 
-   ** Check to see if the id is out of bounds 
+  
+   /*
+   ** Take a free module id, no other task can get it until it is released
    */
-   if( possible_moduleid >= OS_MAX_MODULES || OS_module_table[possible_moduleid].free != TRUE)
+   if ( OS_IdAllocate(&OS_module_id_pool, &possible_moduleid) != OS_SUCCESS )
    {
-       pthread_mutex_unlock(&OS_module_table_mut);
        return OS_ERR_NO_FREE_IDS;
    }
 
    /* 
-   ** Check to see if the module file is already loaded 
+   ** Check to see if the module file is already loaded, and reserve the name 
    */
-   for (i = 0; i < OS_MAX_MODULES; i++)
+   return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_MODULE, module_name, possible_moduleid);
+   if ( return_code != OS_SUCCESS )
    {
-       if ((OS_module_table[i].free == FALSE) &&
-          ( strcmp((char*) module_name, OS_module_table[i].name) == 0)) 
-       {       
-           pthread_mutex_unlock(&OS_module_table_mut);
-           return OS_ERR_NAME_TAKEN;
-       }
+       OS_IdRelease(&OS_module_id_pool, possible_moduleid);
+       return return_code;
    }
 
-   /* 
-   ** Set the possible task Id to not free so that
-   ** no other task can try to use it 
-   */
    OS_module_table[possible_moduleid].free = FALSE ;
-   pthread_mutex_unlock(&OS_module_table_mut);
  
    /*
    ** Translate the filename to the Host System
@@ -233,6 +229,11 @@ int32 OS_ModuleLoad ( uint32 *module_id, char *module_name, char *filename )
    return_code = OS_TranslatePath((const char *)filename, (char *)translated_path); 
    if ( return_code != OS_SUCCESS )
    {
+      pthread_mutex_lock(&OS_module_table_mut); 
+      OS_NameIndexRemove(OS_OBJECT_TYPE_MODULE, module_name);
+      OS_module_table[possible_moduleid].free = TRUE;
+      pthread_mutex_unlock(&OS_module_table_mut);
+      OS_IdRelease(&OS_module_id_pool, possible_moduleid);
       return(return_code);
    }
    /*
@@ -247,7 +248,11 @@ int32 OS_ModuleLoad ( uint32 *module_id, char *module_name, char *filename )
    if( dl_error )
    {
       OS_printf("OSAL: Error, cannot open application file: %s\n",dl_error);
+      pthread_mutex_lock(&OS_module_table_mut); 
+      OS_NameIndexRemove(OS_OBJECT_TYPE_MODULE, module_name);
       OS_module_table[possible_moduleid].free = TRUE;
+      pthread_mutex_unlock(&OS_module_table_mut);
+      OS_IdRelease(&OS_module_id_pool, possible_moduleid);
       return(OS_ERROR);
    }
 
@@ -306,10 +311,18 @@ int32 OS_ModuleUnload ( uint32 module_id )
    if( dlError )
    {
       OS_printf("OSAL Error, Cannot Unload module: %s\n",dlError);
+      pthread_mutex_lock(&OS_module_table_mut); 
+      OS_NameIndexRemove(OS_OBJECT_TYPE_MODULE, OS_module_table[module_id].name);
       OS_module_table[module_id].free = TRUE;  
+      pthread_mutex_unlock(&OS_module_table_mut);
+      OS_IdRelease(&OS_module_id_pool, module_id);
       return(OS_ERROR);
    }
+   pthread_mutex_lock(&OS_module_table_mut); 
+   OS_NameIndexRemove(OS_OBJECT_TYPE_MODULE, OS_module_table[module_id].name);
    OS_module_table[module_id].free = TRUE;
+   pthread_mutex_unlock(&OS_module_table_mut);
+   OS_IdRelease(&OS_module_id_pool, module_id);
  
    return(OS_SUCCESS);
    
@@ -0,0 +1,667 @@
+/*
+** File   : osmempool.c
+**
+**      Copyright (c) 2004-2006, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+** Purpose: This file contains the memory pool API of the posix OSAL. A pool
+**          holds a fixed number of fixed size blocks, all allocated when it
+**          is created. Allocating and freeing a block takes it off or puts it
+**          on a lock-free stack, and never calls malloc or makes a system call.
+*/
+
+/****************************************************************************************
+                                    INCLUDE FILES
+****************************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common_types.h"
+#include "osapi.h"
+#include "osposix.h"
+#include "osobject.h"
+#include "osmempool.h"
+
+/****************************************************************************************
+                                   GLOBAL DATA
+****************************************************************************************/
+
+/* memory pools */
+typedef struct
+{
+    int              free;
+    char             name[OS_MAX_API_NAME];
+    uint32           creator;
+    uint32           block_size;    /* as asked for, the blocks may be larger */
+    uint32           flags;
+    OS_block_pool_t  pool;
+} OS_mempool_record_t;
+
+OS_object_table_t   OS_mempool_table;
+pthread_mutex_t     OS_mempool_table_mut;
+
+static int          OS_mempool_initialized = FALSE;
+
+#define OS_MEMPOOL_RECORD(id)   ((OS_mempool_record_t *)OS_ObjectRecord(&OS_mempool_table, id))
+
+uint32  OS_FindCreator(void);
+
+/****************************************************************************************
+                                  BLOCK POOLS
+****************************************************************************************/
+
+/*
+** Takes up to max_count blocks off the free stack into indexes, and counts
+** them as taken. Returns the number of blocks taken.
+*/
+static uint32 OS_BlockPop(OS_block_pool_t *pool, uint32 *indexes, uint32 max_count)
+{
+    uint64  head;
+    uint64  next;
+    uint32  index;
+    uint32  count;
+    uint32  taken;
+    uint32  high_water;
+
+    for ( count = 0; count < max_count; count++ )
+    {
+        do
+        {
+            head  = pool->free_list;
+            index = (uint32)head;
+            if ( index == 0 )
+            {
+                break;
+            }
+            next = (((head >> 32) + 1) << 32) | pool->next[index - 1];
+        } while ( !__sync_bool_compare_and_swap(&pool->free_list, head, next) );
+
+        if ( index == 0 )
+        {
+            break;
+        }
+        indexes[count] = index - 1;
+    }
+
+    if ( count > 0 )
+    {
+        taken = __sync_add_and_fetch(&pool->taken, count);
+        for ( high_water = pool->high_water; taken > high_water;
+              high_water = pool->high_water )
+        {
+            if ( __sync_bool_compare_and_swap(&pool->high_water, high_water, taken) )
+            {
+                break;
+            }
+        }
+    }
+
+    return(count);
+}
+
+/*
+** Puts count blocks back on the free stack
+*/
+static void OS_BlockPush(OS_block_pool_t *pool, uint32 *indexes, uint32 count)
+{
+    uint64  head;
+    uint32  i;
+
+    for ( i = 0; i < count; i++ )
+    {
+        do
+        {
+            head = pool->free_list;
+            pool->next[indexes[i]] = (uint32)head;
+        } while ( !__sync_bool_compare_and_swap(&pool->free_list, head,
+                     (((head >> 32) + 1) << 32) | (indexes[i] + 1)) );
+    }
+
+    __sync_fetch_and_sub(&pool->taken, count);
+}
+
+/*
+** Cache of the calling task, or NULL when the pool has none or the caller is
+** not an OSAL task
+*/
+static OS_block_cache_t *OS_BlockCacheOf(OS_block_pool_t *pool)
+{
+    uint32 task_id;
+
+    if ( pool->caches == NULL )
+    {
+        return(NULL);
+    }
+
+    task_id = OS_FindCreator();
+
+    return((task_id < pool->num_caches) ? &pool->caches[task_id] : NULL);
+}
+
+/*
+** Sets up a pool of block_count blocks of at least block_size bytes, all free.
+** With task_caches, each OSAL task keeps up to OS_MEMPOOL_CACHE_BLOCKS free
+** blocks of its own. Returns OS_ERROR if the memory cannot be allocated.
+*/
+int32 OS_BlockPoolInit(OS_block_pool_t *pool, uint32 block_size, uint32 block_count,
+                       int task_caches)
+{
+    size_t  size;
+    void   *blocks;
+    void   *caches;
+    uint32  i;
+
+    size = ((block_size + (size_t)OS_CACHE_LINE - 1) / OS_CACHE_LINE) * OS_CACHE_LINE;
+    if ( size > 0xFFFFFFFF || block_count >= OS_BLOCK_IN_USE ||
+         (size_t)block_count > ((size_t)-1) / size ||
+         posix_memalign(&blocks, OS_CACHE_LINE, size * block_count) != 0 )
+    {
+        return(OS_ERROR);
+    }
+
+    caches = NULL;
+    if ( task_caches &&
+         posix_memalign(&caches, OS_CACHE_LINE,
+                        sizeof(OS_block_cache_t) * OS_api_config.max_tasks) != 0 )
+    {
+        free(blocks);
+        return(OS_ERROR);
+    }
+
+    pool->next = malloc(sizeof(uint32) * block_count);
+    if ( pool->next == NULL )
+    {
+        free(caches);
+        free(blocks);
+        return(OS_ERROR);
+    }
+
+    pool->blocks      = blocks;
+    pool->block_size  = (uint32)size;
+    pool->block_count = block_count;
+    pool->caches      = caches;
+    pool->num_caches  = (caches != NULL) ? OS_api_config.max_tasks : 0;
+    for ( i = 0; i < pool->num_caches; i++ )
+    {
+        pool->caches[i].count = 0;
+    }
+
+    /* all the blocks start on the free stack, the first one on top */
+    for ( i = 0; i < block_count; i++ )
+    {
+        pool->next[i] = (i + 1 < block_count) ? i + 2 : 0;
+    }
+    pool->free_list  = 1;
+    pool->taken      = 0;
+    pool->high_water = 0;
+    pool->failures   = 0;
+
+    return(OS_SUCCESS);
+}
+
+/*
+** Frees the memory of a pool, whatever blocks are still allocated
+*/
+void OS_BlockPoolDestroy(OS_block_pool_t *pool)
+{
+    free(pool->blocks);
+    free((void *)pool->next);
+    free(pool->caches);
+    pool->blocks = NULL;
+    pool->next   = NULL;
+    pool->caches = NULL;
+}
+
+/*
+** Allocates a block, from the cache of the calling task when the pool has
+** them, or returns NULL when every block is taken. A task whose cache is empty
+** refills half of it at once, so it does not go to the shared stack for every
+** block.
+*/
+void *OS_BlockAlloc(OS_block_pool_t *pool)
+{
+    OS_block_cache_t *cache;
+    uint32            index;
+
+    cache = OS_BlockCacheOf(pool);
+    if ( cache != NULL )
+    {
+        if ( cache->count == 0 )
+        {
+            cache->count = OS_BlockPop(pool, cache->blocks, OS_MEMPOOL_CACHE_BLOCKS / 2);
+        }
+        if ( cache->count == 0 )
+        {
+            __sync_fetch_and_add(&pool->failures, 1);
+            return(NULL);
+        }
+        index = cache->blocks[--cache->count];
+    }
+    else if ( OS_BlockPop(pool, &index, 1) == 0 )
+    {
+        __sync_fetch_and_add(&pool->failures, 1);
+        return(NULL);
+    }
+
+    pool->next[index] = OS_BLOCK_IN_USE;
+
+    return(OS_BLOCK_AT(pool, index));
+}
+
+/*
+** Frees a block, to the cache of the calling task when the pool has them. A
+** full cache gives the older half back to the pool first. Returns
+** OS_INVALID_POINTER if block is not an allocated block of the pool.
+*/
+int32 OS_BlockFree(OS_block_pool_t *pool, void *block)
+{
+    OS_block_cache_t *cache;
+    size_t            offset;
+    uint32            index;
+
+    if ( (char *)block < pool->blocks )
+    {
+        return(OS_INVALID_POINTER);
+    }
+
+    offset = (size_t)((char *)block - pool->blocks);
+    if ( offset % pool->block_size != 0 || offset / pool->block_size >= pool->block_count )
+    {
+        return(OS_INVALID_POINTER);
+    }
+
+    /* only the task holding a block frees it, so this needs no atomic */
+    index = (uint32)(offset / pool->block_size);
+    if ( pool->next[index] != OS_BLOCK_IN_USE )
+    {
+        return(OS_INVALID_POINTER);
+    }
+    pool->next[index] = 0;
+
+    cache = OS_BlockCacheOf(pool);
+    if ( cache != NULL )
+    {
+        if ( cache->count == OS_MEMPOOL_CACHE_BLOCKS )
+        {
+            OS_BlockPush(pool, cache->blocks, OS_MEMPOOL_CACHE_BLOCKS / 2);
+            memmove(cache->blocks, cache->blocks + OS_MEMPOOL_CACHE_BLOCKS / 2,
+                    sizeof(uint32) * (OS_MEMPOOL_CACHE_BLOCKS - OS_MEMPOOL_CACHE_BLOCKS / 2));
+            cache->count -= OS_MEMPOOL_CACHE_BLOCKS / 2;
+        }
+        cache->blocks[cache->count++] = index;
+    }
+    else
+    {
+        OS_BlockPush(pool, &index, 1);
+    }
+
+    return(OS_SUCCESS);
+}
+
+/*
+** Counts the blocks allocated now, the ones taken less the ones in caches.
+** Exact only while no task allocates or frees.
+*/
+uint32 OS_BlockPoolInUse(OS_block_pool_t *pool)
+{
+    uint32 in_use;
+    uint32 i;
+
+    in_use = pool->taken;
+    for ( i = 0; i < pool->num_caches; i++ )
+    {
+        in_use -= pool->caches[i].count;
+    }
+
+    return(in_use);
+}
+
+/****************************************************************************************
+                                 LOCAL FUNCTIONS
+****************************************************************************************/
+
+/*
+** Marks a new memory pool table record as free
+*/
+static void OS_MemPoolInitRecord(void *record)
+{
+    OS_mempool_record_t *mempool = record;
+
+    mempool->free        = TRUE;
+    mempool->creator     = UNINITIALIZED;
+    mempool->pool.blocks = NULL;
+    strcpy(mempool->name, "");
+}
+
+/*
+** Tells whether id is a memory pool in use
+*/
+static int OS_MemPoolValidId(uint32 id)
+{
+    return(id < OS_mempool_table.num_records && OS_MEMPOOL_RECORD(id)->free != TRUE);
+}
+
+/****************************************************************************************
+                                  MEMORY POOL API
+****************************************************************************************/
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_MemPoolInit
+
+   Purpose: Initialize the table of memory pools
+
+   Returns: OS_ERROR if the table cannot be set up
+            OS_SUCCESS if success
+
+   Notes: OS_API_Init calls it, calling it again does nothing
+---------------------------------------------------------------------------------------*/
+int32 OS_MemPoolInit (void)
+{
+    uint32 max_mempools;
+
+    if ( OS_mempool_initialized )
+    {
+        return OS_SUCCESS;
+    }
+
+    max_mempools = OS_api_config.max_mempools;
+    if ( max_mempools == 0 )
+    {
+        max_mempools = OS_MAX_MEMPOOLS;
+    }
+
+    if ( OS_ObjectTableInit(&OS_mempool_table, sizeof(OS_mempool_record_t),
+                            max_mempools, OS_MemPoolInitRecord) != OS_SUCCESS )
+    {
+        return OS_ERROR;
+    }
+
+    if ( pthread_mutex_init(&OS_mempool_table_mut, NULL) != 0 )
+    {
+        return OS_ERROR;
+    }
+
+    OS_mempool_initialized = TRUE;
+
+    return OS_SUCCESS;
+
+}/* end OS_MemPoolInit */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_MemPoolCreate
+
+   Purpose: Create a memory pool of block_count blocks of block_size bytes
+
+   Returns: OS_INVALID_POINTER if a pointer passed in is NULL
+            OS_ERR_NAME_TOO_LONG if the name passed in is too long
+            OS_ERR_NO_FREE_IDS if there are already the max memory pools created
+            OS_ERR_NAME_TAKEN if the name is already used by a memory pool
+            OS_QUEUE_INVALID_SIZE if block_size or block_count is 0
+            OS_ERROR if the blocks cannot be allocated
+            OS_SUCCESS if success
+
+   Notes: The blocks are allocated here and each starts on a cache line, so
+          block_size is rounded up to whole cache lines. With
+          OS_MEMPOOL_TASK_CACHE each task keeps up to OS_MEMPOOL_CACHE_BLOCKS
+          free blocks for itself, which another task cannot allocate.
+---------------------------------------------------------------------------------------*/
+int32 OS_MemPoolCreate (uint32 *pool_id, const char *pool_name, uint32 block_size,
+                        uint32 block_count, uint32 flags)
+{
+    uint32               possible_id;
+    int32                return_code;
+    OS_mempool_record_t *mempool;
+    OS_block_pool_t      pool;
+
+    if ( pool_id == NULL || pool_name == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( strlen(pool_name) >= OS_MAX_API_NAME )
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ( block_size == 0 || block_count == 0 )
+    {
+        return OS_QUEUE_INVALID_SIZE;
+    }
+
+    if ( OS_BlockPoolInit(&pool, block_size, block_count,
+                          (flags & OS_MEMPOOL_TASK_CACHE) != 0) != OS_SUCCESS )
+    {
+        return OS_ERROR;
+    }
+
+    /* Take a free memory pool Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_mempool_table, &possible_id) != OS_SUCCESS )
+    {
+        OS_BlockPoolDestroy(&pool);
+        return OS_ERR_NO_FREE_IDS;
+    }
+
+    /* Check to see if the name is already taken, and reserve it */
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_MEMPOOL, pool_name, possible_id);
+    if ( return_code != OS_SUCCESS )
+    {
+        OS_ObjectRelease(&OS_mempool_table, possible_id);
+        OS_BlockPoolDestroy(&pool);
+        return return_code;
+    }
+
+    mempool = OS_MEMPOOL_RECORD(possible_id);
+
+    mempool->block_size = block_size;
+    mempool->flags      = flags;
+    mempool->pool       = pool;
+
+    *pool_id = possible_id;
+
+    pthread_mutex_lock(&OS_mempool_table_mut);
+
+    mempool->free    = FALSE;
+    strcpy(mempool->name, pool_name);
+    mempool->creator = OS_FindCreator();
+
+    pthread_mutex_unlock(&OS_mempool_table_mut);
+
+    return OS_SUCCESS;
+
+}/* end OS_MemPoolCreate */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_MemPoolDelete
+
+   Purpose: Delete a memory pool and free its blocks
+
+   Returns: OS_ERR_INVALID_ID if the id passed in is not a memory pool
+            OS_ERROR if a block of the pool is still allocated
+            OS_SUCCESS if success
+
+   Notes: The pool must not be allocated from while it is deleted
+---------------------------------------------------------------------------------------*/
+int32 OS_MemPoolDelete (uint32 pool_id)
+{
+    OS_mempool_record_t *mempool;
+    OS_block_pool_t      pool;
+
+    if ( !OS_MemPoolValidId(pool_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    mempool = OS_MEMPOOL_RECORD(pool_id);
+
+    pthread_mutex_lock(&OS_mempool_table_mut);
+
+    if ( OS_BlockPoolInUse(&mempool->pool) != 0 )
+    {
+        pthread_mutex_unlock(&OS_mempool_table_mut);
+        return OS_ERROR;
+    }
+
+    OS_NameIndexRemove(OS_OBJECT_TYPE_MEMPOOL, mempool->name);
+    mempool->free    = TRUE;
+    strcpy(mempool->name, "");
+    mempool->creator = UNINITIALIZED;
+    pool             = mempool->pool;
+    mempool->pool.blocks = NULL;
+
+    pthread_mutex_unlock(&OS_mempool_table_mut);
+
+    OS_BlockPoolDestroy(&pool);
+    OS_ObjectRelease(&OS_mempool_table, pool_id);
+
+    return OS_SUCCESS;
+
+}/* end OS_MemPoolDelete */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_MemPoolGetIdByName
+
+    Purpose: This function tries to find a memory pool Id given its name.
+             The id is returned through pool_id
+
+    Returns: OS_INVALID_POINTER is pool_id or pool_name are NULL pointers
+             OS_ERR_NAME_TOO_LONG if the name given is to long to have been stored
+             OS_ERR_NAME_NOT_FOUND if the name was not found in the table
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_MemPoolGetIdByName (uint32 *pool_id, const char *pool_name)
+{
+    uint32 i;
+
+    if ( pool_id == NULL || pool_name == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( strlen(pool_name) >= OS_MAX_API_NAME )
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ( (OS_NameIndexFind(OS_OBJECT_TYPE_MEMPOOL, pool_name, &i) == OS_SUCCESS) &&
+         (OS_MEMPOOL_RECORD(i)->free != TRUE) &&
+         (strcmp(OS_MEMPOOL_RECORD(i)->name, pool_name) == 0) )
+    {
+        *pool_id = i;
+        return OS_SUCCESS;
+    }
+
+    return OS_ERR_NAME_NOT_FOUND;
+
+}/* end OS_MemPoolGetIdByName */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_MemPoolGetInfo
+
+    Purpose: This function will pass back the name and creator of the specified
+             memory pool, with the use of its blocks.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid memory pool
+             OS_INVALID_POINTER if the pool_prop pointer is null
+             OS_SUCCESS if success
+
+    Notes: The free blocks include the ones held in the caches of the tasks,
+           and the high water mark counts those as used.
+---------------------------------------------------------------------------------------*/
+int32 OS_MemPoolGetInfo (uint32 pool_id, OS_mempool_prop_t *pool_prop)
+{
+    OS_mempool_record_t *mempool;
+
+    if ( !OS_MemPoolValidId(pool_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( pool_prop == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    mempool = OS_MEMPOOL_RECORD(pool_id);
+
+    pthread_mutex_lock(&OS_mempool_table_mut);
+
+    pool_prop->creator       = mempool->creator;
+    strcpy(pool_prop->name, mempool->name);
+    pool_prop->block_size    = mempool->block_size;
+    pool_prop->blocks        = mempool->pool.block_count;
+    pool_prop->blocks_in_use = OS_BlockPoolInUse(&mempool->pool);
+    pool_prop->blocks_free   = pool_prop->blocks - pool_prop->blocks_in_use;
+    pool_prop->high_water    = mempool->pool.high_water;
+    pool_prop->failures      = mempool->pool.failures;
+
+    pthread_mutex_unlock(&OS_mempool_table_mut);
+
+    return OS_SUCCESS;
+
+} /* end OS_MemPoolGetInfo */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_MemPoolAlloc
+
+   Purpose: Take a free block of a memory pool
+
+   Returns: OS_ERR_INVALID_ID if the pool id passed in is not a memory pool
+            OS_INVALID_POINTER if block is NULL
+            OS_ERROR if all the blocks of the pool are in use
+            OS_SUCCESS if success
+
+   Notes: Never blocks, calls malloc or makes a system call. A task of a pool
+          created with OS_MEMPOOL_TASK_CACHE takes half a cache of blocks at once
+          when its cache is empty.
+---------------------------------------------------------------------------------------*/
+int32 OS_MemPoolAlloc (uint32 pool_id, void **block)
+{
+    if ( !OS_MemPoolValidId(pool_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( block == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    *block = OS_BlockAlloc(&OS_MEMPOOL_RECORD(pool_id)->pool);
+
+    return((*block != NULL) ? OS_SUCCESS : OS_ERROR);
+
+}/* end OS_MemPoolAlloc */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_MemPoolFree
+
+   Purpose: Give a block taken with OS_MemPoolAlloc back to its memory pool
+
+   Returns: OS_ERR_INVALID_ID if the pool id passed in is not a memory pool
+            OS_INVALID_POINTER if block is not an allocated block of the pool,
+                               which includes a block freed twice
+            OS_SUCCESS if success
+
+   Notes: Never blocks, calls free or makes a system call. Any task may free a
+          block, not only the one that allocated it.
+---------------------------------------------------------------------------------------*/
+int32 OS_MemPoolFree (uint32 pool_id, void *block)
+{
+    if ( !OS_MemPoolValidId(pool_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    return(OS_BlockFree(&OS_MEMPOOL_RECORD(pool_id)->pool, block));
+
+}/* end OS_MemPoolFree */
@@ -0,0 +1,54 @@
+#ifndef OSMEMPOOL_H
+#define OSMEMPOOL_H
+	#include "common_types.h"
+	#include "osapi.h"
+	#include "osposix.h"
+	#include "osobject.h"
+
+/*
+** Word of the next array while the block is allocated
+*/
+#define OS_BLOCK_IN_USE   0xFFFFFFFF
+
+/*
+** Free blocks a task keeps for itself, given back to the pool by halves. Only
+** the task owns its cache, so it is used without atomics.
+*/
+typedef struct
+{
+    uint32           count OS_ALIGN(OS_CACHE_LINE);
+    uint32           blocks[OS_MEMPOOL_CACHE_BLOCKS];   /* index of each block */
+} OS_block_cache_t;
+
+/*
+** Blocks of a fixed size, each starting on a cache line, and a stack of the
+** free ones. The stack is linked through the next array, not the blocks, so a
+** block is all data and a free of a block that is not allocated is caught. The
+** head of the stack counts the pushes and pops in its upper half, so a pop
+** that raced with a pop and a push of the same block fails its compare and
+** swap. Used by the memory pools and the publish/subscribe topics.
+*/
+typedef struct
+{
+    char             *blocks;
+    uint32            block_size;   /* whole cache lines */
+    uint32            block_count;
+    volatile uint32  *next;         /* index + 1 of the next free block, 0, or OS_BLOCK_IN_USE */
+    OS_block_cache_t *caches;       /* one per task, or NULL */
+    uint32            num_caches;
+    volatile uint64   free_list OS_ALIGN(OS_CACHE_LINE);   /* count << 32 | index + 1 */
+    volatile uint32   taken;        /* blocks off the stack, allocated or in a cache */
+    volatile uint32   high_water;   /* most blocks taken at once */
+    volatile uint64   failures;     /* allocations that found no free block */
+} OS_block_pool_t;
+
+/* block i of a pool */
+#define OS_BLOCK_AT(pool, i)  ((void *)((pool)->blocks + (size_t)(i) * (pool)->block_size))
+
+	int32  OS_BlockPoolInit(OS_block_pool_t *pool, uint32 block_size, uint32 block_count,
+	                        int task_caches);
+	void   OS_BlockPoolDestroy(OS_block_pool_t *pool);
+	void  *OS_BlockAlloc(OS_block_pool_t *pool);
+	int32  OS_BlockFree(OS_block_pool_t *pool, void *block);
+	uint32 OS_BlockPoolInUse(OS_block_pool_t *pool);
+#endif
@@ -0,0 +1,484 @@
+/*
+** File   : osobject.c
+**
+**      Copyright (c) 2004-2006, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+** Purpose: This file contains the bookkeeping shared by the posix OSAL object
+**          tables. The object tables allocate their records in chunks as they
+**          grow. The ID pools hand out free table entries from a bitmap
+**          without scanning the tables or taking the table mutexes. The name
+**          index is a hash table keyed by object type and name that replaces
+**          the linear name searches in the GetIdByName functions and in the
+**          duplicate name checks of the create functions.
+*/
+
+/****************************************************************************************
+                                    INCLUDE FILES
+****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common_types.h"
+#include "osapi.h"
+#include "osobject.h"
+
+/****************************************************************************************
+                                    LOCAL TYPEDEFS
+****************************************************************************************/
+
+typedef struct OS_name_entry
+{
+   struct OS_name_entry *next;
+   uint32                obj_type;
+   uint32                obj_id;
+   char                  name[OS_MAX_API_NAME];
+} OS_name_entry_t;
+
+/****************************************************************************************
+                                   GLOBAL DATA
+****************************************************************************************/
+
+OS_name_entry_t   *OS_name_index[OS_NAME_INDEX_BUCKETS];
+
+/*
+** Lookups are much more frequent than creates and deletes, so the
+** index is protected with a reader/writer lock
+*/
+pthread_rwlock_t   OS_name_index_lock;
+
+/****************************************************************************************
+                                INTERNAL FUNCTIONS
+****************************************************************************************/
+
+/*
+** FNV-1a hash of the name, seeded with the object type
+*/
+static uint32 OS_NameIndexHash(uint32 obj_type, const char *name)
+{
+   uint32 hash;
+
+   hash = 2166136261U ^ obj_type;
+   while ( *name != '\0' )
+   {
+      hash ^= (uint8)(*name);
+      hash *= 16777619U;
+      name++;
+   }
+
+   return(hash & (OS_NAME_INDEX_BUCKETS - 1));
+}
+
+/****************************************************************************************
+                                INITIALIZATION FUNCTION
+****************************************************************************************/
+int32 OS_NameIndexInit(void)
+{
+   int i;
+
+   for ( i = 0; i < OS_NAME_INDEX_BUCKETS; i++ )
+   {
+      OS_name_index[i] = NULL;
+   }
+
+   if ( pthread_rwlock_init(&OS_name_index_lock, NULL) != 0 )
+   {
+      return(OS_ERROR);
+   }
+
+   return(OS_SUCCESS);
+}
+
+/****************************************************************************************
+                                    ID POOL API
+****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_IdPoolInit
+
+    Purpose: Initializes a pool for the IDs from 0 to max_ids - 1, with the IDs below
+             free_ids free. The map must hold OS_ID_POOL_WORDS(max_ids) words and
+             belongs to the pool from then on.
+
+    Returns: Nothing
+---------------------------------------------------------------------------------------*/
+void OS_IdPoolInit(OS_id_pool_t *pool, uint32 *map, uint32 max_ids, uint32 free_ids)
+{
+   uint32 i;
+
+   for ( i = 0; i < OS_ID_POOL_WORDS(max_ids); i++ )
+   {
+      if ( (i + 1) * 32 <= free_ids )
+      {
+         map[i] = 0xFFFFFFFF;
+      }
+      else if ( i * 32 < free_ids )
+      {
+         map[i] = (1U << (free_ids % 32)) - 1;
+      }
+      else
+      {
+         map[i] = 0;
+      }
+   }
+
+   pool->map     = map;
+   pool->max_ids = max_ids;
+
+}/* end OS_IdPoolInit */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_IdAllocate
+
+    Purpose: Takes the lowest free ID from the pool. The caller owns the table entry
+             for that ID until it gives the ID back with OS_IdRelease.
+
+    Returns: OS_ERR_NO_FREE_IDS if the pool is empty
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_IdAllocate(OS_id_pool_t *pool, uint32 *id)
+{
+   uint32 i;
+   uint32 word;
+   uint32 bit;
+
+   for ( i = 0; i < OS_ID_POOL_WORDS(pool->max_ids); i++ )
+   {
+      word = pool->map[i];
+      while ( word != 0 )
+      {
+         bit = __builtin_ctz(word);
+         if ( __sync_bool_compare_and_swap(&pool->map[i], word, word & ~(1U << bit)) )
+         {
+            *id = (i * 32) + bit;
+            return(OS_SUCCESS);
+         }
+
+         /*
+         ** Another task changed the word, try again with its new value
+         */
+         word = pool->map[i];
+      }
+   }
+
+   return(OS_ERR_NO_FREE_IDS);
+
+}/* end OS_IdAllocate */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_IdRelease
+
+    Purpose: Gives an ID back to the pool. The table entry must be marked free before
+             the ID is released, since another task may take it right away.
+
+    Returns: Nothing
+---------------------------------------------------------------------------------------*/
+void OS_IdRelease(OS_id_pool_t *pool, uint32 id)
+{
+   if ( id >= pool->max_ids )
+   {
+      return;
+   }
+
+   __sync_fetch_and_or(&pool->map[id / 32], 1U << (id % 32));
+
+}/* end OS_IdRelease */
+
+/****************************************************************************************
+                                  OBJECT TABLE API
+****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_ObjectTableInit
+
+    Purpose: Initializes an empty table that can grow to max_records records of
+             record_size bytes. init_record is called on every record when its chunk
+             is allocated, to mark it free.
+
+    Returns: OS_ERROR if the chunk directory or the ID map could not be allocated
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_ObjectTableInit(OS_object_table_t *table, uint32 record_size, uint32 max_records,
+                         OS_ObjectInitRecord_t init_record)
+{
+   uint32  num_chunks;
+   uint32 *map;
+
+   num_chunks = (max_records + OS_OBJECT_CHUNK_SIZE - 1) >> OS_OBJECT_CHUNK_SHIFT;
+
+   table->chunks = calloc(num_chunks + 1, sizeof(char *));
+   map = calloc(OS_ID_POOL_WORDS(max_records) + 1, sizeof(uint32));
+   if ( table->chunks == NULL || map == NULL )
+   {
+      free(table->chunks);
+      free(map);
+      table->chunks = NULL;
+      return(OS_ERROR);
+   }
+
+   if ( pthread_mutex_init(&table->grow_mut, NULL) != 0 )
+   {
+      free(table->chunks);
+      free(map);
+      table->chunks = NULL;
+      return(OS_ERROR);
+   }
+
+   table->record_size = record_size;
+   table->max_records = max_records;
+   table->num_records = 0;
+   table->init_record = init_record;
+
+   OS_IdPoolInit(&table->ids, map, max_records, 0);
+
+   return(OS_SUCCESS);
+
+}/* end OS_ObjectTableInit */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_ObjectTableGrow
+
+    Purpose: Adds a chunk of free records to a table. seen_records is the number of
+             records the caller saw when it ran out of IDs, so a task that waited for
+             another one to grow the table does not add a second chunk.
+
+    Returns: OS_ERR_NO_FREE_IDS if the table is already at its capacity
+             OS_ERROR if the chunk could not be allocated
+             OS_SUCCESS if the table has more records than seen_records
+---------------------------------------------------------------------------------------*/
+static int32 OS_ObjectTableGrow(OS_object_table_t *table, uint32 seen_records)
+{
+   char   *chunk;
+   uint32  first;
+   uint32  last;
+   uint32  i;
+
+   pthread_mutex_lock(&table->grow_mut);
+
+   first = table->num_records;
+   if ( first != seen_records )
+   {
+      pthread_mutex_unlock(&table->grow_mut);
+      return(OS_SUCCESS);
+   }
+
+   if ( first >= table->max_records )
+   {
+      pthread_mutex_unlock(&table->grow_mut);
+      return(OS_ERR_NO_FREE_IDS);
+   }
+
+   if ( posix_memalign((void **)&chunk, OS_CACHE_LINE,
+                       OS_OBJECT_CHUNK_SIZE * table->record_size) != 0 )
+   {
+      pthread_mutex_unlock(&table->grow_mut);
+      return(OS_ERROR);
+   }
+
+   last = first + OS_OBJECT_CHUNK_SIZE;
+   if ( last > table->max_records )
+   {
+      last = table->max_records;
+   }
+
+   for ( i = 0; i < OS_OBJECT_CHUNK_SIZE; i++ )
+   {
+      memset(chunk + (i * table->record_size), 0, table->record_size);
+      table->init_record(chunk + (i * table->record_size));
+   }
+
+   /*
+   ** The chunk must be in the directory before any task can see the new IDs
+   */
+   table->chunks[first >> OS_OBJECT_CHUNK_SHIFT] = chunk;
+   __sync_synchronize();
+   table->num_records = last;
+
+   for ( i = first; i < last; i++ )
+   {
+      OS_IdRelease(&table->ids, i);
+   }
+
+   pthread_mutex_unlock(&table->grow_mut);
+
+   return(OS_SUCCESS);
+
+}/* end OS_ObjectTableGrow */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_ObjectAllocate
+
+    Purpose: Takes the lowest free ID of a table, growing the table by a chunk when all
+             of its records are in use. The caller owns the record for that ID until
+             it gives the ID back with OS_ObjectRelease.
+
+    Returns: OS_ERR_NO_FREE_IDS if the table is full and at its capacity
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_ObjectAllocate(OS_object_table_t *table, uint32 *id)
+{
+   uint32 seen_records;
+
+   for ( ;; )
+   {
+      seen_records = table->num_records;
+      if ( OS_IdAllocate(&table->ids, id) == OS_SUCCESS )
+      {
+         return(OS_SUCCESS);
+      }
+
+      if ( OS_ObjectTableGrow(table, seen_records) != OS_SUCCESS )
+      {
+         return(OS_ERR_NO_FREE_IDS);
+      }
+   }
+
+}/* end OS_ObjectAllocate */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_ObjectRelease
+
+    Purpose: Gives an ID back to its table. The record must be marked free first.
+
+    Returns: Nothing
+---------------------------------------------------------------------------------------*/
+void OS_ObjectRelease(OS_object_table_t *table, uint32 id)
+{
+   OS_IdRelease(&table->ids, id);
+
+}/* end OS_ObjectRelease */
+
+/****************************************************************************************
+                                   NAME INDEX API
+****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_NameIndexAdd
+
+    Purpose: Adds a name for an object of the given type to the index. The check for
+             a duplicate and the insert are done under one lock, so two tasks creating
+             an object with the same name cannot both succeed.
+
+    Returns: OS_ERR_NAME_TOO_LONG if the name does not fit in OS_MAX_API_NAME
+             OS_ERR_NAME_TAKEN if an object of that type already has the name
+             OS_ERROR if the index entry could not be allocated
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_NameIndexAdd(uint32 obj_type, const char *name, uint32 obj_id)
+{
+   uint32           bucket;
+   OS_name_entry_t *entry;
+
+   if ( strlen(name) >= OS_MAX_API_NAME )
+   {
+      return(OS_ERR_NAME_TOO_LONG);
+   }
+
+   bucket = OS_NameIndexHash(obj_type, name);
+
+   pthread_rwlock_wrlock(&OS_name_index_lock);
+
+   for ( entry = OS_name_index[bucket]; entry != NULL; entry = entry->next )
+   {
+      if ( entry->obj_type == obj_type && strcmp(entry->name, name) == 0 )
+      {
+         pthread_rwlock_unlock(&OS_name_index_lock);
+         return(OS_ERR_NAME_TAKEN);
+      }
+   }
+
+   entry = malloc(sizeof(OS_name_entry_t));
+   if ( entry == NULL )
+   {
+      pthread_rwlock_unlock(&OS_name_index_lock);
+      return(OS_ERROR);
+   }
+
+   entry->obj_type = obj_type;
+   entry->obj_id   = obj_id;
+   strcpy(entry->name, name);
+   entry->next = OS_name_index[bucket];
+   OS_name_index[bucket] = entry;
+
+   pthread_rwlock_unlock(&OS_name_index_lock);
+
+   return(OS_SUCCESS);
+
+}/* end OS_NameIndexAdd */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_NameIndexRemove
+
+    Purpose: Removes the name of an object from the index
+
+    Returns: OS_ERR_NAME_NOT_FOUND if the name is not in the index
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_NameIndexRemove(uint32 obj_type, const char *name)
+{
+   uint32            bucket;
+   OS_name_entry_t **link;
+   OS_name_entry_t  *entry;
+
+   bucket = OS_NameIndexHash(obj_type, name);
+
+   pthread_rwlock_wrlock(&OS_name_index_lock);
+
+   for ( link = &OS_name_index[bucket]; *link != NULL; link = &((*link)->next) )
+   {
+      entry = *link;
+      if ( entry->obj_type == obj_type && strcmp(entry->name, name) == 0 )
+      {
+         *link = entry->next;
+         pthread_rwlock_unlock(&OS_name_index_lock);
+         free(entry);
+         return(OS_SUCCESS);
+      }
+   }
+
+   pthread_rwlock_unlock(&OS_name_index_lock);
+
+   return(OS_ERR_NAME_NOT_FOUND);
+
+}/* end OS_NameIndexRemove */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_NameIndexFind
+
+    Purpose: Looks up the ID of an object given its type and name
+
+    Returns: OS_ERR_NAME_NOT_FOUND if the name is not in the index
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_NameIndexFind(uint32 obj_type, const char *name, uint32 *obj_id)
+{
+   uint32           bucket;
+   OS_name_entry_t *entry;
+
+   bucket = OS_NameIndexHash(obj_type, name);
+
+   pthread_rwlock_rdlock(&OS_name_index_lock);
+
+   for ( entry = OS_name_index[bucket]; entry != NULL; entry = entry->next )
+   {
+      if ( entry->obj_type == obj_type && strcmp(entry->name, name) == 0 )
+      {
+         *obj_id = entry->obj_id;
+         pthread_rwlock_unlock(&OS_name_index_lock);
+         return(OS_SUCCESS);
+      }
+   }
+
+   pthread_rwlock_unlock(&OS_name_index_lock);
+
+   return(OS_ERR_NAME_NOT_FOUND);
+
+}/* end OS_NameIndexFind */
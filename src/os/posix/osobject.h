@@ -0,0 +1,131 @@
+/*
+** File   : osobject.h
+**
+**      Copyright (c) 2004-2006, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+** Purpose: Internal definitions shared by the posix OSAL object tables.
+*/
+#ifndef OSOBJECT_H
+#define OSOBJECT_H
+
+#include <pthread.h>
+
+#include "common_types.h"
+#include "osapi.h"
+
+/*
+** Object types. The name index keeps the names of each object table
+** apart, so a queue and a task can still share a name.
+*/
+#define OS_OBJECT_TYPE_TASK       1
+#define OS_OBJECT_TYPE_QUEUE      2
+#define OS_OBJECT_TYPE_BINSEM     3
+#define OS_OBJECT_TYPE_COUNTSEM   4
+#define OS_OBJECT_TYPE_MUTEX      5
+#define OS_OBJECT_TYPE_TIMER      6
+#define OS_OBJECT_TYPE_MODULE     7
+#define OS_OBJECT_TYPE_RWLOCK     8
+#define OS_OBJECT_TYPE_EVENTFLAGS 9
+#define OS_OBJECT_TYPE_SHMEM      10
+#define OS_OBJECT_TYPE_TOPIC      11
+#define OS_OBJECT_TYPE_MEMPOOL    12
+#define OS_OBJECT_TYPE_ARENA      13
+
+/*
+** Number of hash buckets in the name index. Must be a power of two.
+*/
+#ifndef OS_NAME_INDEX_BUCKETS
+#define OS_NAME_INDEX_BUCKETS     1024
+#endif
+
+/*
+** Pool of free object IDs
+**
+** The free IDs of a table are kept in a bitmap with one bit set for each
+** free ID. An ID is taken by clearing its bit with a compare and swap, and
+** given back by setting it again, so neither needs the table mutex. The
+** lowest free ID is always taken first, as with the old table scans.
+*/
+#define OS_ID_POOL_WORDS(max_ids) (((max_ids) + 31) / 32)
+
+typedef struct
+{
+   volatile uint32 *map;
+   uint32           max_ids;
+} OS_id_pool_t;
+
+/*
+** ID pool API
+*/
+void  OS_IdPoolInit      (OS_id_pool_t *pool, uint32 *map, uint32 max_ids, uint32 free_ids);
+int32 OS_IdAllocate      (OS_id_pool_t *pool, uint32 *id);
+void  OS_IdRelease       (OS_id_pool_t *pool, uint32 id);
+
+/*
+** Object tables
+**
+** The records of an object table are allocated in chunks as objects are
+** created, up to the capacity the table was initialized with. A chunk never
+** moves once it is allocated, so a record stays where it is for the life of
+** the program. OS_OBJECT_CHUNK_SHIFT sets the number of records in a chunk.
+*/
+#ifndef OS_OBJECT_CHUNK_SHIFT
+#define OS_OBJECT_CHUNK_SHIFT     4
+#endif
+#define OS_OBJECT_CHUNK_SIZE      (1U << OS_OBJECT_CHUNK_SHIFT)
+#define OS_OBJECT_CHUNK_MASK      (OS_OBJECT_CHUNK_SIZE - 1)
+
+/*
+** Size of a cache line. The chunks start on a cache line, so the members of a
+** record aligned to one are kept apart from the other records too.
+*/
+#define OS_CACHE_LINE             64
+
+typedef void (*OS_ObjectInitRecord_t)(void *record);
+
+typedef struct
+{
+   char                 **chunks;        /* chunk directory, sized for max_records */
+   uint32                 record_size;
+   uint32                 max_records;
+   volatile uint32        num_records;   /* records allocated so far */
+   OS_id_pool_t           ids;
+   pthread_mutex_t        grow_mut;
+   OS_ObjectInitRecord_t  init_record;
+} OS_object_table_t;
+
+/*
+** Record for an ID. The ID must be below the num_records of the table.
+*/
+#define OS_ObjectRecord(table, id) \
+   ((void *)((table)->chunks[(id) >> OS_OBJECT_CHUNK_SHIFT] + \
+             ((id) & OS_OBJECT_CHUNK_MASK) * (table)->record_size))
+
+/*
+** Object table API
+*/
+int32 OS_ObjectTableInit (OS_object_table_t *table, uint32 record_size, uint32 max_records,
+                          OS_ObjectInitRecord_t init_record);
+int32 OS_ObjectAllocate  (OS_object_table_t *table, uint32 *id);
+void  OS_ObjectRelease   (OS_object_table_t *table, uint32 id);
+
+/*
+** Object table capacities, set by OS_API_InitEx
+*/
+extern OS_api_config_t OS_api_config;
+
+/*
+** Name index API
+*/
+int32 OS_NameIndexInit   (void);
+int32 OS_NameIndexAdd    (uint32 obj_type, const char *name, uint32 obj_id);
+int32 OS_NameIndexRemove (uint32 obj_type, const char *name);
+int32 OS_NameIndexFind   (uint32 obj_type, const char *name, uint32 *obj_id);
+
+#endif
@@ -1,5 +1,7 @@
 #ifndef OSPOSIX_H
 #define OSPOSIX_H
+#include <pthread.h>
+#include "common_types.h"
 #include "osmac_stuff.h"
 
 /*
@@ -12,4 +14,31 @@
    #define PTHREAD_STACK_MIN 8092
 #endif
 
+/*
+** Descriptor of a queue or semaphore for OS_QueueGetEventFd and the like,
+** readable while the object is ready. The calls that make the object ready
+** signal it, the ones that find or leave the object not ready drain it.
+*/
+typedef struct
+{
+    int              fd;          /* eventfd, or -1 until one is asked for */
+    volatile uint32  signalled;   /* written to since it was last drained */
+} OS_event_fd_t;
+
+int32 OS_EventFdOpen   (OS_event_fd_t *event, pthread_mutex_t *table_mut);
+void  OS_EventFdClose  (OS_event_fd_t *event);
+void  OS_EventFdSignal (OS_event_fd_t *event);
+void  OS_EventFdDrain  (OS_event_fd_t *event);
+
+/*
+** Deletes the arenas of a task, see osarena.c
+*/
+void  OS_ArenaDeleteByTask (uint32 task_id);
+
+/*
+** Heap accounting of the tasks, see osheap.c
+*/
+int32 OS_HeapInit      (void);
+void  OS_HeapTaskStart (uint32 task_id);
+
 #endif
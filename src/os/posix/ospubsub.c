@@ -0,0 +1,702 @@
+/*
+** File   : ospubsub.c
+**
+**      Copyright (c) 2004-2006, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+** Purpose: This file contains the publish/subscribe API of the posix OSAL. A
+**          topic owns a block pool of fixed size buffers. A buffer published on the
+**          topic is not copied: a pointer to it is put on the queue of each
+**          subscriber, and the buffer carries a count of the subscribers that
+**          still hold it. The last one to release it hands it back to the pool.
+*/
+
+/****************************************************************************************
+                                    INCLUDE FILES
+****************************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common_types.h"
+#include "osapi.h"
+#include "osposix.h"
+#include "osobject.h"
+#include "osqueues.h"
+#include "osmempool.h"
+
+/****************************************************************************************
+                                   GLOBAL DATA
+****************************************************************************************/
+
+/*
+** Header ahead of the data of each buffer. The buffers of a topic are blocks
+** of whole cache lines, so the data of two buffers never shares a line.
+*/
+typedef struct
+{
+    volatile uint32  refs;       /* references held, 0 while the buffer is free */
+    uint32           topic_id;
+    uint32           index;
+    uint32           spare;      /* keeps the data 8 byte aligned */
+} OS_topic_buffer_t;
+
+/* topics */
+typedef struct
+{
+    int              free;
+    char             name[OS_MAX_API_NAME];
+    uint32           creator;
+    uint32           buffer_size;
+    volatile uint32  subscribers[OS_MAX_TOPIC_SUBSCRIBERS];   /* queue id + 1, or 0 */
+    OS_block_pool_t  pool;
+    volatile uint64  published;
+    volatile uint64  missed;
+} OS_topic_record_t;
+
+OS_object_table_t   OS_topic_table;
+pthread_mutex_t     OS_topic_table_mut;
+
+static int          OS_topic_initialized = FALSE;
+
+#define OS_TOPIC_RECORD(id)   ((OS_topic_record_t *)OS_ObjectRecord(&OS_topic_table, id))
+
+/* header of buffer i of a topic */
+#define OS_TOPIC_BUFFER(topic, i)  ((OS_topic_buffer_t *)OS_BLOCK_AT(&(topic)->pool, i))
+
+uint32  OS_FindCreator(void);
+
+/****************************************************************************************
+                                 LOCAL FUNCTIONS
+****************************************************************************************/
+
+/*
+** Marks a new topic table record as free
+*/
+static void OS_TopicInitRecord(void *record)
+{
+    OS_topic_record_t *topic = record;
+
+    topic->free    = TRUE;
+    topic->creator = UNINITIALIZED;
+    topic->pool.blocks = NULL;
+    strcpy(topic->name, "");
+}
+
+/*
+** Tells whether id is a topic in use
+*/
+static int OS_TopicValidId(uint32 id)
+{
+    return(id < OS_topic_table.num_records && OS_TOPIC_RECORD(id)->free != TRUE);
+}
+
+/*
+** Tells whether id is a queue in use
+*/
+static int OS_TopicValidQueue(uint32 id)
+{
+    return(id < OS_queue_table.num_records && OS_QUEUE_RECORD(id)->free != TRUE);
+}
+
+/*
+** Drops a reference to a buffer, freeing it with the last one
+*/
+static void OS_TopicUnref(OS_topic_record_t *topic, OS_topic_buffer_t *buffer)
+{
+    if ( __sync_sub_and_fetch(&buffer->refs, 1) == 0 )
+    {
+        OS_BlockFree(&topic->pool, buffer);
+    }
+}
+
+/*
+** Counts the buffers of a topic nobody holds
+*/
+static uint32 OS_TopicFreeCount(OS_topic_record_t *topic)
+{
+    return(topic->pool.block_count - OS_BlockPoolInUse(&topic->pool));
+}
+
+/*
+** Finds the header of the buffer whose data is at data, and its topic.
+** Returns NULL when data is not the data of a buffer held by someone.
+*/
+static OS_topic_buffer_t *OS_TopicBufferOf(void *data, OS_topic_record_t **topic_out)
+{
+    OS_topic_buffer_t *buffer;
+    OS_topic_record_t *topic;
+
+    if ( data == NULL )
+    {
+        return(NULL);
+    }
+
+    buffer = (OS_topic_buffer_t *)data - 1;
+    if ( !OS_TopicValidId(buffer->topic_id) )
+    {
+        return(NULL);
+    }
+
+    topic = OS_TOPIC_RECORD(buffer->topic_id);
+    if ( buffer->index >= topic->pool.block_count ||
+         OS_TOPIC_BUFFER(topic, buffer->index) != buffer || buffer->refs == 0 )
+    {
+        return(NULL);
+    }
+
+    *topic_out = topic;
+    return(buffer);
+}
+
+/****************************************************************************************
+                                 PUBLISH/SUBSCRIBE API
+****************************************************************************************/
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_TopicInit
+
+   Purpose: Initialize the table of publish/subscribe topics
+
+   Returns: OS_ERROR if the table cannot be set up
+            OS_SUCCESS if success
+
+   Notes: OS_API_Init calls it, calling it again does nothing
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicInit (void)
+{
+    uint32 max_topics;
+
+    if ( OS_topic_initialized )
+    {
+        return OS_SUCCESS;
+    }
+
+    max_topics = OS_api_config.max_topics;
+    if ( max_topics == 0 )
+    {
+        max_topics = OS_MAX_TOPICS;
+    }
+
+    if ( OS_ObjectTableInit(&OS_topic_table, sizeof(OS_topic_record_t),
+                            max_topics, OS_TopicInitRecord) != OS_SUCCESS )
+    {
+        return OS_ERROR;
+    }
+
+    if ( pthread_mutex_init(&OS_topic_table_mut, NULL) != 0 )
+    {
+        return OS_ERROR;
+    }
+
+    OS_topic_initialized = TRUE;
+
+    return OS_SUCCESS;
+
+}/* end OS_TopicInit */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_TopicCreate
+
+   Purpose: Create a topic with num_buffers buffers of buffer_size bytes to
+            publish on
+
+   Returns: OS_INVALID_POINTER if a pointer passed in is NULL
+            OS_ERR_NAME_TOO_LONG if the name passed in is too long
+            OS_ERR_NO_FREE_IDS if there are already the max topics created
+            OS_ERR_NAME_TAKEN if the name is already used by a topic
+            OS_QUEUE_INVALID_SIZE if buffer_size or num_buffers is 0
+            OS_ERROR if the buffers cannot be allocated
+            OS_SUCCESS if success
+
+   Notes: The buffers are allocated here, publishing never allocates memory
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicCreate (uint32 *topic_id, const char *topic_name, uint32 buffer_size,
+                      uint32 num_buffers)
+{
+    uint32             possible_id;
+    int32              return_code;
+    OS_topic_record_t *topic;
+    OS_topic_buffer_t *buffer;
+    OS_block_pool_t    pool;
+    uint32             i;
+
+    if ( topic_id == NULL || topic_name == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( strlen(topic_name) >= OS_MAX_API_NAME )
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ( buffer_size == 0 || num_buffers == 0 )
+    {
+        return OS_QUEUE_INVALID_SIZE;
+    }
+
+    if ( buffer_size > 0xFFFFFFFF - sizeof(OS_topic_buffer_t) ||
+         OS_BlockPoolInit(&pool, sizeof(OS_topic_buffer_t) + buffer_size, num_buffers,
+                          FALSE) != OS_SUCCESS )
+    {
+        return OS_ERROR;
+    }
+
+    /* Take a free topic Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_topic_table, &possible_id) != OS_SUCCESS )
+    {
+        OS_BlockPoolDestroy(&pool);
+        return OS_ERR_NO_FREE_IDS;
+    }
+
+    /* Check to see if the name is already taken, and reserve it */
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_TOPIC, topic_name, possible_id);
+    if ( return_code != OS_SUCCESS )
+    {
+        OS_ObjectRelease(&OS_topic_table, possible_id);
+        OS_BlockPoolDestroy(&pool);
+        return return_code;
+    }
+
+    topic = OS_TOPIC_RECORD(possible_id);
+
+    topic->buffer_size = buffer_size;
+    topic->pool        = pool;
+    topic->published   = 0;
+    topic->missed      = 0;
+    memset((void *)topic->subscribers, 0, sizeof(topic->subscribers));
+
+    for ( i = 0; i < num_buffers; i++ )
+    {
+        buffer = OS_TOPIC_BUFFER(topic, i);
+        buffer->refs     = 0;
+        buffer->topic_id = possible_id;
+        buffer->index    = i;
+    }
+
+    *topic_id = possible_id;
+
+    pthread_mutex_lock(&OS_topic_table_mut);
+
+    topic->free    = FALSE;
+    strcpy(topic->name, topic_name);
+    topic->creator = OS_FindCreator();
+
+    pthread_mutex_unlock(&OS_topic_table_mut);
+
+    return OS_SUCCESS;
+
+}/* end OS_TopicCreate */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_TopicDelete
+
+   Purpose: Delete a topic and free its buffers
+
+   Returns: OS_ERR_INVALID_ID if the id passed in is not a topic
+            OS_ERROR if a buffer of the topic is still allocated, or held by a
+                     subscriber
+            OS_SUCCESS if success
+
+   Notes: The topic must not be published on while it is deleted
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicDelete (uint32 topic_id)
+{
+    OS_topic_record_t *topic;
+    OS_block_pool_t    pool;
+
+    if ( !OS_TopicValidId(topic_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    topic = OS_TOPIC_RECORD(topic_id);
+
+    pthread_mutex_lock(&OS_topic_table_mut);
+
+    if ( OS_TopicFreeCount(topic) != topic->pool.block_count )
+    {
+        pthread_mutex_unlock(&OS_topic_table_mut);
+        return OS_ERROR;
+    }
+
+    OS_NameIndexRemove(OS_OBJECT_TYPE_TOPIC, topic->name);
+    topic->free    = TRUE;
+    strcpy(topic->name, "");
+    topic->creator = UNINITIALIZED;
+    pool           = topic->pool;
+    topic->pool.blocks = NULL;
+
+    pthread_mutex_unlock(&OS_topic_table_mut);
+
+    OS_BlockPoolDestroy(&pool);
+    OS_ObjectRelease(&OS_topic_table, topic_id);
+
+    return OS_SUCCESS;
+
+}/* end OS_TopicDelete */
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_TopicGetIdByName
+
+    Purpose: This function tries to find a topic Id given its name.
+             The id is returned through topic_id
+
+    Returns: OS_INVALID_POINTER is topic_id or topic_name are NULL pointers
+             OS_ERR_NAME_TOO_LONG if the name given is to long to have been stored
+             OS_ERR_NAME_NOT_FOUND if the name was not found in the table
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicGetIdByName (uint32 *topic_id, const char *topic_name)
+{
+    uint32 i;
+
+    if ( topic_id == NULL || topic_name == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( strlen(topic_name) >= OS_MAX_API_NAME )
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ( (OS_NameIndexFind(OS_OBJECT_TYPE_TOPIC, topic_name, &i) == OS_SUCCESS) &&
+         (OS_TOPIC_RECORD(i)->free != TRUE) &&
+         (strcmp(OS_TOPIC_RECORD(i)->name, topic_name) == 0) )
+    {
+        *topic_id = i;
+        return OS_SUCCESS;
+    }
+
+    return OS_ERR_NAME_NOT_FOUND;
+
+}/* end OS_TopicGetIdByName */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_TopicGetInfo
+
+    Purpose: This function will pass back the name and creator of the specified
+             topic, with the use of its buffers and its subscribers.
+
+    Returns: OS_ERR_INVALID_ID if the id passed in is not a valid topic
+             OS_INVALID_POINTER if the topic_prop pointer is null
+             OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicGetInfo (uint32 topic_id, OS_topic_prop_t *topic_prop)
+{
+    OS_topic_record_t *topic;
+    uint32             i;
+
+    if ( !OS_TopicValidId(topic_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( topic_prop == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    topic = OS_TOPIC_RECORD(topic_id);
+
+    pthread_mutex_lock(&OS_topic_table_mut);
+
+    topic_prop->creator      = topic->creator;
+    strcpy(topic_prop->name, topic->name);
+    topic_prop->buffer_size  = topic->buffer_size;
+    topic_prop->buffers      = topic->pool.block_count;
+    topic_prop->buffers_free = OS_TopicFreeCount(topic);
+    topic_prop->published    = topic->published;
+    topic_prop->missed       = topic->missed;
+
+    topic_prop->subscribers = 0;
+    for ( i = 0; i < OS_MAX_TOPIC_SUBSCRIBERS; i++ )
+    {
+        if ( topic->subscribers[i] != 0 )
+        {
+            topic_prop->subscribers++;
+        }
+    }
+
+    pthread_mutex_unlock(&OS_topic_table_mut);
+
+    return OS_SUCCESS;
+
+} /* end OS_TopicGetInfo */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_TopicSubscribe
+
+   Purpose: Have the buffers published on a topic put on a queue. Each message
+            got from the queue is a pointer to the data of a buffer, which the
+            subscriber passes to OS_TopicRelease once it is done with it.
+
+   Returns: OS_ERR_INVALID_ID if topic_id is not a topic or queue_id not a queue
+            OS_ERR_NO_FREE_IDS if the topic has OS_MAX_TOPIC_SUBSCRIBERS already
+            OS_ERROR if the queue is already subscribed, is shared with other
+                     processes, or drops messages when full
+            OS_SUCCESS if success
+
+   Notes: A queue created with OS_QUEUE_DROP_NEWEST or OS_QUEUE_OVERWRITE would
+          lose buffers nobody could release, so it cannot subscribe. The queue
+          must be unsubscribed before it is deleted.
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicSubscribe (uint32 topic_id, uint32 queue_id)
+{
+    OS_topic_record_t *topic;
+    uint32             queue_flags;
+    int32              return_code;
+    uint32             i;
+
+    if ( !OS_TopicValidId(topic_id) || !OS_TopicValidQueue(queue_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    queue_flags = OS_QUEUE_RECORD(queue_id)->flags;
+    if ( (queue_flags & OS_QUEUE_POLICY_MASK) == OS_QUEUE_DROP_NEWEST ||
+         (queue_flags & OS_QUEUE_POLICY_MASK) == OS_QUEUE_OVERWRITE ||
+         (queue_flags & OS_QUEUE_SHARED) != 0 )
+    {
+        return OS_ERROR;
+    }
+
+    topic = OS_TOPIC_RECORD(topic_id);
+
+    pthread_mutex_lock(&OS_topic_table_mut);
+
+    return_code = OS_ERR_NO_FREE_IDS;
+    for ( i = 0; i < OS_MAX_TOPIC_SUBSCRIBERS; i++ )
+    {
+        if ( topic->subscribers[i] == queue_id + 1 )
+        {
+            return_code = OS_ERROR;
+            break;
+        }
+    }
+
+    for ( i = 0; return_code == OS_ERR_NO_FREE_IDS && i < OS_MAX_TOPIC_SUBSCRIBERS; i++ )
+    {
+        if ( topic->subscribers[i] == 0 )
+        {
+            topic->subscribers[i] = queue_id + 1;
+            return_code = OS_SUCCESS;
+        }
+    }
+
+    pthread_mutex_unlock(&OS_topic_table_mut);
+
+    return return_code;
+
+}/* end OS_TopicSubscribe */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_TopicUnsubscribe
+
+   Purpose: Stop putting the buffers published on a topic on a queue
+
+   Returns: OS_ERR_INVALID_ID if the topic id passed in is not a topic
+            OS_ERR_NAME_NOT_FOUND if the queue is not subscribed to the topic
+            OS_SUCCESS if success
+
+   Notes: A publish already under way may still put a buffer on the queue. The
+          buffers left on the queue must still be released.
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicUnsubscribe (uint32 topic_id, uint32 queue_id)
+{
+    OS_topic_record_t *topic;
+    int32              return_code;
+    uint32             i;
+
+    if ( !OS_TopicValidId(topic_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    topic = OS_TOPIC_RECORD(topic_id);
+
+    pthread_mutex_lock(&OS_topic_table_mut);
+
+    return_code = OS_ERR_NAME_NOT_FOUND;
+    for ( i = 0; i < OS_MAX_TOPIC_SUBSCRIBERS; i++ )
+    {
+        if ( topic->subscribers[i] == queue_id + 1 )
+        {
+            topic->subscribers[i] = 0;
+            return_code = OS_SUCCESS;
+        }
+    }
+
+    pthread_mutex_unlock(&OS_topic_table_mut);
+
+    return return_code;
+
+}/* end OS_TopicUnsubscribe */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_TopicAlloc
+
+   Purpose: Take a free buffer of a topic for the caller to fill in and publish
+
+   Returns: OS_ERR_INVALID_ID if the topic id passed in is not a topic
+            OS_INVALID_POINTER if buffer is NULL
+            OS_ERROR if all the buffers of the topic are in use
+            OS_SUCCESS if success
+
+   Notes: The buffer holds the buffer_size bytes the topic was created with. It
+          is handed to OS_TopicPublish, or to OS_TopicRelease when it is not to
+          be published after all. Never blocks and makes no system call.
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicAlloc (uint32 topic_id, void **buffer)
+{
+    OS_topic_buffer_t *header;
+
+    if ( !OS_TopicValidId(topic_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( buffer == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    header = OS_BlockAlloc(&OS_TOPIC_RECORD(topic_id)->pool);
+    if ( header == NULL )
+    {
+        return OS_ERROR;
+    }
+
+    header->refs = 1;
+    *buffer = header + 1;
+
+    return OS_SUCCESS;
+
+}/* end OS_TopicAlloc */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_TopicPublish
+
+   Purpose: Put a pointer to a buffer taken with OS_TopicAlloc on the queue of
+            each subscriber of the topic. The caller gives up the buffer.
+
+   Returns: OS_ERR_INVALID_ID if the topic id passed in is not a topic
+            OS_INVALID_POINTER if buffer is not a buffer of the topic taken with
+                               OS_TopicAlloc
+            OS_ERROR if flags asks to drop messages when a queue is full
+            OS_QUEUE_FULL if one or more of the subscribers did not get it
+            OS_SUCCESS if success, or if the topic has no subscribers
+
+   Notes: flags are passed to OS_QueuePut, so they may give the priority of the
+          message and OS_QUEUE_BLOCK, which waits for room on a full queue and
+          holds up the subscribers after it. A subscriber that does not get the
+          buffer is counted as missed in OS_TopicGetInfo, and no reference is
+          kept for it.
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicPublish (uint32 topic_id, void *buffer, uint32 flags)
+{
+    OS_topic_record_t *topic;
+    OS_topic_record_t *buffer_topic;
+    OS_topic_buffer_t *header;
+    uint32             queues[OS_MAX_TOPIC_SUBSCRIBERS];
+    uint32             count;
+    uint32             missed;
+    uint32             i;
+
+    if ( !OS_TopicValidId(topic_id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    topic  = OS_TOPIC_RECORD(topic_id);
+    header = OS_TopicBufferOf(buffer, &buffer_topic);
+    if ( header == NULL || buffer_topic != topic || header->refs != 1 )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( (flags & OS_QUEUE_POLICY_MASK) == OS_QUEUE_DROP_NEWEST ||
+         (flags & OS_QUEUE_POLICY_MASK) == OS_QUEUE_OVERWRITE )
+    {
+        return OS_ERROR;
+    }
+
+    count = 0;
+    for ( i = 0; i < OS_MAX_TOPIC_SUBSCRIBERS; i++ )
+    {
+        queues[count] = topic->subscribers[i];
+        if ( queues[count] != 0 )
+        {
+            count++;
+        }
+    }
+
+    /*
+    ** Every subscriber may have the buffer, and release it, as soon as it is put
+    ** on its queue, so all the references are taken first. The caller keeps one
+    ** until the buffer is on all the queues.
+    */
+    header->refs = count + 1;
+
+    missed = 0;
+    for ( i = 0; i < count; i++ )
+    {
+        if ( OS_QueuePut(queues[i] - 1, &buffer, sizeof(buffer), flags) != OS_SUCCESS )
+        {
+            missed++;
+            OS_TopicUnref(topic, header);
+        }
+    }
+
+    __sync_fetch_and_add(&topic->published, 1);
+    if ( missed != 0 )
+    {
+        __sync_fetch_and_add(&topic->missed, missed);
+    }
+
+    OS_TopicUnref(topic, header);
+
+    return((missed == 0) ? OS_SUCCESS : OS_QUEUE_FULL);
+
+}/* end OS_TopicPublish */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_TopicRelease
+
+   Purpose: Drop the reference a subscriber holds to a buffer got from its queue.
+            The buffer goes back to its topic once all the subscribers have
+            released it.
+
+   Returns: OS_INVALID_POINTER if buffer is not a buffer of a topic in use
+            OS_SUCCESS if success
+
+   Notes: Also gives back a buffer taken with OS_TopicAlloc that was not
+          published. Never blocks and makes no system call.
+---------------------------------------------------------------------------------------*/
+int32 OS_TopicRelease (void *buffer)
+{
+    OS_topic_record_t *topic;
+    OS_topic_buffer_t *header;
+
+    header = OS_TopicBufferOf(buffer, &topic);
+    if ( header == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    OS_TopicUnref(topic, header);
+
+    return OS_SUCCESS;
+
+}/* end OS_TopicRelease */
@@ -1,59 +1,29 @@
-#include "osapi.h"
-#include "osposix.h"
-#include <pthread.h>
-/*
-** This include must be put below the osapi.h
-** include so it can pick up the define
-*/
-#ifndef OSAL_SOCKET_QUEUE
-#ifndef __MACH__
-	#include <mqueue.h>
-#else
-	#include <sys/fcntl.h>
-#endif
-#endif
+#include "osqueues.h"
 
-#ifdef OSAL_SOCKET_QUEUE
-/* queues */
-typedef struct
-{
-    int free;
-    int id;
-    char name [OS_MAX_API_NAME];
-    int creator;
-}OS_queue_record_t;
-#else
-/* queues */
-typedef struct
-{
-    int   free;
-    mqd_t id;
-    char  name [OS_MAX_API_NAME];
-    int   creator;
-}OS_queue_record_t;
-#endif
-
-OS_queue_record_t   OS_queue_table         [OS_MAX_QUEUES];
+OS_object_table_t   OS_queue_table;
 pthread_mutex_t OS_queue_table_mut;
 
+/*
+** Times a put with OS_QUEUE_OVERWRITE drops the oldest message to make room.
+** Other puts may take the room first, or the oldest message may still be on
+** its way in, so the put gives up with OS_QUEUE_FULL after that.
+*/
+#define OS_QUEUE_OVERWRITE_TRIES 4
 
-int OS_Queue_Init()
+
+int OS_Queue_Init(void)
 {
 	int32 return_code = OS_SUCCESS;
 	int ret;
-	int i;
-	pthread_mutexattr_t mutex_attr ;
     /* Initialize Message Queue Table */
 
-    for(i = 0; i < OS_MAX_QUEUES; i++)
+    if ( OS_ObjectTableInit(&OS_queue_table, sizeof(OS_queue_record_t),
+                            OS_api_config.max_queues, OS_QueueInitRecord) != OS_SUCCESS )
     {
-        OS_queue_table[i].free        = TRUE;
-        OS_queue_table[i].id          = UNINITIALIZED;
-        OS_queue_table[i].creator     = UNINITIALIZED;
-        strcpy(OS_queue_table[i].name,"");
+       return(OS_ERROR);
     }
 
-    ret = pthread_mutex_init((pthread_mutex_t *) & OS_queue_table_mut,&mutex_attr);
+    ret = pthread_mutex_init((pthread_mutex_t *) & OS_queue_table_mut,NULL);
     if ( ret != 0 )
     {
        return_code = OS_ERROR;
@@ -62,6 +32,411 @@ int OS_Queue_Init()
     return return_code;
 }
 
+/*
+** Marks a new queue table record as free
+*/
+void OS_QueueInitRecord(void *record)
+{
+    OS_queue_record_t *queue = record;
+
+    queue->free        = TRUE;
+    queue->id          = UNINITIALIZED;
+    queue->creator     = UNINITIALIZED;
+    strcpy(queue->name,"");
+}
+
+/*
+** Counts count messages put and refused messages not put because the queue
+** was full. depth is the number of messages the queue holds after the put.
+*/
+void OS_QueueCountPut(OS_queue_counters_t *counters, uint32 count, uint32 refused,
+                      uint32 depth)
+{
+    if ( count > 0 )
+    {
+        __atomic_fetch_add(&counters->puts, count, __ATOMIC_RELAXED);
+        OS_QueueCountHighWater(counters, depth);
+    }
+
+    if ( refused > 0 )
+    {
+        __atomic_fetch_add(&counters->full, refused, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+** Raises the high water mark to depth messages
+*/
+void OS_QueueCountHighWater(OS_queue_counters_t *counters, uint32 depth)
+{
+    uint32 high_water;
+
+    high_water = counters->high_water;
+    while ( depth > high_water &&
+            !__sync_bool_compare_and_swap(&counters->high_water, high_water, depth) )
+    {
+        high_water = counters->high_water;
+    }
+}
+
+/*
+** Counts count messages got by a get that returned status
+*/
+void OS_QueueCountGet(OS_queue_counters_t *counters, uint32 count, int32 status)
+{
+    if ( count > 0 )
+    {
+        __atomic_fetch_add(&counters->gets, count, __ATOMIC_RELAXED);
+    }
+    else if ( status == OS_QUEUE_EMPTY )
+    {
+        __atomic_fetch_add(&counters->empty, 1, __ATOMIC_RELAXED);
+    }
+    else if ( status == OS_QUEUE_TIMEOUT )
+    {
+        __atomic_fetch_add(&counters->timeouts, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+** Adds a message put at put_time and got at now, as given by OS_QueueTime, to
+** the latency histogram
+*/
+void OS_QueueCountLatency(OS_queue_counters_t *counters, uint64 put_time, uint64 now)
+{
+    uint64 usecs;
+    uint32 bucket;
+
+    usecs  = (now - put_time) / 1000;
+    bucket = (usecs == 0) ? 0 : 64 - __builtin_clzll(usecs);
+    if ( bucket >= OS_QUEUE_LATENCY_BUCKETS )
+    {
+        bucket = OS_QUEUE_LATENCY_BUCKETS - 1;
+    }
+
+    __atomic_fetch_add(&counters->latency[bucket], 1, __ATOMIC_RELAXED);
+}
+
+/*
+** Number of messages in a queue whose depth only the counters tell. A put
+** counts its message after the message is in the queue, so a get may count
+** it first.
+*/
+uint32 OS_QueueCountedDepth(OS_queue_counters_t *counters)
+{
+    int64 depth;
+
+    depth = (int64)(counters->puts - counters->gets - counters->overwritten);
+
+    return((depth > 0) ? (uint32)depth : 0);
+}
+
+/*
+** Monotonic time in nsecs, for the latency of the messages
+*/
+uint64 OS_QueueTime(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return((uint64)now.tv_sec * 1000000000 + now.tv_nsec);
+}
+
+#ifndef OSAL_RING_QUEUE
+/*
+** Returns the descriptor that becomes readable when the queue has a message,
+** for OS_WaitAny. Both the message queues and the sockets are descriptors,
+** and the puts of a higher priority also wake the socket of priority 0.
+*/
+int32 OS_QueueWaitStart(uint32 queue_id, int *fd)
+{
+    if (queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    *fd = (int)OS_QUEUE_RECORD(queue_id)->id;
+
+    return OS_SUCCESS;
+}
+
+/*
+** Nothing to undo, the descriptor belongs to the queue
+*/
+void OS_QueueWaitEnd(uint32 queue_id)
+{
+}
+
+/*
+** Only poll can tell whether a message queue or socket holds a message
+*/
+int OS_QueueWaitReady(uint32 queue_id, int fd_ready)
+{
+    return(fd_ready);
+}
+
+/*--------------------------------------------------------------------------------------
+    Name: OS_QueueReserve, OS_QueueCommit, OS_QueueGetPtr, OS_QueueRelease
+
+    Purpose: The zero copy queue API needs the messages in the memory of the
+             process, see osqueues_ring.c
+
+    Returns: OS_ERR_NOT_IMPLEMENTED
+---------------------------------------------------------------------------------------*/
+int32 OS_QueueReserve (uint32 queue_id, uint32 size, void **ptr)
+{
+    return(OS_ERR_NOT_IMPLEMENTED);
+}
+
+int32 OS_QueueCommit (uint32 queue_id, void *ptr)
+{
+    return(OS_ERR_NOT_IMPLEMENTED);
+}
+
+int32 OS_QueueGetPtr (uint32 queue_id, void **ptr, uint32 *size, int32 timeout)
+{
+    return(OS_ERR_NOT_IMPLEMENTED);
+}
+
+int32 OS_QueueRelease (uint32 queue_id, void *ptr)
+{
+    return(OS_ERR_NOT_IMPLEMENTED);
+}
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_QueueGetEventFd
+
+    Purpose: Passes back a descriptor that is readable while the queue holds a
+             message, for a poll or epoll loop of the caller
+
+    Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
+             OS_INVALID_POINTER if fd is NULL
+             OS_SUCCESS if SUCCESS
+
+    Notes: This is the message queue or the socket of priority 0 itself, it must
+           not be read or closed. Get the messages with OS_CHECK once it polls
+           readable. The empty datagrams the puts of a higher priority send to
+           wake the socket can leave it readable after the last message, until a
+           get drops them and returns OS_QUEUE_EMPTY.
+---------------------------------------------------------------------------------------*/
+int32 OS_QueueGetEventFd (uint32 queue_id, int32 *fd)
+{
+    if (queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if (fd == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    *fd = (int32)OS_QUEUE_RECORD(queue_id)->id;
+
+    return OS_SUCCESS;
+
+} /* end OS_QueueGetEventFd */
+#endif
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_QueuePut
+
+    Purpose: Put a message on a message queue.
+
+    Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
+             OS_INVALID_POINTER if the data pointer is NULL
+             OS_QUEUE_INVALID_SIZE if the message is larger than the queue takes
+             OS_QUEUE_FULL if the queue cannot accept another message
+             OS_ERROR if the OS call returns an error
+             OS_SUCCESS if SUCCESS
+
+    Notes: flags gives the priority of the message with OS_QUEUE_PRIORITY, or'ed with
+           what to do when the queue is full, if not what the queue was created with:
+           OS_QUEUE_BLOCK waits for room, OS_QUEUE_DROP_NEWEST drops the message and
+           returns OS_SUCCESS, and OS_QUEUE_OVERWRITE drops the oldest message of the
+           same priority to make room. Without any of them the put returns
+           OS_QUEUE_FULL at once. OS_QUEUE_OVERWRITE also returns OS_QUEUE_FULL when
+           that message cannot be dropped: on an OS_QUEUE_SPSC ring queue, and on a
+           POSIX message queue that holds messages of another priority.
+---------------------------------------------------------------------------------------*/
+int32 OS_QueuePut (uint32 queue_id, void *data, uint32 size, uint32 flags)
+{
+    OS_queue_counters_t *counters;
+    uint32               policy;
+    int32                return_code;
+    int32                discarded;
+    int                  tries;
+
+    /*
+    ** Check Parameters
+    */
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    if (data == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    counters = &OS_QUEUE_RECORD(queue_id)->counters;
+    policy   = OS_QUEUE_POLICY(OS_QUEUE_RECORD(queue_id)->flags, flags);
+
+    if ( policy == OS_QUEUE_BLOCK )
+    {
+        return OS_QueueSend(queue_id, data, size, flags, OS_PEND);
+    }
+
+    return_code = OS_QueueSend(queue_id, data, size, flags, OS_CHECK);
+    for ( tries = 0; return_code == OS_QUEUE_FULL && policy == OS_QUEUE_OVERWRITE &&
+                     tries < OS_QUEUE_OVERWRITE_TRIES; tries++ )
+    {
+        /* A get may take the oldest message first, which makes room all the same */
+        discarded = OS_QueueDiscard(queue_id, flags);
+        if ( discarded == OS_SUCCESS )
+        {
+            __atomic_fetch_add(&counters->overwritten, 1, __ATOMIC_RELAXED);
+        }
+        else if ( discarded != OS_QUEUE_EMPTY )
+        {
+            break;
+        }
+        return_code = OS_QueueSend(queue_id, data, size, flags, OS_CHECK);
+    }
+
+    if ( return_code == OS_QUEUE_FULL )
+    {
+        if ( policy == OS_QUEUE_DROP_NEWEST )
+        {
+            __atomic_fetch_add(&counters->dropped, 1, __ATOMIC_RELAXED);
+            return OS_SUCCESS;
+        }
+        OS_QueueCountPut(counters, 0, 1, 0);
+    }
+
+    return return_code;
+
+} /* end OS_QueuePut */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_QueuePutTimeout
+
+    Purpose: Put a message on a message queue, waiting up to timeout msecs for room
+             if the queue is full, or forever if timeout is OS_PEND.
+
+    Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
+             OS_INVALID_POINTER if the data pointer is NULL
+             OS_QUEUE_INVALID_SIZE if the message is larger than the queue takes
+             OS_QUEUE_FULL if the timeout was OS_CHECK and the queue was full
+             OS_QUEUE_TIMEOUT if the time expired before there was room
+             OS_ERROR if the OS call returns an error
+             OS_SUCCESS if SUCCESS
+
+    Notes: flags gives the priority of the message as for OS_QueuePut. The policy
+           the queue was created with does not apply, the put only waits.
+---------------------------------------------------------------------------------------*/
+int32 OS_QueuePutTimeout (uint32 queue_id, void *data, uint32 size, uint32 flags,
+                          int32 timeout)
+{
+    int32 return_code;
+
+    /*
+    ** Check Parameters
+    */
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    if (data == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    return_code = OS_QueueSend(queue_id, data, size, flags, timeout);
+    if ( return_code == OS_QUEUE_FULL || return_code == OS_QUEUE_TIMEOUT )
+    {
+        OS_QueueCountPut(&OS_QUEUE_RECORD(queue_id)->counters, 0, 1, 0);
+    }
+
+    return return_code;
+
+} /* end OS_QueuePutTimeout */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_QueuePutBatch
+
+    Purpose: Puts count messages of size bytes each, stored one after the other at
+             data, on a message queue. If the queue fills up, the messages that fit
+             are put.
+
+    Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
+             OS_INVALID_POINTER if a pointer passed in is NULL
+             OS_QUEUE_INVALID_SIZE if size is larger than the queue takes
+             OS_QUEUE_FULL if the queue could not take all of the messages
+             OS_ERROR if the OS call returns an error
+             OS_SUCCESS if all of the messages were put
+
+    Notes: count_put is set to the number of messages put. flags gives the priority
+           and the policy of the messages as for OS_QueuePut. The messages that do
+           not fit in one go are put one at a time with that policy, and the ones
+           OS_QUEUE_DROP_NEWEST drops are not counted in count_put.
+---------------------------------------------------------------------------------------*/
+int32 OS_QueuePutBatch (uint32 queue_id, void *data, uint32 size, uint32 count,
+                        uint32 *count_put, uint32 flags)
+{
+    OS_queue_counters_t *counters;
+    uint32               policy;
+    int32                return_code;
+
+    /*
+    ** Check Parameters
+    */
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    if ( (data == NULL) || (count_put == NULL) )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    counters = &OS_QUEUE_RECORD(queue_id)->counters;
+    policy   = OS_QUEUE_POLICY(OS_QUEUE_RECORD(queue_id)->flags, flags);
+
+    *count_put = 0;
+    return_code = OS_QueueSendBatch(queue_id, data, size, count, count_put, flags);
+    if ( return_code != OS_QUEUE_FULL )
+    {
+        return return_code;
+    }
+
+    if ( policy == OS_QUEUE_DROP_NEWEST )
+    {
+        __atomic_fetch_add(&counters->dropped, count - *count_put, __ATOMIC_RELAXED);
+        return OS_SUCCESS;
+    }
+    else if ( policy == 0 )
+    {
+        OS_QueueCountPut(counters, 0, count - *count_put, 0);
+        return OS_QUEUE_FULL;
+    }
+
+    while ( *count_put < count )
+    {
+        return_code = OS_QueuePut(queue_id, (char *)data + (size_t)*count_put * size, size,
+                                  flags);
+        if ( return_code != OS_SUCCESS )
+        {
+            return return_code;
+        }
+        (*count_put)++;
+    }
+
+    return OS_SUCCESS;
+
+} /* end OS_QueuePutBatch */
+
 /*--------------------------------------------------------------------------------------
     Name: OS_QueueGetIdByName
 
@@ -71,8 +446,13 @@ int OS_Queue_Init()
     Returns: OS_INVALID_POINTER if the name or id pointers are NULL
              OS_ERR_NAME_TOO_LONG the name passed in is too long
              OS_ERR_NAME_NOT_FOUND the name was not found in the table
+             OS_ERR_NO_FREE_IDS if the name is a shared queue of another process,
+                                and there are already the max queues here
+             OS_ERROR if the shared queue of another process cannot be mapped
              OS_SUCCESS if success
 
+    Notes: A queue another process created with OS_QUEUE_SHARED is opened in this
+           one the first time it is looked up.
 ---------------------------------------------------------------------------------------*/
 
 int32 OS_QueueGetIdByName (uint32 *queue_id, const char *queue_name)
@@ -92,19 +472,18 @@ int32 OS_QueueGetIdByName (uint32 *queue_id, const char *queue_name)
        return OS_ERR_NAME_TOO_LONG;
     }
 
-    for (i = 0; i < OS_MAX_QUEUES; i++)
+    if ((OS_NameIndexFind(OS_OBJECT_TYPE_QUEUE, queue_name, &i) == OS_SUCCESS) &&
+        (OS_QUEUE_RECORD(i)->free != TRUE) &&
+        (strcmp(OS_QUEUE_RECORD(i)->name, (char*) queue_name) == 0))
     {
-        if (OS_queue_table[i].free != TRUE &&
-           (strcmp(OS_queue_table[i].name, (char*) queue_name) == 0 ))
-        {
-            *queue_id = i;
-            return OS_SUCCESS;
-        }
+        *queue_id = i;
+        return OS_SUCCESS;
     }
 
     /* The name was not found in the table,
-     *  or it was, and the queue_id isn't valid anymore */
-    return OS_ERR_NAME_NOT_FOUND;
+     *  or it was, and the queue_id isn't valid anymore.
+     *  It may still be a shared queue of another process */
+    return OS_QueueOpen(queue_id, queue_name);
 
 }/* end OS_QueueGetIdByName */
 
@@ -127,7 +506,7 @@ int32 OS_QueueGetInfo (uint32 queue_id, OS_queue_prop_t *queue_prop)
         return OS_INVALID_POINTER;
     }
 
-    if (queue_id >= OS_MAX_QUEUES || OS_queue_table[queue_id].free == TRUE)
+    if (queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
@@ -135,11 +514,68 @@ int32 OS_QueueGetInfo (uint32 queue_id, OS_queue_prop_t *queue_prop)
     /* put the info into the stucture */
     pthread_mutex_lock(&OS_queue_table_mut);
 
-    queue_prop -> creator =   OS_queue_table[queue_id].creator;
-    strcpy(queue_prop -> name, OS_queue_table[queue_id].name);
+    queue_prop -> creator =   OS_QUEUE_RECORD(queue_id)->creator;
+    strcpy(queue_prop -> name, OS_QUEUE_RECORD(queue_id)->name);
 
     pthread_mutex_unlock(&OS_queue_table_mut);
 
     return OS_SUCCESS;
 
 } /* end OS_QueueGetInfo */
+
+/*---------------------------------------------------------------------------------------
+    Name: OS_QueueGetStats
+
+    Purpose: This function passes back the statistics of the specified queue: its
+             depth, the counts of the puts and gets since it was created, and the
+             histogram of the time its messages spent in it.
+
+    Returns: OS_INVALID_POINTER if queue_stats is NULL
+             OS_ERR_INVALID_ID if the ID given is not  a valid queue
+             OS_ERROR if the depth of the queue could not be read
+             OS_SUCCESS if the statistics were copied over correctly
+
+    Notes: The counters are read one at a time while the queue is in use, so they
+           may be a few messages apart. The latency histogram is only kept for the
+           queues created with OS_QUEUE_LATENCY.
+---------------------------------------------------------------------------------------*/
+int32 OS_QueueGetStats (uint32 queue_id, OS_queue_stats_t *queue_stats)
+{
+    OS_queue_counters_t *counters;
+    int32                return_code;
+    int                  i;
+
+    if (queue_stats == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if (queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    counters = &OS_QUEUE_RECORD(queue_id)->counters;
+
+    queue_stats->high_water  = counters->high_water;
+    queue_stats->puts        = counters->puts;
+    queue_stats->gets        = counters->gets;
+    queue_stats->full        = counters->full;
+    queue_stats->dropped     = counters->dropped;
+    queue_stats->overwritten = counters->overwritten;
+    queue_stats->empty       = counters->empty;
+    queue_stats->timeouts    = counters->timeouts;
+    for ( i = 0; i < OS_QUEUE_LATENCY_BUCKETS; i++ )
+    {
+        queue_stats->latency[i] = counters->latency[i];
+    }
+
+    return_code = OS_QueueGetCounts(queue_id, queue_stats);
+    if ( return_code != OS_SUCCESS )
+    {
+        return return_code;
+    }
+
+    return OS_SUCCESS;
+
+} /* end OS_QueueGetStats */
@@ -2,7 +2,191 @@
 #define OSQUEUES_H
 	#include "common_types.h"
 	#include <stdio.h>
+	#include <string.h>
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <pthread.h>
 	#include <sys/types.h>
+	#include <sys/time.h>
+	#include <sys/select.h>
+	#include <sys/socket.h>
+	#include <netinet/in.h>
 	#include "osapi.h"
 	#include "osmac_stuff.h"
+	#include "osposix.h"
+	#include "osobject.h"
+
+/*
+** This include must be put below the osapi.h
+** include so it can pick up the define
+*/
+#if !defined(OSAL_SOCKET_QUEUE) && !defined(OSAL_RING_QUEUE)
+#ifndef __MACH__
+	#include <mqueue.h>
+#endif
+#endif
+
+/*
+** Statistics of a queue, see OS_QueueGetStats. The puts and the gets each
+** update counters on a cache line of their own, so that a producer and a
+** consumer on two CPUs do not pass one line back and forth. The counters are
+** only added to, with relaxed atomics.
+*/
+typedef struct
+{
+    volatile uint64  puts;
+    volatile uint64  full;
+    volatile uint64  dropped;
+    volatile uint64  overwritten;
+    volatile uint32  high_water;
+    volatile uint64  gets OS_ALIGN(OS_CACHE_LINE);
+    volatile uint64  empty;
+    volatile uint64  timeouts;
+    volatile uint64  latency[OS_QUEUE_LATENCY_BUCKETS];
+} OS_queue_counters_t;
+
+#if defined(OSAL_RING_QUEUE)
+/*
+** A ring of cells, each holding one message. The number of cells is the queue
+** depth rounded up to a power of two, but no more than depth messages are held.
+**
+** The cells of a multi-producer, multi-consumer ring carry a sequence number
+** that tells whether the cell is free for the put at that position, or holds
+** the message for the get at that position. Puts and gets claim a position
+** with a compare and swap. A single-producer, single-consumer ring only moves
+** its positions forward.
+**
+** The cells follow the ring in memory, starting on the next cache line.
+**
+** A queue keeps one ring per message priority, the ring of priority 0 is made
+** with the queue and the others by the first put of their priority. Gets sleep
+** on get_seq when all of them are empty, and puts bump it when there are
+** get_waiters. any_waiters counts the tasks waiting in OS_WaitAny. Puts that
+** wait for room sleep on put_seq in the same way, and gets bump it when there
+** are put_waiters.
+**
+** A queue created with OS_QUEUE_SHARED keeps its rings of all priorities, and
+** the words the tasks wait on, in a shared memory segment that the other
+** processes map when they look the queue up by name.
+**
+** The positions of the rings count the puts and gets for OS_QueueGetStats,
+** so the counters of the queue only take the rarer events.
+*/
+typedef struct
+{
+    volatile uint32  seq;
+    uint32           size;
+    uint64           put_time;    /* for OS_QUEUE_LATENCY */
+} OS_ring_cell_t;
+
+typedef struct
+{
+    volatile uint32  put_pos;
+    volatile uint32  put_laps;    /* times put_pos went past 2^32 */
+    char             put_pad[OS_CACHE_LINE - 2 * sizeof(uint32)];
+    volatile uint32  get_pos;
+    volatile uint32  get_laps;
+    char             get_pad[OS_CACHE_LINE - 2 * sizeof(uint32)];
+    uint32           depth;
+    uint32           mask;
+    uint32           data_size;
+    uint32           cell_size;
+    uint32           spsc;
+} OS_ring_t;
+
+typedef struct
+{
+    volatile uint32  get_seq;
+    volatile uint32  get_waiters;
+    volatile uint32  put_seq;
+    volatile uint32  put_waiters;
+} OS_ring_wait_t;
+
+/* queues */
+typedef struct
+{
+    int              free;
+    int              id;          /* eventfd for OS_WaitAny, or -1 */
+    char             name [OS_MAX_API_NAME];
+    int              creator;
+    uint32           flags;
+    OS_ring_t       *ring[OS_QUEUE_PRIORITIES];
+    OS_ring_wait_t  *wait;        /* local_wait, or in the segment of a shared queue */
+    OS_ring_wait_t   local_wait;
+    volatile uint32  any_waiters;
+    OS_event_fd_t    event;       /* see OS_QueueGetEventFd */
+    void            *segment;     /* mapped segment of a shared queue, or NULL */
+    size_t           segment_size;
+    int              segment_owner;  /* created by this process, deleting it removes the name */
+    OS_queue_counters_t counters;
+}OS_queue_record_t;
+#elif defined(OSAL_SOCKET_QUEUE)
+/* queues */
+typedef struct
+{
+    int free;
+    int id;                 /* socket the gets receive priority 0 messages on */
+    int send_id;            /* socket connected to id that the puts send on */
+    char name [OS_MAX_API_NAME];
+    int creator;
+    uint32 flags;
+    uint32 depth;
+    uint32 data_size;
+    int prio_id[OS_QUEUE_PRIORITIES];       /* the same pair of sockets for each priority */
+    int prio_send_id[OS_QUEUE_PRIORITIES];  /* above 0, made by its first put, or -1 */
+    volatile uint32 prio_count[OS_QUEUE_PRIORITIES];  /* messages sent on each pair */
+    OS_queue_counters_t counters;
+}OS_queue_record_t;
+#else
+/* queues */
+typedef struct
+{
+    int   free;
+    mqd_t id;
+    char  name [OS_MAX_API_NAME];
+    int   creator;
+    uint32 flags;
+    char  *discard;         /* buffer the messages dropped by OS_QUEUE_OVERWRITE go to */
+    volatile int32 level_count[OS_QUEUE_PRIORITIES];   /* messages of each priority in the queue */
+    OS_queue_counters_t counters;
+}OS_queue_record_t;
+#endif
+
+extern OS_object_table_t   OS_queue_table;
+extern pthread_mutex_t     OS_queue_table_mut;
+
+/* Priority of a message put with the given OS_QueuePut flags, up to the highest one kept */
+#define OS_QUEUE_LEVEL(flags) \
+    ((OS_QUEUE_PRIORITY_OF(flags) < OS_QUEUE_PRIORITIES) ? OS_QUEUE_PRIORITY_OF(flags) : \
+     (OS_QUEUE_PRIORITIES - 1))
+
+/* What a put with the given flags does when the queue is full */
+#define OS_QUEUE_POLICY(queue_flags, put_flags) \
+    (((put_flags) & OS_QUEUE_POLICY_MASK) ? ((put_flags) & OS_QUEUE_POLICY_MASK) : \
+     ((queue_flags) & OS_QUEUE_POLICY_MASK))
+
+#define OS_QUEUE_RECORD(id) ((OS_queue_record_t *)OS_ObjectRecord(&OS_queue_table, id))
+
+	int    OS_Queue_Init(void);
+	void   OS_QueueInitRecord(void *record);
+	int32  OS_QueueWaitStart(uint32 queue_id, int *fd);
+	void   OS_QueueWaitEnd(uint32 queue_id);
+	int    OS_QueueWaitReady(uint32 queue_id, int fd_ready);
+	int32  OS_QueueGetCounts(uint32 queue_id, OS_queue_stats_t *queue_stats);
+	int32  OS_QueueSend(uint32 queue_id, void *data, uint32 size, uint32 flags,
+	                    int32 timeout);
+	int32  OS_QueueSendBatch(uint32 queue_id, void *data, uint32 size, uint32 count,
+	                         uint32 *count_put, uint32 flags);
+	int32  OS_QueueDiscard(uint32 queue_id, uint32 flags);
+	int32  OS_QueueOpen(uint32 *queue_id, const char *queue_name);
+	void   OS_QueueCountPut(OS_queue_counters_t *counters, uint32 count, uint32 refused,
+	                        uint32 depth);
+	void   OS_QueueCountGet(OS_queue_counters_t *counters, uint32 count, int32 status);
+	void   OS_QueueCountHighWater(OS_queue_counters_t *counters, uint32 depth);
+	void   OS_QueueCountLatency(OS_queue_counters_t *counters, uint64 put_time, uint64 now);
+	uint32 OS_QueueCountedDepth(OS_queue_counters_t *counters);
+	uint64 OS_QueueTime(void);
+	uint32 OS_FindCreator(void);
+	uint32 OS_CompAbsDelayTime( uint32 milli_second , struct timespec * tm);
 #endif
@@ -1,7 +1,23 @@
 #include "osqueues.h"
-#ifndef OSAL_SOCKET_QUEUE
+#if !defined(OSAL_SOCKET_QUEUE) && !defined(OSAL_RING_QUEUE)
+
+#include <stdlib.h>
 
 /* ---------------------- POSIX MESSAGE QUEUE IMPLEMENTATION ------------------------- */
+
+/*
+** Adds delta to the count of the messages of mq_send priority prio in the
+** queue, which OS_QueueDiscard checks
+*/
+static void OS_QueueCountLevel(uint32 queue_id, unsigned int prio, int32 delta)
+{
+    if ( prio >= 1 && prio <= OS_QUEUE_PRIORITIES )
+    {
+        __atomic_fetch_add(&OS_QUEUE_RECORD(queue_id)->level_count[prio - 1], delta,
+                           __ATOMIC_RELAXED);
+    }
+}
+
 /*---------------------------------------------------------------------------------------
  Name: OS_QueueCreate
 
@@ -11,17 +27,19 @@
  OS_ERR_NAME_TOO_LONG if the name passed in is too long
  OS_ERR_NO_FREE_IDS if there are already the max queues created
  OS_ERR_NAME_TAKEN if the name is already being used on another queue
- OS_ERROR if the OS create call fails
+ OS_ERROR if the OS create call fails, or flags has OS_QUEUE_SHARED
  OS_SUCCESS if success
 
- Notes: the flags parameter is unused.
+ Notes: flags may give what OS_QueuePut does when the queue is full, the others
+ are unused.
  ---------------------------------------------------------------------------------------*/
 int32 OS_QueueCreate (uint32 *queue_id, const char *queue_name, uint32 queue_depth,
                       uint32 data_size, uint32 flags)
 {
-    int                     i;
+    int32                   return_code;
     pid_t                   process_id;
     mqd_t                   queueDesc;
+    char                   *discard;
     struct mq_attr          queueAttr;
     uint32                  possible_qid;
     char                    name[OS_MAX_API_NAME * 2];
@@ -41,40 +59,28 @@ int32 OS_QueueCreate (uint32 *queue_id, const char *queue_name, uint32 queue_dep
         return OS_ERR_NAME_TOO_LONG;
     }
 
-    /* Check Parameters */
-
-    pthread_mutex_lock(&OS_queue_table_mut);
-
-    for(possible_qid = 0; possible_qid < OS_MAX_QUEUES; possible_qid++)
+    /* Only the ring queues can be shared with other processes */
+    if ( flags & OS_QUEUE_SHARED )
     {
-        if (OS_queue_table[possible_qid].free == TRUE)
-            break;
+        return OS_ERROR;
     }
 
-    if( possible_qid >= OS_MAX_QUEUES || OS_queue_table[possible_qid].free != TRUE)
+     /* Take a free queue Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_queue_table, &possible_qid) != OS_SUCCESS )
     {
-        pthread_mutex_unlock(&OS_queue_table_mut);
         return OS_ERR_NO_FREE_IDS;
     }
 
-    /* Check to see if the name is already taken */
+    /* Check to see if the name is already taken, and reserve it */
 
-    for (i = 0; i < OS_MAX_QUEUES; i++)
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_QUEUE, queue_name, possible_qid);
+    if ( return_code != OS_SUCCESS )
     {
-        if ((OS_queue_table[i].free == FALSE) &&
-            strcmp ((char*) queue_name, OS_queue_table[i].name) == 0)
-        {
-            pthread_mutex_unlock(&OS_queue_table_mut);
-            return OS_ERR_NAME_TAKEN;
-        }
+        OS_ObjectRelease(&OS_queue_table, possible_qid);
+        return return_code;
     }
 
-    /* Set the possible task Id to not free so that
-     * no other task can try to use it */
-
-    OS_queue_table[possible_qid].free = FALSE;
-
-    pthread_mutex_unlock(&OS_queue_table_mut);
+    OS_QUEUE_RECORD(possible_qid)->free = FALSE;
 
     /* set queue attributes */
     queueAttr.mq_maxmsg  = 20;
@@ -106,11 +112,22 @@ int32 OS_QueueCreate (uint32 *queue_id, const char *queue_name, uint32 queue_dep
     */
     queueDesc = mq_open(name, O_CREAT | O_RDWR, 0666, &queueAttr);
 
+    /* OS_QUEUE_OVERWRITE receives the message it drops into discard */
+    discard = NULL;
+    if ( queueDesc != -1 && (discard = malloc(data_size ? data_size : 1)) == NULL )
+    {
+        mq_close(queueDesc);
+        mq_unlink(name);
+        queueDesc = -1;
+    }
+
     if ( queueDesc == -1 )
     {
         pthread_mutex_lock(&OS_queue_table_mut);
-        OS_queue_table[possible_qid].free = TRUE;
+        OS_NameIndexRemove(OS_OBJECT_TYPE_QUEUE, queue_name);
+        OS_QUEUE_RECORD(possible_qid)->free = TRUE;
         pthread_mutex_unlock(&OS_queue_table_mut);
+        OS_ObjectRelease(&OS_queue_table, possible_qid);
 
         printf("OS_QueueCreate Error. errno = %d\n",errno);
         if( errno ==EINVAL)
@@ -131,10 +148,15 @@ int32 OS_QueueCreate (uint32 *queue_id, const char *queue_name, uint32 queue_dep
 
     pthread_mutex_lock(&OS_queue_table_mut);
 
-    OS_queue_table[*queue_id].id = queueDesc;
-    OS_queue_table[*queue_id].free = FALSE;
-    strcpy( OS_queue_table[*queue_id].name, (char*) queue_name);
-    OS_queue_table[*queue_id].creator = OS_FindCreator();
+    OS_QUEUE_RECORD(*queue_id)->id = queueDesc;
+    OS_QUEUE_RECORD(*queue_id)->flags = flags;
+    OS_QUEUE_RECORD(*queue_id)->discard = discard;
+    memset(&OS_QUEUE_RECORD(*queue_id)->counters, 0, sizeof(OS_queue_counters_t));
+    memset((void *)OS_QUEUE_RECORD(*queue_id)->level_count, 0,
+           sizeof(OS_QUEUE_RECORD(*queue_id)->level_count));
+    OS_QUEUE_RECORD(*queue_id)->free = FALSE;
+    strcpy( OS_QUEUE_RECORD(*queue_id)->name, (char*) queue_name);
+    OS_QUEUE_RECORD(*queue_id)->creator = OS_FindCreator();
 
     pthread_mutex_unlock(&OS_queue_table_mut);
 
@@ -162,7 +184,7 @@ int32 OS_QueueDelete (uint32 queue_id)
 
     /* Check to see if the queue_id given is valid */
 
-    if (queue_id >= OS_MAX_QUEUES || OS_queue_table[queue_id].free == TRUE)
+    if (queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
     {
        return OS_ERR_INVALID_ID;
     }
@@ -183,10 +205,10 @@ int32 OS_QueueDelete (uint32 queue_id)
     strcat(name, process_id_string);
     strcat(name,".");
 
-    strcat(name, OS_queue_table[queue_id].name);
+    strcat(name, OS_QUEUE_RECORD(queue_id)->name);
 
     /* Try to delete and unlink the queue */
-    if((mq_close(OS_queue_table[queue_id].id) == -1) || (mq_unlink(name) == -1))
+    if((mq_close(OS_QUEUE_RECORD(queue_id)->id) == -1) || (mq_unlink(name) == -1))
     {
         return OS_ERROR;
     }
@@ -197,13 +219,18 @@ int32 OS_QueueDelete (uint32 queue_id)
      */
     pthread_mutex_lock(&OS_queue_table_mut);
 
-    OS_queue_table[queue_id].free = TRUE;
-    strcpy(OS_queue_table[queue_id].name, "");
-    OS_queue_table[queue_id].creator = UNINITIALIZED;
-    OS_queue_table[queue_id].id = UNINITIALIZED;
+    OS_NameIndexRemove(OS_OBJECT_TYPE_QUEUE, OS_QUEUE_RECORD(queue_id)->name);
+    OS_QUEUE_RECORD(queue_id)->free = TRUE;
+    strcpy(OS_QUEUE_RECORD(queue_id)->name, "");
+    OS_QUEUE_RECORD(queue_id)->creator = UNINITIALIZED;
+    OS_QUEUE_RECORD(queue_id)->id = UNINITIALIZED;
+    free(OS_QUEUE_RECORD(queue_id)->discard);
+    OS_QUEUE_RECORD(queue_id)->discard = NULL;
 
     pthread_mutex_unlock(&OS_queue_table_mut);
 
+    OS_ObjectRelease(&OS_queue_table, queue_id);
+
     return OS_SUCCESS;
 
 } /* end OS_QueueDelete */
@@ -223,13 +250,13 @@ int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied
 {
     struct mq_attr  queueAttr;
     int             sizeCopied = -1;
-    int             ret_val;
+    unsigned int    prio;
     struct timespec ts;
 
     /*
     ** Check Parameters
     */
-    if(queue_id >= OS_MAX_QUEUES || OS_queue_table[queue_id].free == TRUE)
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
@@ -249,9 +276,17 @@ int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied
         */
         do
         {
-           sizeCopied = mq_receive(OS_queue_table[queue_id].id, data, size, NULL);
+           sizeCopied = mq_receive(OS_QUEUE_RECORD(queue_id)->id, data, size, &prio);
         } while ( sizeCopied == -1 && errno == EINTR );
 
+        if ( sizeCopied == -1 )
+        {
+            *size_copied = 0;
+            return(OS_QUEUE_INVALID_SIZE);
+        }
+
+        OS_QueueCountLevel(queue_id, prio, -1);
+        OS_QueueCountGet(&OS_QUEUE_RECORD(queue_id)->counters, 1, OS_SUCCESS);
         if(sizeCopied != size )
         {
             *size_copied = sizeCopied;
@@ -261,7 +296,7 @@ int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied
     else if (timeout == OS_CHECK)
     {
         /* get queue attributes */
-        if(mq_getattr(OS_queue_table[queue_id].id, &queueAttr))
+        if(mq_getattr(OS_QUEUE_RECORD(queue_id)->id, &queueAttr))
         {
             return (OS_ERROR);
         }
@@ -269,7 +304,7 @@ int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied
         /* check how many messages in queue */
         if(queueAttr.mq_curmsgs)
         {
-            sizeCopied  = mq_receive(OS_queue_table[queue_id].id, data, size, NULL);
+            sizeCopied  = mq_receive(OS_QUEUE_RECORD(queue_id)->id, data, size, &prio);
         }
         else
         {
@@ -278,10 +313,14 @@ int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied
 
         if (sizeCopied == -1)
         {
+            OS_QueueCountGet(&OS_QUEUE_RECORD(queue_id)->counters, 0, OS_QUEUE_EMPTY);
             *size_copied = 0;
             return OS_QUEUE_EMPTY;
         }
-        else if(sizeCopied != size )
+
+        OS_QueueCountLevel(queue_id, prio, -1);
+        OS_QueueCountGet(&OS_QUEUE_RECORD(queue_id)->counters, 1, OS_SUCCESS);
+        if(sizeCopied != size )
         {
             *size_copied = sizeCopied;
             return(OS_QUEUE_INVALID_SIZE);
@@ -289,7 +328,7 @@ int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied
     }
     else /* timeout */
     {
-        ret_val = OS_CompAbsDelayTime( timeout , &ts) ;
+        OS_CompAbsDelayTime( timeout , &ts) ;
 
         /*
         ** If the mq_timedreceive call is interrupted by a system call or signal,
@@ -297,85 +336,315 @@ int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied
         */
         do
         {
-           sizeCopied = mq_timedreceive(OS_queue_table[queue_id].id, data, size, NULL, &ts);
+           sizeCopied = mq_timedreceive(OS_QUEUE_RECORD(queue_id)->id, data, size, &prio, &ts);
         } while ( sizeCopied == -1 && errno == EINTR );
 
         if((sizeCopied == -1) && (errno == ETIMEDOUT))
         {
+            OS_QueueCountGet(&OS_QUEUE_RECORD(queue_id)->counters, 0, OS_QUEUE_TIMEOUT);
             return(OS_QUEUE_TIMEOUT);
         }
-        else if( sizeCopied == size )
+
+        if ( sizeCopied == -1 )
         {
-            *size_copied = sizeCopied;
-            return OS_SUCCESS;
+            *size_copied = 0;
+            return OS_QUEUE_INVALID_SIZE;
         }
-        else
+
+        OS_QueueCountLevel(queue_id, prio, -1);
+        OS_QueueCountGet(&OS_QUEUE_RECORD(queue_id)->counters, 1, OS_SUCCESS);
+        *size_copied = sizeCopied;
+        if( sizeCopied != size )
         {
-            *size_copied = 0;
             return OS_QUEUE_INVALID_SIZE;
         }
+        return OS_SUCCESS;
 
     } /* END timeout */
 
     /*
-    ** Should never really get here.
+    ** A whole message was got with OS_PEND or OS_CHECK
     */
+    *size_copied = sizeCopied;
     return OS_SUCCESS;
 
 } /* end OS_QueueGet */
 
+/*
+** Sends a message, waiting up to timeout for room as OS_QueueGet waits for a
+** message. The priority in flags is passed on to mq_send one up, so that
+** priority 0 stays the priority 1 used before.
+*/
+int32 OS_QueueSend(uint32 queue_id, void *data, uint32 size, uint32 flags, int32 timeout)
+{
+    struct mq_attr  queueAttr;
+    struct timespec ts;
+    uint32          prio;
+    int             ret;
+
+    prio = 1 + OS_QUEUE_LEVEL(flags);
+
+    if ( timeout == OS_CHECK )
+    {
+        /* get queue attributes */
+        if(mq_getattr(OS_QUEUE_RECORD(queue_id)->id, &queueAttr))
+        {
+           return (OS_ERROR);
+        }
+
+        /* check if queue is full */
+        if(queueAttr.mq_curmsgs >= queueAttr.mq_maxmsg)
+        {
+           return(OS_QUEUE_FULL);
+        }
+
+        /* send message */
+        if(mq_send(OS_QUEUE_RECORD(queue_id)->id, data, size, prio) == -1)
+        {
+            return(OS_ERROR);
+        }
+        OS_QueueCountLevel(queue_id, prio, 1);
+
+        OS_QueueCountPut(&OS_QUEUE_RECORD(queue_id)->counters, 1, 0, queueAttr.mq_curmsgs + 1);
+        return OS_SUCCESS;
+    }
+
+    if ( timeout != OS_PEND )
+    {
+        OS_CompAbsDelayTime(timeout, &ts);
+    }
+
+    /* The queue was opened blocking, so mq_send waits for room */
+    do
+    {
+        ret = (timeout == OS_PEND) ?
+              mq_send(OS_QUEUE_RECORD(queue_id)->id, data, size, prio) :
+              mq_timedsend(OS_QUEUE_RECORD(queue_id)->id, data, size, prio, &ts);
+    } while ( ret == -1 && errno == EINTR );
+
+    if ( ret == -1 )
+    {
+        return (errno == ETIMEDOUT) ? OS_QUEUE_TIMEOUT : OS_ERROR;
+    }
+    OS_QueueCountLevel(queue_id, prio, 1);
+
+    OS_QueueCountPut(&OS_QUEUE_RECORD(queue_id)->counters, 1, 0,
+                     OS_QueueCountedDepth(&OS_QUEUE_RECORD(queue_id)->counters) + 1);
+
+    return OS_SUCCESS;
+}
+
+/*
+** Sends count messages, each with one mq_timedsend with a deadline that has
+** already passed, so that it returns at once when the queue is full
+*/
+int32 OS_QueueSendBatch(uint32 queue_id, void *data, uint32 size, uint32 count,
+                        uint32 *count_put, uint32 flags)
+{
+    struct timespec expired = { 0, 0 };
+    int32           return_code;
+
+    while ( *count_put < count )
+    {
+        if ( mq_timedsend(OS_QUEUE_RECORD(queue_id)->id,
+                          (char *)data + (size_t)*count_put * size, size,
+                          1 + OS_QUEUE_LEVEL(flags), &expired) == -1 )
+        {
+            if ( errno == EINTR )
+            {
+                continue;
+            }
+            break;
+        }
+        OS_QueueCountLevel(queue_id, 1 + OS_QUEUE_LEVEL(flags), 1);
+        (*count_put)++;
+    }
+
+    return_code = OS_SUCCESS;
+    if ( *count_put < count )
+    {
+        return_code = (errno == ETIMEDOUT) ? OS_QUEUE_FULL : OS_ERROR;
+    }
+
+    OS_QueueCountPut(&OS_QUEUE_RECORD(queue_id)->counters, *count_put, 0,
+                     OS_QueueCountedDepth(&OS_QUEUE_RECORD(queue_id)->counters) + *count_put);
+
+    return return_code;
+}
+
+/*
+** Drops the oldest message of the priority in flags for OS_QUEUE_OVERWRITE.
+** A message queue only gives out the message at its head, of the highest
+** priority in it, so this fails while the queue holds messages of another
+** priority. A message of another priority that was put since the check is
+** sent back, at the end of the messages of its priority.
+*/
+int32 OS_QueueDiscard(uint32 queue_id, uint32 flags)
+{
+    struct timespec expired = { 0, 0 };
+    struct mq_attr  queueAttr;
+    unsigned int    prio;
+    uint32          level;
+    uint32          i;
+    int             ret;
+
+    level = OS_QUEUE_LEVEL(flags);
+    for ( i = 0; i < OS_QUEUE_PRIORITIES; i++ )
+    {
+        if ( i != level && OS_QUEUE_RECORD(queue_id)->level_count[i] > 0 )
+        {
+            return OS_ERROR;
+        }
+    }
+
+    if ( mq_getattr(OS_QUEUE_RECORD(queue_id)->id, &queueAttr) )
+    {
+        return OS_ERROR;
+    }
+
+    do
+    {
+        ret = mq_timedreceive(OS_QUEUE_RECORD(queue_id)->id, OS_QUEUE_RECORD(queue_id)->discard,
+                              queueAttr.mq_msgsize, &prio, &expired);
+    } while ( ret == -1 && errno == EINTR );
+
+    if ( ret == -1 )
+    {
+        return (errno == ETIMEDOUT || errno == EAGAIN) ? OS_QUEUE_EMPTY : OS_ERROR;
+    }
+    OS_QueueCountLevel(queue_id, prio, -1);
+
+    if ( prio != 1 + level )
+    {
+        if ( mq_timedsend(OS_QUEUE_RECORD(queue_id)->id, OS_QUEUE_RECORD(queue_id)->discard,
+                          ret, prio, &expired) == 0 )
+        {
+            OS_QueueCountLevel(queue_id, prio, 1);
+        }
+        return OS_ERROR;
+    }
+
+    return OS_SUCCESS;
+}
+
+/*
+** No process but this one sees the queues, so there is none to open
+*/
+int32 OS_QueueOpen(uint32 *queue_id, const char *queue_name)
+{
+    return OS_ERR_NAME_NOT_FOUND;
+}
+
 /*---------------------------------------------------------------------------------------
- Name: OS_QueuePut
+ Name: OS_QueueGetBatch
 
- Purpose: Put a message on a message queue.
+ Purpose: Gets up to max_count messages from a message queue into data, which holds
+ max_count buffers of size bytes one after the other. Waits or times out for the
+ first message as OS_QueueGet does, then takes the messages already there.
 
- Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
- OS_INVALID_POINTER if the data pointer is NULL
- OS_QUEUE_FULL if the queue cannot accept another message
- OS_ERROR if the OS call returns an error
- OS_SUCCESS if SUCCESS
+ Returns: OS_ERR_INVALID_ID if the given ID does not exist
+ OS_INVALID_POINTER if a pointer passed in is NULL
+ OS_ERROR if max_count is 0
+ OS_QUEUE_EMPTY if the Queue has no messages on it to be recieved
+ OS_QUEUE_TIMEOUT if the time expired
+ OS_QUEUE_INVALID_SIZE if one of the messages was not size bytes
+ OS_SUCCESS if success
 
- Notes: The flags parameter is not used.  The message put is always configured to
- immediately return an error if the receiving message queue is full.
+ Notes: count_copied is set to the number of messages got, and sizes_copied, unless
+ it is NULL, to the size copied from each of them. The messages after the first
+ take one mq_timedreceive each, with a deadline that has already passed.
  ---------------------------------------------------------------------------------------*/
-int32 OS_QueuePut (uint32 queue_id, void *data, uint32 size, uint32 flags)
+int32 OS_QueueGetBatch (uint32 queue_id, void *data, uint32 size, uint32 max_count,
+                        uint32 *sizes_copied, uint32 *count_copied, int32 timeout)
 {
-    struct mq_attr  queueAttr;
+    struct timespec expired = { 0, 0 };
+    uint32          first_size;
+    unsigned int    prio;
+    int             sizeCopied;
+    int32           ret_val;
 
     /*
     ** Check Parameters
     */
-    if(queue_id >= OS_MAX_QUEUES || OS_queue_table[queue_id].free == TRUE)
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
     {
-       return OS_ERR_INVALID_ID;
+        return OS_ERR_INVALID_ID;
+    }
+    else if( (data == NULL) || (count_copied == NULL) )
+    {
+        return OS_INVALID_POINTER;
+    }
+    else if ( max_count == 0 )
+    {
+        return OS_ERROR;
     }
 
-    if (data == NULL)
+    *count_copied = 0;
+    ret_val = OS_QueueGet(queue_id, data, size, &first_size, timeout);
+
+    /*
+    ** A first message of the wrong size has been taken off the queue all the
+    ** same, it is counted and the batch goes on
+    */
+    if ( ret_val != OS_SUCCESS && !(ret_val == OS_QUEUE_INVALID_SIZE && first_size != 0) )
     {
-       return OS_INVALID_POINTER;
+        return ret_val;
     }
 
-    /* get queue attributes */
-    if(mq_getattr(OS_queue_table[queue_id].id, &queueAttr))
+    if ( sizes_copied != NULL )
     {
-       return (OS_ERROR);
+        sizes_copied[0] = first_size;
     }
 
-    /* check if queue is full */
-    if(queueAttr.mq_curmsgs >= queueAttr.mq_maxmsg)
+    for ( *count_copied = 1; *count_copied < max_count; (*count_copied)++ )
     {
-       return(OS_QUEUE_FULL);
+        do
+        {
+           sizeCopied = mq_timedreceive(OS_QUEUE_RECORD(queue_id)->id,
+                                        (char *)data + (size_t)*count_copied * size, size,
+                                        &prio, &expired);
+        } while ( sizeCopied == -1 && errno == EINTR );
+
+        if ( sizeCopied == -1 )
+        {
+            break;
+        }
+        OS_QueueCountLevel(queue_id, prio, -1);
+
+        if ( sizes_copied != NULL )
+        {
+            sizes_copied[*count_copied] = sizeCopied;
+        }
+        if ( sizeCopied != size )
+        {
+            ret_val = OS_QUEUE_INVALID_SIZE;
+        }
     }
 
-    /* send message */
-    if(mq_send(OS_queue_table[queue_id].id, data, size, 1) == -1)
+    /* OS_QueueGet has counted the first message */
+    OS_QueueCountGet(&OS_QUEUE_RECORD(queue_id)->counters, *count_copied - 1, ret_val);
+
+    return ret_val;
+
+} /* end OS_QueueGetBatch */
+
+/*
+** The message queue itself keeps its depth
+*/
+int32 OS_QueueGetCounts(uint32 queue_id, OS_queue_stats_t *queue_stats)
+{
+    struct mq_attr  queueAttr;
+
+    if(mq_getattr(OS_QUEUE_RECORD(queue_id)->id, &queueAttr))
     {
-        return(OS_ERROR);
+       return (OS_ERROR);
     }
 
-    return OS_SUCCESS;
+    queue_stats->depth     = queueAttr.mq_curmsgs;
+    queue_stats->max_depth = queueAttr.mq_maxmsg;
 
-} /* end OS_QueuePut */
+    return OS_SUCCESS;
+}
 
 
 /* --------------------- END POSIX MESSAGE QUEUE IMPLEMENTATION ---------------------- */
@@ -0,0 +1,1774 @@
+#include "osqueues.h"
+#ifdef OSAL_RING_QUEUE
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+
+#include "osfutex.h"
+
+/* ---------------------- RING BUFFER QUEUE IMPLEMENTATION --------------------------- */
+
+/*
+** The messages are copied into a ring of cells in the memory of the process,
+** see OS_ring_t. A put or a get that finds room or a message costs a copy and,
+** unless the ring was created with OS_QUEUE_SPSC, a compare and swap. Only a
+** get that finds the ring empty sleeps, on a futex.
+**
+** A put claims a cell, fills it and commits it; a get claims a cell, copies it
+** out and releases it. The zero copy API hands the claimed cell to the caller
+** in between.
+**
+** Each priority has a ring of its own, and the gets look at the rings from
+** the highest priority down.
+**
+** A put that waits for room sleeps on a futex too. Rather than pay for a full
+** barrier on every get to see such a put, the gets only keep the compiler
+** from moving the release past the load of put_waiters, and the waiting put
+** runs membarrier, which orders the memory of every CPU running the process.
+** OS_ring_membarrier is 1 once the process is registered for it, or -1 when
+** the kernel cannot do it and the gets take the full barrier after all.
+**
+** A shared queue is a POSIX shared memory object named "/osal.queue.<name>",
+** laid out as an OS_ring_segment_t followed by a ring for each priority. Its
+** tasks wait on futexes that are not private to the process, and its gets
+** always take the full barrier, as membarrier only orders the CPUs running
+** this process.
+*/
+
+void OS_WaitAnyNotify(int fd);
+
+/* The cells start on the cache line after the ring */
+#define OS_RING_HEADER_SIZE \
+    (((sizeof(OS_ring_t) + OS_CACHE_LINE - 1) / OS_CACHE_LINE) * OS_CACHE_LINE)
+#define OS_RING_CELLS(ring)     ((char *)(ring) + OS_RING_HEADER_SIZE)
+
+#define OS_RING_CELL(ring, pos) \
+    ((OS_ring_cell_t *)(OS_RING_CELLS(ring) + (size_t)((pos) & (ring)->mask) * (ring)->cell_size))
+#define OS_RING_DATA(cell)      ((char *)(cell) + sizeof(OS_ring_cell_t))
+
+#define OS_LOAD_ACQUIRE(addr)          __atomic_load_n((addr), __ATOMIC_ACQUIRE)
+#define OS_STORE_RELEASE(addr, value)  __atomic_store_n((addr), (value), __ATOMIC_RELEASE)
+
+/*
+** Hands a claimed put cell over to the gets, and a claimed get cell back to
+** the put one lap ahead
+*/
+#define OS_RING_COMMIT(cell)           OS_STORE_RELEASE(&(cell)->seq, (cell)->seq + 1)
+#define OS_RING_RELEASE(ring, cell)    OS_STORE_RELEASE(&(cell)->seq, (cell)->seq + (ring)->mask)
+
+/* Largest depth of a ring, so the number of cells stays a power of two */
+#define OS_RING_MAX_DEPTH   0x40000000
+
+/*
+** Start of the segment of a shared queue. The rings follow it, each on a cache
+** line and ring_size bytes apart.
+*/
+typedef struct
+{
+    volatile uint32  magic;       /* set once the creator has set the segment up */
+    uint32           depth;
+    uint32           data_size;
+    uint32           flags;
+    uint64           ring_size;
+    OS_ring_wait_t   wait;
+} OS_ring_segment_t;
+
+#define OS_RING_SEGMENT_MAGIC   0x4F535131
+#define OS_RING_SEGMENT_PREFIX  "/osal.queue."
+#define OS_RING_SEGMENT_SIZE \
+    (((sizeof(OS_ring_segment_t) + OS_CACHE_LINE - 1) / OS_CACHE_LINE) * OS_CACHE_LINE)
+
+/*
+** Times a process opening a shared queue checks, a millisecond apart, whether
+** the creator has set it up yet
+*/
+#define OS_RING_OPEN_TRIES      1000
+
+static volatile int OS_ring_membarrier;
+
+/*
+** Registers the process for membarrier the first time a queue is created
+*/
+static void OS_RingBarrierInit(void)
+{
+    if ( OS_ring_membarrier == 0 )
+    {
+        OS_ring_membarrier =
+            (syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0) ? 1 : -1;
+    }
+}
+
+/*
+** Full barrier of a put about to wait for room, against the loads of
+** put_waiters in OS_RingWakePutters
+*/
+static void OS_RingHeavyBarrier(OS_queue_record_t *queue)
+{
+    if ( OS_ring_membarrier != 1 || queue->segment != NULL ||
+         syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) != 0 )
+    {
+        __sync_synchronize();
+    }
+}
+
+/*
+** Futex calls on the wait words of a queue, which the tasks of other processes
+** sleep on too when the queue is shared
+*/
+static int OS_RingFutexWait(OS_queue_record_t *queue, volatile uint32 *addr, uint32 val,
+                            const struct timespec *abs_timeout)
+{
+    if ( queue->segment != NULL )
+    {
+        return(OS_FutexWaitShared(addr, val, abs_timeout));
+    }
+
+    return(OS_FutexWait(addr, val, abs_timeout));
+}
+
+static int OS_RingFutexWake(OS_queue_record_t *queue, volatile uint32 *addr, int count)
+{
+    if ( queue->segment != NULL )
+    {
+        return(OS_FutexWakeShared(addr, count));
+    }
+
+    return(OS_FutexWake(addr, count));
+}
+
+/*
+** Number of cells of a ring that holds up to depth messages
+*/
+static uint32 OS_RingCells(uint32 depth)
+{
+    uint32 num_cells;
+
+    num_cells = 1;
+    while ( num_cells < depth )
+    {
+        num_cells <<= 1;
+    }
+
+    return(num_cells);
+}
+
+/*
+** Bytes taken by a ring and its cells for up to depth messages of up to
+** data_size bytes, rounded up to a cache line. Returns 0 when that does not
+** fit in a size_t.
+*/
+static size_t OS_RingSize(uint32 depth, uint32 data_size)
+{
+    size_t num_cells;
+    size_t cell_size;
+
+    num_cells = OS_RingCells(depth);
+    cell_size = ((size_t)sizeof(OS_ring_cell_t) + data_size + 7) & ~(size_t)7;
+    if ( cell_size > ((size_t)-1 - OS_RING_HEADER_SIZE - OS_CACHE_LINE) / num_cells )
+    {
+        return(0);
+    }
+
+    return(((OS_RING_HEADER_SIZE + cell_size * num_cells + OS_CACHE_LINE - 1) /
+            OS_CACHE_LINE) * OS_CACHE_LINE);
+}
+
+/*
+** Sets up an empty ring in memory of OS_RingSize bytes
+*/
+static void OS_RingInit(OS_ring_t *ring, uint32 depth, uint32 data_size, uint32 spsc)
+{
+    uint32 num_cells;
+    uint32 i;
+
+    num_cells = OS_RingCells(depth);
+
+    memset(ring, 0, sizeof(OS_ring_t));
+    ring->depth     = depth;
+    ring->mask      = num_cells - 1;
+    ring->data_size = data_size;
+    ring->cell_size = (sizeof(OS_ring_cell_t) + data_size + 7) & ~7;
+    ring->spsc      = spsc;
+
+    /* Each cell starts out free for the put at its own position */
+    for ( i = 0; i < num_cells; i++ )
+    {
+        OS_RING_CELL(ring, i)->seq = i;
+    }
+}
+
+/*
+** Allocates a ring that holds up to depth messages of up to data_size bytes
+*/
+static OS_ring_t *OS_RingCreate(uint32 depth, uint32 data_size, uint32 spsc)
+{
+    void   *mem;
+    size_t  size;
+
+    /* Keep put_pos and get_pos on cache lines of their own */
+    size = OS_RingSize(depth, data_size);
+    if ( size == 0 || posix_memalign(&mem, OS_CACHE_LINE, size) != 0 )
+    {
+        return(NULL);
+    }
+
+    OS_RingInit(mem, depth, data_size, spsc);
+
+    return(mem);
+}
+
+/*
+** TRUE when the cell at the head of the ring holds no message. A put that has
+** claimed the cell but not finished the copy leaves the ring empty too.
+*/
+static int OS_RingEmpty(OS_ring_t *ring)
+{
+    uint32 pos;
+
+    pos = OS_LOAD_ACQUIRE(&ring->get_pos);
+
+    return(OS_LOAD_ACQUIRE(&(OS_RING_CELL(ring, pos)->seq)) != pos + 1);
+}
+
+/*
+** Claims up to max_count cells in a row for the next puts, and passes back the
+** position of the first one. Returns how many were claimed, 0 when the ring is
+** full. The cells keep the sequence numbers of their positions until
+** OS_RING_COMMIT.
+*/
+static uint32 OS_RingClaimPut(OS_ring_t *ring, uint32 max_count, uint32 *first_pos)
+{
+    uint32 pos;
+    uint32 seq;
+    uint32 first_seq;
+    int32  room;
+    uint32 count;
+
+    pos = ring->put_pos;
+    for ( ;; )
+    {
+        /*
+        ** get_pos only moves forward, so a stale value can only make the ring
+        ** look fuller than it is
+        */
+        room = (int32)ring->depth - (int32)(pos - OS_LOAD_ACQUIRE(&ring->get_pos));
+        if ( room <= 0 )
+        {
+            return(0);
+        }
+        if ( max_count > (uint32)room )
+        {
+            max_count = room;
+        }
+
+        first_seq = OS_LOAD_ACQUIRE(&(OS_RING_CELL(ring, pos)->seq));
+        seq       = first_seq;
+        count     = 0;
+        while ( seq == pos + count && ++count < max_count )
+        {
+            seq = OS_LOAD_ACQUIRE(&(OS_RING_CELL(ring, pos + count)->seq));
+        }
+
+        if ( count > 0 )
+        {
+            if ( ring->spsc )
+            {
+                ring->put_pos = pos + count;
+                break;
+            }
+            if ( __sync_bool_compare_and_swap(&ring->put_pos, pos, pos + count) )
+            {
+                break;
+            }
+            pos = ring->put_pos;
+        }
+        else if ( (int32)(first_seq - pos) < 0 )
+        {
+            /* The get of the previous lap has not released the cell yet */
+            return(0);
+        }
+        else
+        {
+            /* Another put claimed this position */
+            pos = ring->put_pos;
+        }
+    }
+
+    if ( (uint32)(pos + count) < pos )
+    {
+        __sync_fetch_and_add(&ring->put_laps, 1);
+    }
+
+    *first_pos = pos;
+    return(count);
+}
+
+/*
+** Claims up to max_count cells in a row holding the messages at the head of
+** the ring, and passes back the position of the first one. Returns how many
+** were claimed, 0 when the ring is empty. The cells stay out of the reach of
+** the puts until OS_RING_RELEASE.
+*/
+static uint32 OS_RingClaimGet(OS_ring_t *ring, uint32 max_count, uint32 *first_pos)
+{
+    uint32 pos;
+    uint32 seq;
+    uint32 first_seq;
+    uint32 count;
+
+    pos = ring->get_pos;
+    for ( ;; )
+    {
+        first_seq = OS_LOAD_ACQUIRE(&(OS_RING_CELL(ring, pos)->seq));
+        seq       = first_seq;
+        count     = 0;
+        while ( seq == pos + count + 1 && ++count < max_count )
+        {
+            seq = OS_LOAD_ACQUIRE(&(OS_RING_CELL(ring, pos + count)->seq));
+        }
+
+        if ( count > 0 )
+        {
+            if ( ring->spsc )
+            {
+                OS_STORE_RELEASE(&ring->get_pos, pos + count);
+                break;
+            }
+            if ( __sync_bool_compare_and_swap(&ring->get_pos, pos, pos + count) )
+            {
+                break;
+            }
+            pos = ring->get_pos;
+        }
+        else if ( (int32)(first_seq - (pos + 1)) < 0 )
+        {
+            /* Empty, or the put at this position has not finished its copy */
+            return(0);
+        }
+        else
+        {
+            /* Another get took this message */
+            pos = ring->get_pos;
+        }
+    }
+
+    if ( (uint32)(pos + count) < pos )
+    {
+        __sync_fetch_and_add(&ring->get_laps, 1);
+    }
+
+    *first_pos = pos;
+    return(count);
+}
+
+/*
+** Number of messages in the ring, counting the ones still being put or got
+*/
+static uint32 OS_RingHeld(OS_ring_t *ring)
+{
+    return(OS_LOAD_ACQUIRE(&ring->put_pos) - OS_LOAD_ACQUIRE(&ring->get_pos));
+}
+
+/*
+** Raises the high water mark of the queue to the messages held in ring after a
+** put. The mark is only written when it moves.
+*/
+static void OS_RingCountPut(OS_queue_record_t *queue, OS_ring_t *ring)
+{
+    uint32 held;
+
+    held = OS_RingHeld(ring);
+    if ( held > queue->counters.high_water )
+    {
+        OS_QueueCountHighWater(&queue->counters, held);
+    }
+}
+
+/*
+** Finds the cell whose data ptr points to, or returns NULL if it is not the
+** data of a cell of the ring
+*/
+static OS_ring_cell_t *OS_RingCellOf(OS_ring_t *ring, void *ptr)
+{
+    size_t offset;
+
+    if ( ptr == NULL || (char *)ptr < OS_RING_CELLS(ring) + sizeof(OS_ring_cell_t) )
+    {
+        return(NULL);
+    }
+
+    offset = (char *)ptr - OS_RING_CELLS(ring) - sizeof(OS_ring_cell_t);
+    if ( offset % ring->cell_size != 0 || offset / ring->cell_size > ring->mask )
+    {
+        return(NULL);
+    }
+
+    return((OS_ring_cell_t *)(OS_RING_CELLS(ring) + offset));
+}
+
+/*
+** Returns the ring of the queue for messages of the given priority, and makes
+** it like the ring of priority 0 if no message of that priority was put yet
+*/
+static OS_ring_t *OS_RingOfLevel(OS_queue_record_t *queue, uint32 level)
+{
+    OS_ring_t *ring;
+
+    ring = OS_LOAD_ACQUIRE(&queue->ring[level]);
+    if ( ring == NULL )
+    {
+        pthread_mutex_lock(&OS_queue_table_mut);
+        ring = queue->ring[level];
+        if ( ring == NULL )
+        {
+            ring = OS_RingCreate(queue->ring[0]->depth, queue->ring[0]->data_size,
+                                 queue->ring[0]->spsc);
+            OS_STORE_RELEASE(&queue->ring[level], ring);
+        }
+        pthread_mutex_unlock(&OS_queue_table_mut);
+    }
+
+    return(ring);
+}
+
+/*
+** Finds the ring and the cell whose data ptr points to, or returns NULL if it
+** is not the data of a cell of the queue
+*/
+static OS_ring_cell_t *OS_QueueCellOf(OS_queue_record_t *queue, void *ptr, OS_ring_t **ring)
+{
+    OS_ring_cell_t *cell;
+    int             level;
+
+    for ( level = 0; level < OS_QUEUE_PRIORITIES; level++ )
+    {
+        *ring = OS_LOAD_ACQUIRE(&queue->ring[level]);
+        if ( *ring != NULL && (cell = OS_RingCellOf(*ring, ptr)) != NULL )
+        {
+            return(cell);
+        }
+    }
+
+    return(NULL);
+}
+
+/*
+** TRUE when no ring of the queue holds a message
+*/
+static int OS_QueueEmpty(OS_queue_record_t *queue)
+{
+    OS_ring_t *ring;
+    int        level;
+
+    for ( level = OS_QUEUE_PRIORITIES - 1; level >= 0; level-- )
+    {
+        ring = OS_LOAD_ACQUIRE(&queue->ring[level]);
+        if ( ring != NULL && !OS_RingEmpty(ring) )
+        {
+            return(FALSE);
+        }
+    }
+
+    return(TRUE);
+}
+
+/*
+** Claims up to max_count cells in a row from the ring of the highest priority
+** that holds a message, as OS_RingClaimGet does. Returns the ring, or NULL
+** when the queue is empty.
+*/
+static OS_ring_t *OS_QueueClaimGet(OS_queue_record_t *queue, uint32 max_count,
+                                   uint32 *first_pos, uint32 *count)
+{
+    OS_ring_t *ring;
+    int        level;
+
+    for ( level = OS_QUEUE_PRIORITIES - 1; level >= 0; level-- )
+    {
+        ring = OS_LOAD_ACQUIRE(&queue->ring[level]);
+        if ( ring != NULL && (*count = OS_RingClaimGet(ring, max_count, first_pos)) > 0 )
+        {
+            return(ring);
+        }
+    }
+
+    *count = 0;
+    return(NULL);
+}
+
+/*
+** Wakes up a task sleeping in OS_RingWaitGet or waiting in OS_WaitAny, if any.
+** The full barrier orders the store that made the message visible with the
+** loads of the waiter counts.
+*/
+static int32 OS_RingWakeGetters(OS_queue_record_t *queue)
+{
+    __sync_synchronize();
+
+    if ( queue->wait->get_waiters != 0 )
+    {
+        __sync_fetch_and_add(&queue->wait->get_seq, 1);
+        if ( OS_RingFutexWake(queue, &queue->wait->get_seq, 1) < 0 )
+        {
+            return(OS_ERROR);
+        }
+    }
+
+    if ( queue->any_waiters != 0 )
+    {
+        OS_WaitAnyNotify(queue->id);
+    }
+
+    if ( queue->event.fd >= 0 )
+    {
+        OS_EventFdSignal(&queue->event);
+    }
+
+    return(OS_SUCCESS);
+}
+
+/*
+** Clears the descriptor of OS_QueueGetEventFd once the queue is empty. A put
+** between the check and the drain signals again, and the second check catches
+** one that came before the drain.
+*/
+static void OS_RingEventDrain(OS_queue_record_t *queue)
+{
+    if ( queue->event.fd >= 0 && OS_QueueEmpty(queue) )
+    {
+        OS_EventFdDrain(&queue->event);
+        if ( !OS_QueueEmpty(queue) )
+        {
+            OS_EventFdSignal(&queue->event);
+        }
+    }
+}
+
+/*
+** Claims the cells holding up to max_count messages of the highest priority
+** there is, waiting for the first one as OS_QueueGet does with timeout
+*/
+static int32 OS_RingWaitGet(OS_queue_record_t *queue, int32 timeout, uint32 max_count,
+                            OS_ring_t **ring, uint32 *first_pos, uint32 *count)
+{
+    uint32           seq;
+    int              ret;
+    struct timespec  ts;
+    struct timespec *abs_timeout;
+
+    abs_timeout = NULL;
+    if ( timeout != OS_PEND && timeout != OS_CHECK )
+    {
+        OS_CompAbsDelayTime(timeout, &ts);
+        abs_timeout = &ts;
+    }
+
+    for ( ;; )
+    {
+        *ring = OS_QueueClaimGet(queue, max_count, first_pos, count);
+        if ( *count > 0 )
+        {
+            break;
+        }
+        else if ( timeout == OS_CHECK )
+        {
+            OS_RingEventDrain(queue);
+            return(OS_QUEUE_EMPTY);
+        }
+
+        seq = queue->wait->get_seq;
+
+        __sync_fetch_and_add(&queue->wait->get_waiters, 1);
+
+        /*
+        ** Check again now that the puts can see this task. If a put gets in
+        ** after this, get_seq no longer matches and the wait returns
+        */
+        ret = 0;
+        if ( OS_QueueEmpty(queue) )
+        {
+            ret = OS_RingFutexWait(queue, &queue->wait->get_seq, seq, abs_timeout);
+        }
+
+        __sync_fetch_and_sub(&queue->wait->get_waiters, 1);
+
+        if ( ret < 0 )
+        {
+            if ( errno == ETIMEDOUT )
+            {
+                /* A put may have woken this task just as it timed out */
+                *ring = OS_QueueClaimGet(queue, max_count, first_pos, count);
+                if ( *count == 0 )
+                {
+                    OS_RingEventDrain(queue);
+                    return(OS_QUEUE_TIMEOUT);
+                }
+                break;
+            }
+            else if ( errno != EAGAIN && errno != EINTR )
+            {
+                return(OS_ERROR);
+            }
+        }
+    }
+
+    /*
+    ** The put that woke this task may have been behind one that had not
+    ** finished its copy. Pass the wakeup on if more messages are there.
+    */
+    if ( queue->wait->get_waiters != 0 && !OS_QueueEmpty(queue) )
+    {
+        __sync_fetch_and_add(&queue->wait->get_seq, 1);
+        OS_RingFutexWake(queue, &queue->wait->get_seq, 1);
+    }
+
+    OS_RingEventDrain(queue);
+
+    return(OS_SUCCESS);
+}
+
+/*
+** Wakes up to count tasks sleeping in OS_RingWaitPut, after a get released
+** their cells. See OS_RingHeavyBarrier for the barrier.
+*/
+static void OS_RingWakePutters(OS_queue_record_t *queue, uint32 count)
+{
+    if ( OS_ring_membarrier == 1 && queue->segment == NULL )
+    {
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    }
+    else
+    {
+        __sync_synchronize();
+    }
+
+    if ( queue->wait->put_waiters != 0 )
+    {
+        __sync_fetch_and_add(&queue->wait->put_seq, 1);
+        OS_RingFutexWake(queue, &queue->wait->put_seq, count);
+    }
+}
+
+/*
+** Claims a cell for a put in ring, waiting for room as OS_QueueGet does for
+** a message with timeout
+*/
+static int32 OS_RingWaitPut(OS_queue_record_t *queue, OS_ring_t *ring, int32 timeout,
+                            uint32 *pos)
+{
+    uint32           seq;
+    uint32           claimed;
+    int              ret;
+    struct timespec  ts;
+    struct timespec *abs_timeout;
+
+    abs_timeout = NULL;
+    if ( timeout != OS_PEND && timeout != OS_CHECK )
+    {
+        OS_CompAbsDelayTime(timeout, &ts);
+        abs_timeout = &ts;
+    }
+
+    for ( ;; )
+    {
+        if ( OS_RingClaimPut(ring, 1, pos) > 0 )
+        {
+            return(OS_SUCCESS);
+        }
+        else if ( timeout == OS_CHECK )
+        {
+            return(OS_QUEUE_FULL);
+        }
+
+        seq = queue->wait->put_seq;
+
+        __sync_fetch_and_add(&queue->wait->put_waiters, 1);
+        OS_RingHeavyBarrier(queue);
+
+        /* Try again now that the gets can see this task */
+        ret = 0;
+        claimed = OS_RingClaimPut(ring, 1, pos);
+        if ( claimed == 0 )
+        {
+            ret = OS_RingFutexWait(queue, &queue->wait->put_seq, seq, abs_timeout);
+        }
+
+        __sync_fetch_and_sub(&queue->wait->put_waiters, 1);
+
+        if ( claimed > 0 )
+        {
+            return(OS_SUCCESS);
+        }
+        if ( ret < 0 )
+        {
+            if ( errno == ETIMEDOUT )
+            {
+                /* A get may have woken this task just as it timed out */
+                return (OS_RingClaimPut(ring, 1, pos) > 0) ? OS_SUCCESS : OS_QUEUE_TIMEOUT;
+            }
+            else if ( errno != EAGAIN && errno != EINTR )
+            {
+                return(OS_ERROR);
+            }
+        }
+    }
+}
+
+/*
+** Builds the name of the shared memory object of a shared queue
+*/
+static void OS_RingSegmentName(const char *queue_name, char *shm_name)
+{
+    strcpy(shm_name, OS_RING_SEGMENT_PREFIX);
+    strcat(shm_name, queue_name);
+}
+
+/*
+** Ring of the given priority in the segment of a shared queue
+*/
+static OS_ring_t *OS_RingOfSegment(OS_ring_segment_t *segment, uint32 level)
+{
+    return((OS_ring_t *)((char *)segment + OS_RING_SEGMENT_SIZE + (size_t)level * segment->ring_size));
+}
+
+/*
+** Creates and maps the segment of a shared queue, with a ring for each priority
+** holding up to depth messages of up to data_size bytes. Returns
+** OS_ERR_NAME_TAKEN if another process has a shared queue of that name.
+*/
+static int32 OS_RingCreateSegment(const char *queue_name, uint32 depth, uint32 data_size,
+                                  uint32 flags, OS_ring_segment_t **segment, size_t *size)
+{
+    char    shm_name[OS_MAX_API_NAME + sizeof(OS_RING_SEGMENT_PREFIX)];
+    size_t  ring_size;
+    int     fd;
+    uint32  level;
+    void   *addr;
+
+    ring_size = OS_RingSize(depth, data_size);
+    if ( ring_size == 0 ||
+         ring_size > ((size_t)-1 - OS_RING_SEGMENT_SIZE) / OS_QUEUE_PRIORITIES )
+    {
+        return OS_ERROR;
+    }
+    *size = OS_RING_SEGMENT_SIZE + ring_size * OS_QUEUE_PRIORITIES;
+
+    OS_RingSegmentName(queue_name, shm_name);
+    fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if ( fd < 0 )
+    {
+        return (errno == EEXIST) ? OS_ERR_NAME_TAKEN : OS_ERROR;
+    }
+
+    addr = MAP_FAILED;
+    if ( ftruncate(fd, *size) == 0 )
+    {
+        addr = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if ( addr == MAP_FAILED )
+    {
+        shm_unlink(shm_name);
+        return OS_ERROR;
+    }
+
+    /* The segment starts out zeroed, so nobody waits yet */
+    *segment = addr;
+    (*segment)->depth     = depth;
+    (*segment)->data_size = data_size;
+    (*segment)->flags     = flags;
+    (*segment)->ring_size = ring_size;
+    for ( level = 0; level < OS_QUEUE_PRIORITIES; level++ )
+    {
+        OS_RingInit(OS_RingOfSegment(*segment, level), depth, data_size,
+                    (flags & OS_QUEUE_SPSC) != 0);
+    }
+
+    OS_STORE_RELEASE(&(*segment)->magic, OS_RING_SEGMENT_MAGIC);
+
+    return OS_SUCCESS;
+}
+
+/*
+** Maps the segment of the shared queue another process created. Returns
+** OS_ERR_NAME_NOT_FOUND if there is none of that name.
+*/
+static int32 OS_RingOpenSegment(const char *queue_name, OS_ring_segment_t **segment,
+                                size_t *size)
+{
+    char         shm_name[OS_MAX_API_NAME + sizeof(OS_RING_SEGMENT_PREFIX)];
+    struct stat  st;
+    int          fd;
+    int          tries;
+    void        *addr;
+
+    OS_RingSegmentName(queue_name, shm_name);
+    fd = shm_open(shm_name, O_RDWR, 0);
+    if ( fd < 0 )
+    {
+        return (errno == ENOENT) ? OS_ERR_NAME_NOT_FOUND : OS_ERROR;
+    }
+
+    /* The creator may not have sized the segment yet */
+    for ( tries = 0; ; tries++ )
+    {
+        if ( fstat(fd, &st) != 0 || tries == OS_RING_OPEN_TRIES )
+        {
+            close(fd);
+            return OS_ERROR;
+        }
+        if ( st.st_size >= (off_t)OS_RING_SEGMENT_SIZE )
+        {
+            break;
+        }
+        usleep(1000);
+    }
+
+    addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if ( addr == MAP_FAILED )
+    {
+        return OS_ERROR;
+    }
+    *segment = addr;
+    *size    = st.st_size;
+
+    /* Nor set up its rings */
+    for ( tries = 0; OS_LOAD_ACQUIRE(&(*segment)->magic) != OS_RING_SEGMENT_MAGIC; tries++ )
+    {
+        if ( tries == OS_RING_OPEN_TRIES )
+        {
+            munmap(addr, *size);
+            return OS_ERROR;
+        }
+        usleep(1000);
+    }
+
+    if ( (*segment)->ring_size != OS_RingSize((*segment)->depth, (*segment)->data_size) ||
+         *size < OS_RING_SEGMENT_SIZE + (*segment)->ring_size * OS_QUEUE_PRIORITIES )
+    {
+        munmap(addr, *size);
+        return OS_ERROR;
+    }
+
+    return OS_SUCCESS;
+}
+
+/*
+** Points a queue record at the rings and wait words in a mapped segment
+*/
+static void OS_RingUseSegment(OS_queue_record_t *queue, OS_ring_segment_t *segment,
+                              size_t size, int owner)
+{
+    uint32 level;
+
+    for ( level = 0; level < OS_QUEUE_PRIORITIES; level++ )
+    {
+        queue->ring[level] = OS_RingOfSegment(segment, level);
+    }
+    queue->wait          = &segment->wait;
+    queue->segment       = segment;
+    queue->segment_size  = size;
+    queue->segment_owner = owner;
+}
+
+/*---------------------------------------------------------------------------------------
+ Name: OS_QueueCreate
+
+ Purpose: Create a message queue which can be refered to by name or ID
+
+ Returns: OS_INVALID_POINTER if a pointer passed in is NULL
+ OS_ERR_NAME_TOO_LONG if the name passed in is too long
+ OS_ERR_NO_FREE_IDS if there are already the max queues created
+ OS_ERR_NAME_TAKEN if the name is already being used on another queue, or by the
+ shared queue of another process
+ OS_ERROR if the depth or data size is 0 or too large, flags has both OS_QUEUE_SPSC
+ and OS_QUEUE_OVERWRITE, or the ring cannot be allocated
+ OS_SUCCESS if success
+
+ Notes: The queue holds up to queue_depth messages of up to data_size bytes of
+ each priority. flags is OS_QUEUE_SPSC when only one task puts and only one task gets, which
+ saves the compare and swap on each put and get, or'ed with OS_QUEUE_LATENCY to time
+ each message from its put to its get for OS_QueueGetStats, and with what OS_QueuePut
+ does when the queue is full.
+ With OS_QUEUE_SHARED the rings are made in shared memory, for every priority at once,
+ and the tasks of other processes can use the queue once they have looked it up with
+ OS_QueueGetIdByName. OS_QUEUE_SPSC then counts the tasks of all of them. A process
+ that dies in the middle of a put holds up the gets behind it. The counters of
+ OS_QueueGetStats other than the puts, gets and depth only count this process, and
+ OS_WaitAny cannot wait on a shared queue.
+ ---------------------------------------------------------------------------------------*/
+int32 OS_QueueCreate (uint32 *queue_id, const char *queue_name, uint32 queue_depth,
+                      uint32 data_size, uint32 flags)
+{
+    int32              return_code;
+    uint32             possible_qid;
+    OS_ring_t         *ring;
+    OS_ring_segment_t *segment;
+    size_t             segment_size;
+    int                level;
+
+    if ( queue_id == NULL || queue_name == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    /* we don't want to allow names too long*/
+    /* if truncated, two names might be the same */
+
+    if (strlen(queue_name) >= OS_MAX_API_NAME)
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ( queue_depth == 0 || queue_depth > OS_RING_MAX_DEPTH || data_size == 0 )
+    {
+        return OS_ERROR;
+    }
+
+    /* Only the get of a single consumer ring may take its messages */
+    if ( (flags & OS_QUEUE_SPSC) && OS_QUEUE_POLICY(flags, 0) == OS_QUEUE_OVERWRITE )
+    {
+        return OS_ERROR;
+    }
+
+    OS_RingBarrierInit();
+
+     /* Take a free queue Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_queue_table, &possible_qid) != OS_SUCCESS )
+    {
+        return OS_ERR_NO_FREE_IDS;
+    }
+
+    /* Check to see if the name is already taken, and reserve it */
+
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_QUEUE, queue_name, possible_qid);
+    if ( return_code != OS_SUCCESS )
+    {
+        OS_ObjectRelease(&OS_queue_table, possible_qid);
+        return return_code;
+    }
+
+    ring    = NULL;
+    segment = NULL;
+    if ( flags & OS_QUEUE_SHARED )
+    {
+        return_code = OS_RingCreateSegment(queue_name, queue_depth, data_size, flags,
+                                           &segment, &segment_size);
+    }
+    else
+    {
+        ring = OS_RingCreate(queue_depth, data_size, (flags & OS_QUEUE_SPSC) != 0);
+        return_code = (ring != NULL) ? OS_SUCCESS : OS_ERROR;
+    }
+
+    if ( return_code != OS_SUCCESS )
+    {
+        pthread_mutex_lock(&OS_queue_table_mut);
+        OS_NameIndexRemove(OS_OBJECT_TYPE_QUEUE, queue_name);
+        pthread_mutex_unlock(&OS_queue_table_mut);
+        OS_ObjectRelease(&OS_queue_table, possible_qid);
+        return return_code;
+    }
+
+    *queue_id = possible_qid;
+
+    pthread_mutex_lock(&OS_queue_table_mut);
+
+    if ( segment != NULL )
+    {
+        OS_RingUseSegment(OS_QUEUE_RECORD(*queue_id), segment, segment_size, TRUE);
+    }
+    else
+    {
+        OS_QUEUE_RECORD(*queue_id)->ring[0] = ring;
+        for ( level = 1; level < OS_QUEUE_PRIORITIES; level++ )
+        {
+            OS_QUEUE_RECORD(*queue_id)->ring[level] = NULL;
+        }
+        memset(&OS_QUEUE_RECORD(*queue_id)->local_wait, 0, sizeof(OS_ring_wait_t));
+        OS_QUEUE_RECORD(*queue_id)->wait = &OS_QUEUE_RECORD(*queue_id)->local_wait;
+        OS_QUEUE_RECORD(*queue_id)->segment = NULL;
+    }
+    OS_QUEUE_RECORD(*queue_id)->id = -1;
+    OS_QUEUE_RECORD(*queue_id)->event.fd = -1;
+    OS_QUEUE_RECORD(*queue_id)->flags = flags;
+    memset(&OS_QUEUE_RECORD(*queue_id)->counters, 0, sizeof(OS_queue_counters_t));
+    OS_QUEUE_RECORD(*queue_id)->free = FALSE;
+    strcpy( OS_QUEUE_RECORD(*queue_id)->name, (char*) queue_name);
+    OS_QUEUE_RECORD(*queue_id)->creator = OS_FindCreator();
+
+    pthread_mutex_unlock(&OS_queue_table_mut);
+
+    return OS_SUCCESS;
+
+}/* end OS_QueueCreate */
+
+/*--------------------------------------------------------------------------------------
+ Name: OS_QueueDelete
+
+ Purpose: Deletes the specified message queue.
+
+ Returns: OS_ERR_INVALID_ID if the id passed in does not exist
+ OS_ERROR if the OS calls to unmap or remove a shared queue fail
+ OS_SUCCESS if success
+
+ Notes: If There are messages on the queue, they will be lost and any subsequent
+ calls to QueueGet or QueuePut to this queue will result in errors.
+ A shared queue is only unmapped from this process. When this process created it,
+ its name is removed too, and the processes that have it open can go on using it
+ until they delete it.
+ ---------------------------------------------------------------------------------------*/
+int32 OS_QueueDelete (uint32 queue_id)
+{
+    OS_ring_t *ring[OS_QUEUE_PRIORITIES];
+    void      *segment;
+    size_t     segment_size;
+    int        segment_owner;
+    char       shm_name[OS_MAX_API_NAME + sizeof(OS_RING_SEGMENT_PREFIX)];
+    int32      return_code;
+    int        level;
+
+    /* Check to see if the queue_id given is valid */
+
+    if (queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+       return OS_ERR_INVALID_ID;
+    }
+
+    pthread_mutex_lock(&OS_queue_table_mut);
+
+    OS_RingSegmentName(OS_QUEUE_RECORD(queue_id)->name, shm_name);
+    segment       = OS_QUEUE_RECORD(queue_id)->segment;
+    segment_size  = OS_QUEUE_RECORD(queue_id)->segment_size;
+    segment_owner = OS_QUEUE_RECORD(queue_id)->segment_owner;
+    OS_QUEUE_RECORD(queue_id)->segment = NULL;
+
+    OS_NameIndexRemove(OS_OBJECT_TYPE_QUEUE, OS_QUEUE_RECORD(queue_id)->name);
+    OS_QUEUE_RECORD(queue_id)->free = TRUE;
+    strcpy(OS_QUEUE_RECORD(queue_id)->name, "");
+    OS_QUEUE_RECORD(queue_id)->creator = UNINITIALIZED;
+    if ( OS_QUEUE_RECORD(queue_id)->id >= 0 )
+    {
+        close(OS_QUEUE_RECORD(queue_id)->id);
+    }
+    OS_QUEUE_RECORD(queue_id)->id = UNINITIALIZED;
+    OS_EventFdClose(&OS_QUEUE_RECORD(queue_id)->event);
+    for ( level = 0; level < OS_QUEUE_PRIORITIES; level++ )
+    {
+        ring[level] = OS_QUEUE_RECORD(queue_id)->ring[level];
+        OS_QUEUE_RECORD(queue_id)->ring[level] = NULL;
+    }
+
+    pthread_mutex_unlock(&OS_queue_table_mut);
+
+    return_code = OS_SUCCESS;
+    if ( segment != NULL )
+    {
+        if ( munmap(segment, segment_size) != 0 ||
+             (segment_owner && shm_unlink(shm_name) != 0) )
+        {
+            return_code = OS_ERROR;
+        }
+    }
+    else
+    {
+        for ( level = 0; level < OS_QUEUE_PRIORITIES; level++ )
+        {
+            free(ring[level]);
+        }
+    }
+
+    OS_ObjectRelease(&OS_queue_table, queue_id);
+
+    return return_code;
+
+} /* end OS_QueueDelete */
+
+/*---------------------------------------------------------------------------------------
+ Name: OS_QueueGet
+
+ Purpose: Receive a message on a message queue.  Will pend or timeout on the receive.
+ Returns: OS_ERR_INVALID_ID if the given ID does not exist
+ OS_ERR_INVALID_POINTER if a pointer passed in is NULL
+ OS_QUEUE_EMPTY if the Queue has no messages on it to be recieved
+ OS_QUEUE_TIMEOUT if the timeout was OS_PEND and the time expired
+ OS_QUEUE_INVALID_SIZE if the size copied from the queue was not correct
+ OS_ERROR if the OS call to wait failed
+ OS_SUCCESS if success
+ ---------------------------------------------------------------------------------------*/
+int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied, int32 timeout)
+{
+    OS_queue_record_t *queue;
+    OS_ring_t      *ring;
+    OS_ring_cell_t *cell;
+    uint32          msg_size;
+    uint32          pos;
+    uint32          count;
+    int32           ret_val;
+
+    /*
+    ** Check Parameters
+    */
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    else if( (data == NULL) || (size_copied == NULL) )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    queue = OS_QUEUE_RECORD(queue_id);
+
+    ret_val = OS_RingWaitGet(queue, timeout, 1, &ring, &pos, &count);
+    if ( ret_val != OS_SUCCESS )
+    {
+        OS_QueueCountGet(&queue->counters, 0, ret_val);
+        *size_copied = 0;
+        return ret_val;
+    }
+
+    cell = OS_RING_CELL(ring, pos);
+    msg_size = cell->size;
+    *size_copied = (size < msg_size) ? size : msg_size;
+    memcpy(data, OS_RING_DATA(cell), *size_copied);
+
+    if ( queue->flags & OS_QUEUE_LATENCY )
+    {
+        OS_QueueCountLatency(&queue->counters, cell->put_time, OS_QueueTime());
+    }
+
+    OS_RING_RELEASE(ring, cell);
+    OS_RingWakePutters(queue, 1);
+
+    if ( msg_size != size )
+    {
+        return OS_QUEUE_INVALID_SIZE;
+    }
+
+    return OS_SUCCESS;
+
+} /* end OS_QueueGet */
+
+/*
+** Copies a message into a cell of the ring of its priority, waiting up to
+** timeout for room as OS_QueueGet waits for a message
+*/
+int32 OS_QueueSend(uint32 queue_id, void *data, uint32 size, uint32 flags, int32 timeout)
+{
+    OS_queue_record_t *queue;
+    OS_ring_t         *ring;
+    OS_ring_cell_t    *cell;
+    uint32             pos;
+    int32              ret_val;
+
+    queue = OS_QUEUE_RECORD(queue_id);
+    if ( size > queue->ring[0]->data_size )
+    {
+        return OS_QUEUE_INVALID_SIZE;
+    }
+
+    ring = OS_RingOfLevel(queue, OS_QUEUE_LEVEL(flags));
+    if ( ring == NULL )
+    {
+        return OS_ERROR;
+    }
+
+    ret_val = OS_RingWaitPut(queue, ring, timeout, &pos);
+    if ( ret_val != OS_SUCCESS )
+    {
+        return ret_val;
+    }
+
+    cell = OS_RING_CELL(ring, pos);
+    memcpy(OS_RING_DATA(cell), data, size);
+    cell->size = size;
+    if ( queue->flags & OS_QUEUE_LATENCY )
+    {
+        cell->put_time = OS_QueueTime();
+    }
+    OS_RING_COMMIT(cell);
+
+    OS_RingCountPut(queue, ring);
+
+    return OS_RingWakeGetters(queue);
+}
+
+/*
+** Claims the cells for as many of the messages as fit together, and wakes up
+** a waiting task once for the whole batch
+*/
+int32 OS_QueueSendBatch(uint32 queue_id, void *data, uint32 size, uint32 count,
+                        uint32 *count_put, uint32 flags)
+{
+    OS_queue_record_t *queue;
+    OS_ring_t         *ring;
+    OS_ring_cell_t    *cell;
+    uint32             pos;
+    uint32             claimed;
+    uint32             i;
+    uint64             put_time;
+    int32              ret_val;
+
+    queue = OS_QUEUE_RECORD(queue_id);
+    if ( size > queue->ring[0]->data_size )
+    {
+        return OS_QUEUE_INVALID_SIZE;
+    }
+
+    ring = OS_RingOfLevel(queue, OS_QUEUE_LEVEL(flags));
+    if ( ring == NULL )
+    {
+        return OS_ERROR;
+    }
+
+    put_time = 0;
+    if ( queue->flags & OS_QUEUE_LATENCY )
+    {
+        put_time = OS_QueueTime();
+    }
+
+    while ( *count_put < count )
+    {
+        claimed = OS_RingClaimPut(ring, count - *count_put, &pos);
+        if ( claimed == 0 )
+        {
+            break;
+        }
+
+        for ( i = 0; i < claimed; i++ )
+        {
+            cell = OS_RING_CELL(ring, pos + i);
+            memcpy(OS_RING_DATA(cell), (char *)data + (size_t)(*count_put + i) * size, size);
+            cell->size = size;
+            cell->put_time = put_time;
+            OS_RING_COMMIT(cell);
+        }
+        *count_put += claimed;
+    }
+
+    OS_RingCountPut(queue, ring);
+
+    if ( *count_put > 0 )
+    {
+        ret_val = OS_RingWakeGetters(queue);
+        if ( ret_val != OS_SUCCESS )
+        {
+            return ret_val;
+        }
+    }
+
+    return (*count_put < count) ? OS_QUEUE_FULL : OS_SUCCESS;
+}
+
+/*
+** Drops the oldest message of the priority in flags for OS_QUEUE_OVERWRITE.
+** The put of a single consumer ring cannot take a message.
+*/
+int32 OS_QueueDiscard(uint32 queue_id, uint32 flags)
+{
+    OS_queue_record_t *queue;
+    OS_ring_t         *ring;
+    uint32             pos;
+
+    queue = OS_QUEUE_RECORD(queue_id);
+    ring  = OS_LOAD_ACQUIRE(&queue->ring[OS_QUEUE_LEVEL(flags)]);
+    if ( ring == NULL )
+    {
+        return OS_QUEUE_EMPTY;
+    }
+    if ( ring->spsc )
+    {
+        return OS_ERROR;
+    }
+
+    if ( OS_RingClaimGet(ring, 1, &pos) == 0 )
+    {
+        return OS_QUEUE_EMPTY;
+    }
+
+    OS_RING_RELEASE(ring, OS_RING_CELL(ring, pos));
+    OS_RingWakePutters(queue, 1);
+
+    return OS_SUCCESS;
+}
+
+/*
+** Opens the shared queue another process created as queue_name, for
+** OS_QueueGetIdByName
+*/
+int32 OS_QueueOpen(uint32 *queue_id, const char *queue_name)
+{
+    OS_ring_segment_t *segment;
+    size_t             segment_size;
+    uint32             possible_qid;
+    int32              return_code;
+
+    return_code = OS_RingOpenSegment(queue_name, &segment, &segment_size);
+    if ( return_code != OS_SUCCESS )
+    {
+        return return_code;
+    }
+
+    if ( OS_ObjectAllocate(&OS_queue_table, &possible_qid) != OS_SUCCESS )
+    {
+        munmap(segment, segment_size);
+        return OS_ERR_NO_FREE_IDS;
+    }
+
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_QUEUE, queue_name, possible_qid);
+    if ( return_code != OS_SUCCESS )
+    {
+        munmap(segment, segment_size);
+        OS_ObjectRelease(&OS_queue_table, possible_qid);
+
+        /* Another task of this process got there first */
+        return (return_code == OS_ERR_NAME_TAKEN) ? OS_QueueGetIdByName(queue_id, queue_name)
+                                                  : return_code;
+    }
+
+    *queue_id = possible_qid;
+
+    pthread_mutex_lock(&OS_queue_table_mut);
+
+    OS_RingUseSegment(OS_QUEUE_RECORD(*queue_id), segment, segment_size, FALSE);
+    OS_QUEUE_RECORD(*queue_id)->id = -1;
+    OS_QUEUE_RECORD(*queue_id)->event.fd = -1;
+    OS_QUEUE_RECORD(*queue_id)->flags = segment->flags;
+    memset(&OS_QUEUE_RECORD(*queue_id)->counters, 0, sizeof(OS_queue_counters_t));
+    OS_QUEUE_RECORD(*queue_id)->free = FALSE;
+    strcpy( OS_QUEUE_RECORD(*queue_id)->name, (char*) queue_name);
+    OS_QUEUE_RECORD(*queue_id)->creator = OS_FindCreator();
+
+    pthread_mutex_unlock(&OS_queue_table_mut);
+
+    return OS_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------------------
+ Name: OS_QueueGetBatch
+
+ Purpose: Gets up to max_count messages from a message queue into data, which holds
+ max_count buffers of size bytes one after the other. Waits or times out for the
+ first message as OS_QueueGet does, then takes the messages already there.
+
+ Returns: OS_ERR_INVALID_ID if the given ID does not exist
+ OS_INVALID_POINTER if a pointer passed in is NULL
+ OS_ERROR if max_count is 0, or the OS call to wait failed
+ OS_QUEUE_EMPTY if the Queue has no messages on it to be recieved
+ OS_QUEUE_TIMEOUT if the time expired
+ OS_QUEUE_INVALID_SIZE if one of the messages was not size bytes
+ OS_SUCCESS if success
+
+ Notes: count_copied is set to the number of messages got, and sizes_copied, unless
+ it is NULL, to the size copied from each of them. The messages of a higher priority
+ come first.
+ ---------------------------------------------------------------------------------------*/
+int32 OS_QueueGetBatch (uint32 queue_id, void *data, uint32 size, uint32 max_count,
+                        uint32 *sizes_copied, uint32 *count_copied, int32 timeout)
+{
+    OS_queue_record_t *queue;
+    OS_ring_t      *ring;
+    OS_ring_cell_t *cell;
+    uint32          pos;
+    uint32          count;
+    uint32          copied;
+    uint32          i;
+    uint64          now;
+    int32           ret_val;
+
+    /*
+    ** Check Parameters
+    */
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    else if( (data == NULL) || (count_copied == NULL) )
+    {
+        return OS_INVALID_POINTER;
+    }
+    else if ( max_count == 0 )
+    {
+        return OS_ERROR;
+    }
+
+    *count_copied = 0;
+    queue = OS_QUEUE_RECORD(queue_id);
+
+    ret_val = OS_RingWaitGet(queue, timeout, max_count, &ring, &pos, &count);
+    if ( ret_val != OS_SUCCESS )
+    {
+        OS_QueueCountGet(&queue->counters, 0, ret_val);
+        return ret_val;
+    }
+
+    now = 0;
+    if ( queue->flags & OS_QUEUE_LATENCY )
+    {
+        now = OS_QueueTime();
+    }
+
+    /* Take the run of cells claimed, then the next run from the same or a lower priority */
+    while ( ring != NULL )
+    {
+        for ( i = 0; i < count; i++ )
+        {
+            cell   = OS_RING_CELL(ring, pos + i);
+            copied = (size < cell->size) ? size : cell->size;
+            memcpy((char *)data + (size_t)*count_copied * size, OS_RING_DATA(cell), copied);
+            if ( cell->size != size )
+            {
+                ret_val = OS_QUEUE_INVALID_SIZE;
+            }
+            if ( sizes_copied != NULL )
+            {
+                sizes_copied[*count_copied] = copied;
+            }
+            if ( queue->flags & OS_QUEUE_LATENCY )
+            {
+                OS_QueueCountLatency(&queue->counters, cell->put_time, now);
+            }
+            OS_RING_RELEASE(ring, cell);
+            (*count_copied)++;
+        }
+
+        if ( *count_copied == max_count )
+        {
+            break;
+        }
+        ring = OS_QueueClaimGet(queue, max_count - *count_copied, &pos, &count);
+    }
+
+    OS_RingWakePutters(queue, *count_copied);
+
+    return ret_val;
+
+} /* end OS_QueueGetBatch */
+
+/*---------------------------------------------------------------------------------------
+ Name: OS_QueueReserve
+
+ Purpose: Reserves room for a message of size bytes in the queue, and passes back a
+ pointer to it in ptr. The message is put on the queue by OS_QueueCommit.
+
+ Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
+ OS_INVALID_POINTER if ptr is NULL
+ OS_QUEUE_INVALID_SIZE if size is larger than the data size of the queue
+ OS_QUEUE_FULL if the queue cannot accept another message
+ OS_SUCCESS if SUCCESS
+
+ Notes: Every reserve must be committed. The message has priority 0, and the gets
+ wait for it before they get any message of priority 0 put after it.
+ ---------------------------------------------------------------------------------------*/
+int32 OS_QueueReserve (uint32 queue_id, uint32 size, void **ptr)
+{
+    OS_ring_t      *ring;
+    OS_ring_cell_t *cell;
+    uint32          pos;
+
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    if (ptr == NULL)
+    {
+        return OS_INVALID_POINTER;
+    }
+    ring = OS_QUEUE_RECORD(queue_id)->ring[0];
+    if ( size > ring->data_size )
+    {
+        return OS_QUEUE_INVALID_SIZE;
+    }
+
+    if ( OS_RingClaimPut(ring, 1, &pos) == 0 )
+    {
+        OS_QueueCountPut(&OS_QUEUE_RECORD(queue_id)->counters, 0, 1, 0);
+        return OS_QUEUE_FULL;
+    }
+
+    cell = OS_RING_CELL(ring, pos);
+    cell->size = size;
+    *ptr = OS_RING_DATA(cell);
+
+    return OS_SUCCESS;
+
+} /* end OS_QueueReserve */
+
+/*---------------------------------------------------------------------------------------
+ Name: OS_QueueCommit
+
+ Purpose: Puts the message built at ptr, as passed back by OS_QueueReserve, on the
+ queue.
+
+ Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
+ OS_INVALID_POINTER if ptr is not a pointer passed back by OS_QueueReserve
+ OS_ERROR if the OS call to wake up a waiting task fails
+ OS_SUCCESS if SUCCESS
+ ---------------------------------------------------------------------------------------*/
+int32 OS_QueueCommit (uint32 queue_id, void *ptr)
+{
+    OS_queue_record_t *queue;
+    OS_ring_cell_t    *cell;
+
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    queue = OS_QUEUE_RECORD(queue_id);
+    cell  = OS_RingCellOf(queue->ring[0], ptr);
+    if ( cell == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( queue->flags & OS_QUEUE_LATENCY )
+    {
+        cell->put_time = OS_QueueTime();
+    }
+    OS_RING_COMMIT(cell);
+
+    OS_RingCountPut(queue, queue->ring[0]);
+
+    return OS_RingWakeGetters(queue);
+
+} /* end OS_QueueCommit */
+
+/*---------------------------------------------------------------------------------------
+ Name: OS_QueueGetPtr
+
+ Purpose: Gets the next message on the queue without copying it. A pointer to the
+ message is passed back in ptr and its size in size. Waits or times out as
+ OS_QueueGet does.
+
+ Returns: OS_ERR_INVALID_ID if the given ID does not exist
+ OS_INVALID_POINTER if a pointer passed in is NULL
+ OS_QUEUE_EMPTY if the Queue has no messages on it to be recieved
+ OS_QUEUE_TIMEOUT if the time expired
+ OS_ERROR if the OS call to wait failed
+ OS_SUCCESS if success
+
+ Notes: The message stays in the queue until OS_QueueRelease, and the puts cannot
+ use its room until then.
+ ---------------------------------------------------------------------------------------*/
+int32 OS_QueueGetPtr (uint32 queue_id, void **ptr, uint32 *size, int32 timeout)
+{
+    OS_queue_record_t *queue;
+    OS_ring_t      *ring;
+    OS_ring_cell_t *cell;
+    uint32          pos;
+    uint32          count;
+    int32           ret_val;
+
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    else if( (ptr == NULL) || (size == NULL) )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    queue = OS_QUEUE_RECORD(queue_id);
+
+    ret_val = OS_RingWaitGet(queue, timeout, 1, &ring, &pos, &count);
+    if ( ret_val != OS_SUCCESS )
+    {
+        OS_QueueCountGet(&queue->counters, 0, ret_val);
+        *size = 0;
+        return ret_val;
+    }
+
+    cell  = OS_RING_CELL(ring, pos);
+
+    if ( queue->flags & OS_QUEUE_LATENCY )
+    {
+        OS_QueueCountLatency(&queue->counters, cell->put_time, OS_QueueTime());
+    }
+
+    *ptr  = OS_RING_DATA(cell);
+    *size = cell->size;
+
+    return OS_SUCCESS;
+
+} /* end OS_QueueGetPtr */
+
+/*---------------------------------------------------------------------------------------
+ Name: OS_QueueRelease
+
+ Purpose: Gives the room of a message passed back by OS_QueueGetPtr back to the
+ queue.
+
+ Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
+ OS_INVALID_POINTER if ptr is not a pointer passed back by OS_QueueGetPtr
+ OS_SUCCESS if SUCCESS
+ ---------------------------------------------------------------------------------------*/
+int32 OS_QueueRelease (uint32 queue_id, void *ptr)
+{
+    OS_ring_t      *ring;
+    OS_ring_cell_t *cell;
+
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    cell = OS_QueueCellOf(OS_QUEUE_RECORD(queue_id), ptr, &ring);
+    if ( cell == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    OS_RING_RELEASE(ring, cell);
+    OS_RingWakePutters(OS_QUEUE_RECORD(queue_id), 1);
+
+    return OS_SUCCESS;
+
+} /* end OS_QueueRelease */
+
+/*---------------------------------------------------------------------------------------
+ Name: OS_QueueGetEventFd
+
+ Purpose: Passes back a descriptor that is readable while the queue holds a
+ message, for a poll or epoll loop of the caller.
+
+ Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
+ OS_INVALID_POINTER if fd is NULL
+ OS_ERROR if the queue is shared, or the descriptor cannot be created
+ OS_SUCCESS if SUCCESS
+
+ Notes: The descriptor is an eventfd of the queue, it must not be read or closed,
+ and it is closed when the queue is deleted. It is only a hint: get the messages
+ with OS_CHECK once it polls readable, the get that finds or leaves the queue
+ empty clears it. The puts of other processes cannot write to it, so a shared
+ queue has none.
+ ---------------------------------------------------------------------------------------*/
+int32 OS_QueueGetEventFd (uint32 queue_id, int32 *fd)
+{
+    if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( fd == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( OS_QUEUE_RECORD(queue_id)->segment != NULL ||
+         OS_EventFdOpen(&(OS_QUEUE_RECORD(queue_id)->event), &OS_queue_table_mut) != OS_SUCCESS )
+    {
+        return OS_ERROR;
+    }
+
+    /* A put either sees the descriptor, or its message is seen here */
+    __sync_synchronize();
+    if ( !OS_QueueEmpty(OS_QUEUE_RECORD(queue_id)) )
+    {
+        OS_EventFdSignal(&(OS_QUEUE_RECORD(queue_id)->event));
+    }
+
+    *fd = OS_QUEUE_RECORD(queue_id)->event.fd;
+
+    return OS_SUCCESS;
+
+} /* end OS_QueueGetEventFd */
+
+/*
+** Adds up the messages put, got and held in the rings of all priorities. A
+** count read just as its position goes past 2^32 may be 2^32 short.
+*/
+int32 OS_QueueGetCounts(uint32 queue_id, OS_queue_stats_t *queue_stats)
+{
+    OS_ring_t *ring;
+    int        level;
+
+    queue_stats->depth = 0;
+    queue_stats->puts  = 0;
+    queue_stats->gets  = 0;
+    for ( level = 0; level < OS_QUEUE_PRIORITIES; level++ )
+    {
+        ring = OS_LOAD_ACQUIRE(&(OS_QUEUE_RECORD(queue_id)->ring[level]));
+        if ( ring != NULL )
+        {
+            queue_stats->depth += OS_RingHeld(ring);
+            queue_stats->puts  += ((uint64)ring->put_laps << 32) | ring->put_pos;
+            queue_stats->gets  += ((uint64)ring->get_laps << 32) | ring->get_pos;
+        }
+    }
+    queue_stats->max_depth = OS_QUEUE_RECORD(queue_id)->ring[0]->depth;
+
+    /* The messages OS_QUEUE_OVERWRITE dropped moved get_pos too */
+    queue_stats->gets -= OS_QUEUE_RECORD(queue_id)->counters.overwritten;
+
+    return OS_SUCCESS;
+}
+
+/*
+** Counts the calling task as waiting on the queue in OS_WaitAny, and creates
+** the eventfd the puts write to the first time. A put either sees the waiter,
+** or has made its message visible to OS_QueueWaitReady. The puts of other
+** processes cannot write to the eventfd, so a shared queue cannot be waited on.
+*/
+int32 OS_QueueWaitStart(uint32 queue_id, int *fd)
+{
+    if (queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
+    {
+        return OS_ERR_INVALID_ID;
+    }
+    if ( OS_QUEUE_RECORD(queue_id)->segment != NULL )
+    {
+        return OS_ERROR;
+    }
+
+    pthread_mutex_lock(&OS_queue_table_mut);
+    if ( OS_QUEUE_RECORD(queue_id)->id < 0 )
+    {
+        OS_QUEUE_RECORD(queue_id)->id = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    pthread_mutex_unlock(&OS_queue_table_mut);
+
+    if ( OS_QUEUE_RECORD(queue_id)->id < 0 )
+    {
+        return OS_ERROR;
+    }
+
+    __sync_fetch_and_add(&(OS_QUEUE_RECORD(queue_id)->any_waiters), 1);
+    *fd = OS_QUEUE_RECORD(queue_id)->id;
+
+    return OS_SUCCESS;
+}
+
+/*
+** Stops counting the task as waiting on the queue in OS_WaitAny
+*/
+void OS_QueueWaitEnd(uint32 queue_id)
+{
+    __sync_fetch_and_sub(&(OS_QUEUE_RECORD(queue_id)->any_waiters), 1);
+}
+
+/*
+** TRUE when the queue holds a message. The eventfd is emptied once poll has
+** reported it, the ring itself tells whether the message is still there.
+*/
+int OS_QueueWaitReady(uint32 queue_id, int fd_ready)
+{
+    uint64_t count;
+
+    if ( fd_ready && read(OS_QUEUE_RECORD(queue_id)->id, &count, sizeof(count)) < 0 )
+    {
+        /* nothing to drain, another task got there first */
+    }
+
+    return(!OS_QueueEmpty(OS_QUEUE_RECORD(queue_id)));
+}
+
+#endif
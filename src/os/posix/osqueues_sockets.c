@@ -1,4 +1,323 @@
-#ifdef OSAL_SOCKET_QUEUE
+#define _GNU_SOURCE     /* for sendmmsg and recvmmsg */
+#include "osqueues.h"
+#if defined(OSAL_SOCKET_QUEUE) && !defined(OSAL_RING_QUEUE)
+
+#include <poll.h>
+
+/*
+** Each queue is a connected pair of AF_UNIX datagram sockets. The gets receive
+** on id and the puts send on send_id, so a put is one send on a socket that
+** stays open, and the messages never go through the IP stack. The batch calls
+** hand up to OS_SOCKET_BATCH messages to each sendmmsg or recvmmsg.
+**
+** A datagram socket cannot let a message overtake the ones before it, so each
+** priority above 0 gets a pair of its own on its first put. Such a put also
+** sends an empty datagram on send_id, so that a task waiting for the queue,
+** in OS_QueueGet or OS_WaitAny, only has to wait on id. The gets look at the
+** pairs that prio_count says hold messages, from the highest priority down,
+** and drop the empty datagrams they find on id.
+*/
+#define OS_SOCKET_BATCH          64
+
+/* Room the kernel takes for each datagram on top of its data */
+#define OS_SOCKET_MSG_OVERHEAD   512
+
+/*
+** Sends count messages of size bytes each, stored one after the other at data,
+** without waiting for room. Returns how many were sent, or -1 if the first one
+** failed, with errno set.
+*/
+static int OS_SocketSendBatch(int sock, char *data, uint32 size, uint32 count)
+{
+#ifdef __linux__
+   struct mmsghdr msgs[OS_SOCKET_BATCH];
+   struct iovec   iovs[OS_SOCKET_BATCH];
+   uint32         i;
+   int            ret;
+
+   if ( count > OS_SOCKET_BATCH )
+   {
+      count = OS_SOCKET_BATCH;
+   }
+
+   memset(msgs, 0, count * sizeof(struct mmsghdr));
+   for ( i = 0; i < count; i++ )
+   {
+      iovs[i].iov_base           = data + (size_t)i * size;
+      iovs[i].iov_len            = size;
+      msgs[i].msg_hdr.msg_iov    = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+   }
+
+   do
+   {
+      ret = sendmmsg(sock, msgs, count, MSG_DONTWAIT);
+   } while ( ret == -1 && errno == EINTR );
+
+   return(ret);
+#else
+   int ret;
+
+   do
+   {
+      ret = send(sock, data, size, MSG_DONTWAIT);
+   } while ( ret == -1 && errno == EINTR );
+
+   return((ret == -1) ? -1 : 1);
+#endif
+}
+
+/*
+** Receives up to max_count messages into data, which holds max_count buffers
+** of size bytes one after the other, without waiting. Returns how many were
+** received, or -1 if there was none, with errno set. sizes, unless it is NULL,
+** gets the size of each message.
+*/
+static int OS_SocketRecvBatch(int sock, char *data, uint32 size, uint32 max_count,
+                              uint32 *sizes)
+{
+#ifdef __linux__
+   struct mmsghdr msgs[OS_SOCKET_BATCH];
+   struct iovec   iovs[OS_SOCKET_BATCH];
+   uint32         i;
+   int            ret;
+
+   if ( max_count > OS_SOCKET_BATCH )
+   {
+      max_count = OS_SOCKET_BATCH;
+   }
+
+   memset(msgs, 0, max_count * sizeof(struct mmsghdr));
+   for ( i = 0; i < max_count; i++ )
+   {
+      iovs[i].iov_base           = data + (size_t)i * size;
+      iovs[i].iov_len            = size;
+      msgs[i].msg_hdr.msg_iov    = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+   }
+
+   do
+   {
+      ret = recvmmsg(sock, msgs, max_count, MSG_DONTWAIT, NULL);
+   } while ( ret == -1 && errno == EINTR );
+
+   for ( i = 0; sizes != NULL && ret > 0 && i < ret; i++ )
+   {
+      sizes[i] = msgs[i].msg_len;
+   }
+
+   return(ret);
+#else
+   int ret;
+
+   do
+   {
+      ret = recv(sock, data, size, MSG_DONTWAIT);
+   } while ( ret == -1 && errno == EINTR );
+
+   if ( ret == -1 )
+   {
+      return(-1);
+   }
+   if ( sizes != NULL )
+   {
+      sizes[0] = ret;
+   }
+
+   return(1);
+#endif
+}
+
+/*
+** Creates a connected pair of datagram sockets, with the send buffer raised to
+** hold depth messages of data_size bytes as far as the system allows. The
+** messages waiting in the queue are charged to the send buffer.
+*/
+static int OS_SocketPairCreate(int sockets[2], uint32 depth, uint32 data_size)
+{
+   int       sndbuf;
+   socklen_t optlen;
+
+   if ( socketpair(AF_UNIX, SOCK_DGRAM, 0, sockets) == -1 )
+   {
+      return(-1);
+   }
+
+   optlen = sizeof(sndbuf);
+   if ( getsockopt(sockets[1], SOL_SOCKET, SO_SNDBUF, &sndbuf, &optlen) == 0 &&
+        (uint32)sndbuf / (data_size + OS_SOCKET_MSG_OVERHEAD) < depth )
+   {
+      sndbuf = depth * (data_size + OS_SOCKET_MSG_OVERHEAD);
+      setsockopt(sockets[1], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+   }
+
+   return(0);
+}
+
+/*
+** Returns the socket the puts of the given priority send on, and makes the
+** pair of the priority on its first put. Returns -1 if it cannot be made.
+*/
+static int OS_SocketOfLevel(OS_queue_record_t *queue, uint32 level)
+{
+   int sockets[2];
+   int sock;
+
+   if ( level == 0 )
+   {
+      return(queue->send_id);
+   }
+
+   sock = __atomic_load_n(&queue->prio_send_id[level], __ATOMIC_ACQUIRE);
+   if ( sock < 0 )
+   {
+      pthread_mutex_lock(&OS_queue_table_mut);
+      sock = queue->prio_send_id[level];
+      if ( sock < 0 && OS_SocketPairCreate(sockets, queue->depth, queue->data_size) == 0 )
+      {
+         queue->prio_id[level] = sockets[0];
+         sock = sockets[1];
+         __atomic_store_n(&queue->prio_send_id[level], sock, __ATOMIC_RELEASE);
+      }
+      pthread_mutex_unlock(&OS_queue_table_mut);
+   }
+
+   return(sock);
+}
+
+/*
+** Counts count messages sent on the pair of a priority above 0, then wakes up
+** the tasks waiting on id
+*/
+static void OS_SocketSentLevel(OS_queue_record_t *queue, uint32 level, uint32 count)
+{
+   __sync_fetch_and_add(&queue->prio_count[level], count);
+
+   /* If id is full the gets are not waiting, and will look at the pair anyway */
+   while ( send(queue->send_id, "", 0, MSG_DONTWAIT) == -1 && errno == EINTR )
+   {
+   }
+}
+
+/*
+** TRUE when a pair of a priority above 0 may hold a message
+*/
+static int OS_SocketLevelsPending(OS_queue_record_t *queue)
+{
+   int level;
+
+   for ( level = OS_QUEUE_PRIORITIES - 1; level > 0; level-- )
+   {
+      if ( queue->prio_count[level] != 0 )
+      {
+         return(TRUE);
+      }
+   }
+
+   return(FALSE);
+}
+
+/*
+** Receives the next message without waiting, from the pair of the highest
+** priority that holds one. Returns the size of the message, or -1 with errno
+** set, to EAGAIN when there is none.
+*/
+static int OS_SocketRecvNext(OS_queue_record_t *queue, void *data, uint32 size)
+{
+   int level;
+   int ret;
+
+   for ( ;; )
+   {
+      /*
+      ** A put counts its message only after sending it, so a message may be
+      ** passed over here. The empty datagram it sends next brings the get back.
+      */
+      for ( level = OS_QUEUE_PRIORITIES - 1; level > 0; level-- )
+      {
+         if ( queue->prio_count[level] != 0 )
+         {
+            do
+            {
+               ret = recv(queue->prio_id[level], data, size, MSG_DONTWAIT);
+            } while ( ret == -1 && errno == EINTR );
+
+            if ( ret != -1 )
+            {
+               __sync_fetch_and_sub(&queue->prio_count[level], 1);
+               return(ret);
+            }
+         }
+      }
+
+      do
+      {
+         ret = recv(queue->id, data, size, MSG_DONTWAIT);
+      } while ( ret == -1 && errno == EINTR );
+
+      /* An empty datagram only wakes the gets up, look at the pairs again */
+      if ( ret != 0 )
+      {
+         return(ret);
+      }
+   }
+}
+
+/*
+** Sets deadline to timeout msecs from now, unless timeout is OS_PEND or OS_CHECK
+*/
+static void OS_SocketDeadline(int32 timeout, struct timespec *deadline)
+{
+   if ( timeout != OS_PEND && timeout != OS_CHECK )
+   {
+      clock_gettime(CLOCK_MONOTONIC, deadline);
+      deadline->tv_sec  += timeout / 1000;
+      deadline->tv_nsec += (timeout % 1000) * 1000000L;
+      if ( deadline->tv_nsec >= 1000000000L )
+      {
+         deadline->tv_nsec -= 1000000000L;
+         deadline->tv_sec++;
+      }
+   }
+}
+
+/*
+** Waits up to the deadline for events on sock, or forever if timeout is
+** OS_PEND. Returns OS_SUCCESS once poll returns, OS_QUEUE_TIMEOUT when the
+** deadline has passed, or OS_ERROR.
+*/
+static int32 OS_SocketPoll(int sock, short events, int32 timeout,
+                           const struct timespec *deadline)
+{
+   struct pollfd   pfd;
+   struct timespec now;
+   int             poll_msecs;
+   int             rv;
+
+   poll_msecs = -1;
+   if ( timeout != OS_PEND )
+   {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      poll_msecs = (deadline->tv_sec - now.tv_sec) * 1000 +
+                   (deadline->tv_nsec - now.tv_nsec + 999999) / 1000000;
+      if ( poll_msecs <= 0 )
+      {
+         return(OS_QUEUE_TIMEOUT);
+      }
+   }
+
+   pfd.fd     = sock;
+   pfd.events = events;
+   rv = poll(&pfd, 1, poll_msecs);
+   if ( rv < 0 && errno != EINTR )
+   {
+      printf("Bad return value from poll: %d, sock = %d\n", rv, sock);
+      return(OS_ERROR);
+   }
+
+   return(OS_SUCCESS);
+}
+
 /****************************************************************************************
                                 MESSAGE QUEUE API
 ****************************************************************************************/
@@ -12,19 +331,21 @@
             OS_ERR_NAME_TOO_LONG if the name passed in is too long
             OS_ERR_NO_FREE_IDS if there are already the max queues created
             OS_ERR_NAME_TAKEN if the name is already being used on another queue
-            OS_ERROR if the OS create call fails
+            OS_ERROR if the OS create call fails, or flags has OS_QUEUE_SHARED
             OS_SUCCESS if success
 
-   Notes: the flags parameter is unused.
+   Notes: flags may give what OS_QueuePut does when the queue is full, the others
+            are unused. The send buffer is raised to hold
+            queue_depth messages of data_size bytes, as far as the system allows.
+            Each priority above 0 holds as many again.
 ---------------------------------------------------------------------------------------*/
 int32 OS_QueueCreate (uint32 *queue_id, const char *queue_name, uint32 queue_depth,
                        uint32 data_size, uint32 flags)
 {
-   int                     tmpSkt;
-   int                     returnStat;
-   struct sockaddr_in      servaddr;
-   int                     i;
+   int                     sockets[2];
+   int32                   return_code;
    uint32                  possible_qid;
+   int                     level;
 
     if ( queue_id == NULL || queue_name == NULL)
     {
@@ -39,83 +360,60 @@ int32 OS_QueueCreate (uint32 *queue_id, const char *queue_name, uint32 queue_dep
        return OS_ERR_NAME_TOO_LONG;
     }
 
-   /* Check Parameters */
-
-    pthread_mutex_lock(&OS_queue_table_mut);
-
-    for(possible_qid = 0; possible_qid < OS_MAX_QUEUES; possible_qid++)
+    /* Only the ring queues can be shared with other processes */
+    if ( flags & OS_QUEUE_SHARED )
     {
-        if (OS_queue_table[possible_qid].free == TRUE)
-            break;
+        return OS_ERROR;
     }
 
-    if( possible_qid >= OS_MAX_QUEUES || OS_queue_table[possible_qid].free != TRUE)
+    /* Take a free queue Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_queue_table, &possible_qid) != OS_SUCCESS )
     {
-        pthread_mutex_unlock(&OS_queue_table_mut);
         return OS_ERR_NO_FREE_IDS;
     }
 
-    /* Check to see if the name is already taken */
-    for (i = 0; i < OS_MAX_QUEUES; i++)
+    /* Check to see if the name is already taken, and reserve it */
+
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_QUEUE, queue_name, possible_qid);
+    if ( return_code != OS_SUCCESS )
     {
-        if ((OS_queue_table[i].free == FALSE) &&
-                strcmp ((char*) queue_name, OS_queue_table[i].name) == 0)
-        {
-            pthread_mutex_unlock(&OS_queue_table_mut);
-            return OS_ERR_NAME_TAKEN;
-        }
+        OS_ObjectRelease(&OS_queue_table, possible_qid);
+        return return_code;
     }
 
-    /* Set the possible task Id to not free so that
-     * no other task can try to use it */
-
-    OS_queue_table[possible_qid].free = FALSE;
-
-    pthread_mutex_unlock(&OS_queue_table_mut);
-
-    tmpSkt = socket(AF_INET, SOCK_DGRAM, 0);
-    if ( tmpSkt == -1 )
+    if ( OS_SocketPairCreate(sockets, queue_depth, data_size) == -1 )
     {
         pthread_mutex_lock(&OS_queue_table_mut);
-        OS_queue_table[possible_qid].free = TRUE;
+        OS_NameIndexRemove(OS_OBJECT_TYPE_QUEUE, queue_name);
         pthread_mutex_unlock(&OS_queue_table_mut);
+        OS_ObjectRelease(&OS_queue_table, possible_qid);
 
         printf("Failed to create a socket on OS_QueueCreate. errno = %d\n",errno);
         return OS_ERROR;
     }
 
-    memset(&servaddr, 0, sizeof(servaddr));
-    servaddr.sin_family      = AF_INET;
-    servaddr.sin_port        = htons(OS_BASE_PORT + possible_qid);
-    servaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-
-   /*
-   ** bind the input socket to a pipe
-   ** port numbers are OS_BASE_PORT + queue_id
-   */
-   returnStat = bind(tmpSkt,(struct sockaddr *)&servaddr, sizeof(servaddr));
-
-   if ( returnStat == -1 )
-   {
-        pthread_mutex_lock(&OS_queue_table_mut);
-        OS_queue_table[possible_qid].free = TRUE;
-        pthread_mutex_unlock(&OS_queue_table_mut);
-
-        printf("bind failed on OS_QueueCreate. errno = %d\n",errno);
-        return OS_ERROR;
-   }
-
    /*
-   ** store socket handle
+   ** store socket handles
    */
    *queue_id = possible_qid;
 
     pthread_mutex_lock(&OS_queue_table_mut);
 
-   OS_queue_table[*queue_id].id = tmpSkt;
-   OS_queue_table[*queue_id].free = FALSE;
-   strcpy( OS_queue_table[*queue_id].name, (char*) queue_name);
-   OS_queue_table[*queue_id].creator = OS_FindCreator();
+   OS_QUEUE_RECORD(*queue_id)->id = sockets[0];
+   OS_QUEUE_RECORD(*queue_id)->send_id = sockets[1];
+   OS_QUEUE_RECORD(*queue_id)->flags = flags;
+   OS_QUEUE_RECORD(*queue_id)->depth = queue_depth;
+   OS_QUEUE_RECORD(*queue_id)->data_size = data_size;
+   for ( level = 0; level < OS_QUEUE_PRIORITIES; level++ )
+   {
+      OS_QUEUE_RECORD(*queue_id)->prio_id[level] = -1;
+      OS_QUEUE_RECORD(*queue_id)->prio_send_id[level] = -1;
+      OS_QUEUE_RECORD(*queue_id)->prio_count[level] = 0;
+   }
+   memset(&OS_QUEUE_RECORD(*queue_id)->counters, 0, sizeof(OS_queue_counters_t));
+   OS_QUEUE_RECORD(*queue_id)->free = FALSE;
+   strcpy( OS_QUEUE_RECORD(*queue_id)->name, (char*) queue_name);
+   OS_QUEUE_RECORD(*queue_id)->creator = OS_FindCreator();
 
     pthread_mutex_unlock(&OS_queue_table_mut);
 
@@ -138,20 +436,34 @@ int32 OS_QueueCreate (uint32 *queue_id, const char *queue_name, uint32 queue_dep
 ---------------------------------------------------------------------------------------*/
 int32 OS_QueueDelete (uint32 queue_id)
 {
+    int level;
+
     /* Check to see if the queue_id given is valid */
 
-    if (queue_id >= OS_MAX_QUEUES || OS_queue_table[queue_id].free == TRUE)
+    if (queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
     {
         return OS_ERR_INVALID_ID;
     }
 
     /* Try to delete the queue */
 
-    if(close(OS_queue_table[queue_id].id) !=0)
+    if(close(OS_QUEUE_RECORD(queue_id)->send_id) !=0 ||
+       close(OS_QUEUE_RECORD(queue_id)->id) !=0)
     {
         return OS_ERROR;
     }
 
+    for ( level = 1; level < OS_QUEUE_PRIORITIES; level++ )
+    {
+        if ( OS_QUEUE_RECORD(queue_id)->prio_send_id[level] >= 0 )
+        {
+            close(OS_QUEUE_RECORD(queue_id)->prio_send_id[level]);
+            close(OS_QUEUE_RECORD(queue_id)->prio_id[level]);
+            OS_QUEUE_RECORD(queue_id)->prio_send_id[level] = -1;
+            OS_QUEUE_RECORD(queue_id)->prio_id[level] = -1;
+        }
+    }
+
     /*
      * Now that the queue is deleted, remove its "presence"
      * in OS_message_q_table and OS_message_q_name_table
@@ -159,13 +471,17 @@ int32 OS_QueueDelete (uint32 queue_id)
 
     pthread_mutex_lock(&OS_queue_table_mut);
 
-    OS_queue_table[queue_id].free = TRUE;
-    strcpy(OS_queue_table[queue_id].name, "");
-    OS_queue_table[queue_id].creator = UNINITIALIZED;
-    OS_queue_table[queue_id].id = UNINITIALIZED;
+    OS_NameIndexRemove(OS_OBJECT_TYPE_QUEUE, OS_QUEUE_RECORD(queue_id)->name);
+    OS_QUEUE_RECORD(queue_id)->free = TRUE;
+    strcpy(OS_QUEUE_RECORD(queue_id)->name, "");
+    OS_QUEUE_RECORD(queue_id)->creator = UNINITIALIZED;
+    OS_QUEUE_RECORD(queue_id)->id = UNINITIALIZED;
+    OS_QUEUE_RECORD(queue_id)->send_id = UNINITIALIZED;
 
     pthread_mutex_unlock(&OS_queue_table_mut);
 
+    OS_ObjectRelease(&OS_queue_table, queue_id);
+
    return OS_SUCCESS;
 
 } /* end OS_QueueDelete */
@@ -184,13 +500,15 @@ int32 OS_QueueDelete (uint32 queue_id)
 ---------------------------------------------------------------------------------------*/
 int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied, int32 timeout)
 {
-   int sizeCopied;
-   int flags;
+   OS_queue_record_t *queue;
+   int             sizeCopied;
+   int32           return_code;
+   struct timespec deadline;
 
    /*
    ** Check Parameters
    */
-   if(queue_id >= OS_MAX_QUEUES || OS_queue_table[queue_id].free == TRUE)
+   if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
    {
        return OS_ERR_INVALID_ID;
    }
@@ -199,190 +517,350 @@ int32 OS_QueueGet (uint32 queue_id, void *data, uint32 size, uint32 *size_copied
        return OS_INVALID_POINTER;
    }
 
+   queue = OS_QUEUE_RECORD(queue_id);
+   OS_SocketDeadline(timeout, &deadline);
+
    /*
-   ** Read the socket for data
+   ** Wait for data to come in on id. Another task may get the message first,
+   ** or a signal may cut the wait short, so the wait goes on until the deadline.
    */
-   if (timeout == OS_PEND)
+   for ( ;; )
    {
-      fcntl(OS_queue_table[queue_id].id,F_SETFL,0);
-      /*
-      ** A signal can interrupt the recvfrom call, so the call has to be done with
-      ** a loop
-      */
-      do
+      sizeCopied = OS_SocketRecvNext(queue, data, size);
+      if ( sizeCopied != -1 || (errno != EAGAIN && errno != EWOULDBLOCK) )
       {
-         sizeCopied = recvfrom(OS_queue_table[queue_id].id, data, size, 0, NULL, NULL);
-      } while ( sizeCopied == -1 && errno == EINTR );
+         break;
+      }
+
+      if ( timeout == OS_CHECK )
+      {
+         OS_QueueCountGet(&queue->counters, 0, OS_QUEUE_EMPTY);
+         *size_copied = 0;
+         return(OS_QUEUE_EMPTY);
+      }
 
-      if(sizeCopied != size )
+      return_code = OS_SocketPoll(queue->id, POLLIN, timeout, &deadline);
+      if ( return_code != OS_SUCCESS )
       {
-         *size_copied = sizeCopied;
-         return(OS_QUEUE_INVALID_SIZE);
+         OS_QueueCountGet(&queue->counters, 0, return_code);
+         *size_copied = 0;
+         return(return_code);
       }
    }
-   else if (timeout == OS_CHECK)
+
+   if ( sizeCopied == -1 )
    {
-      flags = fcntl(OS_queue_table[queue_id].id, F_GETFL, 0);
-      fcntl(OS_queue_table[queue_id].id,F_SETFL,flags|O_NONBLOCK);
+      *size_copied = 0;
+      return(OS_ERROR);
+   }
+
+   OS_QueueCountGet(&queue->counters, 1, OS_SUCCESS);
+
+   *size_copied = sizeCopied;
+   if ( sizeCopied != size )
+   {
+      return(OS_QUEUE_INVALID_SIZE);
+   }
+
+   return OS_SUCCESS;
 
-      sizeCopied = recvfrom(OS_queue_table[queue_id].id, data, size, 0, NULL, NULL);
+} /* end OS_QueueGet */
+
+/*
+** Sends a message on the pair of its priority, waiting up to timeout for room
+** as OS_QueueGet waits for a message. An empty message of priority 0 is taken
+** for a wake up and never got. A datagram socket only polls writable once
+** the messages waiting take no more than a quarter of its send buffer, so a
+** put that waits, waits for the gets to catch up.
+*/
+int32 OS_QueueSend(uint32 queue_id, void *data, uint32 size, uint32 flags, int32 timeout)
+{
+   OS_queue_record_t *queue;
+   struct timespec deadline;
+   uint32 level;
+   int    sock;
+   int    bytesSent;
+   int32  return_code;
+
+   queue = OS_QUEUE_RECORD(queue_id);
+   level = OS_QUEUE_LEVEL(flags);
+   sock  = OS_SocketOfLevel(queue, level);
+   if ( sock < 0 )
+   {
+      return(OS_ERROR);
+   }
 
-      fcntl(OS_queue_table[queue_id].id,F_SETFL,flags);
+   OS_SocketDeadline(timeout, &deadline);
+
+   for ( ;; )
+   {
+      do
+      {
+         bytesSent = send(sock, data, size, MSG_DONTWAIT);
+      } while ( bytesSent == -1 && errno == EINTR );
 
-      if (sizeCopied == -1 && errno == EWOULDBLOCK )
+      if ( bytesSent != -1 )
       {
-         *size_copied = 0;
-         return(OS_QUEUE_EMPTY);
+         break;
       }
-      else if(sizeCopied != size )
+      if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS )
       {
-         *size_copied = sizeCopied;
-         return(OS_QUEUE_INVALID_SIZE);
+         return(OS_ERROR);
+      }
+      if ( timeout == OS_CHECK )
+      {
+         return(OS_QUEUE_FULL);
       }
 
+      return_code = OS_SocketPoll(sock, POLLOUT, timeout, &deadline);
+      if ( return_code != OS_SUCCESS )
+      {
+         return(return_code);
+      }
    }
-   else /* timeout */
+
+   OS_QueueCountPut(&queue->counters, 1, 0, OS_QueueCountedDepth(&queue->counters) + 1);
+
+   if ( level > 0 )
    {
-      int    rv;
-      int    sock = OS_queue_table[queue_id].id;
-      struct timeval tv_timeout;
-      fd_set fdset;
+      OS_SocketSentLevel(queue, level, 1);
+   }
 
-      FD_ZERO( &fdset );
-      FD_SET( sock, &fdset );
+   if( bytesSent != size )
+   {
+      return(OS_QUEUE_FULL);
+   }
 
-      /*
-      ** Translate the timeout value from milliseconds into
-      ** seconds and nanoseconds.
-      */
-      tv_timeout.tv_usec = (timeout % 1000) * 1000;
-      tv_timeout.tv_sec = timeout / 1000;
+   return OS_SUCCESS;
+}
+
+/*
+** Sends count messages on the pair of their priority with sendmmsg,
+** OS_SOCKET_BATCH at a time
+*/
+int32 OS_QueueSendBatch(uint32 queue_id, void *data, uint32 size, uint32 count,
+                        uint32 *count_put, uint32 flags)
+{
+   OS_queue_record_t *queue;
+   uint32 level;
+   int    sock;
+   int    sent;
+   int32  return_code;
+
+   queue = OS_QUEUE_RECORD(queue_id);
+   level = OS_QUEUE_LEVEL(flags);
+   sock  = OS_SocketOfLevel(queue, level);
+   if ( sock < 0 )
+   {
+      return(OS_ERROR);
+   }
 
-      /*
-      ** Use select to wait for data to come in on the socket
-      ** TODO: If the select call is interrupted, the timeout should be
-      ** re-computed to avoid having to delay for the full time.
-      **
-      */
-      do
+   return_code = OS_SUCCESS;
+   while ( *count_put < count )
+   {
+      sent = OS_SocketSendBatch(sock, (char *)data + (size_t)*count_put * size, size,
+                                count - *count_put);
+      if ( sent == -1 )
       {
-         FD_ZERO( &fdset );
-         FD_SET( sock, &fdset );
-         rv = select( sock+1, &fdset, NULL, NULL, &tv_timeout );
-      } while ( rv == -1 && errno == EINTR );
+         return_code = (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) ?
+                       OS_QUEUE_FULL : OS_ERROR;
+         break;
+      }
+      *count_put += sent;
+   }
+
+   OS_QueueCountPut(&queue->counters, *count_put, 0,
+                    OS_QueueCountedDepth(&queue->counters) + *count_put);
+
+   if ( level > 0 && *count_put > 0 )
+   {
+      OS_SocketSentLevel(queue, level, *count_put);
+   }
+
+   return return_code;
+}
 
-      if( rv > 0 )
+/*
+** Drops the oldest message of the priority in flags for OS_QUEUE_OVERWRITE.
+** Only its first byte is received, the rest of the datagram goes with it.
+*/
+int32 OS_QueueDiscard(uint32 queue_id, uint32 flags)
+{
+   OS_queue_record_t *queue;
+   uint32 level;
+   char   byte;
+   int    ret;
+
+   queue = OS_QUEUE_RECORD(queue_id);
+   level = OS_QUEUE_LEVEL(flags);
+
+   for ( ;; )
+   {
+      do
       {
-         /* got a packet within the timeout */
-         sizeCopied = recvfrom(OS_queue_table[queue_id].id, data, size, 0, NULL, NULL);
+         ret = recv((level > 0) ? queue->prio_id[level] : queue->id, &byte, 1, MSG_DONTWAIT);
+      } while ( ret == -1 && errno == EINTR );
 
-         if ( sizeCopied == size )
-         {
-            *size_copied = sizeCopied;
-            return OS_SUCCESS;
-         }
-         else
-         {
-            *size_copied = sizeCopied;
-            return OS_QUEUE_INVALID_SIZE;
-         }
-      }
-      else if ( rv < 0 )
+      if ( ret == -1 )
       {
-         /*
-         ** Need to handle Select error codes here
-         ** This might need a new error code: OS_QUEUE_TIMEOUT_ERROR
-         */
-         printf("Bad return value from select: %d, sock = %d\n", rv, sock);
-         *size_copied = 0;
-         return OS_ERROR;
+         return (errno == EAGAIN || errno == EWOULDBLOCK) ? OS_QUEUE_EMPTY : OS_ERROR;
       }
 
-      /*
-      ** If rv == 0, then the select timed out with no data
-      */
-      return(OS_QUEUE_TIMEOUT);
+      if ( level > 0 )
+      {
+         __sync_fetch_and_sub(&queue->prio_count[level], 1);
+         break;
+      }
 
-   } /* END timeout */
+      /* Drop the empty datagrams on the way, they only wake the gets up */
+      if ( ret != 0 )
+      {
+         break;
+      }
+   }
 
-   /*
-   ** Should never really get here.
-   */
    return OS_SUCCESS;
+}
 
-} /* end OS_QueueGet */
+/*
+** No process but this one sees the queues, so there is none to open
+*/
+int32 OS_QueueOpen(uint32 *queue_id, const char *queue_name)
+{
+   return OS_ERR_NAME_NOT_FOUND;
+}
 
 /*---------------------------------------------------------------------------------------
-   Name: OS_QueuePut
+   Name: OS_QueueGetBatch
 
-   Purpose: Put a message on a message queue.
+   Purpose: Gets up to max_count messages from a message queue into data, which
+            holds max_count buffers of size bytes one after the other. Waits or
+            times out for the first message as OS_QueueGet does, then takes the
+            messages already there.
 
-   Returns: OS_ERR_INVALID_ID if the queue id passed in is not a valid queue
-            OS_INVALID_POINTER if the data pointer is NULL
-            OS_QUEUE_FULL if the queue cannot accept another message
-            OS_ERROR if the OS call returns an error
-            OS_SUCCESS if SUCCESS
+   Returns: OS_ERR_INVALID_ID if the given ID does not exist
+            OS_INVALID_POINTER if a pointer passed in is NULL
+            OS_ERROR if max_count is 0
+            OS_QUEUE_EMPTY if the Queue has no messages on it to be recieved
+            OS_QUEUE_TIMEOUT if the time expired
+            OS_QUEUE_INVALID_SIZE if one of the messages was not size bytes
+            OS_SUCCESS if success
 
-   Notes: The flags parameter is not used.  The message put is always configured to
-            immediately return an error if the receiving message queue is full.
+   Notes: count_copied is set to the number of messages got, and sizes_copied,
+            unless it is NULL, to the size copied from each of them. The messages
+            of a higher priority come first. The messages after the first are
+            received with recvmmsg while only priority 0 has messages.
 ---------------------------------------------------------------------------------------*/
-int32 OS_QueuePut (uint32 queue_id, void *data, uint32 size, uint32 flags)
+int32 OS_QueueGetBatch (uint32 queue_id, void *data, uint32 size, uint32 max_count,
+                        uint32 *sizes_copied, uint32 *count_copied, int32 timeout)
 {
-
-   struct sockaddr_in serva;
-   static int         socketFlags = 0;
-   int                bytesSent    = 0;
-   int                tempSkt      = 0;
+   OS_queue_record_t *queue;
+   uint32 sizes[OS_SOCKET_BATCH];
+   uint32 first_size;
+   uint32 kept;
+   uint32 i;
+   char  *buf;
+   int    from_id;
+   int    received;
+   int32  return_code;
 
    /*
    ** Check Parameters
    */
-   if(queue_id >= OS_MAX_QUEUES || OS_queue_table[queue_id].free == TRUE)
+   if(queue_id >= OS_queue_table.num_records || OS_QUEUE_RECORD(queue_id)->free == TRUE)
    {
        return OS_ERR_INVALID_ID;
    }
-   if (data == NULL)
+   else if( (data == NULL) || (count_copied == NULL) )
    {
        return OS_INVALID_POINTER;
    }
+   else if ( max_count == 0 )
+   {
+       return OS_ERROR;
+   }
 
-   /*
-   ** specify the IP addres and port number of destination
-   */
-   memset(&serva, 0, sizeof(serva));
-   serva.sin_family      = AF_INET;
-   serva.sin_port        = htons(OS_BASE_PORT + queue_id);
-   serva.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   *count_copied = 0;
+   return_code = OS_QueueGet(queue_id, data, size, &first_size, timeout);
 
    /*
-   ** open a temporary socket to transfer the packet to MR
+   ** A first message of the wrong size has been taken off the queue all the
+   ** same, it is counted and the batch goes on
    */
-   tempSkt = socket(AF_INET, SOCK_DGRAM, 0);
-
-   /*
-   ** send the packet to the message router task (MR)
-   */
-   bytesSent = sendto(tempSkt,(char *)data, size, socketFlags,
-                    (struct sockaddr *)&serva, sizeof(serva));
+   if ( return_code != OS_SUCCESS && return_code != OS_QUEUE_INVALID_SIZE )
+   {
+      return return_code;
+   }
 
-   if( bytesSent == -1 )
+   if ( sizes_copied != NULL )
    {
-      close(tempSkt);
-      return(OS_ERROR);
+      sizes_copied[0] = first_size;
    }
 
-   if( bytesSent != size )
+   queue = OS_QUEUE_RECORD(queue_id);
+   for ( *count_copied = 1; *count_copied < max_count; *count_copied += kept )
    {
-      close(tempSkt);
-      return(OS_QUEUE_FULL);
+      buf = (char *)data + (size_t)*count_copied * size;
+      if ( OS_SocketLevelsPending(queue) )
+      {
+         received = OS_SocketRecvNext(queue, buf, size);
+         if ( received == -1 )
+         {
+            break;
+         }
+         sizes[0] = received;
+         received = 1;
+         from_id  = FALSE;
+      }
+      else
+      {
+         received = OS_SocketRecvBatch(queue->id, buf, size, max_count - *count_copied, sizes);
+         if ( received <= 0 )
+         {
+            break;
+         }
+         from_id = TRUE;
+      }
+
+      /* Drop the empty datagrams, which only tell that the other pairs have messages */
+      kept = 0;
+      for ( i = 0; i < received; i++ )
+      {
+         if ( sizes[i] == 0 && from_id )
+         {
+            continue;
+         }
+         if ( kept != i )
+         {
+            memmove(buf + (size_t)kept * size, buf + (size_t)i * size, sizes[i]);
+         }
+         if ( sizes_copied != NULL )
+         {
+            sizes_copied[*count_copied + kept] = sizes[i];
+         }
+         if ( sizes[i] != size )
+         {
+            return_code = OS_QUEUE_INVALID_SIZE;
+         }
+         kept++;
+      }
    }
 
-   /*
-   ** close socket
-   */
-   close(tempSkt);
+   /* OS_QueueGet has counted the first message */
+   OS_QueueCountGet(&queue->counters, *count_copied - 1, return_code);
+
+   return return_code;
+} /* end OS_QueueGetBatch */
+
+/*
+** The puts and gets counted tell the depth of the queue
+*/
+int32 OS_QueueGetCounts(uint32 queue_id, OS_queue_stats_t *queue_stats)
+{
+   queue_stats->depth     = OS_QueueCountedDepth(&OS_QUEUE_RECORD(queue_id)->counters);
+   queue_stats->max_depth = OS_QUEUE_RECORD(queue_id)->depth;
 
    return OS_SUCCESS;
-} /* end OS_QueuePut */
+}
 
 #endif
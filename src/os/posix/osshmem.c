@@ -0,0 +1,760 @@
+/*
+** File   : osshmem.c
+**
+**      Copyright (c) 2004-2006, United States government as represented by the
+**      administrator of the National Aeronautics Space Administration.
+**      All rights reserved. This software was created at NASAs Goddard
+**      Space Flight Center pursuant to government contracts.
+**
+**      This is governed by the NASA Open Source Agreement and may be used,
+**      distributed and modified only pursuant to the terms of that agreement.
+**
+** Purpose: This file contains the shared memory API of the posix OSAL. A
+**          segment is a POSIX shared memory object named "/osal.<name>", so
+**          any process can find it by the name it was created with and map
+**          the same memory. The semaphore of a segment is a process shared
+**          robust mutex kept at the start of the segment, ahead of the data.
+*/
+
+/****************************************************************************************
+                                    INCLUDE FILES
+****************************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/statfs.h>
+#endif
+
+#include "common_types.h"
+#include "osapi.h"
+#include "osposix.h"
+#include "osobject.h"
+
+/****************************************************************************************
+                                     DEFINES
+****************************************************************************************/
+
+/*
+** Set in the header of a segment once its creator has set it up
+*/
+#define OS_SHMEM_MAGIC          0x4F534D31
+
+/*
+** Times a process finding a segment checks, a millisecond apart, whether the
+** creator has set it up yet
+*/
+#define OS_SHMEM_OPEN_TRIES     1000
+
+/*
+** Prefix of the name of the shared memory object of a segment
+*/
+#define OS_SHMEM_PREFIX         "/osal."
+
+/****************************************************************************************
+                                   GLOBAL DATA
+****************************************************************************************/
+
+/*
+** Header at the start of each segment, seen by all the processes that map it.
+** The data follows on the next cache line.
+*/
+typedef struct
+{
+    volatile uint32  magic;
+    uint32           size;
+    pthread_mutex_t  mutex;
+} OS_shmem_header_t;
+
+#define OS_SHMEM_DATA_OFFSET \
+   (((sizeof(OS_shmem_header_t) + OS_CACHE_LINE - 1) / OS_CACHE_LINE) * OS_CACHE_LINE)
+
+/*
+** Segments this process has created or found by name
+*/
+typedef struct
+{
+    int                 free;
+    char                name[OS_MAX_API_NAME];
+    uint32              creator;
+    OS_shmem_header_t  *header;
+    size_t              map_size;
+    int                 owner;   /* created by this process, deleting it removes the name */
+    int                 huge;    /* kept in OS_SHMEM_HUGETLB_DIR rather than /dev/shm */
+} OS_shmem_record_t;
+
+OS_object_table_t   OS_shmem_table;
+pthread_mutex_t     OS_shmem_table_mut;
+
+static int          OS_shmem_initialized = FALSE;
+
+#define OS_SHMEM_RECORD(id)   ((OS_shmem_record_t *)OS_ObjectRecord(&OS_shmem_table, id))
+
+uint32  OS_FindCreator(void);
+
+/****************************************************************************************
+                                 LOCAL FUNCTIONS
+****************************************************************************************/
+
+/*
+** Marks a new shared memory table record as free
+*/
+static void OS_ShMemInitRecord(void *record)
+{
+    OS_shmem_record_t *shmem = record;
+
+    shmem->free     = TRUE;
+    shmem->creator  = UNINITIALIZED;
+    shmem->header   = NULL;
+    shmem->map_size = 0;
+    strcpy(shmem->name, "");
+}
+
+/*
+** Tells whether id is a segment in use
+*/
+static int OS_ShMemValidId(uint32 id)
+{
+    return(id < OS_shmem_table.num_records && OS_SHMEM_RECORD(id)->free != TRUE);
+}
+
+/*
+** Builds the name of the shared memory object of segment seg_name, and its
+** path in the hugetlbfs file system
+*/
+static void OS_ShMemNames(const char *seg_name, char *shm_name, char *huge_path)
+{
+    strcpy(shm_name, OS_SHMEM_PREFIX);
+    strcat(shm_name, seg_name);
+
+    strcpy(huge_path, OS_SHMEM_HUGETLB_DIR);
+    strcat(huge_path, shm_name);
+}
+
+/*
+** Sets up the semaphore of a new segment of nbytes, then marks the segment
+** ready for the other processes
+*/
+static int32 OS_ShMemInitHeader(OS_shmem_header_t *header, uint32 nbytes)
+{
+    pthread_mutexattr_t attr;
+    int                 ret;
+
+    if ( pthread_mutexattr_init(&attr) != 0 )
+    {
+        return OS_ERROR;
+    }
+
+    ret = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#ifdef __linux__
+    /* a process that dies holding the semaphore does not block the others for good */
+    if ( ret == 0 )
+    {
+        ret = pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    }
+#endif
+    if ( ret == 0 )
+    {
+        ret = pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    }
+    if ( ret == 0 )
+    {
+        ret = pthread_mutex_init(&header->mutex, &attr);
+    }
+
+    pthread_mutexattr_destroy(&attr);
+
+    if ( ret != 0 )
+    {
+        return OS_ERROR;
+    }
+
+    header->size = nbytes;
+    __atomic_store_n(&header->magic, OS_SHMEM_MAGIC, __ATOMIC_RELEASE);
+
+    return OS_SUCCESS;
+}
+
+/*
+** Creates and maps a segment of nbytes in the hugetlbfs file system. Returns
+** OS_ERR_NAME_TAKEN if it is there already, and OS_ERROR if it cannot be made
+** with huge pages.
+*/
+static int32 OS_ShMemCreateHuge(OS_shmem_record_t *shmem, const char *huge_path, uint32 nbytes)
+{
+#ifdef __linux__
+    int            fd;
+    struct statfs  fs;
+    size_t         map_size;
+    void          *addr;
+
+    fd = open(huge_path, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if ( fd < 0 )
+    {
+        return((errno == EEXIST) ? OS_ERR_NAME_TAKEN : OS_ERROR);
+    }
+
+    /* the size of a hugetlbfs file is a multiple of its huge page size */
+    addr     = MAP_FAILED;
+    map_size = 0;
+    if ( fstatfs(fd, &fs) == 0 && fs.f_bsize > 0 )
+    {
+        map_size = OS_SHMEM_DATA_OFFSET + nbytes;
+        map_size = ((map_size + fs.f_bsize - 1) / fs.f_bsize) * fs.f_bsize;
+
+        if ( ftruncate(fd, map_size) == 0 )
+        {
+            addr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+    }
+    close(fd);
+
+    if ( addr == MAP_FAILED )
+    {
+        unlink(huge_path);
+        return OS_ERROR;
+    }
+
+    shmem->header   = addr;
+    shmem->map_size = map_size;
+    shmem->huge     = TRUE;
+
+    return OS_SUCCESS;
+#else
+    return OS_ERROR;
+#endif
+}
+
+/*
+** Creates and maps a segment of nbytes in /dev/shm. Returns OS_ERR_NAME_TAKEN
+** if it is there already.
+*/
+static int32 OS_ShMemCreateShm(OS_shmem_record_t *shmem, const char *shm_name, uint32 nbytes,
+                               uint32 flags)
+{
+    int     fd;
+    long    page_size;
+    size_t  map_size;
+    void   *addr;
+
+    fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if ( fd < 0 )
+    {
+        return((errno == EEXIST) ? OS_ERR_NAME_TAKEN : OS_ERROR);
+    }
+
+    page_size = sysconf(_SC_PAGESIZE);
+    map_size  = OS_SHMEM_DATA_OFFSET + nbytes;
+    map_size  = ((map_size + page_size - 1) / page_size) * page_size;
+
+    addr = MAP_FAILED;
+    if ( ftruncate(fd, map_size) == 0 )
+    {
+        addr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if ( addr == MAP_FAILED )
+    {
+        shm_unlink(shm_name);
+        return OS_ERROR;
+    }
+
+#ifdef MADV_HUGEPAGE
+    /* only advice, the kernel may not back shared memory with huge pages */
+    if ( (flags & OS_SHMEM_HUGE_PAGES) != 0 )
+    {
+        madvise(addr, map_size, MADV_HUGEPAGE);
+    }
+#endif
+
+    shmem->header   = addr;
+    shmem->map_size = map_size;
+    shmem->huge     = FALSE;
+
+    return OS_SUCCESS;
+}
+
+/*
+** Maps the segment another process created under shm_name, or huge_path when
+** it has huge pages. Returns OS_ERR_NAME_NOT_FOUND if there is neither.
+*/
+static int32 OS_ShMemOpen(OS_shmem_record_t *shmem, const char *shm_name, const char *huge_path)
+{
+    int          fd;
+    int          huge;
+    int          tries;
+    struct stat  st;
+    void        *addr;
+
+    huge = FALSE;
+    fd   = shm_open(shm_name, O_RDWR, 0);
+#ifdef __linux__
+    if ( fd < 0 && errno == ENOENT )
+    {
+        huge = TRUE;
+        fd   = open(huge_path, O_RDWR);
+    }
+#endif
+    if ( fd < 0 )
+    {
+        return((errno == ENOENT) ? OS_ERR_NAME_NOT_FOUND : OS_ERROR);
+    }
+
+    /* the creator may not have sized the segment yet */
+    for ( tries = 0; ; tries++ )
+    {
+        if ( fstat(fd, &st) != 0 || tries == OS_SHMEM_OPEN_TRIES )
+        {
+            close(fd);
+            return OS_ERROR;
+        }
+        if ( st.st_size >= (off_t)OS_SHMEM_DATA_OFFSET )
+        {
+            break;
+        }
+        usleep(1000);
+    }
+
+    addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if ( addr == MAP_FAILED )
+    {
+        return OS_ERROR;
+    }
+
+    /* nor set up its semaphore */
+    for ( tries = 0;
+          __atomic_load_n(&((OS_shmem_header_t *)addr)->magic, __ATOMIC_ACQUIRE) != OS_SHMEM_MAGIC;
+          tries++ )
+    {
+        if ( tries == OS_SHMEM_OPEN_TRIES )
+        {
+            munmap(addr, st.st_size);
+            return OS_ERROR;
+        }
+        usleep(1000);
+    }
+
+    shmem->header   = addr;
+    shmem->map_size = st.st_size;
+    shmem->huge     = huge;
+
+    return OS_SUCCESS;
+}
+
+/*
+** Unmaps a segment, and removes its name when remove is TRUE
+*/
+static int32 OS_ShMemUnmap(OS_shmem_record_t *shmem, int remove)
+{
+    char   shm_name[OS_MAX_API_NAME + sizeof(OS_SHMEM_PREFIX)];
+    char   huge_path[OS_MAX_API_NAME + sizeof(OS_SHMEM_PREFIX) + sizeof(OS_SHMEM_HUGETLB_DIR)];
+    int32  return_code = OS_SUCCESS;
+
+    if ( munmap(shmem->header, shmem->map_size) != 0 )
+    {
+        return_code = OS_ERROR;
+    }
+
+    if ( remove )
+    {
+        OS_ShMemNames(shmem->name, shm_name, huge_path);
+        if ( (shmem->huge ? unlink(huge_path) : shm_unlink(shm_name)) != 0 )
+        {
+            return_code = OS_ERROR;
+        }
+    }
+
+    return return_code;
+}
+
+/****************************************************************************************
+                                  SHARED MEMORY API
+****************************************************************************************/
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ShMemInit
+
+   Purpose: Initialize the table of shared memory segments
+
+   Returns: OS_ERROR if the table cannot be set up
+            OS_SUCCESS if success
+
+   Notes: OS_API_Init calls it, calling it again does nothing
+---------------------------------------------------------------------------------------*/
+int32 OS_ShMemInit (void)
+{
+    uint32 max_segments;
+
+    if ( OS_shmem_initialized )
+    {
+        return OS_SUCCESS;
+    }
+
+    max_segments = OS_api_config.max_shmem_segments;
+    if ( max_segments == 0 )
+    {
+        max_segments = OS_MAX_SHMEM_SEGMENTS;
+    }
+
+    if ( OS_ObjectTableInit(&OS_shmem_table, sizeof(OS_shmem_record_t),
+                            max_segments, OS_ShMemInitRecord) != OS_SUCCESS )
+    {
+        return OS_ERROR;
+    }
+
+    if ( pthread_mutex_init(&OS_shmem_table_mut, NULL) != 0 )
+    {
+        return OS_ERROR;
+    }
+
+    OS_shmem_initialized = TRUE;
+
+    return OS_SUCCESS;
+
+}/* end OS_ShMemInit */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ShMemCreate
+
+   Purpose: Create a shared memory segment of NBytes which the other processes
+            can find by its name
+
+   Returns: see OS_ShMemCreateEx
+---------------------------------------------------------------------------------------*/
+int32 OS_ShMemCreate (uint32 *Id, uint32 NBytes, char* SegName)
+{
+    return(OS_ShMemCreateEx(Id, NBytes, SegName, 0));
+
+}/* end OS_ShMemCreate */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ShMemCreateEx
+
+   Purpose: Create a shared memory segment of NBytes which the other processes
+            can find by its name
+
+   Returns: OS_INVALID_POINTER if a pointer passed in is NULL
+            OS_ERR_NAME_TOO_LONG if the name passed in is too long
+            OS_ERR_NO_FREE_IDS if there are already the max segments created
+            OS_ERR_NAME_TAKEN if the name is already used by a segment of this or
+                              another process
+            OS_ERROR if the OS calls to make the segment fail
+            OS_SUCCESS if success
+
+   Notes: flags may be OS_SHMEM_HUGE_PAGES, which keeps the segment in the
+          hugetlbfs file system at OS_SHMEM_HUGETLB_DIR. When there are no huge
+          pages to be had the segment is made as usual, and the kernel is asked
+          to back it with transparent huge pages.
+          The segment lasts until the process that created it deletes it, even
+          after that process exits.
+---------------------------------------------------------------------------------------*/
+int32 OS_ShMemCreateEx (uint32 *Id, uint32 NBytes, const char *SegName, uint32 flags)
+{
+    uint32             possible_id;
+    int32              return_code;
+    OS_shmem_record_t *shmem;
+    char               shm_name[OS_MAX_API_NAME + sizeof(OS_SHMEM_PREFIX)];
+    char               huge_path[OS_MAX_API_NAME + sizeof(OS_SHMEM_PREFIX) + sizeof(OS_SHMEM_HUGETLB_DIR)];
+
+    if ( Id == NULL || SegName == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( strlen(SegName) >= OS_MAX_API_NAME )
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    /* Take a free segment Id, no other task can get it until it is released */
+    if ( OS_ObjectAllocate(&OS_shmem_table, &possible_id) != OS_SUCCESS )
+    {
+        return OS_ERR_NO_FREE_IDS;
+    }
+
+    /* Check to see if the name is already taken, and reserve it */
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_SHMEM, SegName, possible_id);
+    if ( return_code != OS_SUCCESS )
+    {
+        OS_ObjectRelease(&OS_shmem_table, possible_id);
+        return return_code;
+    }
+
+    shmem = OS_SHMEM_RECORD(possible_id);
+    OS_ShMemNames(SegName, shm_name, huge_path);
+
+    return_code = OS_ERROR;
+    if ( (flags & OS_SHMEM_HUGE_PAGES) != 0 )
+    {
+        return_code = OS_ShMemCreateHuge(shmem, huge_path, NBytes);
+    }
+    if ( return_code == OS_ERROR )
+    {
+        return_code = OS_ShMemCreateShm(shmem, shm_name, NBytes, flags);
+    }
+
+    if ( return_code == OS_SUCCESS )
+    {
+        return_code = OS_ShMemInitHeader(shmem->header, NBytes);
+        if ( return_code != OS_SUCCESS )
+        {
+            strcpy(shmem->name, SegName);
+            OS_ShMemUnmap(shmem, TRUE);
+        }
+    }
+
+    if ( return_code != OS_SUCCESS )
+    {
+        pthread_mutex_lock(&OS_shmem_table_mut);
+        OS_NameIndexRemove(OS_OBJECT_TYPE_SHMEM, SegName);
+        strcpy(shmem->name, "");
+        shmem->header = NULL;
+        pthread_mutex_unlock(&OS_shmem_table_mut);
+        OS_ObjectRelease(&OS_shmem_table, possible_id);
+
+        return return_code;
+    }
+
+    *Id = possible_id;
+
+    pthread_mutex_lock(&OS_shmem_table_mut);
+
+    shmem->owner   = TRUE;
+    shmem->free    = FALSE;
+    strcpy(shmem->name, SegName);
+    shmem->creator = OS_FindCreator();
+
+    pthread_mutex_unlock(&OS_shmem_table_mut);
+
+    return OS_SUCCESS;
+
+}/* end OS_ShMemCreateEx */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ShMemDelete
+
+   Purpose: Unmap a shared memory segment from this process
+
+   Returns: OS_ERR_INVALID_ID if the id passed in is not a segment
+            OS_ERROR if the OS calls to unmap or remove the segment fail
+            OS_SUCCESS if success
+
+   Notes: When this process created the segment its name is removed, so no other
+          process can find it any more. The processes that have it mapped keep
+          the memory until they delete it too.
+---------------------------------------------------------------------------------------*/
+int32 OS_ShMemDelete (uint32 Id)
+{
+    OS_shmem_record_t *shmem;
+    int32              return_code;
+
+    if ( !OS_ShMemValidId(Id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    shmem = OS_SHMEM_RECORD(Id);
+
+    return_code = OS_ShMemUnmap(shmem, shmem->owner);
+
+    pthread_mutex_lock(&OS_shmem_table_mut);
+
+    OS_NameIndexRemove(OS_OBJECT_TYPE_SHMEM, shmem->name);
+    shmem->free     = TRUE;
+    strcpy(shmem->name, "");
+    shmem->creator  = UNINITIALIZED;
+    shmem->header   = NULL;
+    shmem->map_size = 0;
+
+    pthread_mutex_unlock(&OS_shmem_table_mut);
+
+    OS_ObjectRelease(&OS_shmem_table, Id);
+
+    return return_code;
+
+}/* end OS_ShMemDelete */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ShMemSemTake
+
+   Purpose: Take the semaphore of a shared memory segment, waiting for the task of
+            any process that holds it
+
+   Returns: OS_ERR_INVALID_ID if the id passed in is not a segment
+            OS_SEM_FAILURE if the semaphore cannot be taken
+            OS_SUCCESS if success
+
+   Notes: When a process died holding the semaphore it is handed on to the caller,
+          who should check that the data it guarded is consistent.
+---------------------------------------------------------------------------------------*/
+int32 OS_ShMemSemTake (uint32 Id)
+{
+    int ret;
+
+    if ( !OS_ShMemValidId(Id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    ret = pthread_mutex_lock(&OS_SHMEM_RECORD(Id)->header->mutex);
+#ifdef __linux__
+    if ( ret == EOWNERDEAD )
+    {
+        ret = pthread_mutex_consistent(&OS_SHMEM_RECORD(Id)->header->mutex);
+    }
+#endif
+
+    return((ret == 0) ? OS_SUCCESS : OS_SEM_FAILURE);
+
+}/* end OS_ShMemSemTake */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ShMemSemGive
+
+   Purpose: Give back the semaphore of a shared memory segment
+
+   Returns: OS_ERR_INVALID_ID if the id passed in is not a segment
+            OS_SEM_FAILURE if the calling task does not hold the semaphore
+            OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_ShMemSemGive (uint32 Id)
+{
+    if ( !OS_ShMemValidId(Id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    if ( pthread_mutex_unlock(&OS_SHMEM_RECORD(Id)->header->mutex) != 0 )
+    {
+        return OS_SEM_FAILURE;
+    }
+
+    return OS_SUCCESS;
+
+}/* end OS_ShMemSemGive */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ShMemAttach
+
+   Purpose: Pass back the address of the data of a shared memory segment in this
+            process
+
+   Returns: OS_INVALID_POINTER if Address is NULL
+            OS_ERR_INVALID_ID if the id passed in is not a segment
+            OS_SUCCESS if success
+
+   Notes: The address is a cpuaddr, which holds a pointer on 64-bit systems too.
+          The data starts on a cache line, and each process may see it at a
+          different address.
+---------------------------------------------------------------------------------------*/
+int32 OS_ShMemAttach (cpuaddr * Address, uint32 Id)
+{
+    if ( Address == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( !OS_ShMemValidId(Id) )
+    {
+        return OS_ERR_INVALID_ID;
+    }
+
+    *Address = (cpuaddr)((char *)OS_SHMEM_RECORD(Id)->header + OS_SHMEM_DATA_OFFSET);
+
+    return OS_SUCCESS;
+
+}/* end OS_ShMemAttach */
+
+/*---------------------------------------------------------------------------------------
+   Name: OS_ShMemGetIdByName
+
+   Purpose: Find the id of a shared memory segment by its name. A segment another
+            process created is mapped into this one the first time it is found.
+
+   Returns: OS_INVALID_POINTER if a pointer passed in is NULL
+            OS_ERR_NAME_TOO_LONG if the name passed in is too long
+            OS_ERR_NAME_NOT_FOUND if no process has created a segment of that name
+            OS_ERR_NO_FREE_IDS if the segment is new to this process and there are
+                               already the max segments here
+            OS_ERROR if the OS calls to map the segment fail
+            OS_SUCCESS if success
+---------------------------------------------------------------------------------------*/
+int32 OS_ShMemGetIdByName (uint32 *ShMemId, const char *SegName)
+{
+    uint32             i;
+    int32              return_code;
+    OS_shmem_record_t *shmem;
+    char               shm_name[OS_MAX_API_NAME + sizeof(OS_SHMEM_PREFIX)];
+    char               huge_path[OS_MAX_API_NAME + sizeof(OS_SHMEM_PREFIX) + sizeof(OS_SHMEM_HUGETLB_DIR)];
+
+    if ( ShMemId == NULL || SegName == NULL )
+    {
+        return OS_INVALID_POINTER;
+    }
+
+    if ( strlen(SegName) >= OS_MAX_API_NAME )
+    {
+        return OS_ERR_NAME_TOO_LONG;
+    }
+
+    if ( (OS_NameIndexFind(OS_OBJECT_TYPE_SHMEM, SegName, &i) == OS_SUCCESS) &&
+         (OS_SHMEM_RECORD(i)->free != TRUE) &&
+         (strcmp(OS_SHMEM_RECORD(i)->name, SegName) == 0) )
+    {
+        *ShMemId = i;
+        return OS_SUCCESS;
+    }
+
+    /* Not known here, look for a segment created by another process */
+    if ( OS_ObjectAllocate(&OS_shmem_table, &i) != OS_SUCCESS )
+    {
+        return OS_ERR_NO_FREE_IDS;
+    }
+
+    return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_SHMEM, SegName, i);
+    if ( return_code != OS_SUCCESS )
+    {
+        /* another task of this process got there first */
+        OS_ObjectRelease(&OS_shmem_table, i);
+        return((return_code == OS_ERR_NAME_TAKEN) ? OS_ShMemGetIdByName(ShMemId, SegName)
+                                                  : return_code);
+    }
+
+    shmem = OS_SHMEM_RECORD(i);
+    OS_ShMemNames(SegName, shm_name, huge_path);
+
+    return_code = OS_ShMemOpen(shmem, shm_name, huge_path);
+    if ( return_code != OS_SUCCESS )
+    {
+        pthread_mutex_lock(&OS_shmem_table_mut);
+        OS_NameIndexRemove(OS_OBJECT_TYPE_SHMEM, SegName);
+        pthread_mutex_unlock(&OS_shmem_table_mut);
+        OS_ObjectRelease(&OS_shmem_table, i);
+
+        return return_code;
+    }
+
+    *ShMemId = i;
+
+    pthread_mutex_lock(&OS_shmem_table_mut);
+
+    shmem->owner   = FALSE;
+    shmem->free    = FALSE;
+    strcpy(shmem->name, SegName);
+    shmem->creator = OS_FindCreator();
+
+    pthread_mutex_unlock(&OS_shmem_table_mut);
+
+    return OS_SUCCESS;
+
+}/* end OS_ShMemGetIdByName */
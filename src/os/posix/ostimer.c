@@ -13,9 +13,10 @@
 **
 ** Purpose: This file contains the OSAL Timer API for POSIX systems.
 **            
-**          This implementation depends on the POSIX Timer API which may not be available
-**          in older versions of the Linux kernel. It was developed and tested on
-**          RHEL 5 ./ CentOS 5 with Linux kernel 2.6.18
+**          Each timer is a Linux timerfd. A dispatch thread waits on all of
+**          them with epoll and calls the callbacks of the ones that expire, so
+**          the callbacks run in an ordinary thread, one at a time, and the
+**          number of timers is not limited by the number of signals.
 */
 
 /****************************************************************************************
@@ -31,15 +32,20 @@
 #include <stdio.h>
 #include <limits.h>
 #include <time.h>
-#include <sys/signal.h>
-#include <sys/errno.h>
+#include <errno.h>
 #include <pthread.h>
-#include "osmac_stuff.h"
+#include <sched.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "osobject.h"
 /****************************************************************************************
                                 EXTERNAL FUNCTION PROTOTYPES
 ****************************************************************************************/
 
 uint32 OS_FindCreator(void);
+int32  OS_PriorityRemap(uint32 InputPri);
 
 /****************************************************************************************
                                 INTERNAL FUNCTION PROTOTYPES
@@ -47,17 +53,21 @@ uint32 OS_FindCreator(void);
 
 void  OS_TimespecToUsec(struct timespec time_spec, uint32 *usecs);
 void  OS_UsecToTimespec(uint32 usecs, struct timespec *time_spec);
+int32 OS_TimerGetWaitFd(uint32 timer_id, int *fd);
 
 /****************************************************************************************
                                      DEFINES
 ****************************************************************************************/
 
 /*
-** The timers use the RT Signals. The system that this code was developed
-** and tested on has 32 available RT signals ( SIGRTMIN -> SIGRTMAX ).
-** OS_MAX_TIMERS should not be set to more than this number.
+** Expired timers the dispatch thread takes from epoll at once
 */
-#define OS_STARTING_SIGNAL  (SIGRTMAX-1)
+#define OS_TIMER_EVENTS  64
+
+/*
+** Value of OS_timer_running while no callback is running
+*/
+#define OS_TIMER_NONE    0xFFFFFFFF
 
 /*
 ** Since the API is storing the timer values in a 32 bit integer as Microseconds, 
@@ -80,7 +90,8 @@ typedef struct
    uint32              interval_time;
    uint32              accuracy;
    OS_TimerCallback_t  callback_ptr;
-   uint32              host_timerid;
+   int                 timer_fd;
+   volatile int        wait_fd;
 
 } OS_timer_record_t;
 
@@ -88,20 +99,40 @@ typedef struct
                                    GLOBAL DATA
 ****************************************************************************************/
 
-OS_timer_record_t OS_timer_table[OS_MAX_TIMERS];
+OS_object_table_t OS_timer_table;
 uint32           os_clock_accuracy;
 
+#define OS_TIMER_RECORD(id) ((OS_timer_record_t *)OS_ObjectRecord(&OS_timer_table, id))
+
 /*
 ** The Mutex for protecting the above table
 */
 pthread_mutex_t    OS_timer_table_mut;
 
+/*
+** The dispatch thread, the epoll set of the timers it waits on, and the timer
+** whose callback it is running, or OS_TIMER_NONE. OS_timer_done_cond is
+** signalled when a callback returns. OS_timer_release_running is set when
+** that callback deletes its own timer, whose id the dispatch thread then
+** releases once it is done with it.
+*/
+static pthread_t       OS_timer_thread;
+static int             OS_timer_epoll_fd = -1;
+static uint32          OS_timer_running = OS_TIMER_NONE;
+static int             OS_timer_release_running = FALSE;
+static pthread_cond_t  OS_timer_done_cond;
+
+void  *OS_TimerDispatch(void *arg);
+
 /****************************************************************************************
                                 INITIALIZATION FUNCTION
 ****************************************************************************************/
+void   OS_TimerInitRecord(void *record);
+int32  OS_TimerStartDispatch(void);
+
 int32  OS_TimerAPIInit ( void )
 {
-   int    i;   
+   uint32 max_timers;   
    int    status;
    struct timespec clock_resolution;
    int32  return_code = OS_SUCCESS;
@@ -109,18 +140,18 @@ int32  OS_TimerAPIInit ( void )
    /*
    ** Mark all timers as available
    */
-   for ( i = 0; i < OS_MAX_TIMERS; i++ )
+   max_timers = OS_api_config.max_timers;
+   if ( OS_ObjectTableInit(&OS_timer_table, sizeof(OS_timer_record_t),
+                           max_timers, OS_TimerInitRecord) != OS_SUCCESS )
    {
-      OS_timer_table[i].free      = TRUE;
-      OS_timer_table[i].creator   = UNINITIALIZED;
-      strcpy(OS_timer_table[i].name,"");
-
+      OS_printf("OS_TimerAPIInit: Error allocating the timer table\n");
+      return(OS_ERROR);
    }
 
    /*
    ** get the resolution of the realtime clock
    */
-   status = clock_getres(CLOCK_REALTIME, &clock_resolution);
+   status = clock_getres(CLOCK_MONOTONIC, &clock_resolution);
    if ( status < 0 )
    {
       OS_printf("OS_TimerAPIInit: Error calling clock_getres\n");
@@ -137,12 +168,17 @@ int32  OS_TimerAPIInit ( void )
       ** Create the Timer Table mutex
       */
       status = pthread_mutex_init((pthread_mutex_t *) & OS_timer_table_mut,NULL); 
-      if ( status < 0 )
+      if ( status != 0 || pthread_cond_init(&OS_timer_done_cond, NULL) != 0 )
       {
          OS_printf("OS_TimerAPIInit: Error calling pthread_mutex_init\n");
          return_code = OS_ERROR;
       }
    }
+
+   if ( return_code == OS_SUCCESS )
+   {
+      return_code = OS_TimerStartDispatch();
+   }
    return(return_code);
 
 }
@@ -152,24 +188,171 @@ int32  OS_TimerAPIInit ( void )
 ****************************************************************************************/
 
 /*
-** Timer Signal Handler.
-** The purpose of this function is to convert the POSIX signal number to the 
-** OSAL signal number and pass it to the User defined signal handler.
+** Marks a new timer table record as available
+*/
+void OS_TimerInitRecord(void *record)
+{
+   OS_timer_record_t *timer = record;
+
+   timer->free      = TRUE;
+   timer->creator   = UNINITIALIZED;
+   timer->timer_fd  = -1;
+   timer->wait_fd   = -1;
+   strcpy(timer->name,"");
+}
+
+/*
+** Returns the descriptor that becomes readable when the timer expires, for
+** OS_WaitAny. It is created the first time a task waits on the timer.
+*/
+int32 OS_TimerGetWaitFd(uint32 timer_id, int *fd)
+{
+   if (timer_id >= OS_timer_table.num_records || OS_TIMER_RECORD(timer_id)->free == TRUE)
+   {
+      return OS_ERR_INVALID_ID;
+   }
+
+   pthread_mutex_lock(&OS_timer_table_mut);
+   if ( OS_TIMER_RECORD(timer_id)->wait_fd < 0 )
+   {
+      OS_TIMER_RECORD(timer_id)->wait_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   }
+   *fd = OS_TIMER_RECORD(timer_id)->wait_fd;
+   pthread_mutex_unlock(&OS_timer_table_mut);
+
+   if ( *fd < 0 )
+   {
+      return OS_TIMER_ERR_INTERNAL;
+   }
+
+   return OS_SUCCESS;
+}
+
+/*
+** Creates the epoll set of the timers and the thread that dispatches them, at
+** OS_TIMER_THREAD_PRIORITY
 */
-void OS_TimerSignalHandler(int signum)
+int32 OS_TimerStartDispatch(void)
 {
-   uint32  timer_id;
+   pthread_attr_t      attr;
+   struct sched_param  priority_holder;
+   int                 status;
+
+   OS_timer_running  = OS_TIMER_NONE;
+   OS_timer_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+   if ( OS_timer_epoll_fd < 0 )
+   {
+      OS_printf("OS_TimerAPIInit: Error creating the epoll set of the timers\n");
+      return(OS_ERROR);
+   }
+
+   memset(&priority_holder, 0, sizeof(priority_holder));
+   priority_holder.sched_priority = OS_PriorityRemap(OS_TIMER_THREAD_PRIORITY);
+
+   pthread_attr_init(&attr);
+   pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+   pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+   pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+   pthread_attr_setschedparam(&attr, &priority_holder);
+
+   status = pthread_create(&OS_timer_thread, &attr, OS_TimerDispatch, NULL);
+   if ( status == EPERM )
+   {
+      /*
+      ** Without the privilege to use SCHED_FIFO, run the thread with the
+      ** policy and priority of its creator, as the tasks do
+      */
+      pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+      status = pthread_create(&OS_timer_thread, &attr, OS_TimerDispatch, NULL);
+   }
+   pthread_attr_destroy(&attr);
+
+   if ( status != 0 )
+   {
+      OS_printf("OS_TimerAPIInit: Error creating the timer dispatch thread\n");
+      close(OS_timer_epoll_fd);
+      OS_timer_epoll_fd = -1;
+      return(OS_ERROR);
+   }
 
-   timer_id = OS_STARTING_SIGNAL - signum;
+   return(OS_SUCCESS);
+}
 
-   if ( timer_id  < OS_MAX_TIMERS )
+/*
+** Timer Dispatch Thread.
+** Waits for timers to expire and calls the callback of each one once for
+** every expiration, then wakes up the tasks waiting on it in OS_WaitAny.
+** A timer that is deleted after it expired is skipped, its descriptor is
+** closed or, once it is reused, has nothing to read.
+*/
+void *OS_TimerDispatch(void *arg)
+{
+   struct epoll_event  events[OS_TIMER_EVENTS];
+   OS_TimerCallback_t  callback;
+   uint64_t            expired;
+   uint64_t            one = 1;
+   uint32              timer_id;
+   int                 wait_fd;
+   int                 release;
+   int                 count;
+   int                 i;
+
+   for ( ;; )
    {
-      if ( OS_timer_table[timer_id].free == FALSE )
+      count = epoll_wait(OS_timer_epoll_fd, events, OS_TIMER_EVENTS, -1);
+      if ( count < 0 )
       {
-         (OS_timer_table[timer_id].callback_ptr)(timer_id);
+         continue;
+      }
+
+      for ( i = 0; i < count; i++ )
+      {
+         timer_id = events[i].data.u32;
+
+         pthread_mutex_lock(&OS_timer_table_mut);
+         if ( timer_id >= OS_timer_table.num_records ||
+              OS_TIMER_RECORD(timer_id)->free == TRUE ||
+              OS_TIMER_RECORD(timer_id)->timer_fd < 0 ||
+              read(OS_TIMER_RECORD(timer_id)->timer_fd, &expired, sizeof(expired)) != sizeof(expired) )
+         {
+            pthread_mutex_unlock(&OS_timer_table_mut);
+            continue;
+         }
+         callback = OS_TIMER_RECORD(timer_id)->callback_ptr;
+         OS_timer_running = timer_id;
+         pthread_mutex_unlock(&OS_timer_table_mut);
+
+         /*
+         ** The callback may delete its own timer. The id is not released
+         ** until the end of this event, so no new timer can take it meanwhile.
+         */
+         for ( ; expired > 0 && OS_TIMER_RECORD(timer_id)->free == FALSE; expired-- )
+         {
+            callback(timer_id);
+         }
+
+         /* Wake up the tasks waiting on the timer in OS_WaitAny */
+         pthread_mutex_lock(&OS_timer_table_mut);
+         wait_fd = OS_TIMER_RECORD(timer_id)->wait_fd;
+         if ( OS_TIMER_RECORD(timer_id)->free == FALSE && wait_fd >= 0 &&
+              write(wait_fd, &one, sizeof(one)) < 0 )
+         {
+            /* the count is saturated, the waiter will see it anyway */
+         }
+         release = OS_timer_release_running;
+         OS_timer_release_running = FALSE;
+         OS_timer_running = OS_TIMER_NONE;
+         pthread_cond_broadcast(&OS_timer_done_cond);
+         pthread_mutex_unlock(&OS_timer_table_mut);
+
+         if ( release )
+         {
+            OS_ObjectRelease(&OS_timer_table, timer_id);
+         }
       }
    }
 
+   return(arg);
 }
  
 /******************************************************************************
@@ -238,11 +421,10 @@ void  OS_TimespecToUsec(struct timespec time_spec, uint32 *usecs)
 int32 OS_TimerCreate(uint32 *timer_id, const char *timer_name, uint32 *clock_accuracy, OS_TimerCallback_t  callback_ptr)
 {
    uint32             possible_tid;
-   int32              i;
+   int32              return_code;
 
-   int                status;
-   struct  sigaction  sig_act;
-   struct  sigevent   evp;
+   int                timer_fd;
+   struct epoll_event event;
 
    if ( timer_id == NULL || timer_name == NULL)
    {
@@ -253,91 +435,75 @@ int32 OS_TimerCreate(uint32 *timer_id, const char *timer_name, uint32 *clock_acc
    ** we don't want to allow names too long
    ** if truncated, two names might be the same 
    */
-   if (strlen(timer_name) > OS_MAX_API_NAME)
+   if (strlen(timer_name) >= OS_MAX_API_NAME)
    {
       return OS_ERR_NAME_TOO_LONG;
    }
 
-   /* 
-   ** Check Parameters 
+   /*
+   ** Verify callback parameter
    */
-   pthread_mutex_lock(&OS_timer_table_mut); 
-    
-   for(possible_tid = 0; possible_tid < OS_MAX_TIMERS; possible_tid++)
-   {
-      if (OS_timer_table[possible_tid].free == TRUE)
-         break;
-   }
-
-
-   if( possible_tid >= OS_MAX_TIMERS || OS_timer_table[possible_tid].free != TRUE)
+   if (callback_ptr == NULL ) 
    {
-        pthread_mutex_unlock(&OS_timer_table_mut);
-        return OS_ERR_NO_FREE_IDS;
-   }
+      return OS_TIMER_ERR_INVALID_ARGS;
+   }    
 
    /* 
-   ** Check to see if the name is already taken 
+   ** Take a free timer Id, no other task can get it until it is released 
    */
-   for (i = 0; i < OS_MAX_TIMERS; i++)
+   if ( OS_ObjectAllocate(&OS_timer_table, &possible_tid) != OS_SUCCESS )
    {
-       if ((OS_timer_table[i].free == FALSE) &&
-            strcmp ((char*) timer_name, OS_timer_table[i].name) == 0)
-       {
-            pthread_mutex_unlock(&OS_timer_table_mut);
-            return OS_ERR_NAME_TAKEN;
-       }
+      return OS_ERR_NO_FREE_IDS;
    }
 
-   /*
-   ** Verify callback parameter
+   /* 
+   ** Check to see if the name is already taken, and reserve it 
    */
-   if (callback_ptr == NULL ) 
+   return_code = OS_NameIndexAdd(OS_OBJECT_TYPE_TIMER, timer_name, possible_tid);
+   if ( return_code != OS_SUCCESS )
    {
-      pthread_mutex_unlock(&OS_timer_table_mut);
-      return OS_TIMER_ERR_INVALID_ARGS;
-   }    
+      OS_ObjectRelease(&OS_timer_table, possible_tid);
+      return return_code;
+   }
 
-   /* 
-   ** Set the possible timer Id to not free so that
-   ** no other task can try to use it 
-   */
-   OS_timer_table[possible_tid].free = FALSE;
+   pthread_mutex_lock(&OS_timer_table_mut); 
+   OS_TIMER_RECORD(possible_tid)->free = FALSE;
+   strcpy(OS_TIMER_RECORD(possible_tid)->name, (char*) timer_name);
    pthread_mutex_unlock(&OS_timer_table_mut);
-   OS_timer_table[possible_tid].creator = OS_FindCreator();
+   OS_TIMER_RECORD(possible_tid)->creator = OS_FindCreator();
 
 
-   OS_timer_table[possible_tid].start_time = 0;
-   OS_timer_table[possible_tid].interval_time = 0;
+   OS_TIMER_RECORD(possible_tid)->start_time = 0;
+   OS_TIMER_RECORD(possible_tid)->interval_time = 0;
     
-   OS_timer_table[possible_tid].callback_ptr = callback_ptr;
+   OS_TIMER_RECORD(possible_tid)->callback_ptr = callback_ptr;
 
    /*
-   **  Initialize the sigaction and sigevent structures for the handler.
+   ** Create the timer, disarmed, and add it to the ones the dispatch thread
+   ** waits on
    */
-   memset((void *)&sig_act, 0, sizeof(sig_act));
-   sigemptyset(&sig_act.sa_mask);
-   sig_act.sa_handler = OS_TimerSignalHandler;
-   sig_act.sa_flags = 0;
-
-   memset((void *)&evp, 0, sizeof(evp));
-   evp.sigev_notify = SIGEV_SIGNAL; 
-   evp.sigev_signo = OS_STARTING_SIGNAL - possible_tid;
+   memset(&event, 0, sizeof(event));
+   event.events   = EPOLLIN;
+   event.data.u32 = possible_tid;
 
-   /*
-   ** Create the timer
-   */
-   status = timer_create(CLOCK_REALTIME, &evp, (timer_t *)&(OS_timer_table[possible_tid].host_timerid));
-   if (status < 0) 
+   timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+   if ( timer_fd >= 0 && epoll_ctl(OS_timer_epoll_fd, EPOLL_CTL_ADD, timer_fd, &event) < 0 )
+   {
+      close(timer_fd);
+      timer_fd = -1;
+   }
+   if (timer_fd < 0) 
    {
-      OS_timer_table[possible_tid].free = TRUE;
+      pthread_mutex_lock(&OS_timer_table_mut); 
+      OS_NameIndexRemove(OS_OBJECT_TYPE_TIMER, timer_name);
+      strcpy(OS_TIMER_RECORD(possible_tid)->name, "");
+      OS_TIMER_RECORD(possible_tid)->free = TRUE;
+      pthread_mutex_unlock(&OS_timer_table_mut);
+      OS_ObjectRelease(&OS_timer_table, possible_tid);
       return ( OS_TIMER_ERR_UNAVAILABLE);
    }
    
-   /*
-   ** Set the signal action for the timer
-   */
-   sigaction(OS_STARTING_SIGNAL - possible_tid, &(sig_act), 0); 
+   OS_TIMER_RECORD(possible_tid)->timer_fd = timer_fd;
 
    /*
    ** Return the clock accuracy to the user
@@ -371,7 +537,7 @@ int32 OS_TimerSet(uint32 timer_id, uint32 start_time, uint32 interval_time)
    /* 
    ** Check to see if the timer_id given is valid 
    */
-   if (timer_id >= OS_MAX_TIMERS || OS_timer_table[timer_id].free == TRUE)
+   if (timer_id >= OS_timer_table.num_records || OS_TIMER_RECORD(timer_id)->free == TRUE)
    {
       return OS_ERR_INVALID_ID;
    }
@@ -392,8 +558,8 @@ int32 OS_TimerSet(uint32 timer_id, uint32 start_time, uint32 interval_time)
    /*
    ** Save the start and interval times 
    */
-   OS_timer_table[timer_id].start_time = start_time;
-   OS_timer_table[timer_id].interval_time = interval_time;
+   OS_TIMER_RECORD(timer_id)->start_time = start_time;
+   OS_TIMER_RECORD(timer_id)->interval_time = interval_time;
 
    /*
    ** Convert from Microseconds to timespec structures
@@ -404,8 +570,8 @@ int32 OS_TimerSet(uint32 timer_id, uint32 start_time, uint32 interval_time)
    /*
    ** Program the real timer
    */
-   status = timer_settime((timer_t)(OS_timer_table[timer_id].host_timerid), 
-                             0,              /* Flags field can be zero */
+   status = timerfd_settime(OS_TIMER_RECORD(timer_id)->timer_fd, 
+                             0,              /* relative to now */
                              &timeout,       /* struct itimerspec */
 		             NULL);         /* Oldvalue */
    if (status < 0) 
@@ -420,7 +586,9 @@ int32 OS_TimerSet(uint32 timer_id, uint32 start_time, uint32 interval_time)
 /******************************************************************************
 **  Function:  OS_TimerDelete
 **
-**  Purpose: 
+**  Purpose: Delete a timer. Unless it is called from a timer callback, it
+**           returns after a callback of the timer that is running returns,
+**           and the callback is not called again.
 **
 **  Arguments:
 **    (none)
@@ -431,20 +599,59 @@ int32 OS_TimerSet(uint32 timer_id, uint32 start_time, uint32 interval_time)
 int32 OS_TimerDelete(uint32 timer_id)
 {
    int status;
+   int deferred;
 
    /* 
    ** Check to see if the timer_id given is valid 
    */
-   if (timer_id >= OS_MAX_TIMERS || OS_timer_table[timer_id].free == TRUE)
+   if (timer_id >= OS_timer_table.num_records || OS_TIMER_RECORD(timer_id)->free == TRUE)
    {
       return OS_ERR_INVALID_ID;
    }
 
+   pthread_mutex_lock(&OS_timer_table_mut); 
+
    /*
-   ** Delete the timer 
+   ** Wait for a callback of the timer that is running to return. When it
+   ** is the callback deleting its own timer, the dispatch thread releases
+   ** the id after it returns instead.
    */
-   status = timer_delete((timer_t)(OS_timer_table[timer_id].host_timerid));
-   OS_timer_table[timer_id].free = TRUE;
+   deferred = FALSE;
+   if ( pthread_equal(pthread_self(), OS_timer_thread) )
+   {
+      if ( OS_timer_running == timer_id )
+      {
+         deferred = TRUE;
+         OS_timer_release_running = TRUE;
+      }
+   }
+   else
+   {
+      while ( OS_timer_running == timer_id )
+      {
+         pthread_cond_wait(&OS_timer_done_cond, &OS_timer_table_mut);
+      }
+   }
+
+   /*
+   ** Delete the timer, closing it takes it out of the epoll set
+   */
+   status = close(OS_TIMER_RECORD(timer_id)->timer_fd);
+   OS_TIMER_RECORD(timer_id)->timer_fd = -1;
+
+   OS_NameIndexRemove(OS_OBJECT_TYPE_TIMER, OS_TIMER_RECORD(timer_id)->name);
+   strcpy(OS_TIMER_RECORD(timer_id)->name, "");
+   OS_TIMER_RECORD(timer_id)->free = TRUE;
+   if ( OS_TIMER_RECORD(timer_id)->wait_fd >= 0 )
+   {
+      close(OS_TIMER_RECORD(timer_id)->wait_fd);
+      OS_TIMER_RECORD(timer_id)->wait_fd = -1;
+   }
+   pthread_mutex_unlock(&OS_timer_table_mut);
+   if ( !deferred )
+   {
+      OS_ObjectRelease(&OS_timer_table, timer_id);
+   }
    if (status < 0)
    {
       return ( OS_TIMER_ERR_INTERNAL);
@@ -479,19 +686,17 @@ int32 OS_TimerGetIdByName (uint32 *timer_id, const char *timer_name)
     ** a name too long wouldn't have been allowed in the first place
     ** so we definitely won't find a name too long
     */
-    if (strlen(timer_name) > OS_MAX_API_NAME)
+    if (strlen(timer_name) >= OS_MAX_API_NAME)
     {
         return OS_ERR_NAME_TOO_LONG;
     }
 
-    for (i = 0; i < OS_MAX_TIMERS; i++)
+    if ((OS_NameIndexFind(OS_OBJECT_TYPE_TIMER, timer_name, &i) == OS_SUCCESS) &&
+        (OS_TIMER_RECORD(i)->free != TRUE) &&
+        (strcmp (OS_TIMER_RECORD(i)->name , (char*) timer_name) == 0))
     {
-        if (OS_timer_table[i].free != TRUE &&
-                (strcmp (OS_timer_table[i].name , (char*) timer_name) == 0))
-        {
-            *timer_id = i;
-            return OS_SUCCESS;
-        }
+        *timer_id = i;
+        return OS_SUCCESS;
     }
    
     /* 
@@ -517,7 +722,7 @@ int32 OS_TimerGetInfo (uint32 timer_id, OS_timer_prop_t *timer_prop)
     /* 
     ** Check to see that the id given is valid 
     */
-    if (timer_id >= OS_MAX_TIMERS || OS_timer_table[timer_id].free == TRUE)
+    if (timer_id >= OS_timer_table.num_records || OS_TIMER_RECORD(timer_id)->free == TRUE)
     {
        return OS_ERR_INVALID_ID;
     }
@@ -532,11 +737,11 @@ int32 OS_TimerGetInfo (uint32 timer_id, OS_timer_prop_t *timer_prop)
     */
     pthread_mutex_lock(&OS_timer_table_mut);  
 
-    timer_prop ->creator       = OS_timer_table[timer_id].creator;
-    strcpy(timer_prop-> name, OS_timer_table[timer_id].name);
-    timer_prop ->start_time    = OS_timer_table[timer_id].start_time;
-    timer_prop ->interval_time = OS_timer_table[timer_id].interval_time;
-    timer_prop ->accuracy      = OS_timer_table[timer_id].accuracy;
+    timer_prop ->creator       = OS_TIMER_RECORD(timer_id)->creator;
+    strcpy(timer_prop-> name, OS_TIMER_RECORD(timer_id)->name);
+    timer_prop ->start_time    = OS_TIMER_RECORD(timer_id)->start_time;
+    timer_prop ->interval_time = OS_TIMER_RECORD(timer_id)->interval_time;
+    timer_prop ->accuracy      = OS_TIMER_RECORD(timer_id)->accuracy;
     
     pthread_mutex_unlock(&OS_timer_table_mut);
 
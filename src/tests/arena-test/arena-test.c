@@ -0,0 +1,317 @@
+/*
+** Arena Test
+**
+** Allocates from an arena until it is full, and checks the alignment of the
+** allocations, that they do not overlap, and that a reset gives all of the
+** arena back. Checks that the arenas of a task are deleted when it exits or
+** is deleted, then compares a cycle of allocations and a reset with malloc
+** and free.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define CHILD_PRIORITY    80
+
+#define ARENA_SIZE        (64 * 1024)
+#define ALLOC_ALIGN       16
+#define MAX_ALLOCS        1024
+#define FIND_TRIES        100
+#define FIND_DELAY        10
+#define CYCLE_ALLOCS      1000
+#define CYCLE_SIZE        64
+#define NUM_CYCLES        1000
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+uint32 child_stack[TASK_STACK_SIZE];
+uint32 child_id;
+
+uint32 child_sem;
+uint32 errors;
+
+void *allocs[MAX_ALLOCS];
+void *blocks[CYCLE_ALLOCS];
+
+/*
+** Child that creates an arena, then exits or waits to be deleted
+*/
+void exiting_child(void)
+{
+    uint32  arena_id;
+    void   *ptr;
+
+    OS_TaskRegister();
+
+    if ( OS_ArenaCreate(&arena_id, "ChildArena", ARENA_SIZE, 0) != OS_SUCCESS ||
+         OS_ArenaAlloc(arena_id, CYCLE_SIZE, &ptr) != OS_SUCCESS )
+    {
+       errors++;
+    }
+    OS_BinSemGive(child_sem);
+    OS_TaskExit();
+}
+
+void deleted_child(void)
+{
+    uint32 arena_id;
+
+    OS_TaskRegister();
+
+    if ( OS_ArenaCreate(&arena_id, "ChildArena", ARENA_SIZE, 0) != OS_SUCCESS )
+    {
+       errors++;
+    }
+    OS_BinSemGive(child_sem);
+
+    for ( ;; )
+    {
+       OS_TaskDelay(1000);
+    }
+}
+
+/*
+** Waits for the arena of the child to go away with it
+*/
+void check_child_arena(const char *when)
+{
+    uint32 arena_id;
+    int    tries;
+
+    for ( tries = 0; OS_ArenaGetIdByName(&arena_id, "ChildArena") == OS_SUCCESS; tries++ )
+    {
+       if ( tries == FIND_TRIES )
+       {
+          OS_printf("The arena of the child is still there after it %s\n", when);
+          errors++;
+          break;
+       }
+       OS_TaskDelay(FIND_DELAY);
+    }
+}
+
+/*
+** Elapsed nsecs from start to end, per count operations
+*/
+unsigned long nsecs_per(OS_time_t *start, OS_time_t *end, uint32 count)
+{
+    double usecs;
+
+    usecs = (double)(end->seconds - start->seconds) * 1000000.0 +
+            (double)end->microsecs - (double)start->microsecs;
+
+    return((unsigned long)((usecs * 1000.0) / count));
+}
+
+void test_task(void)
+{
+    OS_time_t        start;
+    OS_time_t        end;
+    OS_arena_prop_t  prop;
+    uint32           arena_id;
+    uint32           huge_id;
+    uint32           found_id;
+    uint32           count;
+    uint32           size;
+    uint32           used;
+    void            *first;
+    void            *ptr;
+    uint32           i;
+    uint32           j;
+
+    OS_TaskRegister();
+
+    if ( OS_ArenaCreate(&arena_id, "Arena", ARENA_SIZE, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the arena\n");
+       errors++;
+       OS_TaskExit();
+    }
+
+    if ( OS_ArenaCreate(&found_id, "Arena", ARENA_SIZE, 0) != OS_ERR_NAME_TAKEN ||
+         OS_ArenaCreate(&found_id, "Empty", 0, 0) != OS_QUEUE_INVALID_SIZE ||
+         OS_ArenaGetIdByName(&found_id, "Arena") != OS_SUCCESS || found_id != arena_id ||
+         OS_ArenaAlloc(arena_id, 1, NULL) != OS_INVALID_POINTER )
+    {
+       OS_printf("Bad arena arguments were not rejected\n");
+       errors++;
+    }
+
+    /* sizes that do not keep the next allocation aligned, until it is full */
+    used = 0;
+    for ( count = 0; count < MAX_ALLOCS; count++ )
+    {
+       size = 1 + (count * 37) % 300;
+       if ( OS_ArenaAlloc(arena_id, size, &allocs[count]) != OS_SUCCESS )
+       {
+          break;
+       }
+       if ( ((unsigned long)allocs[count] % ALLOC_ALIGN) != 0 )
+       {
+          OS_printf("Allocation %lu is not aligned\n", (unsigned long)count);
+          errors++;
+       }
+       memset(allocs[count], (int)count, size);
+       used = (char *)allocs[count] + size - (char *)allocs[0];
+    }
+
+    if ( count == MAX_ALLOCS || count == 0 || used > ARENA_SIZE ||
+         used + 300 + ALLOC_ALIGN < ARENA_SIZE )
+    {
+       OS_printf("The arena filled up after %lu allocations of %lu bytes\n",
+                 (unsigned long)count, (unsigned long)used);
+       errors++;
+    }
+
+    for ( i = 0; i < count; i++ )
+    {
+       size = 1 + (i * 37) % 300;
+       for ( j = 0; j < size; j++ )
+       {
+          if ( ((unsigned char *)allocs[i])[j] != (unsigned char)i )
+          {
+             OS_printf("Allocation %lu overlaps another one\n", (unsigned long)i);
+             errors++;
+             break;
+          }
+       }
+    }
+
+    if ( OS_ArenaGetInfo(arena_id, &prop) != OS_SUCCESS || prop.size != ARENA_SIZE ||
+         prop.used != used || prop.failures != 1 )
+    {
+       OS_printf("Wrong arena info when full\n");
+       errors++;
+    }
+
+    /* all of it back at once, from the start */
+    first = allocs[0];
+    if ( OS_ArenaReset(arena_id) != OS_SUCCESS ||
+         OS_ArenaAlloc(arena_id, ARENA_SIZE, &ptr) != OS_SUCCESS || ptr != first ||
+         OS_ArenaReset(arena_id) != OS_SUCCESS )
+    {
+       OS_printf("The reset did not give the arena back\n");
+       errors++;
+    }
+
+    if ( OS_ArenaGetInfo(arena_id, &prop) != OS_SUCCESS || prop.used != 0 ||
+         prop.high_water != ARENA_SIZE )
+    {
+       OS_printf("Wrong arena info after the reset\n");
+       errors++;
+    }
+
+    /* huge pages when the system has some, ordinary ones otherwise */
+    if ( OS_ArenaCreate(&huge_id, "HugeArena", ARENA_SIZE, OS_ARENA_HUGE_PAGES) != OS_SUCCESS ||
+         OS_ArenaAlloc(huge_id, ARENA_SIZE, &ptr) != OS_SUCCESS ||
+         OS_ArenaGetInfo(huge_id, &prop) != OS_SUCCESS )
+    {
+       OS_printf("Error using an arena with huge pages\n");
+       errors++;
+    }
+    else
+    {
+       memset(ptr, 0, ARENA_SIZE);
+       OS_printf("Arena with OS_ARENA_HUGE_PAGES %s huge pages\n",
+                 prop.huge_pages ? "has" : "does not have");
+       OS_ArenaDelete(huge_id);
+    }
+
+    /* the arena of a task goes away with it */
+    if ( OS_BinSemCreate(&child_sem, "ChildSem", 0, 0) != OS_SUCCESS ||
+         OS_TaskCreate(&child_id, "Exiting", exiting_child, child_stack,
+                       TASK_STACK_SIZE, CHILD_PRIORITY, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the exiting child\n");
+       errors++;
+    }
+    OS_BinSemTake(child_sem);
+    check_child_arena("exited");
+
+    if ( OS_TaskCreate(&child_id, "Deleted", deleted_child, child_stack,
+                       TASK_STACK_SIZE, CHILD_PRIORITY, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the deleted child\n");
+       errors++;
+    }
+    OS_BinSemTake(child_sem);
+    if ( OS_ArenaGetIdByName(&found_id, "ChildArena") != OS_SUCCESS )
+    {
+       OS_printf("The arena of the child is missing\n");
+       errors++;
+    }
+    OS_TaskDelete(child_id);
+    check_child_arena("was deleted");
+
+    /* the arena of this task is left alone */
+    if ( OS_ArenaGetIdByName(&found_id, "Arena") != OS_SUCCESS )
+    {
+       OS_printf("The arena of the test task went away with a child\n");
+       errors++;
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_CYCLES; i++ )
+    {
+       for ( j = 0; j < CYCLE_ALLOCS; j++ )
+       {
+          OS_ArenaAlloc(arena_id, CYCLE_SIZE, &blocks[j]);
+       }
+       OS_ArenaReset(arena_id);
+    }
+    OS_GetLocalTime(&end);
+    OS_printf("Cycle of %d arena allocations and a reset: %lu nsecs\n", CYCLE_ALLOCS,
+              nsecs_per(&start, &end, NUM_CYCLES));
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_CYCLES; i++ )
+    {
+       for ( j = 0; j < CYCLE_ALLOCS; j++ )
+       {
+          blocks[j] = malloc(CYCLE_SIZE);
+       }
+       for ( j = 0; j < CYCLE_ALLOCS; j++ )
+       {
+          free(blocks[j]);
+       }
+    }
+    OS_GetLocalTime(&end);
+    OS_printf("Cycle of %d mallocs and frees: %lu nsecs\n", CYCLE_ALLOCS,
+              nsecs_per(&start, &end, NUM_CYCLES));
+
+    if ( OS_ArenaDelete(arena_id) != OS_SUCCESS ||
+         OS_ArenaGetIdByName(&found_id, "Arena") != OS_ERR_NAME_NOT_FOUND )
+    {
+       OS_printf("Error deleting the arena\n");
+       errors++;
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Arena Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Arena Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
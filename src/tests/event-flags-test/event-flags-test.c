@@ -0,0 +1,215 @@
+/*
+** Event Flags Test
+**
+** A dispatcher task waits for any of several flags with auto-clear, while
+** each source task sets its own flag and waits for the dispatcher to
+** handle it. Every event must be seen exactly once. Then checks the wait
+** for all flags, the timeouts, and the name lookup.
+*/
+#include <stdio.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define SOURCE_PRIORITY   100
+
+#define NUM_SOURCES       4
+#define NUM_EVENTS        20000
+#define ALL_SOURCES       ((1 << NUM_SOURCES) - 1)
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+
+uint32 source_stack[NUM_SOURCES][TASK_STACK_SIZE];
+uint32 source_id[NUM_SOURCES];
+uint32 ack_sem_id[NUM_SOURCES];
+
+uint32 events_id;
+uint32 events_seen[NUM_SOURCES];
+uint32 errors;
+
+void source_task(void)
+{
+    OS_task_prop_t task_prop;
+    int            source;
+    int            i;
+
+    OS_TaskRegister();
+
+    /* Each source finds its flag from its task name */
+    OS_TaskGetInfo(OS_TaskGetId(), &task_prop);
+    if ( sscanf(task_prop.name, "Source %d", &source) != 1 )
+    {
+       errors++;
+       OS_TaskExit();
+    }
+
+    for ( i = 0; i < NUM_EVENTS; i++ )
+    {
+       if ( OS_EventFlagsSet(events_id, 1 << source) != OS_SUCCESS )
+       {
+          errors++;
+       }
+       if ( OS_BinSemTake(ack_sem_id[source]) != OS_SUCCESS )
+       {
+          errors++;
+       }
+    }
+
+    OS_TaskExit();
+}
+
+void test_task(void)
+{
+    OS_time_t              start;
+    OS_time_t              end;
+    OS_event_flags_prop_t  flags_prop;
+    double                 usecs;
+    char                   name[OS_MAX_API_NAME];
+    uint32                 flags;
+    uint32                 found_id;
+    uint32                 total;
+    int                    i;
+
+    OS_TaskRegister();
+
+    /*
+    ** One dispatcher, several sources
+    */
+    for ( i = 0; i < NUM_SOURCES; i++ )
+    {
+       sprintf(name, "Ack %d", i);
+       if ( OS_BinSemCreate(&ack_sem_id[i], name, 0, 0) != OS_SUCCESS )
+       {
+          OS_printf("Error creating %s\n", name);
+          errors++;
+       }
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_SOURCES; i++ )
+    {
+       sprintf(name, "Source %d", i);
+       if ( OS_TaskCreate(&source_id[i], name, source_task, source_stack[i],
+                          TASK_STACK_SIZE, SOURCE_PRIORITY, 0) != OS_SUCCESS )
+       {
+          OS_printf("Error creating %s\n", name);
+          errors++;
+       }
+    }
+
+    for ( total = 0; total < NUM_SOURCES * NUM_EVENTS; )
+    {
+       if ( OS_EventFlagsWait(events_id, ALL_SOURCES, OS_EVENT_WAIT_ANY | OS_EVENT_AUTO_CLEAR,
+                              10000, &flags) != OS_SUCCESS )
+       {
+          OS_printf("Timed out waiting for events, %lu seen\n", (unsigned long)total);
+          errors++;
+          break;
+       }
+
+       for ( i = 0; i < NUM_SOURCES; i++ )
+       {
+          if ( flags & (1 << i) )
+          {
+             events_seen[i]++;
+             total++;
+             OS_BinSemGive(ack_sem_id[i]);
+          }
+       }
+    }
+
+    OS_GetLocalTime(&end);
+    usecs = (double)(end.seconds - start.seconds) * 1000000.0 +
+            (double)end.microsecs - (double)start.microsecs;
+    OS_printf("%d sources: %lu nsecs per event\n", NUM_SOURCES,
+              (unsigned long)((usecs * 1000.0) / (NUM_SOURCES * NUM_EVENTS)));
+
+    for ( i = 0; i < NUM_SOURCES; i++ )
+    {
+       if ( events_seen[i] != NUM_EVENTS )
+       {
+          OS_printf("Source %d: %lu events seen, expected %lu\n", i,
+                    (unsigned long)events_seen[i], (unsigned long)NUM_EVENTS);
+          errors++;
+       }
+    }
+
+    /*
+    ** Wait for all flags, and the timeouts
+    */
+    OS_EventFlagsClear(events_id, 0xFFFFFFFF);
+    OS_EventFlagsSet(events_id, 0x1);
+    if ( OS_EventFlagsWait(events_id, 0x3, OS_EVENT_WAIT_ALL, OS_CHECK, NULL) != OS_SEM_TIMEOUT )
+    {
+       OS_printf("Wait for all flags returned with only one set\n");
+       errors++;
+    }
+    if ( OS_EventFlagsWait(events_id, 0x2, OS_EVENT_WAIT_ANY, 50, NULL) != OS_SEM_TIMEOUT )
+    {
+       OS_printf("Timed wait for a clear flag did not time out\n");
+       errors++;
+    }
+    OS_EventFlagsSet(events_id, 0x2);
+    if ( OS_EventFlagsWait(events_id, 0x3, OS_EVENT_WAIT_ALL, OS_CHECK, &flags) != OS_SUCCESS ||
+         flags != 0x3 )
+    {
+       OS_printf("Wait for all flags failed with all of them set\n");
+       errors++;
+    }
+    if ( OS_EventFlagsWait(events_id, 0, OS_EVENT_WAIT_ANY, OS_CHECK, NULL) != OS_ERROR )
+    {
+       OS_printf("Wait for no flags was accepted\n");
+       errors++;
+    }
+    if ( OS_EventFlagsWait(events_id, 0x1, OS_EVENT_WAIT_ANY, -5, NULL) != OS_ERROR )
+    {
+       OS_printf("A negative timeout was accepted\n");
+       errors++;
+    }
+
+    if ( OS_EventFlagsGetIdByName(&found_id, "Events") != OS_SUCCESS || found_id != events_id ||
+         OS_EventFlagsGetInfo(events_id, &flags_prop) != OS_SUCCESS || flags_prop.flags != 0x3 )
+    {
+       OS_printf("The event flags could not be looked up\n");
+       errors++;
+    }
+
+    if ( OS_EventFlagsDelete(events_id) != OS_SUCCESS ||
+         OS_EventFlagsSet(events_id, 0x1) != OS_ERR_INVALID_ID )
+    {
+       OS_printf("Error deleting the event flags\n");
+       errors++;
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Event Flags Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Event Flags Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_EventFlagsCreate(&events_id, "Events", 0, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the event flags\n");
+   }
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
@@ -0,0 +1,300 @@
+/*
+** Event Descriptor Test
+**
+** Adds the descriptors of a queue, a binary semaphore and a counting semaphore
+** to an epoll set, and checks that each is readable while a get or take would
+** succeed, and no longer once the messages are got or the semaphores taken. A
+** producer task then puts messages and gives the counting semaphore, and the
+** test task waits for both in epoll only.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define PRODUCER_PRIORITY 80
+
+#define QUEUE_DEPTH       10
+#define NUM_PRODUCED      10000
+#define EPOLL_TIMEOUT     5000
+
+#define QUEUE_READY       0x1
+#define BIN_READY         0x2
+#define COUNT_READY       0x4
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+uint32 producer_stack[TASK_STACK_SIZE];
+uint32 producer_id;
+
+uint32 queue_id;
+uint32 bin_id;
+uint32 count_id;
+
+uint32 errors;
+uint32 producer_errors;
+
+/*
+** The descriptors that are readable, as a mask of the *_READY bits
+*/
+uint32 ready_mask(int epoll_fd, int timeout)
+{
+    struct epoll_event events[3];
+    uint32             mask;
+    int                n;
+    int                i;
+
+    mask = 0;
+    n = epoll_wait(epoll_fd, events, 3, timeout);
+    for ( i = 0; i < n; i++ )
+    {
+       mask |= events[i].data.u32;
+    }
+
+    return(mask);
+}
+
+/*
+** Checks which of the descriptors are readable
+*/
+void check_ready(int epoll_fd, uint32 expected, const char *when)
+{
+    uint32 mask;
+
+    mask = ready_mask(epoll_fd, 0);
+    if ( mask != expected )
+    {
+       OS_printf("Readable 0x%x %s, expected 0x%x\n", (unsigned int)mask, when,
+                 (unsigned int)expected);
+       errors++;
+    }
+}
+
+/*
+** Adds a descriptor to the epoll set, with the bit it sets in ready_mask
+*/
+void add_fd(int epoll_fd, int32 fd, uint32 bit)
+{
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.u32 = bit;
+    if ( epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0 )
+    {
+       OS_printf("Error adding descriptor 0x%x to epoll\n", (unsigned int)bit);
+       errors++;
+    }
+}
+
+/*
+** Puts the messages in order and gives the counting semaphore for each
+*/
+void producer_task(void)
+{
+    uint32 i;
+
+    OS_TaskRegister();
+
+    for ( i = 0; i < NUM_PRODUCED; i++ )
+    {
+       if ( OS_QueuePut(queue_id, &i, sizeof(i), OS_QUEUE_BLOCK) != OS_SUCCESS ||
+            OS_CountSemGive(count_id) != OS_SUCCESS )
+       {
+          producer_errors++;
+       }
+    }
+
+    OS_TaskExit();
+}
+
+void test_task(void)
+{
+    uint32 msg;
+    uint32 size;
+    uint32 mask;
+    uint32 next_msg;
+    uint32 taken;
+    int32  queue_fd;
+    int32  bin_fd;
+    int32  count_fd;
+    int32  fd;
+    int32  ret;
+    int    epoll_fd;
+
+    OS_TaskRegister();
+
+    if ( OS_QueueCreate(&queue_id, "EventQueue", QUEUE_DEPTH, sizeof(uint32), 0) != OS_SUCCESS ||
+         OS_BinSemCreate(&bin_id, "EventBin", 0, 0) != OS_SUCCESS ||
+         OS_CountSemCreate(&count_id, "EventCount", 0, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the objects\n");
+       errors++;
+       OS_TaskExit();
+    }
+
+    if ( OS_QueueGetEventFd(queue_id, NULL) != OS_INVALID_POINTER ||
+         OS_BinSemGetEventFd(bin_id, NULL) != OS_INVALID_POINTER ||
+         OS_CountSemGetEventFd(OS_MAX_COUNT_SEMAPHORES, &fd) != OS_ERR_INVALID_ID )
+    {
+       OS_printf("Bad arguments were not rejected\n");
+       errors++;
+    }
+
+    /* A message put before the descriptor was asked for makes it readable too */
+    msg = 0;
+    OS_QueuePut(queue_id, &msg, sizeof(msg), 0);
+
+    epoll_fd = epoll_create(3);
+    if ( epoll_fd < 0 ||
+         OS_QueueGetEventFd(queue_id, &queue_fd) != OS_SUCCESS ||
+         OS_BinSemGetEventFd(bin_id, &bin_fd) != OS_SUCCESS ||
+         OS_CountSemGetEventFd(count_id, &count_fd) != OS_SUCCESS )
+    {
+       OS_printf("Error getting the descriptors\n");
+       errors++;
+       OS_TaskExit();
+    }
+
+    if ( OS_QueueGetEventFd(queue_id, &fd) != OS_SUCCESS || fd != queue_fd )
+    {
+       OS_printf("A second call passed back another descriptor\n");
+       errors++;
+    }
+
+    add_fd(epoll_fd, queue_fd, QUEUE_READY);
+    add_fd(epoll_fd, bin_fd, BIN_READY);
+    add_fd(epoll_fd, count_fd, COUNT_READY);
+
+    check_ready(epoll_fd, QUEUE_READY, "with the message put before");
+    OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK);
+    if ( OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK) != OS_QUEUE_EMPTY )
+    {
+       OS_printf("The queue is not empty\n");
+       errors++;
+    }
+    check_ready(epoll_fd, 0, "once the queue is empty");
+
+    OS_BinSemGive(bin_id);
+    OS_CountSemGive(count_id);
+    OS_CountSemGive(count_id);
+    check_ready(epoll_fd, BIN_READY | COUNT_READY, "after the gives");
+
+    if ( OS_BinSemTimedWait(bin_id, 0) != OS_SUCCESS ||
+         OS_CountSemTimedWait(count_id, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error taking the semaphores\n");
+       errors++;
+    }
+    check_ready(epoll_fd, COUNT_READY, "with one count left");
+
+    if ( OS_CountSemTimedWait(count_id, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error taking the last count\n");
+       errors++;
+    }
+    check_ready(epoll_fd, 0, "once the semaphores are taken");
+
+    /* The pthread flush leaves the semaphore available, the take clears it */
+    OS_BinSemFlush(bin_id);
+    OS_BinSemTimedWait(bin_id, 0);
+    check_ready(epoll_fd, 0, "after a flush");
+
+    /* Every message and count comes in through epoll, the gets never wait */
+    if ( OS_TaskCreate(&producer_id, "Producer", producer_task, producer_stack,
+                       TASK_STACK_SIZE, PRODUCER_PRIORITY, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the producer task\n");
+       errors++;
+       OS_TaskExit();
+    }
+
+    next_msg = 0;
+    taken    = 0;
+    while ( next_msg < NUM_PRODUCED || taken < NUM_PRODUCED )
+    {
+       mask = ready_mask(epoll_fd, EPOLL_TIMEOUT);
+       if ( mask == 0 )
+       {
+          OS_printf("Nothing became readable after %lu messages, %lu counts\n",
+                    (unsigned long)next_msg, (unsigned long)taken);
+          errors++;
+          break;
+       }
+       if ( mask & BIN_READY )
+       {
+          OS_printf("The binary semaphore became readable\n");
+          errors++;
+       }
+       if ( mask & QUEUE_READY )
+       {
+          while ( (ret = OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK)) == OS_SUCCESS )
+          {
+             if ( msg != next_msg )
+             {
+                errors++;
+             }
+             next_msg++;
+          }
+          if ( ret != OS_QUEUE_EMPTY )
+          {
+             errors++;
+          }
+       }
+       if ( mask & COUNT_READY )
+       {
+          while ( OS_CountSemTimedWait(count_id, 0) == OS_SUCCESS )
+          {
+             taken++;
+          }
+       }
+    }
+
+    check_ready(epoll_fd, 0, "once the producer is done");
+
+    close(epoll_fd);
+
+    if ( OS_QueueDelete(queue_id) != OS_SUCCESS ||
+         OS_BinSemDelete(bin_id) != OS_SUCCESS ||
+         OS_CountSemDelete(count_id) != OS_SUCCESS )
+    {
+       OS_printf("Error deleting the objects\n");
+       errors++;
+    }
+
+    if ( OS_QueueGetEventFd(queue_id, &fd) != OS_ERR_INVALID_ID )
+    {
+       OS_printf("The deleted queue passed back a descriptor\n");
+       errors++;
+    }
+
+    errors += producer_errors;
+    if ( errors == 0 )
+    {
+       OS_printf("Event Descriptor Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Event Descriptor Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
@@ -0,0 +1,207 @@
+/*
+** Heap Test
+**
+** Checks that OS_HeapGetInfo reports the free space of the heap, and that it
+** grows when a large block is freed. With OS_HEAP_ACCOUNTING, a child task
+** allocates and frees a known number of blocks and its counters are checked,
+** then the cost of a malloc and free is measured.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define CHILD_PRIORITY    80
+
+#define LARGE_SIZE        (256 * 1024)
+#define CHILD_ALLOCS      100
+#define CHILD_SIZE        200
+#define CHILD_FREES       60
+#define NUM_CYCLES        1000000
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+uint32 child_stack[TASK_STACK_SIZE];
+uint32 child_id;
+
+uint32 child_sem;
+uint32 done_sem;
+uint32 errors;
+
+void *child_blocks[CHILD_ALLOCS];
+void * volatile cycle_block;
+
+/*
+** Child that allocates CHILD_ALLOCS blocks, frees CHILD_FREES of them, then
+** waits to be deleted
+*/
+void child_task(void)
+{
+    uint32 i;
+
+    OS_TaskRegister();
+    OS_BinSemTake(child_sem);
+
+    for ( i = 0; i < CHILD_ALLOCS; i++ )
+    {
+       child_blocks[i] = malloc(CHILD_SIZE);
+    }
+    for ( i = 0; i < CHILD_FREES; i++ )
+    {
+       free(child_blocks[i]);
+    }
+    OS_BinSemGive(done_sem);
+
+    for ( ;; )
+    {
+       OS_TaskDelay(1000);
+    }
+}
+
+/*
+** Elapsed nsecs from start to end, per count operations
+*/
+unsigned long nsecs_per(OS_time_t *start, OS_time_t *end, uint32 count)
+{
+    double usecs;
+
+    usecs = (double)(end->seconds - start->seconds) * 1000000.0 +
+            (double)end->microsecs - (double)start->microsecs;
+
+    return((unsigned long)((usecs * 1000.0) / count));
+}
+
+void test_task(void)
+{
+    OS_time_t            start;
+    OS_time_t            end;
+    OS_heap_prop_t       heap;
+    OS_heap_prop_t       after;
+    OS_heap_task_prop_t  prop;
+    int32                status;
+    void                *ptr;
+    uint32               i;
+
+    OS_TaskRegister();
+
+    if ( OS_HeapGetInfo(NULL) != OS_INVALID_POINTER ||
+         OS_HeapGetTaskInfo(test_id, NULL) != OS_INVALID_POINTER )
+    {
+       OS_printf("A NULL heap info was not rejected\n");
+       errors++;
+    }
+
+    /* a large block in the middle of the heap, freed while kept from the top */
+    ptr = malloc(LARGE_SIZE);
+    memset(ptr, 0, LARGE_SIZE);
+    child_blocks[0] = malloc(CHILD_SIZE);
+
+    if ( OS_HeapGetInfo(&heap) != OS_SUCCESS )
+    {
+       OS_printf("Error getting the heap info\n");
+       errors++;
+    }
+    free(ptr);
+    if ( OS_HeapGetInfo(&after) != OS_SUCCESS || after.free_bytes < heap.free_bytes )
+    {
+       OS_printf("The free bytes of the heap did not grow with a free\n");
+       errors++;
+    }
+    free(child_blocks[0]);
+
+    OS_printf("Heap: %lu free bytes in %lu blocks, %lu at the top\n",
+              (unsigned long)after.free_bytes, (unsigned long)after.free_blocks,
+              (unsigned long)after.largest_free_block);
+
+    status = OS_HeapGetTaskInfo(test_id, &prop);
+    if ( status == OS_ERR_NOT_IMPLEMENTED )
+    {
+       OS_printf("OS_HEAP_ACCOUNTING is not defined, the task counters are not checked\n");
+    }
+    else if ( status != OS_SUCCESS || prop.allocs < 2 || prop.frees < 2 ||
+              prop.bytes_allocated < LARGE_SIZE + CHILD_SIZE )
+    {
+       OS_printf("Wrong heap info of the test task\n");
+       errors++;
+    }
+    else
+    {
+       if ( OS_HeapGetTaskInfo(0xFFFF, &prop) != OS_ERR_INVALID_ID )
+       {
+          OS_printf("A bad task id was not rejected\n");
+          errors++;
+       }
+
+       /* what the child does is counted against it and nobody else */
+       if ( OS_BinSemCreate(&child_sem, "ChildSem", 0, 0) != OS_SUCCESS ||
+            OS_BinSemCreate(&done_sem, "DoneSem", 0, 0) != OS_SUCCESS ||
+            OS_TaskCreate(&child_id, "Child", child_task, child_stack,
+                          TASK_STACK_SIZE, CHILD_PRIORITY, 0) != OS_SUCCESS )
+       {
+          OS_printf("Error creating the child\n");
+          errors++;
+       }
+       OS_TaskDelay(100);
+       OS_BinSemGive(child_sem);
+       OS_BinSemTake(done_sem);
+
+       if ( OS_HeapGetTaskInfo(child_id, &prop) != OS_SUCCESS ||
+            prop.allocs != CHILD_ALLOCS || prop.frees != CHILD_FREES ||
+            prop.bytes_allocated < CHILD_ALLOCS * CHILD_SIZE ||
+            prop.bytes_allocated - prop.bytes_freed < (CHILD_ALLOCS - CHILD_FREES) * CHILD_SIZE )
+       {
+          OS_printf("Wrong heap info of the child: %lu allocs, %lu frees\n",
+                    (unsigned long)prop.allocs, (unsigned long)prop.frees);
+          errors++;
+       }
+       else
+       {
+          OS_printf("Child holds %lu bytes in %lu blocks\n",
+                    (unsigned long)(prop.bytes_allocated - prop.bytes_freed),
+                    (unsigned long)(prop.allocs - prop.frees));
+       }
+
+       OS_TaskDelete(child_id);
+       for ( i = CHILD_FREES; i < CHILD_ALLOCS; i++ )
+       {
+          free(child_blocks[i]);
+       }
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_CYCLES; i++ )
+    {
+       cycle_block = malloc(CHILD_SIZE);
+       free(cycle_block);
+    }
+    OS_GetLocalTime(&end);
+    OS_printf("malloc and free: %lu nsecs\n", nsecs_per(&start, &end, NUM_CYCLES));
+
+    if ( errors == 0 )
+    {
+       OS_printf("Heap Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Heap Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
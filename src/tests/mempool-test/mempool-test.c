@@ -0,0 +1,312 @@
+/*
+** Memory Pool Test
+**
+** Allocates every block of a memory pool and checks that the blocks are
+** aligned to a cache line and do not overlap, that one more allocation fails,
+** and that freeing a block twice or a pointer that is not a block is caught.
+** Several tasks then allocate and free the blocks of a pool with task caches
+** at once, and the cost of a block is compared with malloc and free.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define WORKER_PRIORITY   80
+
+#define BLOCK_SIZE        100
+#define NUM_BLOCKS        32
+#define CACHE_LINE        64
+#define NUM_WORKERS       3
+#define WORKER_BLOCKS     8
+#define WORKER_LOOPS      100000
+#define NUM_TIMED         1000000
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+uint32 worker_stack[NUM_WORKERS][TASK_STACK_SIZE];
+uint32 worker_id[NUM_WORKERS];
+
+uint32 shared_pool;
+uint32 done_sem;
+
+uint32 errors;
+uint32 worker_errors;
+
+void *blocks[NUM_BLOCKS];
+
+/*
+** Checks the use of the blocks of a pool
+*/
+void check_info(uint32 pool_id, uint32 in_use, uint32 high_water, uint64 failures,
+                const char *when)
+{
+    OS_mempool_prop_t prop;
+
+    if ( OS_MemPoolGetInfo(pool_id, &prop) != OS_SUCCESS ||
+         prop.blocks_in_use != in_use || prop.blocks_free != prop.blocks - in_use ||
+         prop.high_water != high_water || prop.failures != failures )
+    {
+       OS_printf("Wrong pool info %s\n", when);
+       errors++;
+    }
+}
+
+/*
+** Worker that allocates a few blocks at a time, marks them as its own, and
+** checks that no other worker wrote to them before freeing them
+*/
+void worker_task(void)
+{
+    uint32  mine[WORKER_BLOCKS];
+    void   *block[WORKER_BLOCKS];
+    uint32  task_id;
+    uint32  loop;
+    uint32  i;
+
+    OS_TaskRegister();
+    task_id = OS_TaskGetId();
+
+    for ( loop = 0; loop < WORKER_LOOPS; loop++ )
+    {
+       for ( i = 0; i < WORKER_BLOCKS; i++ )
+       {
+          if ( OS_MemPoolAlloc(shared_pool, &block[i]) != OS_SUCCESS )
+          {
+             worker_errors++;
+             block[i] = NULL;
+             continue;
+          }
+          mine[i] = (task_id << 24) | (loop << 4) | i;
+          memcpy(block[i], &mine[i], sizeof(mine[i]));
+       }
+       for ( i = 0; i < WORKER_BLOCKS; i++ )
+       {
+          if ( block[i] == NULL )
+          {
+             continue;
+          }
+          if ( memcmp(block[i], &mine[i], sizeof(mine[i])) != 0 ||
+               OS_MemPoolFree(shared_pool, block[i]) != OS_SUCCESS )
+          {
+             worker_errors++;
+          }
+       }
+    }
+
+    OS_CountSemGive(done_sem);
+    OS_TaskExit();
+}
+
+/*
+** Elapsed nsecs from start to end, per count operations
+*/
+unsigned long nsecs_per(OS_time_t *start, OS_time_t *end, uint32 count)
+{
+    double usecs;
+
+    usecs = (double)(end->seconds - start->seconds) * 1000000.0 +
+            (double)end->microsecs - (double)start->microsecs;
+
+    return((unsigned long)((usecs * 1000.0) / count));
+}
+
+void test_task(void)
+{
+    OS_time_t  start;
+    OS_time_t  end;
+    char       name[OS_MAX_API_NAME];
+    uint32     pool_id;
+    uint32     found_id;
+    uint32     stack_word;
+    void      *block;
+    void      *extra;
+    uint32     i;
+    uint32     j;
+
+    OS_TaskRegister();
+
+    if ( OS_MemPoolCreate(&pool_id, "Pool", BLOCK_SIZE, NUM_BLOCKS, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the pool\n");
+       errors++;
+       OS_TaskExit();
+    }
+
+    if ( OS_MemPoolCreate(&found_id, "Pool", BLOCK_SIZE, NUM_BLOCKS, 0) != OS_ERR_NAME_TAKEN ||
+         OS_MemPoolCreate(&found_id, "Empty", BLOCK_SIZE, 0, 0) != OS_QUEUE_INVALID_SIZE ||
+         OS_MemPoolGetIdByName(&found_id, "Pool") != OS_SUCCESS || found_id != pool_id )
+    {
+       OS_printf("Bad pool arguments were not rejected\n");
+       errors++;
+    }
+
+    /* every block, each starting on a cache line, and each filled in */
+    for ( i = 0; i < NUM_BLOCKS; i++ )
+    {
+       if ( OS_MemPoolAlloc(pool_id, &blocks[i]) != OS_SUCCESS ||
+            ((unsigned long)blocks[i] % CACHE_LINE) != 0 )
+       {
+          OS_printf("Error allocating block %lu\n", (unsigned long)i);
+          errors++;
+          OS_TaskExit();
+       }
+       memset(blocks[i], (int)i, BLOCK_SIZE);
+    }
+
+    for ( i = 0; i < NUM_BLOCKS; i++ )
+    {
+       for ( j = 0; j < BLOCK_SIZE; j++ )
+       {
+          if ( ((unsigned char *)blocks[i])[j] != i )
+          {
+             OS_printf("Block %lu overlaps another one\n", (unsigned long)i);
+             errors++;
+             break;
+          }
+       }
+    }
+
+    if ( OS_MemPoolAlloc(pool_id, &extra) != OS_ERROR )
+    {
+       OS_printf("A block was allocated from an empty pool\n");
+       errors++;
+    }
+    check_info(pool_id, NUM_BLOCKS, NUM_BLOCKS, 1, "with all the blocks allocated");
+
+    if ( OS_MemPoolDelete(pool_id) != OS_ERROR )
+    {
+       OS_printf("A pool with blocks allocated was deleted\n");
+       errors++;
+    }
+
+    if ( OS_MemPoolFree(pool_id, blocks[0]) != OS_SUCCESS ||
+         OS_MemPoolFree(pool_id, blocks[0]) != OS_INVALID_POINTER ||
+         OS_MemPoolFree(pool_id, (char *)blocks[1] + 1) != OS_INVALID_POINTER ||
+         OS_MemPoolFree(pool_id, &stack_word) != OS_INVALID_POINTER ||
+         OS_MemPoolFree(pool_id, NULL) != OS_INVALID_POINTER )
+    {
+       OS_printf("A bad free was not caught\n");
+       errors++;
+    }
+
+    /* the freed block is the one allocated next */
+    if ( OS_MemPoolAlloc(pool_id, &block) != OS_SUCCESS || block != blocks[0] )
+    {
+       OS_printf("The freed block was not allocated again\n");
+       errors++;
+    }
+
+    for ( i = 0; i < NUM_BLOCKS; i++ )
+    {
+       if ( OS_MemPoolFree(pool_id, blocks[i]) != OS_SUCCESS )
+       {
+          errors++;
+       }
+    }
+    check_info(pool_id, 0, NUM_BLOCKS, 1, "with all the blocks freed");
+
+    /* the tasks share a pool with caches, sized so that none runs out */
+    if ( OS_MemPoolCreate(&shared_pool, "Shared", BLOCK_SIZE,
+                          NUM_WORKERS * (WORKER_BLOCKS + OS_MEMPOOL_CACHE_BLOCKS),
+                          OS_MEMPOOL_TASK_CACHE) != OS_SUCCESS ||
+         OS_CountSemCreate(&done_sem, "Done", 0, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the shared pool\n");
+       errors++;
+       OS_TaskExit();
+    }
+
+    for ( i = 0; i < NUM_WORKERS; i++ )
+    {
+       sprintf(name, "Worker%lu", (unsigned long)i);
+       if ( OS_TaskCreate(&worker_id[i], name, worker_task, worker_stack[i],
+                          TASK_STACK_SIZE, WORKER_PRIORITY, 0) != OS_SUCCESS )
+       {
+          OS_printf("Error creating %s\n", name);
+          errors++;
+       }
+    }
+
+    for ( i = 0; i < NUM_WORKERS; i++ )
+    {
+       OS_CountSemTake(done_sem);
+    }
+
+    if ( worker_errors != 0 )
+    {
+       OS_printf("The workers found %lu errors\n", (unsigned long)worker_errors);
+       errors += worker_errors;
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_TIMED; i++ )
+    {
+       OS_MemPoolAlloc(shared_pool, &block);
+       OS_MemPoolFree(shared_pool, block);
+    }
+    OS_GetLocalTime(&end);
+    OS_printf("Block of a pool with task caches allocated and freed: %lu nsecs\n",
+              nsecs_per(&start, &end, NUM_TIMED));
+
+    /* the blocks left in the caches of the workers are free */
+    if ( OS_MemPoolDelete(shared_pool) != OS_SUCCESS )
+    {
+       OS_printf("Error deleting the shared pool\n");
+       errors++;
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_TIMED; i++ )
+    {
+       OS_MemPoolAlloc(pool_id, &block);
+       OS_MemPoolFree(pool_id, block);
+    }
+    OS_GetLocalTime(&end);
+    OS_printf("Pool block allocated and freed: %lu nsecs\n",
+              nsecs_per(&start, &end, NUM_TIMED));
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_TIMED; i++ )
+    {
+       block = malloc(BLOCK_SIZE);
+       free(block);
+    }
+    OS_GetLocalTime(&end);
+    OS_printf("malloc and free: %lu nsecs\n", nsecs_per(&start, &end, NUM_TIMED));
+
+    if ( OS_MemPoolDelete(pool_id) != OS_SUCCESS ||
+         OS_MemPoolGetIdByName(&found_id, "Pool") != OS_ERR_NAME_NOT_FOUND )
+    {
+       OS_printf("Error deleting the pool\n");
+       errors++;
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Memory Pool Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Memory Pool Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
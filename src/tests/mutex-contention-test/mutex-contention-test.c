@@ -0,0 +1,163 @@
+/*
+** Mutex Contention Test
+**
+** Several tasks take the same mutex around a very short critical section,
+** once for each set of mutex options, to compare the cost of a collision
+** for the default, fast and adaptive mutexes, and for the priority
+** inheritance and priority ceiling protocols.
+*/
+#include <stdio.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define WORKER_PRIORITY   100
+
+#define NUM_WORKERS       4
+#define NUM_ITERATIONS    100000
+#define NUM_OPTION_SETS   6
+#define CEILING_PRIORITY  50
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+
+uint32 worker_stack[NUM_WORKERS][TASK_STACK_SIZE];
+uint32 worker_id[NUM_WORKERS];
+
+uint32 done_sem_id;
+uint32 mutex_id;
+
+volatile uint32 shared_counter;
+uint32 errors;
+
+uint32 option_sets[NUM_OPTION_SETS] =
+{
+   0,
+   OS_MUTEX_FAST,
+   OS_MUTEX_ADAPTIVE,
+   OS_MUTEX_FAST | OS_MUTEX_ADAPTIVE,
+   OS_MUTEX_FAST | OS_MUTEX_PRIO_INHERIT,
+   OS_MUTEX_FAST | OS_MUTEX_PRIO_PROTECT | OS_MUTEX_CEILING(CEILING_PRIORITY)
+};
+
+char *option_names[NUM_OPTION_SETS] =
+{
+   "default",
+   "fast",
+   "adaptive",
+   "fast+adaptive",
+   "fast+inherit",
+   "fast+protect"
+};
+
+void worker_task(void)
+{
+    int i;
+
+    OS_TaskRegister();
+
+    for ( i = 0; i < NUM_ITERATIONS; i++ )
+    {
+       if ( OS_MutSemTake(mutex_id) != OS_SUCCESS )
+       {
+          errors++;
+       }
+       shared_counter++;
+       if ( OS_MutSemGive(mutex_id) != OS_SUCCESS )
+       {
+          errors++;
+       }
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+void test_task(void)
+{
+    OS_time_t  start;
+    OS_time_t  end;
+    double     usecs;
+    char       name[OS_MAX_API_NAME];
+    int        set;
+    int        i;
+
+    OS_TaskRegister();
+
+    for ( set = 0; set < NUM_OPTION_SETS; set++ )
+    {
+       if ( OS_MutSemCreate(&mutex_id, "Contended", option_sets[set]) != OS_SUCCESS )
+       {
+          OS_printf("Error creating the %s mutex\n", option_names[set]);
+          errors++;
+          continue;
+       }
+
+       shared_counter = 0;
+       OS_GetLocalTime(&start);
+
+       for ( i = 0; i < NUM_WORKERS; i++ )
+       {
+          sprintf(name, "Worker %d.%d", set, i);
+          if ( OS_TaskCreate(&worker_id[i], name, worker_task, worker_stack[i],
+                             TASK_STACK_SIZE, WORKER_PRIORITY, 0) != OS_SUCCESS )
+          {
+             OS_printf("Error creating %s\n", name);
+             errors++;
+          }
+       }
+
+       for ( i = 0; i < NUM_WORKERS; i++ )
+       {
+          OS_CountSemTake(done_sem_id);
+       }
+
+       OS_GetLocalTime(&end);
+       usecs = (double)(end.seconds - start.seconds) * 1000000.0 +
+               (double)end.microsecs - (double)start.microsecs;
+
+       OS_printf("%-14s mutex, %d tasks: %lu nsecs per take/give\n",
+                 option_names[set], NUM_WORKERS,
+                 (unsigned long)((usecs * 1000.0) / (NUM_WORKERS * NUM_ITERATIONS)));
+
+       if ( shared_counter != NUM_WORKERS * NUM_ITERATIONS )
+       {
+          OS_printf("Counter is %lu, expected %lu\n", (unsigned long)shared_counter,
+                    (unsigned long)(NUM_WORKERS * NUM_ITERATIONS));
+          errors++;
+       }
+
+       OS_MutSemDelete(mutex_id);
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Mutex Contention Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Mutex Contention Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_CountSemCreate(&done_sem_id, "Done", 0, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the done semaphore\n");
+   }
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
@@ -0,0 +1,202 @@
+/*
+** Object Create/Delete Test
+**
+** Several tasks create and delete semaphores and mutexes at the same time,
+** to measure how fast the object tables hand out and take back IDs when
+** many creators run concurrently.
+*/
+#include <stdio.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define WORKER_PRIORITY   100
+#define REPORT_PRIORITY   90
+
+#define NUM_WORKERS       8
+#define NUM_ITERATIONS    20000
+
+uint32 worker_stack[NUM_WORKERS][TASK_STACK_SIZE];
+uint32 worker_id[NUM_WORKERS];
+
+uint32 report_stack[TASK_STACK_SIZE];
+uint32 report_id;
+
+uint32 done_sem_id;
+uint32 worker_errors[NUM_WORKERS];
+
+OS_time_t start_time;
+
+/*
+** Each worker finds its index from its task name
+*/
+int worker_index(void)
+{
+    OS_task_prop_t task_prop;
+    int            index;
+
+    index = 0;
+    if ( OS_TaskGetInfo(OS_TaskGetId(), &task_prop) == OS_SUCCESS )
+    {
+       sscanf(task_prop.name, "Worker %d", &index);
+    }
+    return(index);
+}
+
+void worker_task(void)
+{
+    uint32 status;
+    uint32 bin_sem_id;
+    uint32 count_sem_id;
+    uint32 mut_sem_id;
+    char   name[OS_MAX_API_NAME];
+    int    index;
+    int    i;
+
+    OS_TaskRegister();
+    index = worker_index();
+
+    for ( i = 0; i < NUM_ITERATIONS; i++ )
+    {
+       sprintf(name, "B%d.%d", index, i);
+       status = OS_BinSemCreate(&bin_sem_id, name, 1, 0);
+       if ( status != OS_SUCCESS )
+       {
+          worker_errors[index]++;
+       }
+
+       sprintf(name, "C%d.%d", index, i);
+       status = OS_CountSemCreate(&count_sem_id, name, 1, 0);
+       if ( status != OS_SUCCESS )
+       {
+          worker_errors[index]++;
+       }
+
+       sprintf(name, "M%d.%d", index, i);
+       status = OS_MutSemCreate(&mut_sem_id, name, 0);
+       if ( status != OS_SUCCESS )
+       {
+          worker_errors[index]++;
+       }
+
+       if ( OS_BinSemDelete(bin_sem_id) != OS_SUCCESS )
+       {
+          worker_errors[index]++;
+       }
+       if ( OS_CountSemDelete(count_sem_id) != OS_SUCCESS )
+       {
+          worker_errors[index]++;
+       }
+       if ( OS_MutSemDelete(mut_sem_id) != OS_SUCCESS )
+       {
+          worker_errors[index]++;
+       }
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+void report_task(void)
+{
+    OS_time_t end_time;
+    uint32    usecs;
+    uint32    errors;
+    uint32    sem_ids[OS_MAX_BIN_SEMAPHORES];
+    uint32    free_ids;
+    char      name[OS_MAX_API_NAME];
+    int       i;
+
+    OS_TaskRegister();
+
+    for ( i = 0; i < NUM_WORKERS; i++ )
+    {
+       OS_CountSemTake(done_sem_id);
+    }
+
+    OS_GetLocalTime(&end_time);
+    usecs = (end_time.seconds - start_time.seconds) * 1000000 +
+            end_time.microsecs - start_time.microsecs;
+
+    errors = 0;
+    for ( i = 0; i < NUM_WORKERS; i++ )
+    {
+       errors += worker_errors[i];
+    }
+
+    OS_printf("%d tasks did %d create/delete cycles of 3 objects each\n",
+              NUM_WORKERS, NUM_ITERATIONS);
+    OS_printf("Elapsed time: %lu usecs, %lu nsecs per object\n",
+              (unsigned long)usecs,
+              (unsigned long)(((double)usecs * 1000.0) / (3.0 * NUM_WORKERS * NUM_ITERATIONS)));
+    OS_printf("Errors: %lu\n", (unsigned long)errors);
+
+    /*
+    ** Every ID must have been given back: the whole binary semaphore table
+    ** must be available again
+    */
+    free_ids = 0;
+    for ( i = 0; i < OS_MAX_BIN_SEMAPHORES; i++ )
+    {
+       sprintf(name, "Check%d", i);
+       if ( OS_BinSemCreate(&sem_ids[free_ids], name, 1, 0) == OS_SUCCESS )
+       {
+          free_ids++;
+       }
+    }
+    for ( i = 0; i < free_ids; i++ )
+    {
+       OS_BinSemDelete(sem_ids[i]);
+    }
+
+    if ( free_ids == OS_MAX_BIN_SEMAPHORES && errors == 0 )
+    {
+       OS_printf("Object Create Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Object Create Test FAILED: %lu of %d binary semaphore IDs free\n",
+                 (unsigned long)free_ids, OS_MAX_BIN_SEMAPHORES);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   uint32 status;
+   char   name[OS_MAX_API_NAME];
+   int    i;
+
+   OS_printf("OS Application Startup\n");
+
+   status = OS_CountSemCreate(&done_sem_id, "DoneSem", 0, 0);
+   if ( status != OS_SUCCESS )
+   {
+      OS_printf("Error creating the done semaphore\n");
+   }
+
+   status = OS_TaskCreate(&report_id, "Report", report_task, report_stack,
+                          TASK_STACK_SIZE, REPORT_PRIORITY, 0);
+   if ( status != OS_SUCCESS )
+   {
+      OS_printf("Error creating the report task\n");
+   }
+
+   OS_GetLocalTime(&start_time);
+
+   for ( i = 0; i < NUM_WORKERS; i++ )
+   {
+      sprintf(name, "Worker %d", i);
+      status = OS_TaskCreate(&worker_id[i], name, worker_task, worker_stack[i],
+                             TASK_STACK_SIZE, WORKER_PRIORITY, 0);
+      if ( status != OS_SUCCESS )
+      {
+         OS_printf("Error creating %s\n", name);
+      }
+   }
+
+   OS_printf("Main done!\n");
+}
+
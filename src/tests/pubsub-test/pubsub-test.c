@@ -0,0 +1,409 @@
+/*
+** Publish/Subscribe Test
+**
+** Publishes buffers on a topic to several subscriber queues, and checks that
+** each subscriber gets the same buffer and that it goes back to the topic once
+** all of them release it. Checks that a full subscriber queue misses a buffer
+** without holding on to it, and what happens when all the buffers are in use.
+** Two subscriber tasks then release the buffers while a task publishes more,
+** and the cost of publishing is compared with putting a copy on each queue.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define SUBSCRIBER_PRIORITY 80
+
+#define MSG_SIZE          1024
+#define NUM_BUFFERS       32
+#define NUM_SUBSCRIBERS   3
+#define QUEUE_DEPTH       16
+#define SMALL_DEPTH       4
+#define MAX_FILL          100000
+#define NUM_STREAMED      100000
+#define NUM_TIMED         20000
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+uint32 subscriber_stack[2][TASK_STACK_SIZE];
+uint32 subscriber_id[2];
+
+uint32 topic_id;
+uint32 queues[NUM_SUBSCRIBERS];
+uint32 done_sem;
+
+uint32 errors;
+uint32 subscriber_errors;
+
+/*
+** Checks the number of free buffers of the topic
+*/
+void check_free(uint32 expected, const char *when)
+{
+    OS_topic_prop_t prop;
+
+    if ( OS_TopicGetInfo(topic_id, &prop) != OS_SUCCESS || prop.buffers_free != expected )
+    {
+       OS_printf("Wrong number of free buffers %s\n", when);
+       errors++;
+    }
+}
+
+/*
+** Subscriber task that checks the order of the streamed buffers and releases
+** them. Task "Sub<n>" reads queue n.
+*/
+void subscriber_task(void)
+{
+    OS_task_prop_t  prop;
+    uint32         *buffer;
+    uint32          queue_id;
+    uint32          size;
+    uint32          i;
+
+    OS_TaskRegister();
+
+    OS_TaskGetInfo(OS_TaskGetId(), &prop);
+    queue_id = queues[prop.name[3] - '0'];
+
+    for ( i = 0; i < NUM_STREAMED; i++ )
+    {
+       if ( OS_QueueGet(queue_id, &buffer, sizeof(buffer), &size, OS_PEND) != OS_SUCCESS ||
+            buffer[0] != i || buffer[MSG_SIZE / sizeof(uint32) - 1] != ~i ||
+            OS_TopicRelease(buffer) != OS_SUCCESS )
+       {
+          subscriber_errors++;
+       }
+    }
+
+    OS_CountSemGive(done_sem);
+    OS_TaskExit();
+}
+
+/*
+** Elapsed nsecs from start to end, per count operations
+*/
+unsigned long nsecs_per(OS_time_t *start, OS_time_t *end, uint32 count)
+{
+    double usecs;
+
+    usecs = (double)(end->seconds - start->seconds) * 1000000.0 +
+            (double)end->microsecs - (double)start->microsecs;
+
+    return((unsigned long)((usecs * 1000.0) / count));
+}
+
+void test_task(void)
+{
+    OS_time_t        start;
+    OS_time_t        end;
+    OS_topic_prop_t  prop;
+    uint32          *buffer;
+    uint32          *got;
+    void            *held[NUM_BUFFERS];
+    uint32           copy[MSG_SIZE / sizeof(uint32)];
+    char             name[OS_MAX_API_NAME];
+    uint32           small_id;
+    uint32           dropping_id;
+    uint32           found_id;
+    uint32           size;
+    int32            ret;
+    uint32           i;
+    uint32           j;
+
+    OS_TaskRegister();
+
+    if ( OS_TopicCreate(&topic_id, "Telemetry", MSG_SIZE, NUM_BUFFERS) != OS_SUCCESS ||
+         OS_TopicGetIdByName(&found_id, "Telemetry") != OS_SUCCESS || found_id != topic_id )
+    {
+       OS_printf("Error creating the topic\n");
+       errors++;
+    }
+
+    if ( OS_TopicCreate(&found_id, "Telemetry", MSG_SIZE, NUM_BUFFERS) != OS_ERR_NAME_TAKEN )
+    {
+       OS_printf("A second topic of the same name was created\n");
+       errors++;
+    }
+
+    for ( i = 0; i < NUM_SUBSCRIBERS; i++ )
+    {
+       sprintf(name, "Subscriber%lu", (unsigned long)i);
+       if ( OS_QueueCreate(&queues[i], name, QUEUE_DEPTH, sizeof(void *), 0) != OS_SUCCESS ||
+            OS_TopicSubscribe(topic_id, queues[i]) != OS_SUCCESS )
+       {
+          OS_printf("Error subscribing queue %lu\n", (unsigned long)i);
+          errors++;
+       }
+    }
+
+    if ( OS_TopicSubscribe(topic_id, queues[0]) != OS_ERROR )
+    {
+       OS_printf("A queue was subscribed twice\n");
+       errors++;
+    }
+
+    if ( OS_QueueCreate(&dropping_id, "Dropping", QUEUE_DEPTH, sizeof(void *),
+                        OS_QUEUE_DROP_NEWEST) != OS_SUCCESS ||
+         OS_TopicSubscribe(topic_id, dropping_id) != OS_ERROR )
+    {
+       OS_printf("A queue that drops messages was subscribed\n");
+       errors++;
+    }
+
+    /*
+    ** One buffer to all the subscribers
+    */
+    if ( OS_TopicAlloc(topic_id, (void **)&buffer) != OS_SUCCESS )
+    {
+       OS_printf("Error allocating a buffer\n");
+       errors++;
+    }
+    else
+    {
+       memset(buffer, 0x5A, MSG_SIZE);
+       if ( OS_TopicPublish(topic_id, buffer, 0) != OS_SUCCESS )
+       {
+          OS_printf("Error publishing a buffer\n");
+          errors++;
+       }
+
+       for ( i = 0; i < NUM_SUBSCRIBERS; i++ )
+       {
+          check_free(NUM_BUFFERS - 1, "while the subscribers hold a buffer");
+          if ( OS_QueueGet(queues[i], &got, sizeof(got), &size, OS_CHECK) != OS_SUCCESS ||
+               got != buffer ||
+               ((uint8 *)got)[MSG_SIZE - 1] != 0x5A ||
+               OS_TopicRelease(got) != OS_SUCCESS )
+          {
+             OS_printf("Subscriber %lu did not get the buffer\n", (unsigned long)i);
+             errors++;
+          }
+       }
+       check_free(NUM_BUFFERS, "once all the subscribers released a buffer");
+
+       if ( OS_TopicRelease(buffer) != OS_INVALID_POINTER )
+       {
+          OS_printf("A free buffer was released\n");
+          errors++;
+       }
+    }
+
+    /*
+    ** All the buffers in use
+    */
+    for ( i = 0; i < NUM_BUFFERS; i++ )
+    {
+       if ( OS_TopicAlloc(topic_id, &held[i]) != OS_SUCCESS )
+       {
+          OS_printf("Error allocating buffer %lu\n", (unsigned long)i);
+          errors++;
+       }
+    }
+    if ( OS_TopicAlloc(topic_id, (void **)&buffer) != OS_ERROR )
+    {
+       OS_printf("A buffer was allocated past the end of the pool\n");
+       errors++;
+    }
+    if ( OS_TopicDelete(topic_id) != OS_ERROR )
+    {
+       OS_printf("The topic was deleted with its buffers in use\n");
+       errors++;
+    }
+    for ( i = 0; i < NUM_BUFFERS; i++ )
+    {
+       OS_TopicRelease(held[i]);
+    }
+    check_free(NUM_BUFFERS, "after giving back unpublished buffers");
+
+    /*
+    ** A subscriber whose queue is full misses the buffer. The queue is filled
+    ** up with NULL pointers, as the message and socket queues hold more messages
+    ** than the depth they were created with.
+    */
+    if ( OS_QueueCreate(&small_id, "Small", SMALL_DEPTH, sizeof(void *), 0) != OS_SUCCESS ||
+         OS_TopicSubscribe(topic_id, small_id) != OS_SUCCESS )
+    {
+       OS_printf("Error subscribing the small queue\n");
+       errors++;
+    }
+
+    got = NULL;
+    for ( i = 0; i < MAX_FILL && OS_QueuePut(small_id, &got, sizeof(got), 0) == OS_SUCCESS; i++ )
+    {
+    }
+
+    OS_TopicAlloc(topic_id, (void **)&buffer);
+    ret = OS_TopicPublish(topic_id, buffer, 0);
+    if ( ret != OS_QUEUE_FULL )
+    {
+       OS_printf("Publishing to a full queue returned %ld\n", (long)ret);
+       errors++;
+    }
+
+    if ( OS_TopicGetInfo(topic_id, &prop) != OS_SUCCESS || prop.missed != 1 ||
+         prop.published != 2 || prop.subscribers != NUM_SUBSCRIBERS + 1 )
+    {
+       OS_printf("The topic info does not add up\n");
+       errors++;
+    }
+
+    for ( i = 0; i < NUM_SUBSCRIBERS; i++ )
+    {
+       if ( OS_QueueGet(queues[i], &got, sizeof(got), &size, OS_CHECK) != OS_SUCCESS ||
+            got != buffer || OS_TopicRelease(got) != OS_SUCCESS )
+       {
+          OS_printf("Subscriber %lu did not get the buffer\n", (unsigned long)i);
+          errors++;
+       }
+    }
+    check_free(NUM_BUFFERS, "without a reference for the full queue");
+
+    while ( OS_QueueGet(small_id, &got, sizeof(got), &size, OS_CHECK) == OS_SUCCESS )
+    {
+       if ( got != NULL )
+       {
+          OS_printf("The full queue got the buffer\n");
+          errors++;
+       }
+    }
+
+    if ( OS_TopicUnsubscribe(topic_id, small_id) != OS_SUCCESS ||
+         OS_TopicUnsubscribe(topic_id, small_id) != OS_ERR_NAME_NOT_FOUND ||
+         OS_TopicUnsubscribe(topic_id, queues[2]) != OS_SUCCESS )
+    {
+       OS_printf("Error unsubscribing\n");
+       errors++;
+    }
+
+    /*
+    ** Two subscriber tasks release the buffers while more are published
+    */
+    if ( OS_CountSemCreate(&done_sem, "Done", 0, 0) != OS_SUCCESS ||
+         OS_TaskCreate(&subscriber_id[0], "Sub0", subscriber_task, subscriber_stack[0],
+                       TASK_STACK_SIZE, SUBSCRIBER_PRIORITY, 0) != OS_SUCCESS ||
+         OS_TaskCreate(&subscriber_id[1], "Sub1", subscriber_task, subscriber_stack[1],
+                       TASK_STACK_SIZE, SUBSCRIBER_PRIORITY, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the subscriber tasks\n");
+       errors++;
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_STREAMED; i++ )
+    {
+       while ( OS_TopicAlloc(topic_id, (void **)&buffer) != OS_SUCCESS )
+       {
+          OS_TaskDelay(1);
+       }
+       buffer[0] = i;
+       buffer[MSG_SIZE / sizeof(uint32) - 1] = ~i;
+       if ( OS_TopicPublish(topic_id, buffer, OS_QUEUE_BLOCK) != OS_SUCCESS )
+       {
+          errors++;
+       }
+    }
+    OS_CountSemTake(done_sem);
+    OS_CountSemTake(done_sem);
+    OS_GetLocalTime(&end);
+    OS_printf("Streamed to 2 subscriber tasks: %lu nsecs per buffer\n",
+              nsecs_per(&start, &end, NUM_STREAMED));
+
+    if ( subscriber_errors != 0 )
+    {
+       OS_printf("The subscriber tasks found %lu errors\n", (unsigned long)subscriber_errors);
+       errors++;
+    }
+    check_free(NUM_BUFFERS, "once the subscriber tasks are done");
+
+    /*
+    ** Publishing to 2 queues against putting a copy on each
+    */
+    memset(copy, 0, sizeof(copy));
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_TIMED; i++ )
+    {
+       OS_TopicAlloc(topic_id, (void **)&buffer);
+       buffer[0] = i;
+       OS_TopicPublish(topic_id, buffer, 0);
+       for ( j = 0; j < 2; j++ )
+       {
+          OS_QueueGet(queues[j], &got, sizeof(got), &size, OS_CHECK);
+          OS_TopicRelease(got);
+       }
+    }
+    OS_GetLocalTime(&end);
+    OS_printf("Published %d byte buffer to 2 queues: %lu nsecs\n", MSG_SIZE,
+              nsecs_per(&start, &end, NUM_TIMED));
+
+    OS_TopicUnsubscribe(topic_id, queues[0]);
+    OS_TopicUnsubscribe(topic_id, queues[1]);
+    OS_QueueDelete(queues[0]);
+    OS_QueueDelete(queues[1]);
+    if ( OS_QueueCreate(&queues[0], "Copy0", QUEUE_DEPTH, MSG_SIZE, 0) != OS_SUCCESS ||
+         OS_QueueCreate(&queues[1], "Copy1", QUEUE_DEPTH, MSG_SIZE, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the queues for the copies\n");
+       errors++;
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_TIMED; i++ )
+    {
+       copy[0] = i;
+       for ( j = 0; j < 2; j++ )
+       {
+          OS_QueuePut(queues[j], copy, MSG_SIZE, 0);
+       }
+       for ( j = 0; j < 2; j++ )
+       {
+          OS_QueueGet(queues[j], copy, MSG_SIZE, &size, OS_CHECK);
+       }
+    }
+    OS_GetLocalTime(&end);
+    OS_printf("Put a %d byte copy on 2 queues: %lu nsecs\n", MSG_SIZE,
+              nsecs_per(&start, &end, NUM_TIMED));
+
+    if ( OS_TopicGetInfo(topic_id, &prop) != OS_SUCCESS || prop.subscribers != 0 ||
+         prop.buffers_free != NUM_BUFFERS )
+    {
+       OS_printf("The topic info does not add up after the timing\n");
+       errors++;
+    }
+
+    if ( OS_TopicDelete(topic_id) != OS_SUCCESS ||
+         OS_TopicGetIdByName(&found_id, "Telemetry") != OS_ERR_NAME_NOT_FOUND )
+    {
+       OS_printf("Error deleting the topic\n");
+       errors++;
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Publish/Subscribe Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Publish/Subscribe Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
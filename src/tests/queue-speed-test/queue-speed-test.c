@@ -0,0 +1,945 @@
+/*
+** Queue Speed Test
+**
+** Checks that a queue holds as many messages as its depth, and that a get
+** on an empty queue returns at once or times out. Then measures the cost of
+** a put and get from a single task, and streams messages from one producer
+** to one consumer, and from several producers to several consumers, checking
+** that no message is lost or reordered. Last, measures putting and getting
+** messages in batches, checks that messages of a higher priority overtake
+** the ones already in the queue, checks the queue statistics and what a put
+** to a full queue does under each policy, and compares moving large frames
+** with copies and in place, with the zero copy API.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define CONSUMER_PRIORITY 95
+#define PRODUCER_PRIORITY 100
+
+#define QUEUE_DEPTH       10
+#define STREAM_DEPTH      64
+#define NUM_UNCONTENDED   1000000
+#define NUM_MESSAGES      100000
+#define NUM_PRODUCERS     2
+#define NUM_CONSUMERS     2
+#define GET_TIMEOUT       5000
+#define FRAME_SIZE        4096
+#define NUM_FRAMES        100000
+#define BATCH_SIZE        8
+#define NUM_BATCHES       100000
+#define DRAIN_DELAY       50
+#define DRAIN_TIMEOUT     200
+
+typedef struct
+{
+   uint32 producer;
+   uint32 seq;
+} message_t;
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+
+uint32 producer_stack[NUM_PRODUCERS][TASK_STACK_SIZE];
+uint32 producer_id[NUM_PRODUCERS];
+
+uint32 consumer_stack[NUM_CONSUMERS][TASK_STACK_SIZE];
+uint32 consumer_id[NUM_CONSUMERS];
+
+uint32 queue_id;
+uint32 done_sem_id;
+
+/* Number of messages each consumer must get, and how many it got from each producer */
+uint32 consumer_quota;
+uint32 received[NUM_CONSUMERS][NUM_PRODUCERS];
+
+uint32 frame[FRAME_SIZE / sizeof(uint32)];
+message_t batch[2 * QUEUE_DEPTH];
+uint32    batch_sizes[2 * QUEUE_DEPTH];
+
+/* Messages the drain task got */
+uint32 drained;
+
+uint32 errors;
+
+/*
+** Elapsed time in nanoseconds per operation since start
+*/
+uint32 nsecs_per_op(OS_time_t *start, uint32 ops)
+{
+    OS_time_t end;
+    double    usecs;
+
+    OS_GetLocalTime(&end);
+    usecs = (double)(end.seconds - start->seconds) * 1000000.0 +
+            (double)end.microsecs - (double)start->microsecs;
+
+    return((uint32)((usecs * 1000.0) / ops));
+}
+
+/*
+** Finds the index of the calling task from the number at the end of its name
+*/
+int task_index(void)
+{
+    OS_task_prop_t prop;
+    int            index = 0;
+
+    OS_TaskGetInfo(OS_TaskGetId(), &prop);
+    sscanf(prop.name, "%*s %d", &index);
+
+    return(index);
+}
+
+void producer_task(void)
+{
+    message_t msg;
+    int32     status;
+
+    OS_TaskRegister();
+
+    msg.producer = task_index();
+    for ( msg.seq = 0; msg.seq < NUM_MESSAGES; msg.seq++ )
+    {
+       while ( (status = OS_QueuePut(queue_id, &msg, sizeof(msg), 0)) == OS_QUEUE_FULL )
+       {
+          OS_TaskDelay(1);
+       }
+       if ( status != OS_SUCCESS )
+       {
+          OS_printf("Producer %lu: put returned %d\n", (unsigned long)msg.producer, (int)status);
+          errors++;
+          break;
+       }
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+void consumer_task(void)
+{
+    message_t msg;
+    uint32    size;
+    uint32    next[NUM_PRODUCERS];
+    int       index;
+    int32     status;
+    uint32    i;
+
+    OS_TaskRegister();
+
+    index = task_index();
+    for ( i = 0; i < NUM_PRODUCERS; i++ )
+    {
+       next[i] = 0;
+    }
+
+    for ( i = 0; i < consumer_quota; i++ )
+    {
+       status = OS_QueueGet(queue_id, &msg, sizeof(msg), &size, GET_TIMEOUT);
+       if ( status != OS_SUCCESS || msg.producer >= NUM_PRODUCERS )
+       {
+          OS_printf("Consumer %d: get returned %d\n", index, (int)status);
+          errors++;
+          break;
+       }
+
+       /* Messages from one producer come out in the order they were put */
+       if ( msg.seq < next[msg.producer] )
+       {
+          OS_printf("Consumer %d: message %lu of producer %lu out of order\n", index,
+                    (unsigned long)msg.seq, (unsigned long)msg.producer);
+          errors++;
+       }
+       next[msg.producer] = msg.seq + 1;
+       received[index][msg.producer]++;
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+/*
+** Runs num_producers producers and num_consumers consumers on a new queue,
+** and checks that every message got through
+*/
+void stream_test(int stream, const char *label, uint32 flags, int num_producers,
+                 int num_consumers)
+{
+    OS_time_t start;
+    char      name[OS_MAX_API_NAME];
+    uint32    total;
+    int       i;
+    int       j;
+
+    if ( OS_QueueCreate(&queue_id, "Stream", STREAM_DEPTH, sizeof(message_t), flags) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the %s queue\n", label);
+       errors++;
+       return;
+    }
+
+    consumer_quota = (num_producers * NUM_MESSAGES) / num_consumers;
+    for ( i = 0; i < NUM_CONSUMERS; i++ )
+    {
+       for ( j = 0; j < NUM_PRODUCERS; j++ )
+       {
+          received[i][j] = 0;
+       }
+    }
+
+    OS_GetLocalTime(&start);
+
+    for ( i = 0; i < num_consumers; i++ )
+    {
+       snprintf(name, sizeof(name), "Consumer.%d %d", stream % 100, i % NUM_CONSUMERS);
+       if ( OS_TaskCreate(&consumer_id[i], name, consumer_task, consumer_stack[i],
+                          TASK_STACK_SIZE, CONSUMER_PRIORITY, 0) != OS_SUCCESS )
+       {
+          OS_printf("Error creating %s\n", name);
+          errors++;
+       }
+    }
+    for ( i = 0; i < num_producers; i++ )
+    {
+       snprintf(name, sizeof(name), "Producer.%d %d", stream % 100, i % NUM_PRODUCERS);
+       if ( OS_TaskCreate(&producer_id[i], name, producer_task, producer_stack[i],
+                          TASK_STACK_SIZE, PRODUCER_PRIORITY, 0) != OS_SUCCESS )
+       {
+          OS_printf("Error creating %s\n", name);
+          errors++;
+       }
+    }
+
+    for ( i = 0; i < num_producers + num_consumers; i++ )
+    {
+       OS_CountSemTake(done_sem_id);
+    }
+
+    OS_printf("%-5s %d producer(s), %d consumer(s): %lu nsecs per message\n", label,
+              num_producers, num_consumers,
+              (unsigned long)nsecs_per_op(&start, num_producers * NUM_MESSAGES));
+
+    for ( j = 0; j < num_producers; j++ )
+    {
+       total = 0;
+       for ( i = 0; i < num_consumers; i++ )
+       {
+          total += received[i][j];
+       }
+       if ( total != NUM_MESSAGES )
+       {
+          OS_printf("Got %lu messages from producer %d, expected %lu\n",
+                    (unsigned long)total, j, (unsigned long)NUM_MESSAGES);
+          errors++;
+       }
+    }
+
+    OS_QueueDelete(queue_id);
+}
+
+/*
+** Puts more messages than the queue holds in one batch, gets them back in
+** one batch, then measures the cost of a message in batches
+*/
+void batch_test(void)
+{
+    OS_time_t  start;
+    uint32     count;
+    uint32     count_put;
+    int32      status;
+    int        i;
+
+    if ( OS_QueueCreate(&queue_id, "Batch", QUEUE_DEPTH, sizeof(message_t), 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the batch queue\n");
+       errors++;
+       return;
+    }
+
+    for ( i = 0; i < 2 * QUEUE_DEPTH; i++ )
+    {
+       batch[i].producer = 0;
+       batch[i].seq      = i;
+    }
+
+    status = OS_QueuePutBatch(queue_id, batch, sizeof(message_t), 2 * QUEUE_DEPTH - 1,
+                              &count_put, 0);
+    if ( (status == OS_QUEUE_FULL && count_put >= 2 * QUEUE_DEPTH - 1) ||
+         (status == OS_SUCCESS && count_put != 2 * QUEUE_DEPTH - 1) ||
+         (status != OS_SUCCESS && status != OS_QUEUE_FULL) )
+    {
+       OS_printf("Batch put returned %d after %lu messages\n", (int)status,
+                 (unsigned long)count_put);
+       errors++;
+    }
+#ifdef OSAL_RING_QUEUE
+    if ( count_put != QUEUE_DEPTH )
+    {
+       OS_printf("Batch put %lu messages in a queue of depth %d\n",
+                 (unsigned long)count_put, QUEUE_DEPTH);
+       errors++;
+    }
+#endif
+
+    memset(batch, 0, sizeof(batch));
+    status = OS_QueueGetBatch(queue_id, batch, sizeof(message_t), 2 * QUEUE_DEPTH,
+                              batch_sizes, &count, OS_CHECK);
+    if ( status != OS_SUCCESS || count != count_put )
+    {
+       OS_printf("Batch get returned %d, %lu messages of %lu\n", (int)status,
+                 (unsigned long)count, (unsigned long)count_put);
+       errors++;
+    }
+    for ( i = 0; i < count; i++ )
+    {
+       if ( batch[i].seq != i || batch_sizes[i] != sizeof(message_t) )
+       {
+          OS_printf("Batch get message %d is %lu, size %lu\n", i,
+                    (unsigned long)batch[i].seq, (unsigned long)batch_sizes[i]);
+          errors++;
+          break;
+       }
+    }
+
+    status = OS_QueueGetBatch(queue_id, batch, sizeof(message_t), 2 * QUEUE_DEPTH,
+                              NULL, &count, 20);
+    if ( status != OS_QUEUE_TIMEOUT || count != 0 )
+    {
+       OS_printf("Timed batch get from an empty queue returned %d, expected OS_QUEUE_TIMEOUT\n",
+                 (int)status);
+       errors++;
+    }
+
+    /* a short first message is got and counted, and the batch goes on */
+    batch[0].seq = 0;
+    batch[1].seq = 1;
+    OS_QueuePut(queue_id, &batch[0], sizeof(message_t) / 2, 0);
+    OS_QueuePut(queue_id, &batch[1], sizeof(message_t), 0);
+    memset(batch, 0, sizeof(batch));
+    status = OS_QueueGetBatch(queue_id, batch, sizeof(message_t), 2 * QUEUE_DEPTH,
+                              batch_sizes, &count, OS_CHECK);
+    if ( status != OS_QUEUE_INVALID_SIZE || count != 2 ||
+         batch_sizes[0] != sizeof(message_t) / 2 || batch_sizes[1] != sizeof(message_t) ||
+         batch[1].seq != 1 )
+    {
+       OS_printf("Batch get with a short first message returned %d, %lu messages\n",
+                 (int)status, (unsigned long)count);
+       errors++;
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_BATCHES; i++ )
+    {
+       OS_QueuePutBatch(queue_id, batch, sizeof(message_t), BATCH_SIZE, &count_put, 0);
+       OS_QueueGetBatch(queue_id, batch, sizeof(message_t), BATCH_SIZE, NULL, &count, OS_CHECK);
+    }
+    OS_printf("Put/get in batches of %d:   %lu nsecs per message\n", BATCH_SIZE,
+              (unsigned long)nsecs_per_op(&start, NUM_BATCHES * BATCH_SIZE));
+
+    OS_QueueDelete(queue_id);
+}
+
+/*
+** Puts messages of mixed priorities and checks that the gets, one at a time
+** and in a batch, take the highest priority first and keep the order of the
+** messages of each priority
+*/
+void priority_test(void)
+{
+    static const struct
+    {
+       uint32 priority;
+       uint32 seq;
+    } puts[] = { { 0, 0 }, { 0, 1 }, { OS_QUEUE_PRIORITIES - 1, 100 }, { 0, 2 },
+                 { 1, 50 }, { 200, 101 }, { 1, 51 } };
+    static const uint32 expected[] = { 100, 101, 50, 51, 0, 1, 2 };
+    message_t  msg;
+    uint32     count;
+    uint32     count_put;
+    uint32     size_copied;
+    int32      status;
+    int        i;
+
+    if ( OS_QueueCreate(&queue_id, "Priority", QUEUE_DEPTH, sizeof(message_t), 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the priority queue\n");
+       errors++;
+       return;
+    }
+
+    for ( i = 0; i < sizeof(puts) / sizeof(puts[0]); i++ )
+    {
+       msg.producer = puts[i].priority;
+       msg.seq      = puts[i].seq;
+       status = OS_QueuePut(queue_id, &msg, sizeof(msg), OS_QUEUE_PRIORITY(puts[i].priority));
+       if ( status != OS_SUCCESS )
+       {
+          OS_printf("Put of priority %lu returned %d\n", (unsigned long)puts[i].priority,
+                    (int)status);
+          errors++;
+       }
+    }
+
+    for ( i = 0; i < sizeof(expected) / sizeof(expected[0]); i++ )
+    {
+       status = OS_QueueGet(queue_id, &msg, sizeof(msg), &size_copied, OS_CHECK);
+       if ( status != OS_SUCCESS || msg.seq != expected[i] )
+       {
+          OS_printf("Priority get %d returned %d, message %lu, expected %lu\n", i, (int)status,
+                    (unsigned long)msg.seq, (unsigned long)expected[i]);
+          errors++;
+          break;
+       }
+    }
+
+    if ( OS_QueueGet(queue_id, &msg, sizeof(msg), &size_copied, OS_CHECK) != OS_QUEUE_EMPTY )
+    {
+       OS_printf("Priority queue not empty after all messages were got\n");
+       errors++;
+    }
+
+    /* Bulk messages in the queue, then an urgent batch behind them */
+    for ( i = 0; i < 4; i++ )
+    {
+       batch[i].producer = 0;
+       batch[i].seq      = i;
+    }
+    OS_QueuePutBatch(queue_id, batch, sizeof(message_t), 4, &count_put, 0);
+    for ( i = 0; i < 2; i++ )
+    {
+       batch[i].seq = 100 + i;
+    }
+    OS_QueuePutBatch(queue_id, batch, sizeof(message_t), 2, &count_put,
+                     OS_QUEUE_PRIORITY(OS_QUEUE_PRIORITIES - 1));
+
+    memset(batch, 0, sizeof(batch));
+    status = OS_QueueGetBatch(queue_id, batch, sizeof(message_t), 2 * QUEUE_DEPTH,
+                              batch_sizes, &count, OS_CHECK);
+    if ( status != OS_SUCCESS || count != 6 || batch[0].seq != 100 || batch[1].seq != 101 ||
+         batch[2].seq != 0 || batch[5].seq != 3 )
+    {
+       OS_printf("Priority batch get returned %d, %lu messages starting %lu %lu %lu\n",
+                 (int)status, (unsigned long)count, (unsigned long)batch[0].seq,
+                 (unsigned long)batch[1].seq, (unsigned long)batch[2].seq);
+       errors++;
+    }
+
+    OS_QueueDelete(queue_id);
+}
+
+/*
+** Checks that the statistics of a queue follow its puts and gets
+*/
+void stats_test(void)
+{
+    OS_queue_stats_t stats;
+    message_t        msg;
+    uint32           size_copied;
+#ifdef OSAL_RING_QUEUE
+    uint64           latencies;
+#endif
+    int32            status;
+    int              i;
+
+    if ( OS_QueueCreate(&queue_id, "Stats", QUEUE_DEPTH, sizeof(message_t),
+                        OS_QUEUE_LATENCY) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the stats queue\n");
+       errors++;
+       return;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    for ( i = 0; i < 3; i++ )
+    {
+       OS_QueuePut(queue_id, &msg, sizeof(msg), 0);
+    }
+    OS_QueueGet(queue_id, &msg, sizeof(msg), &size_copied, OS_CHECK);
+    OS_QueueGet(queue_id, &msg, sizeof(msg), &size_copied, OS_CHECK);
+
+    status = OS_QueueGetStats(queue_id, &stats);
+    if ( status != OS_SUCCESS || stats.depth != 1 || stats.puts != 3 || stats.gets != 2 ||
+         stats.high_water != 3 || stats.full != 0 )
+    {
+       OS_printf("Stats returned %d, depth %lu, %lu puts, %lu gets, high water %lu\n",
+                 (int)status, (unsigned long)stats.depth, (unsigned long)stats.puts,
+                 (unsigned long)stats.gets, (unsigned long)stats.high_water);
+       errors++;
+    }
+
+    OS_QueueGet(queue_id, &msg, sizeof(msg), &size_copied, OS_CHECK);
+    OS_QueueGet(queue_id, &msg, sizeof(msg), &size_copied, OS_CHECK);
+    OS_QueueGet(queue_id, &msg, sizeof(msg), &size_copied, 10);
+
+    /* Fill the queue up */
+    for ( i = 0; i < 100000; i++ )
+    {
+       if ( OS_QueuePut(queue_id, &msg, sizeof(msg), 0) == OS_QUEUE_FULL )
+       {
+          break;
+       }
+    }
+
+    OS_QueueGetStats(queue_id, &stats);
+    if ( stats.empty != 1 || stats.timeouts != 1 || stats.full != 1 ||
+         stats.depth != i || stats.high_water != i || stats.max_depth < QUEUE_DEPTH )
+    {
+       OS_printf("Stats after %d puts to fill: %lu empty, %lu timeouts, %lu full, depth %lu of %lu,"
+                 " high water %lu\n", i, (unsigned long)stats.empty,
+                 (unsigned long)stats.timeouts, (unsigned long)stats.full,
+                 (unsigned long)stats.depth, (unsigned long)stats.max_depth,
+                 (unsigned long)stats.high_water);
+       errors++;
+    }
+
+#ifdef OSAL_RING_QUEUE
+    latencies = 0;
+    for ( i = 0; i < OS_QUEUE_LATENCY_BUCKETS; i++ )
+    {
+       latencies += stats.latency[i];
+    }
+    if ( latencies != stats.gets )
+    {
+       OS_printf("Latency histogram holds %lu messages of %lu got\n",
+                 (unsigned long)latencies, (unsigned long)stats.gets);
+       errors++;
+    }
+#endif
+
+    OS_QueueDelete(queue_id);
+}
+
+/*
+** Waits a while, then gets the messages from the queue until none comes for
+** DRAIN_TIMEOUT msecs
+*/
+void drain_task(void)
+{
+    message_t msg;
+    uint32    size;
+
+    OS_TaskRegister();
+
+    OS_TaskDelay(DRAIN_DELAY);
+    drained = 0;
+    while ( OS_QueueGet(queue_id, &msg, sizeof(msg), &size, DRAIN_TIMEOUT) == OS_SUCCESS )
+    {
+       drained++;
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+/*
+** Fills a queue and returns how many messages it took, numbered from first
+*/
+uint32 fill_queue(uint32 first)
+{
+    message_t msg;
+    uint32    count;
+
+    msg.producer = 0;
+    for ( count = 0; count < 100000; count++ )
+    {
+       msg.seq = first + count;
+       if ( OS_QueuePut(queue_id, &msg, sizeof(msg), 0) != OS_SUCCESS )
+       {
+          break;
+       }
+    }
+
+    return(count);
+}
+
+/*
+** Checks what a put to a full queue does: drop the oldest message, drop the
+** new one, wait for room, or time out
+*/
+void policy_test(void)
+{
+    OS_queue_stats_t stats;
+    message_t        msg;
+    uint32           size;
+    uint32           depth;
+    uint32           count;
+    int32            status;
+    uint32           i;
+
+    /*
+    ** Overwrite the oldest message, the gets find the newest depth messages
+    */
+    if ( OS_QueueCreate(&queue_id, "Overwrite", QUEUE_DEPTH, sizeof(message_t),
+                        OS_QUEUE_OVERWRITE) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the overwrite queue\n");
+       errors++;
+       return;
+    }
+
+    /* Find out how many messages the queue holds, the last put counts as full */
+    depth = 0;
+    msg.producer = 0;
+    msg.seq      = 0;
+    while ( depth < 100000 &&
+            OS_QueuePutTimeout(queue_id, &msg, sizeof(msg), 0, OS_CHECK) == OS_SUCCESS )
+    {
+       depth++;
+    }
+    while ( OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK) == OS_SUCCESS )
+    {
+    }
+
+    count = fill_queue(0);
+    if ( count != 100000 )
+    {
+       OS_printf("Overwrite queue took %lu messages, expected all of them\n",
+                 (unsigned long)count);
+       errors++;
+    }
+
+    for ( i = 0; i < depth; i++ )
+    {
+       status = OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK);
+       if ( status != OS_SUCCESS || msg.seq != count - depth + i )
+       {
+          OS_printf("Overwrite get %lu returned %d, message %lu\n", (unsigned long)i,
+                    (int)status, (unsigned long)msg.seq);
+          errors++;
+          break;
+       }
+    }
+
+    OS_QueueGetStats(queue_id, &stats);
+    if ( stats.overwritten != count - depth || stats.depth != 0 || stats.full != 1 )
+    {
+       OS_printf("Stats after overwrites: %lu overwritten, depth %lu, %lu full\n",
+                 (unsigned long)stats.overwritten, (unsigned long)stats.depth,
+                 (unsigned long)stats.full);
+       errors++;
+    }
+
+    /* An overwrite never drops a message of another priority */
+    msg.seq = 0;
+    for ( i = 0; i + 1 < depth; i++ )
+    {
+       OS_QueuePut(queue_id, &msg, sizeof(msg), 0);
+    }
+    msg.seq = 1000;
+    OS_QueuePut(queue_id, &msg, sizeof(msg), OS_QUEUE_PRIORITY(1));
+    msg.seq = 0;
+    status = OS_QueuePut(queue_id, &msg, sizeof(msg), 0);
+#if !defined(OSAL_RING_QUEUE) && !defined(OSAL_SOCKET_QUEUE)
+    if ( status != OS_QUEUE_FULL )
+#else
+    if ( status != OS_SUCCESS )
+#endif
+    {
+       OS_printf("Overwrite with a message of another priority queued returned %d\n",
+                 (int)status);
+       errors++;
+    }
+    if ( OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK) != OS_SUCCESS ||
+         msg.seq != 1000 )
+    {
+       OS_printf("An overwrite dropped the message of another priority\n");
+       errors++;
+    }
+    while ( OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK) == OS_SUCCESS )
+    {
+    }
+    OS_QueueDelete(queue_id);
+
+    /*
+    ** Drop the newest message, chosen for one put
+    */
+    if ( OS_QueueCreate(&queue_id, "Policy", QUEUE_DEPTH, sizeof(message_t), 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the policy queue\n");
+       errors++;
+       return;
+    }
+
+    depth = fill_queue(0);
+    msg.seq = depth;
+    status  = OS_QueuePut(queue_id, &msg, sizeof(msg), OS_QUEUE_DROP_NEWEST);
+    OS_QueueGetStats(queue_id, &stats);
+    if ( status != OS_SUCCESS || stats.dropped != 1 || stats.depth != depth )
+    {
+       OS_printf("Drop newest put returned %d, %lu dropped, depth %lu of %lu\n", (int)status,
+                 (unsigned long)stats.dropped, (unsigned long)stats.depth, (unsigned long)depth);
+       errors++;
+    }
+
+    /*
+    ** Time out, then wait until the drain task makes room
+    */
+    status = OS_QueuePutTimeout(queue_id, &msg, sizeof(msg), 0, 20);
+    if ( status != OS_QUEUE_TIMEOUT )
+    {
+       OS_printf("Timed put to a full queue returned %d, expected OS_QUEUE_TIMEOUT\n",
+                 (int)status);
+       errors++;
+    }
+
+    if ( OS_TaskCreate(&consumer_id[0], "Drain 0", drain_task, consumer_stack[0],
+                       TASK_STACK_SIZE, CONSUMER_PRIORITY, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the drain task\n");
+       errors++;
+       OS_QueueDelete(queue_id);
+       return;
+    }
+
+    status = OS_QueuePut(queue_id, &msg, sizeof(msg), OS_QUEUE_BLOCK);
+    if ( status != OS_SUCCESS )
+    {
+       OS_printf("Blocking put returned %d\n", (int)status);
+       errors++;
+    }
+    OS_CountSemTake(done_sem_id);
+
+    OS_QueueGetStats(queue_id, &stats);
+    if ( drained != depth + 1 || stats.full != 2 )
+    {
+       OS_printf("Drained %lu messages of %lu, %lu full\n", (unsigned long)drained,
+                 (unsigned long)depth + 1, (unsigned long)stats.full);
+       errors++;
+    }
+
+    OS_QueueDelete(queue_id);
+}
+
+/*
+** Checks that a reserved message keeps its place in the queue, then moves
+** frames through a queue with copies and in place
+*/
+void zero_copy_test(void)
+{
+    OS_time_t  start;
+    message_t  msg;
+    void      *ptr;
+    void      *frame_ptr;
+    uint32     size;
+    int32      status;
+    int        i;
+
+    if ( OS_QueueCreate(&queue_id, "Frames", QUEUE_DEPTH, FRAME_SIZE, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the frame queue\n");
+       errors++;
+       return;
+    }
+
+    memset(frame, 0x5A, sizeof(frame));
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_FRAMES; i++ )
+    {
+       OS_QueuePut(queue_id, frame, FRAME_SIZE, 0);
+       OS_QueueGet(queue_id, frame, FRAME_SIZE, &size, OS_CHECK);
+    }
+    OS_printf("%d byte frames, put/get:              %lu nsecs per frame\n", FRAME_SIZE,
+              (unsigned long)nsecs_per_op(&start, NUM_FRAMES));
+
+    status = OS_QueueReserve(queue_id, FRAME_SIZE, &frame_ptr);
+    if ( status == OS_ERR_NOT_IMPLEMENTED )
+    {
+       OS_printf("This queue implementation has no zero copy API\n");
+#ifdef OSAL_RING_QUEUE
+       errors++;
+#endif
+       OS_QueueDelete(queue_id);
+       return;
+    }
+    else if ( status != OS_SUCCESS )
+    {
+       OS_printf("Reserve returned %d\n", (int)status);
+       errors++;
+       OS_QueueDelete(queue_id);
+       return;
+    }
+
+    /*
+    ** A message put after a reserved one comes out after it
+    */
+    msg.producer = 0;
+    msg.seq      = 2;
+    OS_QueuePut(queue_id, &msg, sizeof(msg), 0);
+
+    status = OS_QueueGetPtr(queue_id, &ptr, &size, OS_CHECK);
+    if ( status != OS_QUEUE_EMPTY )
+    {
+       OS_printf("Get ahead of a reserved message returned %d, expected OS_QUEUE_EMPTY\n",
+                 (int)status);
+       errors++;
+    }
+
+    ((message_t *)frame_ptr)->producer = 0;
+    ((message_t *)frame_ptr)->seq      = 1;
+    OS_QueueCommit(queue_id, frame_ptr);
+
+    for ( i = 1; i <= 2; i++ )
+    {
+       status = OS_QueueGetPtr(queue_id, &ptr, &size, OS_CHECK);
+       if ( status != OS_SUCCESS || ((message_t *)ptr)->seq != i ||
+            size != ((i == 1) ? FRAME_SIZE : sizeof(msg)) )
+       {
+          OS_printf("Get in place %d returned %d, size %lu\n", i, (int)status,
+                    (unsigned long)size);
+          errors++;
+          break;
+       }
+       if ( OS_QueueRelease(queue_id, ptr) != OS_SUCCESS )
+       {
+          OS_printf("Release %d failed\n", i);
+          errors++;
+       }
+    }
+
+    if ( OS_QueueRelease(queue_id, frame) != OS_INVALID_POINTER )
+    {
+       OS_printf("Release of a pointer outside the queue did not fail\n");
+       errors++;
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_FRAMES; i++ )
+    {
+       OS_QueueReserve(queue_id, FRAME_SIZE, &ptr);
+       ((message_t *)ptr)->seq = i;
+       OS_QueueCommit(queue_id, ptr);
+       OS_QueueGetPtr(queue_id, &ptr, &size, OS_CHECK);
+       OS_QueueRelease(queue_id, ptr);
+    }
+    OS_printf("%d byte frames, reserve/get in place: %lu nsecs per frame\n", FRAME_SIZE,
+              (unsigned long)nsecs_per_op(&start, NUM_FRAMES));
+
+    OS_QueueDelete(queue_id);
+}
+
+void test_task(void)
+{
+    OS_time_t  start;
+    message_t  msg;
+    uint32     size;
+    uint32     count;
+    int32      status;
+    int        i;
+
+    OS_TaskRegister();
+
+    /*
+    ** Fill a queue, then empty it
+    */
+    if ( OS_QueueCreate(&queue_id, "Depth", QUEUE_DEPTH, sizeof(msg), 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the depth queue\n");
+       errors++;
+    }
+
+    msg.producer = 0;
+    for ( count = 0; count < 100; count++ )
+    {
+       msg.seq = count;
+       if ( OS_QueuePut(queue_id, &msg, sizeof(msg), 0) != OS_SUCCESS )
+       {
+          break;
+       }
+    }
+    OS_printf("Queue of depth %d took %lu messages\n", QUEUE_DEPTH, (unsigned long)count);
+#ifdef OSAL_RING_QUEUE
+    if ( count != QUEUE_DEPTH )
+    {
+       OS_printf("Expected the queue to take %d messages\n", QUEUE_DEPTH);
+       errors++;
+    }
+#endif
+
+    for ( i = 0; i < count; i++ )
+    {
+       status = OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK);
+       if ( status != OS_SUCCESS || msg.seq != i )
+       {
+          OS_printf("Get %d returned %d, message %lu\n", i, (int)status, (unsigned long)msg.seq);
+          errors++;
+          break;
+       }
+    }
+
+    status = OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK);
+    if ( status != OS_QUEUE_EMPTY )
+    {
+       OS_printf("Get from an empty queue returned %d, expected OS_QUEUE_EMPTY\n", (int)status);
+       errors++;
+    }
+
+    status = OS_QueueGet(queue_id, &msg, sizeof(msg), &size, 20);
+    if ( status != OS_QUEUE_TIMEOUT )
+    {
+       OS_printf("Timed get from an empty queue returned %d, expected OS_QUEUE_TIMEOUT\n",
+                 (int)status);
+       errors++;
+    }
+
+    /*
+    ** Nobody waiting
+    */
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_UNCONTENDED; i++ )
+    {
+       OS_QueuePut(queue_id, &msg, sizeof(msg), 0);
+       OS_QueueGet(queue_id, &msg, sizeof(msg), &size, OS_CHECK);
+    }
+    OS_printf("Put/get, no waiters: %lu nsecs per pair\n",
+              (unsigned long)nsecs_per_op(&start, NUM_UNCONTENDED));
+
+    OS_QueueDelete(queue_id);
+
+    /*
+    ** Streams between tasks
+    */
+    stream_test(0, "SPSC", OS_QUEUE_SPSC, 1, 1);
+    stream_test(1, "MPMC", 0, 1, 1);
+    stream_test(2, "MPMC", 0, NUM_PRODUCERS, NUM_CONSUMERS);
+
+    batch_test();
+    priority_test();
+    stats_test();
+    policy_test();
+    zero_copy_test();
+
+    if ( errors == 0 )
+    {
+       OS_printf("Queue Speed Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Queue Speed Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_CountSemCreate(&done_sem_id, "Done", 0, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the done semaphore\n");
+   }
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
@@ -0,0 +1,217 @@
+/*
+** Reader/Writer Lock Test
+**
+** Several reader tasks check that a pair of values is always consistent
+** while a writer task keeps updating it, once for each lock preference.
+** Also checks the name lookup and the rejected option combination.
+*/
+#include <stdio.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define WORKER_PRIORITY   100
+
+#define NUM_READERS       3
+#define NUM_READS         100000
+#define NUM_WRITES        20000
+#define NUM_OPTION_SETS   3
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+
+uint32 reader_stack[NUM_READERS][TASK_STACK_SIZE];
+uint32 reader_id[NUM_READERS];
+
+uint32 writer_stack[TASK_STACK_SIZE];
+uint32 writer_id;
+
+uint32 done_sem_id;
+uint32 rwlock_id;
+
+volatile uint32 shared_first;
+volatile uint32 shared_second;
+uint32 errors;
+
+uint32 option_sets[NUM_OPTION_SETS] =
+{
+   0,
+   OS_RWLOCK_PREFER_READER,
+   OS_RWLOCK_PREFER_WRITER
+};
+
+char *option_names[NUM_OPTION_SETS] =
+{
+   "default",
+   "prefer reader",
+   "prefer writer"
+};
+
+void reader_task(void)
+{
+    int i;
+
+    OS_TaskRegister();
+
+    for ( i = 0; i < NUM_READS; i++ )
+    {
+       if ( OS_RwLockReadTake(rwlock_id) != OS_SUCCESS )
+       {
+          errors++;
+       }
+       if ( shared_first != shared_second )
+       {
+          errors++;
+       }
+       if ( OS_RwLockGive(rwlock_id) != OS_SUCCESS )
+       {
+          errors++;
+       }
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+void writer_task(void)
+{
+    int i;
+
+    OS_TaskRegister();
+
+    for ( i = 0; i < NUM_WRITES; i++ )
+    {
+       if ( OS_RwLockWriteTake(rwlock_id) != OS_SUCCESS )
+       {
+          errors++;
+       }
+       shared_first++;
+       shared_second++;
+       if ( OS_RwLockGive(rwlock_id) != OS_SUCCESS )
+       {
+          errors++;
+       }
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+void test_task(void)
+{
+    OS_time_t         start;
+    OS_time_t         end;
+    OS_rwlock_prop_t  rwlock_prop;
+    double            usecs;
+    char              name[OS_MAX_API_NAME];
+    uint32            found_id;
+    uint32            bad_id;
+    int               set;
+    int               i;
+
+    OS_TaskRegister();
+
+    if ( OS_RwLockCreate(&bad_id, "Bad", OS_RWLOCK_PREFER_READER | OS_RWLOCK_PREFER_WRITER) != OS_ERROR )
+    {
+       OS_printf("A lock preferring both readers and writers was created\n");
+       errors++;
+    }
+
+    for ( set = 0; set < NUM_OPTION_SETS; set++ )
+    {
+       if ( OS_RwLockCreate(&rwlock_id, "Shared", option_sets[set]) != OS_SUCCESS )
+       {
+          OS_printf("Error creating the %s lock\n", option_names[set]);
+          errors++;
+          continue;
+       }
+
+       if ( OS_RwLockGetIdByName(&found_id, "Shared") != OS_SUCCESS || found_id != rwlock_id ||
+            OS_RwLockGetInfo(rwlock_id, &rwlock_prop) != OS_SUCCESS ||
+            rwlock_prop.creator != OS_TaskGetId() )
+       {
+          OS_printf("The %s lock could not be looked up\n", option_names[set]);
+          errors++;
+       }
+
+       shared_first  = 0;
+       shared_second = 0;
+       OS_GetLocalTime(&start);
+
+       for ( i = 0; i < NUM_READERS; i++ )
+       {
+          sprintf(name, "Reader %d.%d", set, i);
+          if ( OS_TaskCreate(&reader_id[i], name, reader_task, reader_stack[i],
+                             TASK_STACK_SIZE, WORKER_PRIORITY, 0) != OS_SUCCESS )
+          {
+             OS_printf("Error creating %s\n", name);
+             errors++;
+          }
+       }
+
+       sprintf(name, "Writer %d", set);
+       if ( OS_TaskCreate(&writer_id, name, writer_task, writer_stack,
+                          TASK_STACK_SIZE, WORKER_PRIORITY, 0) != OS_SUCCESS )
+       {
+          OS_printf("Error creating %s\n", name);
+          errors++;
+       }
+
+       for ( i = 0; i < NUM_READERS + 1; i++ )
+       {
+          OS_CountSemTake(done_sem_id);
+       }
+
+       OS_GetLocalTime(&end);
+       usecs = (double)(end.seconds - start.seconds) * 1000000.0 +
+               (double)end.microsecs - (double)start.microsecs;
+
+       OS_printf("%-14s lock, %d readers and a writer: %lu nsecs per take/give\n",
+                 option_names[set], NUM_READERS,
+                 (unsigned long)((usecs * 1000.0) / (NUM_READERS * NUM_READS + NUM_WRITES)));
+
+       if ( shared_first != NUM_WRITES )
+       {
+          OS_printf("Writer count is %lu, expected %lu\n", (unsigned long)shared_first,
+                    (unsigned long)NUM_WRITES);
+          errors++;
+       }
+
+       if ( OS_RwLockDelete(rwlock_id) != OS_SUCCESS )
+       {
+          OS_printf("Error deleting the %s lock\n", option_names[set]);
+          errors++;
+       }
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Reader/Writer Lock Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Reader/Writer Lock Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_CountSemCreate(&done_sem_id, "Done", 0, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the done semaphore\n");
+   }
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
@@ -0,0 +1,215 @@
+/*
+** Semaphore Speed Test
+**
+** Measures the cost of giving and taking binary and counting semaphores,
+** first from a single task with nobody waiting, then between two tasks
+** that hand a semaphore back and forth. Last, several tasks wait on one
+** counting semaphore to check that no give is lost.
+*/
+#include <stdio.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define PONG_PRIORITY     100
+#define WAITER_PRIORITY   100
+
+#define NUM_UNCONTENDED   1000000
+#define NUM_PING_PONG     100000
+#define NUM_WAITERS       4
+#define NUM_WAITER_TAKES  25000
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+
+uint32 pong_stack[TASK_STACK_SIZE];
+uint32 pong_id;
+
+uint32 waiter_stack[NUM_WAITERS][TASK_STACK_SIZE];
+uint32 waiter_id[NUM_WAITERS];
+
+uint32 ping_sem_id;
+uint32 pong_sem_id;
+uint32 work_sem_id;
+uint32 done_sem_id;
+
+uint32 errors;
+
+/*
+** Elapsed time in nanoseconds per operation since start
+*/
+uint32 nsecs_per_op(OS_time_t *start, uint32 ops)
+{
+    OS_time_t end;
+    double    usecs;
+
+    OS_GetLocalTime(&end);
+    usecs = (double)(end.seconds - start->seconds) * 1000000.0 +
+            (double)end.microsecs - (double)start->microsecs;
+
+    return((uint32)((usecs * 1000.0) / ops));
+}
+
+void pong_task(void)
+{
+    int i;
+
+    OS_TaskRegister();
+
+    for ( i = 0; i < NUM_PING_PONG; i++ )
+    {
+       if ( OS_BinSemTake(ping_sem_id) != OS_SUCCESS )
+       {
+          errors++;
+       }
+       if ( OS_BinSemGive(pong_sem_id) != OS_SUCCESS )
+       {
+          errors++;
+       }
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+void waiter_task(void)
+{
+    int i;
+
+    OS_TaskRegister();
+
+    for ( i = 0; i < NUM_WAITER_TAKES; i++ )
+    {
+       if ( OS_CountSemTake(work_sem_id) != OS_SUCCESS )
+       {
+          errors++;
+       }
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+void test_task(void)
+{
+    OS_time_t            start;
+    OS_count_sem_prop_t  count_prop;
+    char                 name[OS_MAX_API_NAME];
+    int                  i;
+
+    OS_TaskRegister();
+
+    /*
+    ** Nobody waiting
+    */
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_UNCONTENDED; i++ )
+    {
+       OS_BinSemGive(ping_sem_id);
+       OS_BinSemTake(ping_sem_id);
+    }
+    OS_printf("Binary sem give/take, no waiters:   %lu nsecs per pair\n",
+              (unsigned long)nsecs_per_op(&start, NUM_UNCONTENDED));
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_UNCONTENDED; i++ )
+    {
+       OS_CountSemGive(work_sem_id);
+       OS_CountSemTake(work_sem_id);
+    }
+    OS_printf("Counting sem give/take, no waiters: %lu nsecs per pair\n",
+              (unsigned long)nsecs_per_op(&start, NUM_UNCONTENDED));
+
+    /*
+    ** Two tasks handing a binary semaphore back and forth
+    */
+    if ( OS_TaskCreate(&pong_id, "Pong", pong_task, pong_stack,
+                       TASK_STACK_SIZE, PONG_PRIORITY, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the pong task\n");
+       errors++;
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_PING_PONG; i++ )
+    {
+       OS_BinSemGive(ping_sem_id);
+       OS_BinSemTake(pong_sem_id);
+    }
+    OS_printf("Binary sem ping-pong:               %lu nsecs per round trip\n",
+              (unsigned long)nsecs_per_op(&start, NUM_PING_PONG));
+    OS_CountSemTake(done_sem_id);
+
+    /*
+    ** Several tasks waiting on one counting semaphore. Every give must
+    ** release exactly one take.
+    */
+    for ( i = 0; i < NUM_WAITERS; i++ )
+    {
+       sprintf(name, "Waiter %d", i);
+       if ( OS_TaskCreate(&waiter_id[i], name, waiter_task, waiter_stack[i],
+                          TASK_STACK_SIZE, WAITER_PRIORITY, 0) != OS_SUCCESS )
+       {
+          OS_printf("Error creating %s\n", name);
+          errors++;
+       }
+    }
+
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_WAITERS * NUM_WAITER_TAKES; i++ )
+    {
+       OS_CountSemGive(work_sem_id);
+    }
+    for ( i = 0; i < NUM_WAITERS; i++ )
+    {
+       if ( OS_CountSemTimedWait(done_sem_id, 10000) != OS_SUCCESS )
+       {
+          OS_printf("A waiter did not get all of its gives\n");
+          errors++;
+          break;
+       }
+    }
+    OS_printf("Counting sem, %d waiters:            %lu nsecs per give\n", NUM_WAITERS,
+              (unsigned long)nsecs_per_op(&start, NUM_WAITERS * NUM_WAITER_TAKES));
+
+    OS_CountSemGetInfo(work_sem_id, &count_prop);
+    if ( count_prop.value != 0 )
+    {
+       OS_printf("Counting sem value is %d, expected 0\n", (int)count_prop.value);
+       errors++;
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Semaphore Speed Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Semaphore Speed Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_BinSemCreate(&ping_sem_id, "Ping", 0, 0) != OS_SUCCESS ||
+        OS_BinSemCreate(&pong_sem_id, "Pong", 0, 0) != OS_SUCCESS ||
+        OS_CountSemCreate(&work_sem_id, "Work", 0, 0) != OS_SUCCESS ||
+        OS_CountSemCreate(&done_sem_id, "Done", 0, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the semaphores\n");
+   }
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
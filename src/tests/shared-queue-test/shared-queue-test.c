@@ -0,0 +1,249 @@
+/*
+** Shared Queue Test
+**
+** A child process opens two queues the parent creates with OS_QUEUE_SHARED
+** after the fork, by their names. The parent streams messages through a
+** small queue to the child, which checks their order, then times round trips
+** of a message to the child and back.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+
+#define QUEUE_DEPTH       16
+#define MSG_WORDS         16
+#define NUM_STREAMED      100000
+#define NUM_ROUND_TRIPS   10000
+#define FIND_TRIES        200
+#define FIND_DELAY        10
+#define REPLY_TIMEOUT     5000
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+
+uint32 errors;
+
+char request_name[OS_MAX_API_NAME];
+char reply_name[OS_MAX_API_NAME];
+
+/*
+** Looks a queue of the parent up, waiting for the parent to create it
+*/
+uint32 find_queue(const char *name)
+{
+    uint32 queue_id;
+    int    tries;
+
+    for ( tries = 0; OS_QueueGetIdByName(&queue_id, name) != OS_SUCCESS; tries++ )
+    {
+       if ( tries == FIND_TRIES )
+       {
+          _exit(100);
+       }
+       OS_TaskDelay(FIND_DELAY);
+    }
+
+    return(queue_id);
+}
+
+/*
+** Child that checks the streamed messages, then answers each round trip.
+** Exits with the number of errors it found, up to 99.
+*/
+void child_process(void)
+{
+    uint32 msg[MSG_WORDS];
+    uint32 request_id;
+    uint32 reply_id;
+    uint32 size;
+    uint32 child_errors;
+    uint32 i;
+
+    request_id = find_queue(request_name);
+    reply_id   = find_queue(reply_name);
+
+    child_errors = 0;
+    for ( i = 0; i < NUM_STREAMED + NUM_ROUND_TRIPS; i++ )
+    {
+       if ( OS_QueueGet(request_id, msg, sizeof(msg), &size, OS_PEND) != OS_SUCCESS ||
+            msg[0] != i || msg[MSG_WORDS - 1] != ~i )
+       {
+          child_errors++;
+       }
+       if ( i >= NUM_STREAMED &&
+            OS_QueuePut(reply_id, msg, sizeof(msg), OS_QUEUE_BLOCK) != OS_SUCCESS )
+       {
+          child_errors++;
+       }
+    }
+
+    OS_QueueDelete(request_id);
+    OS_QueueDelete(reply_id);
+    _exit((child_errors < 99) ? child_errors : 99);
+}
+
+/*
+** Elapsed nsecs from start to end, per count operations
+*/
+unsigned long nsecs_per(OS_time_t *start, OS_time_t *end, uint32 count)
+{
+    double usecs;
+
+    usecs = (double)(end->seconds - start->seconds) * 1000000.0 +
+            (double)end->microsecs - (double)start->microsecs;
+
+    return((unsigned long)((usecs * 1000.0) / count));
+}
+
+void test_task(void)
+{
+    OS_time_t         start;
+    OS_time_t         end;
+    OS_queue_stats_t  stats;
+    uint32            msg[MSG_WORDS];
+    uint32            request_id;
+    uint32            reply_id;
+    uint32            found_id;
+    uint32            size;
+    pid_t             child;
+    int               status;
+    int32             ret;
+    uint32            i;
+
+    OS_TaskRegister();
+
+    /* names of their own, so a test killed before it cleaned up does not matter */
+    sprintf(request_name, "Request%d", (int)getpid());
+    sprintf(reply_name, "Reply%d", (int)getpid());
+
+    memset(msg, 0, sizeof(msg));
+
+    child = fork();
+    if ( child == 0 )
+    {
+       child_process();
+    }
+
+    ret = OS_QueueCreate(&request_id, request_name, QUEUE_DEPTH, sizeof(msg), OS_QUEUE_SHARED);
+    if ( ret == OS_ERROR )
+    {
+       /* only the ring queues are shared, the child would never find them */
+       OS_printf("Shared queues need OSAL_RING_QUEUE, skipped\n");
+       kill(child, SIGKILL);
+       waitpid(child, &status, 0);
+    }
+    else if ( ret != OS_SUCCESS ||
+              OS_QueueCreate(&reply_id, reply_name, QUEUE_DEPTH, sizeof(msg),
+                             OS_QUEUE_SHARED) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the shared queues\n");
+       errors++;
+    }
+    else
+    {
+       if ( OS_QueueCreate(&found_id, request_name, QUEUE_DEPTH, sizeof(msg),
+                           OS_QUEUE_SHARED) != OS_ERR_NAME_TAKEN )
+       {
+          OS_printf("A second shared queue of the same name was created\n");
+          errors++;
+       }
+
+       /* The child checks the order, and the puts wait on it for room */
+       OS_GetLocalTime(&start);
+       for ( i = 0; i < NUM_STREAMED; i++ )
+       {
+          msg[0] = i;
+          msg[MSG_WORDS - 1] = ~i;
+          if ( OS_QueuePut(request_id, msg, sizeof(msg), OS_QUEUE_BLOCK) != OS_SUCCESS )
+          {
+             errors++;
+          }
+       }
+       OS_GetLocalTime(&end);
+       OS_printf("Streamed to another process: %lu nsecs per message\n",
+                 nsecs_per(&start, &end, NUM_STREAMED));
+
+       OS_GetLocalTime(&start);
+       for ( ; i < NUM_STREAMED + NUM_ROUND_TRIPS; i++ )
+       {
+          msg[0] = i;
+          msg[MSG_WORDS - 1] = ~i;
+          if ( OS_QueuePut(request_id, msg, sizeof(msg), OS_QUEUE_BLOCK) != OS_SUCCESS ||
+               OS_QueueGet(reply_id, msg, sizeof(msg), &size, REPLY_TIMEOUT) != OS_SUCCESS ||
+               msg[0] != i )
+          {
+             errors++;
+          }
+       }
+       OS_GetLocalTime(&end);
+       OS_printf("Round trip to another process: %lu nsecs\n",
+                 nsecs_per(&start, &end, NUM_ROUND_TRIPS));
+
+       /* the child would wait for messages that were not put */
+       if ( errors != 0 )
+       {
+          kill(child, SIGKILL);
+       }
+
+       if ( waitpid(child, &status, 0) != child || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0 )
+       {
+          OS_printf("The child found errors, status %d\n", status);
+          errors++;
+       }
+
+       if ( OS_QueueGetStats(request_id, &stats) != OS_SUCCESS ||
+            stats.puts != NUM_STREAMED + NUM_ROUND_TRIPS ||
+            stats.gets != NUM_STREAMED + NUM_ROUND_TRIPS || stats.depth != 0 )
+       {
+          OS_printf("The stats do not add up\n");
+          errors++;
+       }
+
+       if ( OS_QueueDelete(request_id) != OS_SUCCESS ||
+            OS_QueueDelete(reply_id) != OS_SUCCESS )
+       {
+          OS_printf("Error deleting the shared queues\n");
+          errors++;
+       }
+
+       if ( OS_QueueGetIdByName(&found_id, request_name) != OS_ERR_NAME_NOT_FOUND )
+       {
+          OS_printf("The deleted queue can still be found\n");
+          errors++;
+       }
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Shared Queue Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Shared Queue Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
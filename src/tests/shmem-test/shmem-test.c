@@ -0,0 +1,292 @@
+/*
+** Shared Memory Test
+**
+** Creates segments and checks the name lookup and the attach address. A
+** child process dies holding the semaphore of a segment, which must then be
+** handed on to the parent. Another child finds a segment the parent creates
+** after the fork by its name and checks the data in it. Also times a take and
+** give of the semaphore.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+
+#define SEGMENT_SIZE      65536
+#define HUGE_SEGMENT_SIZE (4 * 1024 * 1024)
+#define NUM_SEM_PAIRS     100000
+#define FIND_TRIES        200
+#define FIND_DELAY        10
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+
+uint32 errors;
+
+/*
+** Pattern written to a segment by one process and checked by the other
+*/
+uint8 pattern_byte(uint32 i)
+{
+    return((uint8)((i * 7) + 1));
+}
+
+/*
+** Child that waits for the parent to create segment name and fill it in, then
+** exits with 0 if the data is right
+*/
+void find_later_segment(const char *name)
+{
+    cpuaddr  address;
+    uint8   *data;
+    uint32   shmem_id;
+    uint32   ready;
+    uint32   i;
+    int      tries;
+
+    for ( tries = 0; OS_ShMemGetIdByName(&shmem_id, name) != OS_SUCCESS; tries++ )
+    {
+       if ( tries == FIND_TRIES )
+       {
+          _exit(1);
+       }
+       OS_TaskDelay(FIND_DELAY);
+    }
+
+    if ( OS_ShMemAttach(&address, shmem_id) != OS_SUCCESS )
+    {
+       _exit(2);
+    }
+    data = (uint8 *)address;
+
+    /* the first byte is set once the rest is written */
+    ready = 0;
+    for ( tries = 0; !ready && tries < FIND_TRIES; tries++ )
+    {
+       OS_ShMemSemTake(shmem_id);
+       ready = data[0];
+       for ( i = 1; ready && i < SEGMENT_SIZE; i++ )
+       {
+          if ( data[i] != pattern_byte(i) )
+          {
+             OS_ShMemSemGive(shmem_id);
+             _exit(3);
+          }
+       }
+       OS_ShMemSemGive(shmem_id);
+       if ( !ready )
+       {
+          OS_TaskDelay(FIND_DELAY);
+       }
+    }
+
+    OS_ShMemDelete(shmem_id);
+    _exit(ready ? 0 : 4);
+}
+
+void test_task(void)
+{
+    OS_time_t  start;
+    OS_time_t  end;
+    double     usecs;
+    cpuaddr    address;
+    uint8     *data;
+    uint32     shmem_id;
+    uint32     later_id;
+    uint32     huge_id;
+    uint32     found_id;
+    char       name[OS_MAX_API_NAME];
+    char       later_name[OS_MAX_API_NAME];
+    char       huge_name[OS_MAX_API_NAME];
+    pid_t      child;
+    int        status;
+    uint32     i;
+
+    OS_TaskRegister();
+
+    /* names of their own, so a test killed before it cleaned up does not matter */
+    sprintf(name, "Buffer%d", (int)getpid());
+    sprintf(later_name, "Later%d", (int)getpid());
+    sprintf(huge_name, "Huge%d", (int)getpid());
+
+    if ( OS_ShMemCreate(&shmem_id, SEGMENT_SIZE, name) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the segment\n");
+       errors++;
+    }
+
+    if ( OS_ShMemCreate(&found_id, SEGMENT_SIZE, name) != OS_ERR_NAME_TAKEN )
+    {
+       OS_printf("A second segment of the same name was created\n");
+       errors++;
+    }
+
+    if ( OS_ShMemGetIdByName(&found_id, name) != OS_SUCCESS || found_id != shmem_id )
+    {
+       OS_printf("The segment could not be looked up\n");
+       errors++;
+    }
+
+    if ( OS_ShMemAttach(&address, shmem_id) != OS_SUCCESS || address == 0 )
+    {
+       OS_printf("The segment could not be attached\n");
+       errors++;
+    }
+    data = (uint8 *)address;
+    memset(data, 0xA5, SEGMENT_SIZE);
+
+    /*
+    ** A child that dies holding the semaphore
+    */
+    child = fork();
+    if ( child == 0 )
+    {
+       OS_ShMemSemTake(shmem_id);
+       data[0] = 0x5A;
+       _exit(0);
+    }
+
+    if ( child < 0 || waitpid(child, &status, 0) != child )
+    {
+       OS_printf("Error running the child that holds the semaphore\n");
+       errors++;
+    }
+    else if ( OS_ShMemSemTake(shmem_id) != OS_SUCCESS )
+    {
+       OS_printf("The semaphore of a dead process was not handed on\n");
+       errors++;
+    }
+    else
+    {
+       if ( data[0] != 0x5A || data[SEGMENT_SIZE - 1] != 0xA5 )
+       {
+          OS_printf("The child did not share the segment\n");
+          errors++;
+       }
+       if ( OS_ShMemSemGive(shmem_id) != OS_SUCCESS )
+       {
+          OS_printf("Error giving the recovered semaphore\n");
+          errors++;
+       }
+    }
+
+    /*
+    ** A child that finds a segment created after it was forked
+    */
+    child = fork();
+    if ( child == 0 )
+    {
+       find_later_segment(later_name);
+    }
+
+    OS_TaskDelay(FIND_DELAY);
+    if ( OS_ShMemCreate(&later_id, SEGMENT_SIZE, later_name) != OS_SUCCESS ||
+         OS_ShMemAttach(&address, later_id) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the segment for the child to find\n");
+       errors++;
+    }
+    else
+    {
+       data = (uint8 *)address;
+       OS_ShMemSemTake(later_id);
+       for ( i = 1; i < SEGMENT_SIZE; i++ )
+       {
+          data[i] = pattern_byte(i);
+       }
+       data[0] = 1;
+       OS_ShMemSemGive(later_id);
+    }
+
+    if ( child < 0 || waitpid(child, &status, 0) != child ||
+         !WIFEXITED(status) || WEXITSTATUS(status) != 0 )
+    {
+       OS_printf("The child did not find the segment, status %d\n", status);
+       errors++;
+    }
+
+    if ( OS_ShMemDelete(later_id) != OS_SUCCESS )
+    {
+       OS_printf("Error deleting the segment found by the child\n");
+       errors++;
+    }
+
+    /*
+    ** Huge pages, or the usual pages when the system has none
+    */
+    if ( OS_ShMemCreateEx(&huge_id, HUGE_SEGMENT_SIZE, huge_name, OS_SHMEM_HUGE_PAGES) != OS_SUCCESS ||
+         OS_ShMemAttach(&address, huge_id) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the huge page segment\n");
+       errors++;
+    }
+    else
+    {
+       memset((void *)address, 0x3C, HUGE_SEGMENT_SIZE);
+       if ( ((uint8 *)address)[HUGE_SEGMENT_SIZE - 1] != 0x3C ||
+            OS_ShMemDelete(huge_id) != OS_SUCCESS )
+       {
+          OS_printf("Error using the huge page segment\n");
+          errors++;
+       }
+    }
+
+    /*
+    ** Semaphore speed
+    */
+    OS_GetLocalTime(&start);
+    for ( i = 0; i < NUM_SEM_PAIRS; i++ )
+    {
+       OS_ShMemSemTake(shmem_id);
+       OS_ShMemSemGive(shmem_id);
+    }
+    OS_GetLocalTime(&end);
+    usecs = (double)(end.seconds - start.seconds) * 1000000.0 +
+            (double)end.microsecs - (double)start.microsecs;
+    OS_printf("Segment semaphore: %lu nsecs per take/give\n",
+              (unsigned long)((usecs * 1000.0) / NUM_SEM_PAIRS));
+
+    if ( OS_ShMemDelete(shmem_id) != OS_SUCCESS )
+    {
+       OS_printf("Error deleting the segment\n");
+       errors++;
+    }
+
+    if ( OS_ShMemGetIdByName(&found_id, name) != OS_ERR_NAME_NOT_FOUND ||
+         OS_ShMemAttach(&address, shmem_id) != OS_ERR_INVALID_ID )
+    {
+       OS_printf("The deleted segment can still be found\n");
+       errors++;
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Shared Memory Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Shared Memory Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
@@ -0,0 +1,290 @@
+/*
+** Timer Dispatch Test
+**
+** Runs every timer there is at once and checks that each callback is called
+** for each expiration, that the callbacks do not interrupt the delay of a
+** task, that a timer can be deleted before it ever expires, that a callback
+** can delete its own timer, even with expirations left and a new timer made
+** in its place, and that no callback of a timer runs after OS_TimerDelete
+** returns. Then measures the jitter of a 1 msec periodic timer.
+*/
+#include <stdio.h>
+#include <string.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+
+#define MAX_TIMERS        4096
+#define TIMER_PERIOD      10000     /* usecs */
+#define RUN_MSECS         500
+#define DELAY_MSECS       200
+#define DELETE_MSECS      20
+#define STALL_MSECS       30
+#define JITTER_PERIOD     1000      /* usecs */
+#define JITTER_TICKS      1000
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+
+uint32 timer_ids[MAX_TIMERS];
+volatile uint32 timer_counts[MAX_TIMERS];
+volatile uint32 deleting;
+volatile uint32 self_deleted;
+volatile uint32 replace_calls;
+uint32 replaced_id;
+uint32 errors;
+
+OS_time_t        last_tick;
+volatile uint32  ticks;
+unsigned long    min_usecs;
+unsigned long    max_usecs;
+
+/*
+** Elapsed usecs from start to end
+*/
+unsigned long usecs_between(OS_time_t *start, OS_time_t *end)
+{
+    return((end->seconds - start->seconds) * 1000000 + end->microsecs - start->microsecs);
+}
+
+void count_func(uint32 timer_id)
+{
+    if ( deleting )
+    {
+       /* a callback that runs after its timer was deleted */
+       errors++;
+    }
+    timer_counts[timer_id]++;
+}
+
+void self_delete_func(uint32 timer_id)
+{
+    if ( OS_TimerDelete(timer_id) == OS_SUCCESS )
+    {
+       self_deleted++;
+    }
+}
+
+/*
+** Holds up the dispatch thread, so that the expirations of the other timers
+** pile up
+*/
+void stall_func(uint32 timer_id)
+{
+    OS_TaskDelay(STALL_MSECS);
+}
+
+void noop_func(uint32 timer_id)
+{
+}
+
+/*
+** Deletes its own timer with expirations still to be called, and creates a
+** new timer, which must not be called back with this function
+*/
+void replace_func(uint32 timer_id)
+{
+    uint32 accuracy;
+
+    replace_calls++;
+    if ( OS_TimerDelete(timer_id) != OS_SUCCESS ||
+         OS_TimerCreate(&replaced_id, "Replaced", &accuracy, noop_func) != OS_SUCCESS ||
+         OS_TimerSet(replaced_id, TIMER_PERIOD, TIMER_PERIOD) != OS_SUCCESS )
+    {
+       errors++;
+    }
+}
+
+void jitter_func(uint32 timer_id)
+{
+    OS_time_t      now;
+    unsigned long  usecs;
+
+    OS_GetLocalTime(&now);
+    if ( ticks > 0 )
+    {
+       usecs = usecs_between(&last_tick, &now);
+       if ( usecs < min_usecs )
+       {
+          min_usecs = usecs;
+       }
+       if ( usecs > max_usecs )
+       {
+          max_usecs = usecs;
+       }
+    }
+    last_tick = now;
+    ticks++;
+}
+
+void test_task(void)
+{
+    OS_time_t  start;
+    OS_time_t  end;
+    uint32     accuracy;
+    uint32     timer_id;
+    uint32     count;
+    uint32     expected;
+    uint32     low;
+    uint32     i;
+    char       name[OS_MAX_API_NAME];
+
+    OS_TaskRegister();
+
+    /* a timer deleted before it ever expires, while no callback runs */
+    if ( OS_TimerCreate(&timer_id, "NeverFired", &accuracy, count_func) != OS_SUCCESS ||
+         OS_TimerDelete(timer_id) != OS_SUCCESS )
+    {
+       OS_printf("Error deleting a timer that never expired\n");
+       errors++;
+    }
+    if ( OS_TimerCreate(&timer_id, "NeverSet", &accuracy, count_func) != OS_SUCCESS ||
+         OS_TimerSet(timer_id, 1000000, 0) != OS_SUCCESS ||
+         OS_TimerDelete(timer_id) != OS_SUCCESS )
+    {
+       OS_printf("Error deleting a timer before it expired\n");
+       errors++;
+    }
+
+    /* every timer there is */
+    for ( count = 0; count < MAX_TIMERS; count++ )
+    {
+       sprintf(name, "Timer%lu", (unsigned long)count);
+       if ( OS_TimerCreate(&timer_ids[count], name, &accuracy, count_func) != OS_SUCCESS )
+       {
+          break;
+       }
+    }
+    if ( count == 0 )
+    {
+       OS_printf("Error creating the timers\n");
+       errors++;
+    }
+    OS_printf("%lu timers, accuracy %lu usecs\n", (unsigned long)count, (unsigned long)accuracy);
+
+    for ( i = 0; i < count; i++ )
+    {
+       if ( OS_TimerSet(timer_ids[i], TIMER_PERIOD, TIMER_PERIOD) != OS_SUCCESS )
+       {
+          OS_printf("Error setting timer %lu\n", (unsigned long)i);
+          errors++;
+       }
+    }
+
+    /* the callbacks do not cut the delay short */
+    OS_GetLocalTime(&start);
+    OS_TaskDelay(DELAY_MSECS);
+    OS_GetLocalTime(&end);
+    if ( usecs_between(&start, &end) < DELAY_MSECS * 1000 )
+    {
+       OS_printf("The delay was cut short to %lu usecs\n", usecs_between(&start, &end));
+       errors++;
+    }
+    OS_TaskDelay(RUN_MSECS - DELAY_MSECS);
+
+    /* each timer expired about as often as it should have */
+    expected = (RUN_MSECS * 1000) / TIMER_PERIOD;
+    low = expected;
+    for ( i = 0; i < count; i++ )
+    {
+       if ( timer_counts[timer_ids[i]] < low )
+       {
+          low = timer_counts[timer_ids[i]];
+       }
+    }
+    if ( low < expected / 2 )
+    {
+       OS_printf("A timer ran %lu times out of %lu\n", (unsigned long)low, (unsigned long)expected);
+       errors++;
+    }
+
+    /* no callback once the timers are deleted */
+    for ( i = 0; i < count; i++ )
+    {
+       if ( OS_TimerDelete(timer_ids[i]) != OS_SUCCESS )
+       {
+          OS_printf("Error deleting timer %lu\n", (unsigned long)i);
+          errors++;
+       }
+    }
+    deleting = TRUE;
+    OS_TaskDelay(DELETE_MSECS);
+    deleting = FALSE;
+
+    /* a one shot timer that deletes itself */
+    if ( OS_TimerCreate(&timer_id, "SelfDelete", &accuracy, self_delete_func) != OS_SUCCESS ||
+         OS_TimerSet(timer_id, TIMER_PERIOD, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the self deleting timer\n");
+       errors++;
+    }
+    OS_TaskDelay(DELETE_MSECS * 2);
+    if ( self_deleted != 1 || OS_TimerGetIdByName(&timer_id, "SelfDelete") != OS_ERR_NAME_NOT_FOUND )
+    {
+       OS_printf("The timer did not delete itself\n");
+       errors++;
+    }
+
+    /* a timer that deletes itself with expirations left, and makes a new one */
+    if ( OS_TimerCreate(&timer_ids[0], "Stall", &accuracy, stall_func) != OS_SUCCESS ||
+         OS_TimerCreate(&timer_id, "Replace", &accuracy, replace_func) != OS_SUCCESS ||
+         OS_TimerSet(timer_ids[0], 1000, 0) != OS_SUCCESS ||
+         OS_TimerSet(timer_id, 2000, 1000) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the replacing timer\n");
+       errors++;
+    }
+    OS_TaskDelay(STALL_MSECS + DELETE_MSECS * 2);
+    if ( replace_calls != 1 || OS_TimerGetIdByName(&timer_id, "Replaced") != OS_SUCCESS ||
+         OS_TimerDelete(replaced_id) != OS_SUCCESS )
+    {
+       OS_printf("The callback of a deleted timer ran %lu times\n", (unsigned long)replace_calls);
+       errors++;
+    }
+    OS_TimerDelete(timer_ids[0]);
+
+    min_usecs = 0xFFFFFFFF;
+    max_usecs = 0;
+    if ( OS_TimerCreate(&timer_id, "Jitter", &accuracy, jitter_func) != OS_SUCCESS ||
+         OS_TimerSet(timer_id, JITTER_PERIOD, JITTER_PERIOD) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the jitter timer\n");
+       errors++;
+    }
+    else
+    {
+       while ( ticks < JITTER_TICKS )
+       {
+          OS_TaskDelay(10);
+       }
+       OS_TimerDelete(timer_id);
+       OS_printf("1 msec timer period: %lu to %lu usecs\n", min_usecs, max_usecs);
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Timer Dispatch Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Timer Dispatch Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}
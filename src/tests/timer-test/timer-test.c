@@ -68,15 +68,9 @@ void OS_Application_Startup(void)
    /*
    ** Let the main thread sleep 
    */     
-   OS_printf("Starting Delay loop. Linux/OSX/Cygwin will be faster, because sleep call is interrupted by timer\n");
+   OS_printf("Starting Delay loop\n");
    for (i = 0 ; i < 15; i++ )
    {
-      /* 
-      ** Even though this sleep call is for 1 second,
-      ** the sigalarm timer for the 1hz will keep waking
-      ** it up. Keep that in mind when setting the timer down
-      ** to something very small.
-      */
       OS_TaskDelay(1000);
    }
 
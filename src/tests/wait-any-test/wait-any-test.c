@@ -0,0 +1,263 @@
+/*
+** Wait Any Test
+**
+** One server task waits on two queues, a binary semaphore, a counting
+** semaphore and a periodic timer with OS_WaitAny, while a client task
+** sends to all of them. Every message and give must be seen, and the
+** timer must be reported. Then checks the timeout and the bad arguments.
+*/
+#include <stdio.h>
+#include "common_types.h"
+#include "osapi.h"
+
+#define TASK_STACK_SIZE   4096
+#define TEST_PRIORITY     90
+#define CLIENT_PRIORITY   100
+
+#define NUM_ROUNDS        10000
+#define QUEUE_DEPTH       16
+#define TIMER_USECS       10000
+
+#define OBJ_QUEUE_A       0
+#define OBJ_QUEUE_B       1
+#define OBJ_BIN_SEM       2
+#define OBJ_COUNT_SEM     3
+#define OBJ_TIMER         4
+#define NUM_OBJECTS       5
+
+uint32 test_stack[TASK_STACK_SIZE];
+uint32 test_id;
+
+uint32 client_stack[TASK_STACK_SIZE];
+uint32 client_id;
+
+uint32 queue_a_id;
+uint32 queue_b_id;
+uint32 bin_sem_id;
+uint32 count_sem_id;
+uint32 timer_id;
+uint32 done_sem_id;
+
+uint32 received[NUM_OBJECTS];
+volatile uint32 timer_ticks;
+uint32 errors;
+
+void timer_callback(uint32 id)
+{
+    timer_ticks++;
+}
+
+void client_task(void)
+{
+    uint32 msg;
+    int    i;
+
+    OS_TaskRegister();
+
+    for ( i = 0; i < NUM_ROUNDS; i++ )
+    {
+       msg = i;
+       while ( OS_QueuePut(queue_a_id, &msg, sizeof(msg), 0) == OS_QUEUE_FULL )
+       {
+          OS_TaskDelay(1);
+       }
+       while ( OS_QueuePut(queue_b_id, &msg, sizeof(msg), 0) == OS_QUEUE_FULL )
+       {
+          OS_TaskDelay(1);
+       }
+       OS_CountSemGive(count_sem_id);
+
+       /* a binary semaphore holds one give, so the server sees fewer of them */
+       OS_BinSemGive(bin_sem_id);
+    }
+
+    OS_CountSemGive(done_sem_id);
+    OS_TaskExit();
+}
+
+void test_task(void)
+{
+    OS_wait_object_t  objects[NUM_OBJECTS];
+    OS_time_t         start;
+    OS_time_t         end;
+    double            usecs;
+    uint32            msg;
+    uint32            size_copied;
+    uint32            accuracy;
+    uint32            num_waits;
+    int32             status;
+    int               i;
+
+    OS_TaskRegister();
+
+    if ( OS_TimerCreate(&timer_id, "Tick", &accuracy, timer_callback) != OS_SUCCESS ||
+         OS_TimerSet(timer_id, TIMER_USECS, TIMER_USECS) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the timer\n");
+       errors++;
+    }
+
+    objects[OBJ_QUEUE_A].type   = OS_WAIT_QUEUE;
+    objects[OBJ_QUEUE_A].id     = queue_a_id;
+    objects[OBJ_QUEUE_B].type   = OS_WAIT_QUEUE;
+    objects[OBJ_QUEUE_B].id     = queue_b_id;
+    objects[OBJ_BIN_SEM].type   = OS_WAIT_BIN_SEM;
+    objects[OBJ_BIN_SEM].id     = bin_sem_id;
+    objects[OBJ_COUNT_SEM].type = OS_WAIT_COUNT_SEM;
+    objects[OBJ_COUNT_SEM].id   = count_sem_id;
+    objects[OBJ_TIMER].type     = OS_WAIT_TIMER;
+    objects[OBJ_TIMER].id       = timer_id;
+
+    if ( OS_TaskCreate(&client_id, "Client", client_task, client_stack,
+                       TASK_STACK_SIZE, CLIENT_PRIORITY, 0) != OS_SUCCESS )
+    {
+       OS_printf("Error creating the client task\n");
+       errors++;
+    }
+
+    /*
+    ** Serve everything from one task until the client is done and all of
+    ** its messages are in
+    */
+    OS_GetLocalTime(&start);
+    num_waits = 0;
+    while ( received[OBJ_QUEUE_A] < NUM_ROUNDS || received[OBJ_QUEUE_B] < NUM_ROUNDS ||
+            received[OBJ_COUNT_SEM] < NUM_ROUNDS || received[OBJ_TIMER] == 0 )
+    {
+       status = OS_WaitAny(objects, NUM_OBJECTS, 1000);
+       num_waits++;
+       if ( status != OS_SUCCESS )
+       {
+          OS_printf("OS_WaitAny returned %d\n", (int)status);
+          errors++;
+          break;
+       }
+
+       for ( i = 0; i < NUM_OBJECTS; i++ )
+       {
+          if ( objects[i].ready == FALSE )
+          {
+             continue;
+          }
+
+          switch ( i )
+          {
+             case OBJ_QUEUE_A:
+             case OBJ_QUEUE_B:
+                while ( OS_QueueGet(objects[i].id, &msg, sizeof(msg), &size_copied,
+                                    OS_CHECK) == OS_SUCCESS )
+                {
+                   if ( msg != received[i] )
+                   {
+                      errors++;
+                   }
+                   received[i]++;
+                }
+                break;
+
+             case OBJ_BIN_SEM:
+                OS_BinSemTake(bin_sem_id);
+                received[i]++;
+                break;
+
+             case OBJ_COUNT_SEM:
+                OS_CountSemTake(count_sem_id);
+                received[i]++;
+                break;
+
+             case OBJ_TIMER:
+                received[i]++;
+                break;
+          }
+       }
+    }
+
+    OS_GetLocalTime(&end);
+    usecs = (double)(end.seconds - start.seconds) * 1000000.0 +
+            (double)end.microsecs - (double)start.microsecs;
+    OS_printf("%lu waits for %lu events: %lu nsecs per wait\n", (unsigned long)num_waits,
+              (unsigned long)(received[OBJ_QUEUE_A] + received[OBJ_QUEUE_B] +
+                              received[OBJ_BIN_SEM] + received[OBJ_COUNT_SEM] + received[OBJ_TIMER]),
+              (unsigned long)((usecs * 1000.0) / num_waits));
+    OS_printf("Timer reported %lu times for %lu ticks\n", (unsigned long)received[OBJ_TIMER],
+              (unsigned long)timer_ticks);
+
+    if ( received[OBJ_BIN_SEM] == 0 )
+    {
+       OS_printf("The binary semaphore was never reported\n");
+       errors++;
+    }
+
+    OS_CountSemTake(done_sem_id);
+    OS_TimerDelete(timer_id);
+
+    /*
+    ** Nothing left to report
+    */
+    OS_BinSemTimedWait(bin_sem_id, 10);
+    if ( OS_WaitAny(objects, NUM_OBJECTS - 1, OS_CHECK) != OS_ERROR_TIMEOUT )
+    {
+       OS_printf("OS_WaitAny did not time out with nothing ready\n");
+       errors++;
+    }
+    if ( OS_WaitAny(objects, NUM_OBJECTS - 1, 20) != OS_ERROR_TIMEOUT )
+    {
+       OS_printf("OS_WaitAny did not time out after 20 msecs\n");
+       errors++;
+    }
+
+    /*
+    ** Bad arguments
+    */
+    if ( OS_WaitAny(NULL, 1, OS_CHECK) != OS_INVALID_POINTER ||
+         OS_WaitAny(objects, 0, OS_CHECK) != OS_ERROR ||
+         OS_WaitAny(objects, NUM_OBJECTS, OS_CHECK) != OS_ERR_INVALID_ID )
+    {
+       OS_printf("OS_WaitAny accepted bad arguments\n");
+       errors++;
+    }
+    objects[OBJ_QUEUE_A].type = 99;
+    if ( OS_WaitAny(objects, 1, OS_CHECK) != OS_ERROR )
+    {
+       OS_printf("OS_WaitAny accepted an unknown type\n");
+       errors++;
+    }
+
+    if ( errors == 0 )
+    {
+       OS_printf("Wait Any Test PASSED\n");
+    }
+    else
+    {
+       OS_printf("Wait Any Test FAILED: %lu errors\n", (unsigned long)errors);
+    }
+
+    OS_printf("Test Complete: On a Desktop System, hit Control-C to return to command shell\n");
+    OS_TaskExit();
+}
+
+void OS_Application_Startup(void)
+{
+   OS_printf("OS Application Startup\n");
+
+   if ( OS_QueueCreate(&queue_a_id, "Queue A", QUEUE_DEPTH, sizeof(uint32), 0) != OS_SUCCESS ||
+        OS_QueueCreate(&queue_b_id, "Queue B", QUEUE_DEPTH, sizeof(uint32), 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the queues\n");
+   }
+
+   if ( OS_BinSemCreate(&bin_sem_id, "Bin", 0, 0) != OS_SUCCESS ||
+        OS_CountSemCreate(&count_sem_id, "Count", 0, 0) != OS_SUCCESS ||
+        OS_CountSemCreate(&done_sem_id, "Done", 0, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the semaphores\n");
+   }
+
+   if ( OS_TaskCreate(&test_id, "Test", test_task, test_stack,
+                      TASK_STACK_SIZE, TEST_PRIORITY, 0) != OS_SUCCESS )
+   {
+      OS_printf("Error creating the test task\n");
+   }
+
+   OS_printf("Main done!\n");
+}